@@ -51,8 +51,11 @@
 #include <cmath>
 
 /* standard C++ library */
+#include <algorithm>
 /* set needed in BVP_Init */
 #include <set>
+#include <tuple>
+#include <vector>
 
 #include <dune/common/fvector.hh>
 
@@ -114,8 +117,9 @@ USING_UGDIM_NAMESPACE
 /*                                                                          */
 /****************************************************************************/
 
-static STD_BVP *currBVP;
-
+/* BVP of the last BVP_Init or Set_Current_BVP on this thread, only for the
+   boundary points of BNDP_LoadBndP_Ext, which have no multigrid to take it from */
+static thread_local STD_BVP *currBVP = nullptr;
 
 /****************************************************************************/
 /* Methods for the class 'boundary_segment'                                 */
@@ -124,8 +128,9 @@ static STD_BVP *currBVP;
 boundary_segment::boundary_segment(INT idA,
                                    const INT* pointsA,
                                    BndSegFuncPtr bndSegFuncA,
-                                   void *dataA)
-: id(idA), BndSegFunc(bndSegFuncA), data(dataA)
+                                   void *dataA,
+                                   BndSegBatchFuncPtr bndSegBatchFuncA)
+: id(idA), BndSegFunc(bndSegFuncA), data(dataA), BndSegBatchFunc(bndSegBatchFuncA)
 {
   for (INT i = 0; i < CORNERS_OF_BND_SEG; i++)
     points[i] = pointsA[i];
@@ -152,15 +157,15 @@ linear_segment::linear_segment(INT idA,
 UINT NS_DIM_PREFIX GetBoundarySegmentId(BNDS* boundarySegment)
 {
   const BND_PS *ps = (BND_PS*)boundarySegment;
-  const PATCH *patch = currBVP->patches[ps->patch_id];
+  const PATCH *patch = ps->bvp->patches[ps->patch_id];
   if (patch == nullptr) {
     PrintErrorMessageF ('E', "GetBoundarySegmentId", "invalid argument");
     return 0;
   }
 
   /* The ids in the patch data structure are consecutive but they
-     start at currBVP->sideoffset instead of zero. */
-  return PATCH_ID(patch) - currBVP->sideoffset;
+     start at sideoffset instead of zero. */
+  return PATCH_ID(patch) - ps->bvp->sideoffset;
 }
 
 static INT
@@ -203,7 +208,7 @@ GetPatchId (const PATCH * p, INT i)
 }
 
 static BNDP *
-CreateBndPOnPoint (HEAP * Heap, PATCH * p)
+CreateBndPOnPoint (HEAP * Heap, STD_BVP * theBVP, PATCH * p)
 {
   BND_PS *ps;
   PATCH *pp;
@@ -221,12 +226,13 @@ CreateBndPOnPoint (HEAP * Heap, PATCH * p)
                                      + (m - 1) * sizeof (COORD_BND_VECTOR));
   if (ps == NULL)
     REP_ERR_RETURN (NULL);
+  ps->bvp = theBVP;
   ps->n = m;
   ps->patch_id = PATCH_ID (p);
 
   for (j = 0; j < m; j++)
   {
-    pp = currBVP->patches[POINT_PATCH_PID (p, j)];
+    pp = theBVP->patches[POINT_PATCH_PID (p, j)];
     if (PATCH_TYPE (pp) == PARAMETRIC_PATCH_TYPE)
     {
       PRINTDEBUG (dom, 1, ("cp r %f %f %f %f\n",
@@ -313,7 +319,7 @@ CreateCornerPoints (HEAP * Heap, STD_BVP * theBVP, BNDP ** bndp)
 
   for (i = 0; i < theBVP->ncorners; i++)
   {
-    bndp[i] = CreateBndPOnPoint (Heap, theBVP->patches[i]);
+    bndp[i] = CreateBndPOnPoint (Heap, theBVP, theBVP->patches[i]);
     if (bndp[i] == NULL)
       REP_ERR_RETURN (1);
   }
@@ -474,6 +480,7 @@ BVP_Init (STD_BVP* theBVP, HEAP * Heap, MESH * Mesh, INT MarkKey)
     }
     PARAM_PATCH_BS (thePatch) = theSegment.BndSegFunc;
     PARAM_PATCH_BSD (thePatch) = theSegment.data;
+    PARAM_PATCH_BSB (thePatch) = theSegment.BndSegBatchFunc;
     sides[theSegment.id] = thePatch;
     PRINTDEBUG (dom, 1, ("sides id %d type %d left %d right %d\n",
                          PATCH_ID (thePatch), PATCH_TYPE (thePatch),
@@ -773,7 +780,7 @@ GetCommonPatchId (const PATCH * p0, const PATCH * p1, INT k)
 }
 
 static INT
-GetCommonLinePatchId (PATCH * p0, PATCH * p1)
+GetCommonLinePatchId (const STD_BVP * theBVP, PATCH * p0, PATCH * p1)
 {
   INT i, k, l, cnt, cnt1;
 
@@ -787,9 +794,9 @@ GetCommonLinePatchId (PATCH * p0, PATCH * p1)
   if (cnt < 1)
     return (-1);
 
-  for (k = currBVP->ncorners; k < currBVP->sideoffset; k++)
+  for (k = theBVP->ncorners; k < theBVP->sideoffset; k++)
   {
-    PATCH *p = currBVP->patches[k];
+    PATCH *p = theBVP->patches[k];
     if (LINE_PATCH_N (p) != cnt)
       continue;
     cnt1 = 0;
@@ -856,7 +863,7 @@ PatchGlobal (const PATCH * p, DOUBLE * lambda, Dune::FieldVector<DOUBLE,DIM>& gl
 static INT
 local2lambda (BND_PS * ps, const Dune::FieldVector<DOUBLE,DIM_OF_BND>& local, DOUBLE lambda[])
 {
-  const PATCH *p = currBVP->patches[ps->patch_id];
+  const PATCH *p = ps->bvp->patches[ps->patch_id];
 
   if ((PATCH_TYPE (p) == PARAMETRIC_PATCH_TYPE)
       || (PATCH_TYPE (p) == LINEAR_PATCH_TYPE))
@@ -929,7 +936,7 @@ BNDS_BndSDesc (BNDS * theBndS, INT * id, INT * nbid)
   INT left, right;
 
   ps = (BND_PS *) theBndS;
-  p = currBVP->patches[ps->patch_id];
+  p = ps->bvp->patches[ps->patch_id];
 
   if (PATCH_TYPE (p) == PARAMETRIC_PATCH_TYPE)
   {
@@ -976,6 +983,7 @@ BNDS_CreateBndP (HEAP * Heap, BNDS * aBndS, const FieldVector<DOUBLE,DIM_OF_BND>
   if (pp == NULL)
     return (NULL);
 
+  pp->bvp = ps->bvp;
   pp->patch_id = ps->patch_id;
   pp->n = 1;
 
@@ -1006,7 +1014,7 @@ BNDP_Global (const BNDP * aBndP, FieldVector<DOUBLE,DIM>& global)
   FieldVector<DOUBLE,DIM> pglobal;
 
   ps = (BND_PS *) aBndP;
-  p = currBVP->patches[ps->patch_id];
+  p = ps->bvp->patches[ps->patch_id];
 
   PRINTDEBUG (dom, 1, (" bndp pid %d %d %d\n", ps->patch_id,
                        PATCH_ID (p), PATCH_TYPE (p)));
@@ -1018,7 +1026,7 @@ BNDP_Global (const BNDP * aBndP, FieldVector<DOUBLE,DIM>& global)
     return (PatchGlobal (p, ps->local[0], global));
   case POINT_PATCH_TYPE :
 
-    s = currBVP->patches[POINT_PATCH_PID (p, 0)];
+    s = ps->bvp->patches[POINT_PATCH_PID (p, 0)];
 
     PRINTDEBUG (dom, 1, (" bndp n %d %d loc %f %f gl \n",
                          POINT_PATCH_N (p),
@@ -1029,7 +1037,7 @@ BNDP_Global (const BNDP * aBndP, FieldVector<DOUBLE,DIM>& global)
 
     for (j = 1; j < POINT_PATCH_N (p); j++)
     {
-      s = currBVP->patches[POINT_PATCH_PID (p, j)];
+      s = ps->bvp->patches[POINT_PATCH_PID (p, j)];
 
       if (PatchGlobal(s, ps->local[j], pglobal))
         REP_ERR_RETURN (1);
@@ -1047,7 +1055,7 @@ BNDP_Global (const BNDP * aBndP, FieldVector<DOUBLE,DIM>& global)
     return (0);
 #ifdef UG_DIM_3
   case LINE_PATCH_TYPE :
-    s = currBVP->patches[LINE_PATCH_PID (p, 0)];
+    s = ps->bvp->patches[LINE_PATCH_PID (p, 0)];
 
     if (PatchGlobal(s, ps->local[0], global))
       REP_ERR_RETURN (1);
@@ -1059,7 +1067,7 @@ BNDP_Global (const BNDP * aBndP, FieldVector<DOUBLE,DIM>& global)
                          ps->local[0][1], global[0], global[1], global[2]));
     for (j = 1; j < LINE_PATCH_N (p); j++)
     {
-      s = currBVP->patches[LINE_PATCH_PID (p, j)];
+      s = ps->bvp->patches[LINE_PATCH_PID (p, j)];
 
       if (PatchGlobal(s, ps->local[j], pglobal))
         REP_ERR_RETURN (1);
@@ -1080,6 +1088,59 @@ BNDP_Global (const BNDP * aBndP, FieldVector<DOUBLE,DIM>& global)
   REP_ERR_RETURN (1);
 }
 
+/* domain interface function: for description see domain.h */
+INT NS_DIM_PREFIX
+BNDP_GlobalBatch (INT n, const BNDP *const *theBndPs, FieldVector<DOUBLE,DIM> *globals)
+{
+  /* queue of the points on segments with a batch function */
+  std::vector<INT> queue;
+
+  for (INT i = 0; i < n; i++)
+  {
+    const BND_PS *ps = (const BND_PS *) theBndPs[i];
+    const PATCH *p = ps->bvp->patches[ps->patch_id];
+
+    if (PATCH_TYPE (p) == PARAMETRIC_PATCH_TYPE && PARAM_PATCH_BSB (p) != nullptr)
+      queue.push_back (i);
+    else if (BNDP_Global (theBndPs[i], globals[i]))
+      REP_ERR_RETURN (1);
+  }
+
+  /* group the queue by segment */
+  std::stable_sort (queue.begin (), queue.end (), [theBndPs](INT a, INT b) {
+    const BND_PS *psa = (const BND_PS *) theBndPs[a];
+    const BND_PS *psb = (const BND_PS *) theBndPs[b];
+    return std::tie (psa->bvp, psa->patch_id) < std::tie (psb->bvp, psb->patch_id);
+  });
+
+  std::vector<DOUBLE> lambda, global;
+  for (std::size_t first = 0, last; first < queue.size (); first = last)
+  {
+    const BND_PS *ps = (const BND_PS *) theBndPs[queue[first]];
+    for (last = first; last < queue.size (); last++)
+      if (((const BND_PS *) theBndPs[queue[last]])->patch_id != ps->patch_id
+          || ((const BND_PS *) theBndPs[queue[last]])->bvp != ps->bvp)
+        break;
+
+    const INT m = last - first;
+    lambda.resize (m * DIM_OF_BND);
+    global.resize (m * DIM);
+    for (INT j = 0; j < m; j++)
+      for (INT k = 0; k < DIM_OF_BND; k++)
+        lambda[j * DIM_OF_BND + k] = ((const BND_PS *) theBndPs[queue[first + j]])->local[0][k];
+
+    const PATCH *p = ps->bvp->patches[ps->patch_id];
+    if ((*PARAM_PATCH_BSB (p))(PARAM_PATCH_BSD (p), m, lambda.data (), global.data ()))
+      REP_ERR_RETURN (1);
+
+    for (INT j = 0; j < m; j++)
+      for (INT k = 0; k < DIM; k++)
+        globals[queue[first + j]][k] = global[j * DIM + k];
+  }
+
+  return (0);
+}
+
 /* domain interface function: for description see domain.h */
 INT NS_DIM_PREFIX
 BNDP_BndPDesc (BNDP * theBndP, INT * move)
@@ -1088,7 +1149,7 @@ BNDP_BndPDesc (BNDP * theBndP, INT * move)
   PATCH *p;
 
   ps = (BND_PS *) theBndP;
-  p = STD_BVP_PATCH (currBVP, ps->patch_id);
+  p = STD_BVP_PATCH (ps->bvp, ps->patch_id);
 
   switch (PATCH_TYPE (p))
   {
@@ -1140,7 +1201,7 @@ BNDP_CreateBndS (HEAP * Heap, BNDP ** aBndP, INT n)
   for (i = 0; i < n; i++)
   {
     bp[i] = (BND_PS *) aBndP[i];
-    p[i] = currBVP->patches[bp[i]->patch_id];
+    p[i] = bp[i]->bvp->patches[bp[i]->patch_id];
 
     PRINTDEBUG (dom, 1, (" bp %d p %d n %d\n",
                          bp[i]->patch_id, PATCH_ID (p[i]), n));
@@ -1212,6 +1273,7 @@ BNDP_CreateBndS (HEAP * Heap, BNDP ** aBndP, INT n)
                                      + sizeof (BND_PS));
   if (bs == NULL)
     return (NULL);
+  bs->bvp = bp[0]->bvp;
   bs->n = n;
   bs->patch_id = pid;
   for (i = 0; i < n; i++)
@@ -1241,8 +1303,8 @@ BNDP_CreateBndP (HEAP * Heap, BNDP * aBndP0, BNDP * aBndP1, DOUBLE lcoord)
   if ((bp0 == NULL) || (bp1 == NULL))
     return (NULL);
 
-  p0 = currBVP->patches[bp0->patch_id];
-  p1 = currBVP->patches[bp1->patch_id];
+  p0 = bp0->bvp->patches[bp0->patch_id];
+  p1 = bp1->bvp->patches[bp1->patch_id];
 
   PRINTDEBUG (dom, 1, ("   bp0 %d pid %d\n", bp0->patch_id, PATCH_ID (p0)));
   for (l = 0; l < GetNumberOfPatches (p0); l++)
@@ -1261,16 +1323,17 @@ BNDP_CreateBndP (HEAP * Heap, BNDP * aBndP0, BNDP * aBndP1, DOUBLE lcoord)
                                   sizeof (BND_PS));
   if (bp == NULL)
     return (NULL);
+  bp->bvp = bp0->bvp;
   bp->n = cnt;
 
 #ifdef UG_DIM_3
   if (cnt > 1)
   {
     PATCH *p;
-    k = GetCommonLinePatchId (p0, p1);
-    if ((k < currBVP->ncorners) || (k >= currBVP->sideoffset))
+    k = GetCommonLinePatchId (bp->bvp, p0, p1);
+    if ((k < bp->bvp->ncorners) || (k >= bp->bvp->sideoffset))
       return (NULL);
-    p = currBVP->patches[k];
+    p = bp->bvp->patches[k];
     bp->patch_id = k;
 
     PRINTDEBUG (dom, 1, (" Create BNDP line %d cnt %d\n", k, cnt));
@@ -1334,20 +1397,20 @@ BNDP_SaveInsertedBndP (BNDP * theBndP, char *data, INT max_data_size)
     return (1);
 
   pid = bp->patch_id;
-  p = currBVP->patches[pid];
+  p = bp->bvp->patches[pid];
 
   switch (PATCH_TYPE (p))
   {
   case PARAMETRIC_PATCH_TYPE :
   case LINEAR_PATCH_TYPE :
-    pid -= currBVP->sideoffset;
+    pid -= bp->bvp->sideoffset;
     break;
   case POINT_PATCH_TYPE :
-    pid = POINT_PATCH_PID (p, 0) - currBVP->sideoffset;
+    pid = POINT_PATCH_PID (p, 0) - bp->bvp->sideoffset;
     break;
 #ifdef UG_DIM_3
   case LINE_PATCH_TYPE :
-    pid = LINE_PATCH_PID (p, 0) - currBVP->sideoffset;
+    pid = LINE_PATCH_PID (p, 0) - bp->bvp->sideoffset;
     break;
 #endif
   }
@@ -1484,6 +1547,7 @@ BNDP_LoadBndP (STD_BVP *theBVP, HEAP * Heap)
     (BND_PS *) GetFreelistMemory (Heap,
                                   (n - 1) * sizeof (COORD_BND_VECTOR) +
                                   sizeof (BND_PS));
+  bp->bvp = theBVP;
   bp->n = n;
   bp->patch_id = pid;
   for (i = 0; i < n; i++)
@@ -1511,6 +1575,7 @@ BNDP_LoadBndP_Ext (void)
   n = iList[1];
   bp =
     (BND_PS *) malloc ((n - 1) * sizeof (COORD_BND_VECTOR) + sizeof (BND_PS));
+  bp->bvp = currBVP;
   bp->n = n;
   bp->patch_id = pid;
   for (i = 0; i < n; i++)
@@ -88,6 +88,16 @@ typedef void *BNDP;                /*!< Structure handled by domain module    */
  */
 typedef INT (*BndSegFuncPtr)(void *,DOUBLE *, FieldVector<DOUBLE,DIM>&);
 
+/** \brief Data type of the functions mapping many parameters to world space at once
+ *
+ * The first argument is the user data pointer from the corresponding
+ * BOUNDARY_SEGMENT and the second one the number n of points. The third
+ * parameter provides the n parameters one after the other (DIM_OF_BND numbers
+ * each) and the fourth one an array for the n results (DIM numbers each).
+ * The results have to be the same as the ones of the BndSegFunc of the segment.
+ */
+typedef INT (*BndSegBatchFuncPtr)(void *, INT, const DOUBLE *, DOUBLE *);
+
 
 /** \brief Data structure defining part of the boundary of a domain
 
@@ -113,11 +123,13 @@ struct boundary_segment
    * @param  point - the endpoints of the boundary segment
    * @param  BndSegFunc - function mapping parameters
    * @param  data - user defined space
+   * @param  BndSegBatchFunc - function mapping many parameters at once, or nullptr
    */
   boundary_segment(INT id,
                    const INT* point,
                    BndSegFuncPtr BndSegFunc,
-                   void *data);
+                   void *data,
+                   BndSegBatchFuncPtr BndSegBatchFunc = nullptr);
 
   /** \brief Number of the boundary segment beginning with zero */
   INT id;
@@ -140,6 +152,12 @@ struct boundary_segment
    * e.g. from a CAD system.
    */
   void *data;
+
+  /** \brief Optional function evaluating BndSegFunc for many parameters at once
+   *
+   * It is used by BNDP_GlobalBatch, e.g. for the boundary nodes of a refinement step.
+   */
+  BndSegBatchFuncPtr BndSegBatchFunc;
 };
 
 
@@ -252,6 +270,7 @@ enum PatchType {POINT_PATCH_TYPE,
 #define PARAM_PATCH_RANGE(p)    (p)->pa.range
 #define PARAM_PATCH_BS(p)       (p)->pa.BndSegFunc
 #define PARAM_PATCH_BSD(p)      (p)->pa.bs_data
+#define PARAM_PATCH_BSB(p)      (p)->pa.BndSegBatchFunc
 #define LINEAR_PATCH_LEFT(p)    (p)->lp.left
 #define LINEAR_PATCH_RIGHT(p)   (p)->lp.right
 #define LINEAR_PATCH_N(p)       (p)->lp.corners
@@ -259,7 +278,7 @@ enum PatchType {POINT_PATCH_TYPE,
 #define LINEAR_PATCH_POS(p,i)    (p)->lp.pos[i]
 
 #define BND_PATCH_ID(p)         (((BND_PS *)p)->patch_id)
-#define BND_DATA(p)             (((BND_PS *)p)->data)
+#define BND_BVP(p)              (((BND_PS *)p)->bvp)
 #define BND_N(p)                (((BND_PS *)p)->n)
 #define BND_LOCAL(p,i)          (((BND_PS *)p)->local[i])
 #define BND_SIZE(p)             ((((BND_PS *)p)->n-1)*sizeof(COORD_BND_VECTOR)+sizeof(BND_PS))
@@ -438,6 +457,9 @@ struct parameter_patch {
   /** \brief Can be used by applic to find data */
   void *bs_data;
 
+  /** \brief Pointer to the batched definition function, or nullptr */
+  BndSegBatchFuncPtr BndSegBatchFunc;
+
   /*@}*/
 };
 
@@ -464,8 +486,8 @@ struct bnd_ps {
   /** \brief Associated patch                     */
   INT patch_id;
 
-  /** \brief E.g. global coordinates, pointers... */
-  void *data;
+  /** \brief Boundary value problem of the patch */
+  struct std_BoundaryValueProblem *bvp;
 
   /** \brief Number of arguments                  */
   INT n;
@@ -558,7 +580,10 @@ struct mesh
 };
 typedef struct mesh MESH;
 
+/** \brief Set the BVP of the boundary points loaded by BNDP_LoadBndP_Ext on this thread
 
+   All other boundary points and sides know their BVP.
+ */
 void Set_Current_BVP(STD_BVP *theBVP);
 
 /****************************************************************************/
@@ -603,6 +628,24 @@ INT         BNDP_SaveInsertedBndP (BNDP *theBndP, char *data, INT max_data_size)
 /****************************************************************************/
 INT         BNDP_Global           (const BNDP *theBndP, Dune::FieldVector<DOUBLE,DIM>& global);
 
+/****************************************************************************/
+/** \brief Return global coordinates of many BNDPs
+ *
+ * @param n - number of BNDPs
+ * @param theBndPs - BNDP structures
+ * @param globals - global coordinates
+
+   This function returns the same as BNDP_Global for each BNDP. The points
+   on boundary segments with a BndSegBatchFunc are grouped by segment and
+   evaluated with one call per segment.
+
+ * @return <ul>
+ *   <li> 0 if ok </li>
+ *   <li> 1 if error. </li>
+ * </ul> */
+/****************************************************************************/
+INT         BNDP_GlobalBatch      (INT n, const BNDP *const *theBndPs, Dune::FieldVector<DOUBLE,DIM> *globals);
+
 /****************************************************************************/
 /** \brief Sets descriptor for BNDP
  *
@@ -166,6 +166,8 @@ void NS_DIM_PREFIX BElementScatterBndS (const DDD::DDDContext& context, BNDS **b
     {
       bs = (BNDS *) memmgr_AllocOMEM((size_t)size,ddd_ctrl(context).TypeBndS,0,0);
       memcpy(bs,data,size);
+      /* the sender's pointer to its BVP is meaningless here */
+      BND_BVP(bs) = MG_BVP(ddd_ctrl(context).currMG);
       bnds[i] = bs;
     }
     data += CEIL(size);
@@ -204,6 +206,7 @@ void NS_DIM_PREFIX BVertexScatterBndP (const DDD::DDDContext& context, BNDP **bn
   {
     *bndp = (BNDS *) memmgr_AllocOMEM((size_t)cnt,ddd_ctrl(context).TypeBndP,0,0);
     memcpy(*bndp,data,cnt);
+    BND_BVP(*bndp) = MG_BVP(ddd_ctrl(context).currMG);
     PRINTDEBUG(dom,1,("BVertexScatterBndP():  pid "
                       "%d n %d size %d cnt %d\n",
                       BND_PATCH_ID(*bndp),
@@ -57,11 +57,14 @@
 /****************************************************************************/
 
 #include <config.h>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 #include <dune/uggrid/low/architecture.h>
 #include <dune/uggrid/low/debug.h>
@@ -135,6 +138,7 @@ INT NS_DIM_PREFIX CreateSideVector (GRID *theGrid, INT side, GEOM_OBJECT *object
   SETVOTYPE(pv,SIDEVEC);
   SETVCLASS(pv,3);
   SETVNCLASS(pv,0);
+  SETFINE_GRID_DOF(pv,0);
   SETVNEW(pv,1);
   /* SETPRIO(dddContext, pv,PrioMaster); */
 
@@ -187,6 +191,11 @@ INT NS_DIM_PREFIX DisposeVector (GRID *theGrid, VECTOR *theVector)
   /* now remove vector from vector list */
   GRID_UNLINK_VECTOR(theGrid,theVector);
 
+  /* keep the count of SetIncrementalSurfaceClasses, the chunk grids of
+     the threaded refinement count their own vectors */
+  if (theGrid->mg->surfaceClassUpdate && FINE_GRID_DOF(theVector))
+    theGrid->nFineDof--;
+
   /* reset count flags */
   SETVCOUNT(theVector,0);
 
@@ -368,12 +377,244 @@ static int Scatter_GhostVectorVNew (DDD::DDDContext&, DDD_OBJ obj, void *data)
 }
 #endif
 
+#ifndef ModelP
+/* the classes are computed on all levels if more than this */
+/* fraction of the elements changed its refinement           */
+#define SURFACE_CLASS_CHANGE_RATIO      16
+
+/****************************************************************************/
+/** \brief Elements of a level sharing a corner with given elements
+
+ * @param theMG - multigrid
+ * @param update - elements of level 0 at their corners
+ * @param sources - elements of one level, sorted
+
+   An element sharing a corner with a source has a father sharing a corner
+   with the father of the source, such that the elements are found among
+   the sons of the elements found for the fathers.
+
+ * @return the sorted elements including the sources
+ */
+/****************************************************************************/
+
+static std::vector<ELEMENT*> ElementsAtCorners (const MULTIGRID *theMG,
+                                                const SurfaceClassUpdate& update,
+                                                const std::vector<ELEMENT*>& sources)
+{
+  std::vector<ELEMENT*> elements;
+  if (sources.empty())
+    return(elements);
+
+  std::vector<const NODE*> corners;
+  for (ELEMENT *theElement : sources)
+    for (INT i=0; i<CORNERS_OF_ELEM(theElement); i++)
+      corners.push_back(CORNER(theElement,i));
+  std::sort(corners.begin(),corners.end());
+  corners.erase(std::unique(corners.begin(),corners.end()),corners.end());
+
+  if (LEVEL(sources.front()) == 0)
+  {
+    for (const NODE *theNode : corners)
+    {
+      const std::vector<ELEMENT*>& star = update.coarseStars.at(theNode);
+      elements.insert(elements.end(),star.begin(),star.end());
+    }
+  }
+  else
+  {
+    std::vector<ELEMENT*> fathers;
+    for (ELEMENT *theElement : sources)
+      fathers.push_back(EFATHER(theElement));
+    std::sort(fathers.begin(),fathers.end());
+    fathers.erase(std::unique(fathers.begin(),fathers.end()),fathers.end());
+
+    for (ELEMENT *theFather : ElementsAtCorners(theMG,update,fathers))
+      for (ELEMENT *theSon : GetSonRange(theMG,theFather))
+        for (INT i=0; i<CORNERS_OF_ELEM(theSon); i++)
+          if (std::binary_search(corners.begin(),corners.end(),CORNER(theSon,i)))
+          {
+            elements.push_back(theSon);
+            break;
+          }
+  }
+
+  std::sort(elements.begin(),elements.end());
+  elements.erase(std::unique(elements.begin(),elements.end()),elements.end());
+
+  return(elements);
+}
+
+/****************************************************************************/
+/** \brief Recompute the vector classes around the changed elements
+
+ * @param theMG - multigrid
+ * @param update - changed elements of the last AdaptMultiGrid
+
+   The node classes of a level are seeded from the corners of its regular
+   elements and of its elements marked for refinement. Both only change at
+   the corners of the changed elements and of the sons created or disposed
+   below them, so only the vectors of the elements at these corners are
+   cleared and seeded again, by the elements on both sides of each vector.
+   Like the full sweep, the VCLASS of level 0 and the VNCLASS of the top
+   level are left alone.
+
+ * @return true if the classes were updated, false if they have to be
+   computed on all levels
+ */
+/****************************************************************************/
+
+static bool UpdateSurfaceClasses (MULTIGRID *theMG, SurfaceClassUpdate& update)
+{
+  const INT toplevel = TOPLEVEL(theMG);
+  const RefineState& theState = theMG->refineState;
+
+  if (!update.incremental || toplevel != update.topLevel || toplevel == 0
+      || theState.rFlag == GM_COPY_ALL || !theState.hFlag)
+    return(false);
+
+  INT nElements = 0;
+  for (INT level=0; level<=toplevel; level++)
+    nElements += NT(GRID_ON_LEVEL(theMG,level));
+  if (SURFACE_CLASS_CHANGE_RATIO*(INT)update.changed.size() > nElements)
+    return(false);
+
+  std::vector<std::vector<ELEMENT*> > changed(toplevel+1);
+  for (ELEMENT *theElement : update.changed)
+    changed[LEVEL(theElement)].push_back(theElement);
+
+  /* elements of each level with a corner whose class may have changed */
+  std::vector<std::vector<ELEMENT*> > affected(toplevel+1);
+  for (INT level=0; level<=toplevel; level++)
+  {
+    std::sort(changed[level].begin(),changed[level].end());
+    for (ELEMENT *theElement : ElementsAtCorners(theMG,update,changed[level]))
+    {
+      affected[level].push_back(theElement);
+      if (level < toplevel)
+        for (ELEMENT *theSon : GetSonRange(theMG,theElement))
+          affected[level+1].push_back(theSon);
+    }
+  }
+
+  INT fullrefine = toplevel;
+  for (INT level=toplevel; level>=0; level--)
+  {
+    GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+    std::vector<ELEMENT*>& elements = affected[level];
+    std::sort(elements.begin(),elements.end());
+    elements.erase(std::unique(elements.begin(),elements.end()),elements.end());
+
+    /* only 3d grids have vectors */
+    std::vector<VECTOR*> vectors;
+#ifdef UG_DIM_3
+    for (ELEMENT *theElement : elements)
+    {
+      VECTOR *vList[MAX_SIDES_OF_ELEM];
+      INT cnt;
+      GetVectorsOfSides(theElement,&cnt,vList);
+      vectors.insert(vectors.end(),vList,vList+cnt);
+    }
+#endif
+    std::sort(vectors.begin(),vectors.end());
+    vectors.erase(std::unique(vectors.begin(),vectors.end()),vectors.end());
+
+    const bool vclass = (level > 0);
+    const bool vnclass = (level < toplevel);
+    for (VECTOR *v : vectors)
+    {
+      if (vclass)
+        SETVCLASS(v,0);
+      if (vnclass)
+        SETVNCLASS(v,0);
+    }
+
+    auto seed = [&](ELEMENT *theElement)
+    {
+      if (vclass && MinNodeClass(theElement)==3)
+        SeedVectorClasses(theGrid,theElement);
+      if (vnclass && MinNextNodeClass(theElement)==3)
+        SeedNextVectorClasses(theGrid,theElement);
+    };
+    for (ELEMENT *theElement : elements)
+    {
+      seed(theElement);
+      for (INT side=0; side<SIDES_OF_ELEM(theElement); side++)
+      {
+        ELEMENT *theNeighbour = NBELEM(theElement,side);
+        if (theNeighbour != NULL
+            && !std::binary_search(elements.begin(),elements.end(),theNeighbour))
+          seed(theNeighbour);
+      }
+    }
+
+    for (VECTOR *v : vectors)
+    {
+      const INT fine = (VCLASS(v)>=2)&&(VNCLASS(v)<=1);
+      theGrid->nFineDof += fine - (INT)FINE_GRID_DOF(v);
+      SETFINE_GRID_DOF(v,fine);
+    }
+    if (theGrid->nFineDof > 0)
+      fullrefine = level;
+  }
+
+  FULLREFINELEVEL(theMG) = fullrefine;
+
+  return(true);
+}
+
+/* prepare the next update after the classes were computed on all levels */
+static void ResetSurfaceClassUpdate (MULTIGRID *theMG, SurfaceClassUpdate& update)
+{
+  update.topLevel = TOPLEVEL(theMG);
+
+  update.coarseStars.clear();
+  if (TOPLEVEL(theMG) < 0)
+    return;
+  for (ELEMENT *theElement=PFIRSTELEMENT(GRID_ON_LEVEL(theMG,0)); theElement!=NULL;
+       theElement=SUCCE(theElement))
+    for (INT i=0; i<CORNERS_OF_ELEM(theElement); i++)
+      update.coarseStars[CORNER(theElement,i)].push_back(theElement);
+}
+#endif
+
 INT NS_DIM_PREFIX SetSurfaceClasses (MULTIGRID *theMG)
 {
   GRID *theGrid;
   ELEMENT *theElement;        VECTOR *v;
   INT level,fullrefine;
 
+#ifndef ModelP
+  SurfaceClassUpdate *update = theMG->surfaceClassUpdate.get();
+#endif
+
+  /* without side vectors there are no classes, as on a grid without fine grid dofs */
+  if (!VEC_DEF_IN_OBJ_OF_MG(theMG,SIDEVEC))
+  {
+#ifndef ModelP
+    if (update != nullptr)
+    {
+      update->changed.clear();
+      update->incremental = false;
+      update->valid = false;
+    }
+#endif
+    FULLREFINELEVEL(theMG) = TOPLEVEL(theMG);
+    return(0);
+  }
+
+#ifndef ModelP
+  if (update != nullptr)
+  {
+    const bool updated = UpdateSurfaceClasses(theMG,*update);
+    update->changed.clear();
+    update->incremental = false;
+    update->valid = (theMG->refineState.rFlag != GM_COPY_ALL && theMG->refineState.hFlag);
+    if (updated)
+      return(0);
+    ResetSurfaceClassUpdate(theMG,*update);
+  }
+#endif
+
   level = TOPLEVEL(theMG);
   if (level > 0) {
     theGrid = GRID_ON_LEVEL(theMG,TOPLEVEL(theMG));
@@ -414,12 +655,16 @@ INT NS_DIM_PREFIX SetSurfaceClasses (MULTIGRID *theMG)
   fullrefine = TOPLEVEL(theMG);
   for (level=TOPLEVEL(theMG); level>=0; level--)
   {
+    INT fineDofs = 0;
     theGrid = GRID_ON_LEVEL(theMG,level);
     for (v=PFIRSTVECTOR(theGrid); v!= NULL; v=SUCCVC(v)) {
       SETFINE_GRID_DOF(v,((VCLASS(v)>=2)&&(VNCLASS(v)<=1)));
-      if (FINE_GRID_DOF(v))
+      if (FINE_GRID_DOF(v)) {
         fullrefine = level;
+        fineDofs++;
+      }
     }
+    theGrid->nFineDof = fineDofs;
   }
         #ifdef ModelP
   fullrefine = UG_GlobalMinINT(theMG->ppifContext(), fullrefine);
@@ -431,122 +676,211 @@ INT NS_DIM_PREFIX SetSurfaceClasses (MULTIGRID *theMG)
 }
 
 /****************************************************************************/
-/** \brief Creates the algebra for a grid
+/** \brief Switch the incremental update of the vector classes
 
- * @param theGrid - pointer to grid
+ * @param theMG - multigrid
+ * @param incremental - true to update the classes around the changed elements
 
-   This function allocates VECTORs in all geometrical objects of the grid.
+   SetSurfaceClasses computes VCLASS, VNCLASS and FINE_GRID_DOF of all vectors
+   of all levels after each AdaptMultiGrid. With the incremental update it
+   recomputes them only for the elements sharing a corner with the elements
+   whose refinement changed, and with their sons. All levels are computed
+   if the top level changed, if more than a small fraction of the elements
+   changed, for GM_COPY_ALL and for refinements without closure, and after
+   other changes of the grid. The parallel version always computes all
+   levels.
 
  * @return <ul>
- *   <li>    GM_OK if ok
+ *   <li>    GM_OK if ok </li>
+ *   <li>    GM_ERROR if the update is requested in the parallel version </li>
    </ul>
  */
 /****************************************************************************/
 
-INT NS_DIM_PREFIX CreateAlgebra (MULTIGRID *theMG)
+INT NS_DIM_PREFIX SetIncrementalSurfaceClasses (MULTIGRID *theMG, bool incremental)
 {
-  GRID *g = nullptr;
-#ifdef UG_DIM_3
-  VECTOR *nbvec;
-  ELEMENT *nbelem;
-  INT j;
+  if (!incremental)
+  {
+    theMG->surfaceClassUpdate.reset();
+    return(GM_OK);
+  }
+
+#ifdef ModelP
+  PrintErrorMessage('E',"SetIncrementalSurfaceClasses","not available in the parallel version");
+  RETURN(GM_ERROR);
+#else
+  if (!theMG->surfaceClassUpdate)
+    theMG->surfaceClassUpdate = std::make_unique<SurfaceClassUpdate>();
+  theMG->surfaceClassUpdate->incremental = false;
+  SetSurfaceClasses(theMG);
+
+  return(GM_OK);
 #endif
-  ELEMENT *elem;
-  INT i;
+}
 
+#ifdef UG_DIM_3
+/****************************************************************************/
+/** \brief Create the side vectors of a range of elements
 
-  if (MG_COARSE_FIXED(theMG) == false) {
-    for (i=0; i<=TOPLEVEL(theMG); i++) {
-      g = GRID_ON_LEVEL(theMG,i);
+ * @param theGrid - grid the new vectors are linked into
+ * @param first - first element
+ * @param last - end of the elements
 
-      if (NVEC(g)>0)
-        continue;                               /* skip this level */
+   Each side gets exactly one vector. It is created by the element with
+   the smaller id and shared with the neighbor, which therefore must not
+   have side vectors yet. The elements of different ranges can be handled
+   by different threads, since each vector is set by its creator only.
+
+ * @return <ul>
+ *   <li>    GM_OK if ok </li>
+ *   <li>    GM_ERROR if out of memory </li>
+   </ul>
+ */
+/****************************************************************************/
 
-      /* loop elements and element sides */
-      for (elem=PFIRSTELEMENT(g); elem!=NULL; elem=SUCCE(elem)) {
+static INT CreateSideVectors (GRID *theGrid, ELEMENT *const *first, ELEMENT *const *last)
+{
+  for (ELEMENT *const *pos=first; pos!=last; pos++)
+  {
+    ELEMENT *elem = *pos;
 
-        /* side vectors */
-#ifdef UG_DIM_3
-          for (INT side=0; side<SIDES_OF_ELEM(elem); side++)
-            if (SVECTOR(elem,side)==NULL) {
-              VECTOR *vec;
-              if (CreateSideVector (g,side,
-                                    (GEOM_OBJECT *)elem,&vec))
-                REP_ERR_RETURN (GM_ERROR);
-              SET_SVECTOR(elem,side,vec);
-            }
-#endif
+    for (INT side=0; side<SIDES_OF_ELEM(elem); side++)
+    {
+      ELEMENT *nbelem = NULL;
+      if (OBJT(elem)!=BEOBJ || INNER_SIDE(elem,side))
+      {
+        nbelem = NBELEM(elem,side);
+        ASSERT(nbelem!=NULL);
       }
+      if (nbelem!=NULL && ID(nbelem)<ID(elem))
+        continue;
+
+      VECTOR *vec;
+      if (CreateSideVector(theGrid,side,(GEOM_OBJECT *)elem,&vec))
+        REP_ERR_RETURN(GM_ERROR);
+      SET_SVECTOR(elem,side,vec);
+      if (nbelem==NULL)
+        continue;
+
+      INT j;
+      for (j=0; j<SIDES_OF_ELEM(nbelem); j++)
+        if (NBELEM(nbelem,j)==elem)
+          break;
+      ASSERT(j<SIDES_OF_ELEM(nbelem));
+      SET_SVECTOR(nbelem,j,vec);
+      SETVCOUNT(vec,2);                                  /* PB, 25 Sep 2005: changed from 1 to 2 */
     }
-#ifdef UG_DIM_3
-    /* dispose doubled side vectors */
-      for (elem=PFIRSTELEMENT(g); elem!=NULL; elem=SUCCE(elem))
-      {
-        for(INT side=0; side<SIDES_OF_ELEM(elem); side++)
-        {
-          if(OBJT(elem)==BEOBJ)
-          {
-            if(INNER_SIDE(elem,side))
-            {
-              nbelem = NBELEM(elem,side);
-              ASSERT(nbelem!=NULL);
-              VECTOR *vec=SVECTOR(elem,side);
-#ifdef Debug
-              INT n=0;
-#endif
-              for(j=0; j<SIDES_OF_ELEM(nbelem); j++)
-              {
-                nbvec=SVECTOR(nbelem,j);
-
-                /* doubled sidevectors ? */
-                if(NBELEM(nbelem,j)==elem)
-                {
-                  if(vec!=nbvec)
-                  {
-                    if(DisposeVector(g,nbvec))
-                      REP_ERR_RETURN(GM_ERROR);
-                    SET_SVECTOR(nbelem,j,vec);
-                    SETVCOUNT(vec,2);                                                                     /* PB, 25 Sep 2005: changed from 1 to 2 */
-                  }
-                }
-              }
-#ifdef Debug
-              n++;
+  }
+
+  return(GM_OK);
+}
+
+/****************************************************************************/
+/** \brief Create the side vectors of a grid without vectors
+
+ * @param theGrid - the grid
+
+   The elements are split into chunks which get their vectors on separate
+   threads, at most as many as set by SetRefineThreads. Each thread links
+   its vectors into the list of a private copy of 'theGrid'; these lists are
+   appended in chunk order and the vectors are numbered afterwards, such
+   that list, ids and indices are those of a single thread.
+
+ * @return <ul>
+ *   <li>    GM_OK if ok </li>
+ *   <li>    GM_ERROR if out of memory </li>
+   </ul>
+ */
+/****************************************************************************/
+
+static INT CreateGridSideVectors (GRID *theGrid)
+{
+  std::vector<ELEMENT*> elements;
+  for (ELEMENT *elem=PFIRSTELEMENT(theGrid); elem!=NULL; elem=SUCCE(elem))
+    elements.push_back(elem);
+  const INT n = elements.size();
+
+#ifdef ModelP
+  return(CreateSideVectors(theGrid,elements.data(),elements.data()+n));
+#else
+  /* a thread is not worth it for few elements */
+  constexpr INT minChunkSize = 4096;
+  const INT nChunks = std::max<INT>(std::min<INT>(MYMG(theGrid)->refineThreads,
+                                                  n/minChunkSize),1);
+
+  if (nChunks==1)
+    return(CreateSideVectors(theGrid,elements.data(),elements.data()+n));
+
+  MULTIGRID *theMG = MYMG(theGrid);
+  const INT firstId = theMG->vectorIdCounter;
+  std::vector<GRID> chunkGrids(nChunks,*theGrid);
+  std::vector<INT> error(nChunks,GM_OK);
+  std::vector<std::thread> threads;
+
+  for (GRID& chunkGrid : chunkGrids)
+    GRID_INIT_VECTOR_LIST(&chunkGrid);
+
+  auto createChunk = [&](INT chunk)
+  {
+    ELEMENT *const *first = elements.data() + ((long)n*chunk)/nChunks;
+    ELEMENT *const *last = elements.data() + ((long)n*(chunk+1))/nChunks;
+    error[chunk] = CreateSideVectors(&chunkGrids[chunk],first,last);
+  };
+  for (INT chunk=1; chunk<nChunks; chunk++)
+    threads.emplace_back(createChunk,chunk);
+  createChunk(0);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (GRID& chunkGrid : chunkGrids)
+    GRID_APPEND_VECTOR_LIST(theGrid,&chunkGrid);
+
+  for (INT chunk=0; chunk<nChunks; chunk++)
+    if (error[chunk]!=GM_OK)
+      REP_ERR_RETURN(GM_ERROR);
+
+  INT index = 0;
+  for (VECTOR *vec=PFIRSTVECTOR(theGrid); vec!=NULL; vec=SUCCVC(vec))
+  {
+    vec->id = firstId + index;
+    VINDEX(vec) = index++;
+  }
+  theMG->vectorIdCounter = firstId + index;
+
+  return(GM_OK);
 #endif
-              ASSERT(n==1);
-            }
-          }else
-          {
-            nbelem = NBELEM(elem,side);
-            ASSERT(nbelem!=NULL);
-            VECTOR* vec=SVECTOR(elem,side);
-#ifdef Debug
-            INT n=0;
+}
 #endif
-            for(j=0; j<SIDES_OF_ELEM(nbelem); j++)
-            {
-              nbvec=SVECTOR(nbelem,j);
-              ASSERT(nbvec!=NULL);
 
-              /* doubled sidevectors ? */
-              if(NBELEM(nbelem,j)==elem)
-              {
-                if(vec!=nbvec)
-                {
-                  if(DisposeVector(g,nbvec))
-                    REP_ERR_RETURN(GM_ERROR);
-                  SET_SVECTOR(nbelem,j,vec);
-                  SETVCOUNT(vec,2);                                                               /* PB, 25 Sep 2005: changed from 1 to 2 */
-                }
-              }
-            }
-#ifdef Debug
-            n++;
-#endif
-            ASSERT(n==1);
-          }
-        }
-      }
+/****************************************************************************/
+/** \brief Creates the algebra for a grid
+
+ * @param theGrid - pointer to grid
+
+   This function allocates VECTORs in all geometrical objects of the grid.
+   In 3D each element side gets one vector, shared by the two elements of
+   an inner side.
+
+ * @return <ul>
+ *   <li>    GM_OK if ok
+   </ul>
+ */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX CreateAlgebra (MULTIGRID *theMG)
+{
+  if (MG_COARSE_FIXED(theMG) == false) {
+#ifdef UG_DIM_3
+    for (INT i=0; i<=TOPLEVEL(theMG); i++) {
+      GRID *g = GRID_ON_LEVEL(theMG,i);
+
+      if (NVEC(g)>0 || !VEC_DEF_IN_OBJ_OF_GRID(g,SIDEVEC))
+        continue;                               /* skip this level */
+
+      /* side vectors */
+      if (CreateGridSideVectors(g))
+        REP_ERR_RETURN (GM_ERROR);
+    }
 #endif
     MG_COARSE_FIXED(theMG) = true;
   }
@@ -571,6 +905,71 @@ INT NS_DIM_PREFIX CreateAlgebra (MULTIGRID *theMG)
   return(GM_OK);
 }
 
+/****************************************************************************/
+/** \brief Switch the side vectors of a 3D multigrid on or off
+
+ * @param theMG - multigrid
+ * @param sideVectors - false if the element sides get no vectors
+
+   Discretizations without unknowns on the element sides do not need the
+   side vectors, which otherwise take the memory of one VECTOR per side and
+   are created, shared and classified during each refinement. Without them
+   SVECTOR is NULL for all sides, the vector classes and FINE_GRID_DOF are
+   not computed and the sides have no index. Switching them off disposes
+   the vectors of all levels, switching them on again creates them as in
+   CreateAlgebra. 2D grids never have vectors. The parallel version keeps
+   the side vectors, since they are part of the DDD element types.
+
+ * @return <ul>
+ *   <li>    GM_OK if ok </li>
+ *   <li>    GM_ERROR if out of memory or if switched off in the parallel version </li>
+   </ul>
+ */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX SetSideVectors (MULTIGRID *theMG, bool sideVectors)
+{
+  if (sideVectors == theMG->sideVectors)
+    return(GM_OK);
+
+#ifdef ModelP
+  PrintErrorMessage('E',"SetSideVectors","side vectors cannot be switched off in the parallel version");
+  RETURN(GM_ERROR);
+#else
+  theMG->sideVectors = sideVectors;
+  if (!MG_COARSE_FIXED(theMG))
+    return(GM_OK);
+
+#ifdef UG_DIM_3
+  for (INT level=0; level<=TOPLEVEL(theMG); level++)
+  {
+    GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+
+    if (sideVectors)
+    {
+      if (CreateGridSideVectors(theGrid))
+        REP_ERR_RETURN(GM_ERROR);
+      continue;
+    }
+
+    for (ELEMENT *theElement=PFIRSTELEMENT(theGrid); theElement!=NULL;
+         theElement=SUCCE(theElement))
+      for (INT i=0; i<SIDES_OF_ELEM(theElement); i++)
+        SET_SVECTOR(theElement,i,NULL);
+    while (PFIRSTVECTOR(theGrid)!=NULL)
+      if (DisposeVector(theGrid,PFIRSTVECTOR(theGrid)))
+        REP_ERR_RETURN(GM_ERROR);
+  }
+#endif
+
+  if (theMG->surfaceClassUpdate)
+    theMG->surfaceClassUpdate->incremental = false;
+  SetSurfaceClasses(theMG);
+
+  return(GM_OK);
+#endif
+}
+
 
 
 INT NS_DIM_PREFIX PrepareAlgebraModification (MULTIGRID *theMG)
@@ -86,6 +86,8 @@ INT             GetElementInfoFromSideVector    (const VECTOR *theVector, ELEMEN
 /** @name Gridwise functions */
 /*@{*/
 INT             SetSurfaceClasses                               (MULTIGRID *theMG);
+INT         SetIncrementalSurfaceClasses    (MULTIGRID *theMG, bool incremental);
+INT         SetSideVectors                  (MULTIGRID *theMG, bool sideVectors);
 INT         CreateAlgebra                               (MULTIGRID *theMG);
 /*@}*/
 
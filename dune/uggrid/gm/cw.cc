@@ -24,6 +24,7 @@
 #include <config.h>
 #include <cstring>
 #include <cstdio>
+#include <mutex>
 
 /* define this to exclude extern definition of global arrays */
 #define __COMPILE_CW__
@@ -147,6 +148,10 @@ static CONTROL_WORD control_words[MAX_CONTROL_WORDS] = {
   {MULTIGRID_STATUS_OFFSET,     CW_MGOBJ,   0b0}
 };
 
+/** \brief Guards control_words and control_entries: the tables are shared by
+    all multigrids, which may allocate control entries on several threads */
+static std::mutex controlEntryMutex;
+
 static CONTROL_ENTRY_PREDEF ce_predefines[MAX_CONTROL_ENTRIES] = {
   CE_INIT(CE_LOCKED,      VECTOR_,                VOTYPE_,                CW_VEOBJ),
   CE_INIT(CE_LOCKED,      VECTOR_,                VCOUNT_,                CW_VEOBJ),
@@ -532,6 +537,8 @@ INT NS_DIM_PREFIX AllocateControlEntry (INT cw_id, INT length, INT *ce_id)
   if ((length<0)||(length>=32)) return(GM_ERROR);
   if ((cw_id<0)||(cw_id>=MAX_CONTROL_WORDS)) return(GM_ERROR);
 
+  std::lock_guard<std::mutex> lock(controlEntryMutex);
+
   /* it is sufficient to check only the control entries control word
      multiple object types are only allowed for predefines */
   cw = control_words+cw_id;
@@ -594,6 +601,8 @@ INT NS_DIM_PREFIX FreeControlEntry (INT ce_id)
 
   /* check parameter */
   if ((ce_id<0)||(ce_id>=MAX_CONTROL_ENTRIES)) return(GM_ERROR);
+
+  std::lock_guard<std::mutex> lock(controlEntryMutex);
   ce = control_entries+ce_id;
   cw = control_words+ce->control_word;
 
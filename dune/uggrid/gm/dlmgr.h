@@ -92,6 +92,9 @@ START_UGDIM_NAMESPACE
 #define LINKX(OTYPE)     void CAT(GRID_LINKX_,OTYPE) (GRID *Grid, OTYPE *Object, INT Prio, OTYPE *After)
 #define INIT(OTYPE)      void CAT3(GRID_INIT_,OTYPE,_LIST(GRID *Grid))
 #define CHECK(OTYPE)     void CAT3(GRID_CHECK_,OTYPE,_LIST(GRID *Grid))
+#ifndef ModelP
+#define APPEND(OTYPE)    void CAT3(GRID_APPEND_,OTYPE,_LIST(GRID *Grid, GRID *Other))
+#endif
 #ifdef ModelP
 #define PRINT_LIST(OTYPE) void CAT(PRINT_LIST_STARTS_,OTYPE) (GRID *Grid, INT prios)
 #endif
@@ -101,24 +104,36 @@ LINKX(ELEMENT);
 UNLINK(ELEMENT);
 INIT(ELEMENT);
 CHECK(ELEMENT);
+#ifndef ModelP
+APPEND(ELEMENT);
+#endif
 
 LINK(NODE);
 LINKX(NODE);
 UNLINK(NODE);
 INIT(NODE);
 CHECK(NODE);
+#ifndef ModelP
+APPEND(NODE);
+#endif
 
 LINK(VERTEX);
 LINKX(VERTEX);
 UNLINK(VERTEX);
 INIT(VERTEX);
 CHECK(VERTEX);
+#ifndef ModelP
+APPEND(VERTEX);
+#endif
 
 LINK(VECTOR);
 LINKX(VECTOR);
 UNLINK(VECTOR);
 INIT(VECTOR);
 CHECK(VECTOR);
+#ifndef ModelP
+APPEND(VECTOR);
+#endif
 
 #ifdef ModelP
 PRINT_LIST(ELEMENT);
@@ -595,6 +595,25 @@ INIT(OTYPE)
 	CAT(FIRST,OTYPE(Grid)) = CAT(LAST,OTYPE(Grid)) = NULL;
 	CAT(COUNT,OTYPE(Grid)) = 0;
 }
+
+/* move all objects of Other to the end of the list of Grid */
+APPEND(OTYPE)
+{
+	if (CAT(FIRST,OTYPE(Other)) == NULL) return;
+
+	if (CAT(LAST,OTYPE(Grid)) == NULL)
+		CAT(FIRST,OTYPE(Grid)) = CAT(FIRST,OTYPE(Other));
+	else
+	{
+		SUCC(CAT(LAST,OTYPE(Grid))) = CAT(FIRST,OTYPE(Other));
+		PRED(CAT(FIRST,OTYPE(Other))) = CAT(LAST,OTYPE(Grid));
+	}
+	CAT(LAST,OTYPE(Grid)) = CAT(LAST,OTYPE(Other));
+	CAT(COUNT,OTYPE(Grid)) += CAT(COUNT,OTYPE(Other));
+
+	CAT(FIRST,OTYPE(Other)) = CAT(LAST,OTYPE(Other)) = NULL;
+	CAT(COUNT,OTYPE(Other)) = 0;
+}
 #endif
 			
 #ifdef ModelP
@@ -35,6 +35,8 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstddef>
+#include <algorithm>
+#include <vector>
 
 #include <dune/uggrid/low/architecture.h>
 #include <dune/uggrid/low/misc.h>
@@ -382,3 +384,178 @@ DOUBLE NS_DIM_PREFIX ElementVolume (const ELEMENT *elem)
 
   return (GeneralElementVolume(TAG(elem),x_co));
 }
+
+/****************************************************************************/
+/** \brief Gather the corner coordinates of elements of one tag
+
+   \param n - number of elements
+   \param theElements - elements, all with the same tag
+   \param buffer - filled with the elements and their corner coordinates
+
+   The batched geometry functions below compute the same results as their
+   per-element counterparts for all elements of the buffer.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX GatherElementCorners (INT n, ELEMENT *const *theElements, ElementCornerBuffer &buffer)
+{
+  buffer.tag = (n>0) ? TAG(theElements[0]) : -1;
+  buffer.elements.assign(theElements,theElements+n);
+
+  const INT nCorners = (n>0) ? CORNERS_OF_TAG(buffer.tag) : 0;
+  for (INT i=0; i<MAX_CORNERS_OF_ELEM; i++)
+    for (INT d=0; d<DIM; d++)
+      buffer.x[i][d].resize((i<nCorners) ? n : 0);
+
+  for (INT k=0; k<n; k++)
+  {
+    assert((INT)TAG(theElements[k])==buffer.tag);
+    for (INT i=0; i<nCorners; i++)
+    {
+      const FieldVector<DOUBLE,DIM>& x = CVECT(MYVERTEX(CORNER(theElements[k],i)));
+      for (INT d=0; d<DIM; d++)
+        buffer.x[i][d][k] = x[d];
+    }
+  }
+}
+
+/****************************************************************************/
+/** \brief Gather the corner coordinates of all elements of a grid level
+
+   \param theGrid - grid level
+   \param buffers - filled with the elements of each tag and their corners
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX GatherGridCorners (GRID *theGrid, ElementCornerBuffer buffers[TAGS])
+{
+  std::vector<ELEMENT*> elements[TAGS];
+
+  for (ELEMENT *theElement=PFIRSTELEMENT(theGrid); theElement!=NULL; theElement=SUCCE(theElement))
+    elements[TAG(theElement)].push_back(theElement);
+
+  for (INT tag=0; tag<TAGS; tag++)
+    GatherElementCorners(elements[tag].size(),elements[tag].data(),buffers[tag]);
+}
+
+/* corners of element k of a buffer */
+template<INT N>
+static inline void LoadCorners (const ElementCornerBuffer &buffer, std::size_t k, DOUBLE x[N][DIM])
+{
+  for (INT i=0; i<N; i++)
+    for (INT d=0; d<DIM; d++)
+      x[i][d] = buffer.x[i][d][k];
+}
+
+/****************************************************************************/
+/** \brief Compute the volumes of all elements of a buffer
+
+   \param buffer - corners of the elements, see GatherElementCorners
+   \param volume - filled with the result of ElementVolume for each element
+
+   There is one loop per element tag calling the volume function of the tag,
+   which the compiler can inline and vectorize.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX ElementVolumes (const ElementCornerBuffer &buffer, std::vector<DOUBLE> &volume)
+{
+  const std::size_t n = buffer.size();
+  volume.resize(n);
+
+  switch (buffer.tag)
+  {
+#               ifdef UG_DIM_2
+  case TRIANGLE :
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE x[3][DIM];
+      LoadCorners<3>(buffer,k,x);
+      volume[k] = c_tarea(x[0],x[1],x[2]);
+    }
+    break;
+
+  case QUADRILATERAL :
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE x[4][DIM];
+      LoadCorners<4>(buffer,k,x);
+      volume[k] = c_qarea(x[0],x[1],x[2],x[3]);
+    }
+    break;
+#               endif
+
+#               ifdef UG_DIM_3
+  case TETRAHEDRON :
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE x[4][DIM];
+      LoadCorners<4>(buffer,k,x);
+      volume[k] = V_te(x[0],x[1],x[2],x[3]);
+    }
+    break;
+
+  case PYRAMID :
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE x[5][DIM];
+      LoadCorners<5>(buffer,k,x);
+      volume[k] = V_py(x[0],x[1],x[2],x[3],x[4]);
+    }
+    break;
+
+  case PRISM :
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE x[6][DIM];
+      LoadCorners<6>(buffer,k,x);
+      volume[k] = V_pr(x[0],x[1],x[2],x[3],x[4],x[5]);
+    }
+    break;
+
+  case HEXAHEDRON :
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE x[8][DIM];
+      LoadCorners<8>(buffer,k,x);
+      volume[k] = V_he(x[0],x[1],x[2],x[3],x[4],x[5],x[6],x[7]);
+    }
+    break;
+#               endif
+
+  default :
+    if (n>0)
+      PrintErrorMessage('E',"ElementVolumes","unknown element");
+    std::fill(volume.begin(),volume.end(),0.0);
+  }
+}
+
+/****************************************************************************/
+/** \brief Compute the centers of mass of all elements of a buffer
+
+   \param buffer - corners of the elements, see GatherElementCorners
+   \param center - center[d] is filled with coordinate d of the result of
+                   CalculateCenterOfMass for each element
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX ElementCentersOfMass (const ElementCornerBuffer &buffer, std::vector<DOUBLE> center[DIM])
+{
+  const std::size_t n = buffer.size();
+  const INT nCorners = (n>0) ? CORNERS_OF_TAG(buffer.tag) : 0;
+
+  for (INT d=0; d<DIM; d++)
+  {
+    center[d].assign(n,0.0);
+    for (INT i=0; i<nCorners; i++)
+    {
+      const DOUBLE *x = buffer.x[i][d].data();
+      DOUBLE *c = center[d].data();
+      for (std::size_t k=0; k<n; k++)
+        c[k] += x[k];
+    }
+    const DOUBLE scale = 1.0/nCorners;
+    for (std::size_t k=0; k<n; k++)
+      center[d][k] = scale*center[d][k];
+  }
+}
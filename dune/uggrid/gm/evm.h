@@ -215,6 +215,31 @@ START_UGDIM_NAMESPACE
 #endif
 
 
+/****************************************************************************/
+/*                                                                          */
+/* data structures exported by the corresponding source file                */
+/*                                                                          */
+/****************************************************************************/
+
+/** \brief Corner coordinates of many elements of one tag, see GatherElementCorners
+
+   The coordinates are stored as one array per corner and coordinate
+   (structure of arrays), such that the batched geometry functions loop
+   over contiguous memory and can be vectorized by the compiler. */
+struct ElementCornerBuffer
+{
+  /** \brief Tag of all elements, -1 if empty */
+  INT tag = -1;
+
+  /** \brief The elements in the order of the coordinates */
+  std::vector<ELEMENT*> elements;
+
+  /** \brief x[i][d][k] is coordinate d of corner i of element k */
+  std::vector<DOUBLE> x[MAX_CORNERS_OF_ELEM][DIM];
+
+  std::size_t size () const { return elements.size(); }
+};
+
 /****************************************************************************/
 /*                                                                          */
 /* function declarations                                                    */
@@ -244,6 +269,12 @@ INT             V3_Normalize
 DOUBLE GeneralElementVolume                            (INT tag, DOUBLE *x_co[]);
 DOUBLE          ElementVolume                                           (const ELEMENT *elem);
 
+/* batched geometry of many elements of one tag */
+void            GatherElementCorners                            (INT n, ELEMENT *const *theElements, ElementCornerBuffer &buffer);
+void            GatherGridCorners                                       (GRID *theGrid, ElementCornerBuffer buffers[TAGS]);
+void            ElementVolumes                                          (const ElementCornerBuffer &buffer, std::vector<DOUBLE> &volume);
+void            ElementCentersOfMass                            (const ElementCornerBuffer &buffer, std::vector<DOUBLE> center[DIM]);
+
 END_UGDIM_NAMESPACE
 
 #endif
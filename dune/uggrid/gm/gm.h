@@ -48,13 +48,18 @@
 
 #include <climits>
 #include <cassert>
+#include <cstddef>
 #include <cstdlib>
 #include <ctime>
 #include <cmath>
 #include <memory>
 
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <array>
+#include <atomic>
+#include <mutex>
 #include <numeric>
 
 #include <dune/common/fvector.hh>
@@ -397,6 +402,14 @@ struct vector {
   /** \brief object identification, various flags */
   UINT control;
 
+#ifndef ModelP   // Dune uses ddd.gid for ids in parallel
+  /** \brief A unique and persistent, but not necessarily consecutive index
+
+      Used to implement face ids for Dune.
+   */
+  INT id;
+#endif
+
   /** \brief associated geometric object */
   union geom_object *object;
 
@@ -413,21 +426,6 @@ struct vector {
 
   /** \brief Index if the vector is part of the leaf grid */
   UINT leafIndex;
-
-#ifndef ModelP   // Dune uses ddd.gid for ids in parallel
-  /** \brief A unique and persistent, but not necessarily consecutive index
-
-      Used to implement face ids for Dune.
-   */
-  INT id;
-#endif
-
-  /** \brief User data
-   *
-   * Array of double values. This array is allocated dynamically with the
-   * size specified in the FORMAT structure.
-   */
-  DOUBLE value[1];
 };
 typedef struct vector VECTOR;
 
@@ -443,6 +441,28 @@ typedef struct vector VECTOR;
 
 /*----------- definition of structs ----------------------------------------*/
 
+#ifdef ModelP
+/** \brief Message buffer of a node or an element
+
+    Dune sends the user data of its dynamic load-balancing in these buffers.
+    They only exist during a load-balancing step, so they are kept in a table
+    keyed by the object instead of in every node and element. The table is
+    per thread: a buffer is only seen on the thread which set it.
+ */
+struct MessageBuffer {
+
+  /** \brief The message, allocated with std::malloc */
+  char* data = nullptr;
+
+  /** \brief Size of the message */
+  std::size_t size = 0;
+};
+
+const MessageBuffer& GetMessageBuffer (const void *object);
+void SetMessageBuffer (const void *object, char* data, std::size_t size);
+void FreeMessageBuffer (const void *object);
+#endif
+
 /** \brief Inner vertex data structure
  Data type storing level-independent node information
 
@@ -757,14 +777,6 @@ struct node {
   /** \brief Information if this node is on the leaf. */
   bool isLeaf;
 
-#ifdef ModelP
-  /** \brief Per-node message buffer used by Dune for dynamic load-balancing */
-  char* message_buffer_;
-
-  /** \brief Size of the `message_buffer` */
-  std::size_t message_buffer_size_;
-#endif
-
 #ifdef ModelP
   /** \brief Information about the parallelization of this object */
   DDD_HEADER ddd;
@@ -791,23 +803,19 @@ struct node {
   union vertex *myvertex;
 
 #ifdef ModelP
+  /** \brief Per-node message buffer used by Dune for dynamic load-balancing */
   const char* message_buffer() const
-    { return message_buffer_; }
+    { return GetMessageBuffer(this).data; }
 
+  /** \brief Size of the `message_buffer` */
   std::size_t message_buffer_size() const
-  { return message_buffer_size_; }
+  { return GetMessageBuffer(this).size; }
 
   void message_buffer(char* p, std::size_t size)
-  {
-    message_buffer_ = p;
-    message_buffer_size_ = size;
-  }
+  { SetMessageBuffer(this, p, size); }
 
   void message_buffer_free()
-  {
-    std::free(message_buffer_);
-    message_buffer(nullptr, 0);
-  }
+  { FreeMessageBuffer(this); }
 #endif
 };
 
@@ -1005,14 +1013,6 @@ struct generic_element {
       Controlled by DUNE */
   int leafIndex;
 
-#ifdef ModelP
-  /** \brief Per-node message buffer used by Dune for dynamic load-balancing */
-  char* message_buffer;
-
-  /** \brief Size of the `message_buffer` */
-  std::size_t message_buffer_size;
-#endif
-
 #ifdef ModelP
   /** \brief Information about the parallelization of this object */
   DDD_HEADER ddd;
@@ -1062,14 +1062,6 @@ struct triangle {
       Controlled by DUNE */
   int leafIndex;
 
-#ifdef ModelP
-  /** \brief Per-node message buffer used by Dune for dynamic load-balancing */
-  char* message_buffer;
-
-  /** \brief Size of the `message_buffer` */
-  std::size_t message_buffer_size;
-#endif
-
 #ifdef ModelP
   /** \brief Information about the parallelization of this object */
   DDD_HEADER ddd;
@@ -1135,14 +1127,6 @@ struct quadrilateral {
       Controlled by DUNE */
   int leafIndex;
 
-#ifdef ModelP
-  /** \brief Per-node message buffer used by Dune for dynamic load-balancing */
-  char* message_buffer;
-
-  /** \brief Size of the `message_buffer` */
-  std::size_t message_buffer_size;
-#endif
-
 #ifdef ModelP
   /** \brief Information about the parallelization of this object */
   DDD_HEADER ddd;
@@ -1208,14 +1192,6 @@ struct tetrahedron {
       Controlled by DUNE */
   int leafIndex;
 
-#ifdef ModelP
-  /** \brief Per-node message buffer used by Dune for dynamic load-balancing */
-  char* message_buffer;
-
-  /** \brief Size of the `message_buffer` */
-  std::size_t message_buffer_size;
-#endif
-
 #ifdef ModelP
 
   /** \brief Information about the parallelization of this element */
@@ -1287,14 +1263,6 @@ struct pyramid {
       Controlled by DUNE */
   int leafIndex;
 
-#ifdef ModelP
-  /** \brief Per-node message buffer used by Dune for dynamic load-balancing */
-  char* message_buffer;
-
-  /** \brief Size of the `message_buffer` */
-  std::size_t message_buffer_size;
-#endif
-
 #ifdef ModelP
   /** \brief Information about the parallelization of this element */
   DDD_HEADER ddd;
@@ -1364,14 +1332,6 @@ struct prism {
       Controlled by DUNE */
   int leafIndex;
 
-#ifdef ModelP
-  /** \brief Per-node message buffer used by Dune for dynamic load-balancing */
-  char* message_buffer;
-
-  /** \brief Size of the `message_buffer` */
-  std::size_t message_buffer_size;
-#endif
-
 #ifdef ModelP
   /** \brief Information about the parallelization of this element */
   DDD_HEADER ddd;
@@ -1441,14 +1401,6 @@ struct hexahedron {
       Controlled by DUNE */
   int leafIndex;
 
-#ifdef ModelP
-  /** \brief Per-node message buffer used by Dune for dynamic load-balancing */
-  char* message_buffer;
-
-  /** \brief Size of the `message_buffer` */
-  std::size_t message_buffer_size;
-#endif
-
 #ifdef ModelP
   /** \brief Information about the parallelization of this element */
   DDD_HEADER ddd;
@@ -1612,23 +1564,19 @@ union element {
         #endif
 
 #ifdef ModelP
+  /** \brief Per-element message buffer used by Dune for dynamic load-balancing */
   const char* message_buffer() const
-    { return ge.message_buffer; }
+    { return GetMessageBuffer(this).data; }
 
+  /** \brief Size of the `message_buffer` */
   std::size_t message_buffer_size() const
-  { return ge.message_buffer_size; }
+  { return GetMessageBuffer(this).size; }
 
   void message_buffer(char* p, std::size_t size)
-  {
-    ge.message_buffer = p;
-    ge.message_buffer_size = size;
-  }
+  { SetMessageBuffer(this, p, size); }
 
   void message_buffer_free()
-  {
-    std::free(ge.message_buffer);
-    message_buffer(nullptr, 0);
-  }
+  { FreeMessageBuffer(this); }
 #endif
 };
 
@@ -1652,6 +1600,31 @@ union object_with_key {
   struct edge edge;
 };
 
+/* There is one of these objects per entity of a grid, so their fields are
+   ordered without padding. Maximal sizes in bytes on 64-bit platforms: */
+#ifdef ModelP
+static_assert(sizeof(void*) != 8 || sizeof(struct vector) <= 64, "struct vector has grown");
+static_assert(sizeof(void*) != 8 || sizeof(struct node) <= 88, "struct node has grown");
+static_assert(sizeof(void*) != 8 || sizeof(struct edge) <= (DIM==2 ? 120 : 104), "struct edge has grown");
+static_assert(sizeof(void*) != 8 || offsetof(struct generic_element,refs) <= 72, "struct generic_element has grown");
+#else
+static_assert(sizeof(void*) != 8 || sizeof(struct vector) <= 40, "struct vector has grown");
+static_assert(sizeof(void*) != 8 || sizeof(struct node) <= 64, "struct node has grown");
+static_assert(sizeof(void*) != 8 || sizeof(struct edge) <= (DIM==2 ? 96 : 80), "struct edge has grown");
+static_assert(sizeof(void*) != 8 || offsetof(struct generic_element,refs) <= 40, "struct generic_element has grown");
+#endif
+
+/* the element specific parts start at generic_element::refs */
+#ifdef UG_DIM_2
+static_assert(offsetof(struct triangle,n) == offsetof(struct generic_element,refs), "element corners must start at refs");
+static_assert(offsetof(struct quadrilateral,n) == offsetof(struct generic_element,refs), "element corners must start at refs");
+#else
+static_assert(offsetof(struct tetrahedron,n) == offsetof(struct generic_element,refs), "element corners must start at refs");
+static_assert(offsetof(struct pyramid,n) == offsetof(struct generic_element,refs), "element corners must start at refs");
+static_assert(offsetof(struct prism,n) == offsetof(struct generic_element,refs), "element corners must start at refs");
+static_assert(offsetof(struct hexahedron,n) == offsetof(struct generic_element,refs), "element corners must start at refs");
+#endif
+
 typedef struct
 {
   UINT VecReserv[MAXVECTORS][MAX_NDOF_MOD_32];
@@ -1699,6 +1672,10 @@ struct grid {
   /** \brief Number of vectors on this grid level */
   INT nVector[NS_DIM_PREFIX MAX_PRIOS];
 
+  /** \brief Number of vectors with FINE_GRID_DOF, kept by SetSurfaceClasses
+      and DisposeVector for SetIncrementalSurfaceClasses */
+  INT nFineDof;
+
   DATA_STATUS data_status;          /* memory management for vectors|matrix */
                                     /* status for consistent and collect    */
   /* pointers */
@@ -1722,6 +1699,270 @@ struct grid {
 #endif
 };
 
+/** \brief Consecutive indices of one kind of objects, see EnableIndexMaintenance
+
+Disposing an object releases its index, new objects get an index at the end.
+CompactIndices moves the objects with the largest indices into the released
+ones, the moves are kept until the next compaction.
+*/
+struct IndexSlots {
+
+  /** \brief Object of each index, nullptr for a released index */
+  std::vector<void*> objects;
+
+  /** \brief Released indices, filled by the next compaction */
+  std::vector<INT> released;
+
+  /** \brief Number of indices after the previous compaction */
+  INT previousSize = 0;
+
+  /** \brief Index moves (old index, new index) of the last compaction.
+
+     Applied in order, they compact a data vector with previousSize entries.
+     The objects created since the previous compaction are those moved from an
+     index not smaller than previousSize, and those not moved with such an index.
+   */
+  std::vector<std::pair<INT,INT> > moves;
+};
+
+/** \brief Level and leaf indices maintained by AdaptMultiGrid, see EnableIndexMaintenance */
+struct IndexMaintenance {
+
+  /** \brief Level indices of the objects of one grid level */
+  struct Level {
+
+    /** \brief levelIndex of the nodes */
+    IndexSlots nodes;
+
+    /** \brief levelIndex of the edges */
+    IndexSlots edges;
+
+    /** \brief levelIndex of the elements, per tag */
+    std::vector<IndexSlots> elements;
+  };
+
+  /** \brief Level indices per grid level */
+  std::vector<Level> levels;
+
+  /** \brief leafIndex of the vertices */
+  IndexSlots leafVertices;
+
+  /** \brief leafIndex of the elements without sons, per tag */
+  std::vector<IndexSlots> leafElements;
+};
+
+/** \brief Objects changed by the last AdaptMultiGrid, see SetChangeSetRecording */
+struct ChangeSet {
+
+  /** \brief Elements which got new sons, their former sons are disposed */
+  std::vector<union element*> refinedElements;
+
+  /** \brief Elements which lost their sons and got no new ones */
+  std::vector<union element*> coarsenedElements;
+
+  /** \brief New nodes, sorted by id */
+  std::vector<struct node*> newNodes;
+
+  /** \brief New vertices, sorted by id */
+  std::vector<union vertex*> newVertices;
+
+  /** \brief New edges, sorted by id */
+  std::vector<struct edge*> newEdges;
+
+  /** \brief Ids of the disposed elements, nodes, vertices and edges */
+  std::vector<INT> deletedElements;
+  std::vector<INT> deletedNodes;
+  std::vector<INT> deletedVertices;
+  std::vector<INT> deletedEdges;
+
+  /** \brief Objects with at least these ids are new */
+  INT firstNodeId = 0;
+  INT firstVertexId = 0;
+  INT firstEdgeId = 0;
+};
+
+/** \brief Sons of the elements with sons in one array, see SetSonTable */
+struct SonTable {
+
+  /** \brief Position of the sons of an element in sons */
+  struct Entry {
+    INT first = 0;
+
+    /** \brief Number of the sons returned by GetSons */
+    INT count = 0;
+
+    /** \brief Number of the sons returned by GetAllSons, which follow them */
+    INT allCount = 0;
+  };
+
+  /** \brief Entry of each element with sons */
+  std::unordered_map<const union element*,Entry> entries;
+
+  /** \brief Sons of the elements, those of one element one after the other */
+  std::vector<union element*> sons;
+
+  /** \brief Number of sons no longer referenced by an entry */
+  std::size_t unused = 0;
+
+  /** \brief Elements whose sons changed since the last update, their
+      entries are not used, see SonsChanged */
+  std::unordered_set<const union element*> changed;
+
+  /** \brief Cleared while AdaptMultiGrid changes the sons */
+  bool valid = true;
+};
+
+/** \brief Boundary vertices of a refinement step whose positions are
+    evaluated at once, see SetBoundaryBatching */
+struct BoundaryBatch {
+
+  /** \brief Guards the lists against the refine threads */
+  std::mutex mutex;
+
+  /** \brief New vertices on edges and sides of the boundary */
+  std::vector<union vertex*> vertices;
+
+  /** \brief New center vertices of boundary elements, they are moved
+      with the vertices on their edges */
+  std::vector<union vertex*> centerVertices;
+};
+
+/** \brief Bounding boxes of the element trees for point location,
+    see SetSearchIndex */
+struct SearchIndex {
+
+  /** \brief Axis-aligned bounding box */
+  struct Box {
+    std::array<DOUBLE,DIM> lower;
+    std::array<DOUBLE,DIM> upper;
+  };
+
+  /** \brief Node of the bounding volume hierarchy over the elements of
+      level 0, a leaf if entry is not -1 */
+  struct Node {
+    Box box;
+    INT left = -1;
+    INT right = -1;
+
+    /** \brief Entry of the level 0 element of a leaf */
+    INT entry = -1;
+  };
+
+  /** \brief Element with the box of the element and all its descendants */
+  struct Entry {
+    Box box;
+    union element *element;
+
+    /** \brief Entry after the descendants, the sons come first */
+    INT end;
+  };
+
+  /** \brief Element trees in pre-order, one after the other in the order of
+      the leaves of the hierarchy */
+  std::vector<Entry> entries;
+
+  /** \brief Hierarchy with the root at 0, the children of a node come after it */
+  std::vector<Node> nodes;
+
+  /** \brief Elements whose sons changed in the current AdaptMultiGrid */
+  std::vector<union element*> changed;
+
+  /** \brief Margin of the boxes, relative to the size of the domain */
+  DOUBLE tolerance = 0.0;
+
+  /** \brief The boxes are valid before the current AdaptMultiGrid and
+      are updated from the changed elements only */
+  bool incremental = false;
+
+  /** \brief Cleared when an element is created or disposed */
+  std::atomic<bool> valid = false;
+};
+
+/** \brief Neighbourhoods of the elements changed by AdaptMultiGrid,
+    whose vector classes are recomputed, see SetIncrementalSurfaceClasses */
+struct SurfaceClassUpdate {
+
+  /** \brief Elements whose refinement changed in the current AdaptMultiGrid */
+  std::vector<union element*> changed;
+
+  /** \brief Elements of level 0 at each of their corners */
+  std::unordered_map<const struct node*,std::vector<union element*> > coarseStars;
+
+  /** \brief Top level when the classes were computed the last time */
+  INT topLevel = -1;
+
+  /** \brief The classes are valid before the current AdaptMultiGrid and
+      are updated around the changed elements only */
+  bool incremental = false;
+
+  /** \brief Cleared when an element is created or disposed */
+  std::atomic<bool> valid = false;
+};
+
+/** \brief Number of AdaptMultiGrid calls kept in the refine info */
+#define RINFO_MAX                                               100
+
+/** \brief Estimated and real element counts of the last calls to
+    AdaptMultiGrid, see REFINEINFO */
+struct refineinfo
+{
+  INT step;                                               /* count of calls to AdaptMultiGrid   */
+  float markcount[RINFO_MAX];             /* count of currently marked elements */
+  float predicted_new[RINFO_MAX][3];
+  /* count of elements, would be created */
+  float real[RINFO_MAX];                      /* count of elements before refinement */
+};
+
+/** \brief State of the refinement of a multigrid, set up by AdaptMultiGrid
+    and EstimateRefinement */
+struct RefineState {
+
+  /** \brief type of refinement                   */
+  int rFlag = 0;
+
+  /** \brief refine with hanging nodes?		*/
+  int hFlag = 0;
+
+  /** \brief use fifo? 0=no 1=yes				*/
+  int fifoFlag = 0;
+
+  /** \brief elements to visit in the next fifo loop   */
+  std::vector<union element*> fifoInsertList;
+
+  /** \brief elements in fifoInsertList                 */
+  std::unordered_set<const union element*> fifoQueued;
+
+  /** \brief Counter for green refinements doesn't need to be updated */
+  INT No_Green_Update = 0;
+
+  /** \brief green refined element counter	*/
+  INT Green_Marks = 0;
+
+  /** \brief 0/1: do/do not parallel part		*/
+  INT refine_seq = 0;
+
+  /** \brief counter for FIFO loops			*/
+  INT fifoloop = 0;
+
+  /** \brief count of adapted elements        */
+  INT total_adapted = 0;
+};
+
+/** \brief Range of the sons of an element, see GetSonRange */
+struct SonRange {
+
+  /** \brief Sons in the son table, nullptr if they are in buffer */
+  union element *const *first = nullptr;
+  INT count = 0;
+
+  /** \brief Sons collected if they are not stored in a son table */
+  std::array<union element*,MAX_SONS> buffer;
+
+  union element *const *begin () const { return first!=nullptr ? first : buffer.data(); }
+  union element *const *end () const { return begin()+count; }
+  INT size () const { return count; }
+};
+
 /** \brief Data type representing a complete multigrid structure
 
 Data type providing access to all information about the complete
@@ -1746,20 +1987,20 @@ struct multigrid {
   INT magic_cookie;
 
   /** \brief count objects in that multigrid              */
-  INT vertIdCounter;
+  std::atomic<INT> vertIdCounter;
 
   /** \brief count objects in that multigrid              */
-  INT nodeIdCounter;
+  std::atomic<INT> nodeIdCounter;
 
   /** \brief count objects in that multigrid              */
-  INT elemIdCounter;
+  std::atomic<INT> elemIdCounter;
 
   /** \brief count objects in that multigrid              */
-  INT edgeIdCounter;
+  std::atomic<INT> edgeIdCounter;
 
 #ifndef ModelP
   /** \brief Count vector objects in that multigrid   */
-  INT vectorIdCounter;
+  std::atomic<INT> vectorIdCounter;
 #endif
 
   /** \brief Finest grid level currently allocated in the MULTIGRID */
@@ -1768,6 +2009,45 @@ struct multigrid {
   /** \brief last level with complete surface     */
   INT fullrefineLevel;
 
+  /** \brief Number of threads refining the elements of a grid level and
+      computing its closure, see SetRefineThreads */
+  INT refineThreads = 1;
+
+  /** \brief False if the element sides of a 3D multigrid have no vectors,
+      see SetSideVectors */
+  bool sideVectors = true;
+
+  /** \brief Flags and work lists of the current refinement */
+  RefineState refineState;
+
+  /** \brief Element counts of the last refinements, see REFINEINFO,
+      also updated by MultiGridStatus */
+  mutable struct refineinfo refineInfo = {};
+
+  /** \brief Level and leaf indices kept up to date by AdaptMultiGrid,
+      nullptr if they are controlled by DUNE, see EnableIndexMaintenance */
+  std::unique_ptr<IndexMaintenance> indexMaintenance;
+
+  /** \brief Objects changed by the last AdaptMultiGrid,
+      nullptr if not recorded, see SetChangeSetRecording */
+  std::unique_ptr<ChangeSet> changeSet;
+
+  /** \brief Sons of the elements with sons,
+      nullptr if not stored, see SetSonTable */
+  std::unique_ptr<SonTable> sonTable;
+
+  /** \brief Boundary vertices waiting for their positions,
+      nullptr if evaluated one by one, see SetBoundaryBatching */
+  std::unique_ptr<BoundaryBatch> boundaryBatch;
+
+  /** \brief Bounding boxes for point location updated by AdaptMultiGrid,
+      nullptr if not stored, see SetSearchIndex */
+  std::unique_ptr<SearchIndex> searchIndex;
+
+  /** \brief Changed elements of the last AdaptMultiGrid for SetSurfaceClasses,
+      nullptr if the classes are computed on all levels, see SetIncrementalSurfaceClasses */
+  std::unique_ptr<SurfaceClassUpdate> surfaceClassUpdate;
+
   /** \brief pointer to BndValProblem                             */
   STD_BVP *theBVP;
 
@@ -2840,7 +3120,7 @@ START_UGDIM_NAMESPACE
 #define NE(p)                           ((p)->nEdge)
 #define NS(p)                           ((p)->nSide)
 #ifdef UG_DIM_3
-#define VEC_DEF_IN_OBJ_OF_GRID(p,tp)     (true)   // 3d grids have side vectors
+#define VEC_DEF_IN_OBJ_OF_GRID(p,tp)     (MYMG(p)->sideVectors)   // 3d grids have side vectors unless switched off
 #else
 #define VEC_DEF_IN_OBJ_OF_GRID(p,tp)     (false)  // 2d grids have no vectors at all
 #endif
@@ -2893,7 +3173,7 @@ grid::dddContext()
 #define GRID_ON_LEVEL(p,i)              ((p)->grids[i])
 #define MGNAME(p)                               ((p)->v.name)
 #ifdef UG_DIM_3
-#define VEC_DEF_IN_OBJ_OF_MG(p,tp)     (true)   // 3d grids have side vectors
+#define VEC_DEF_IN_OBJ_OF_MG(p,tp)     ((p)->sideVectors)   // 3d grids have side vectors unless switched off
 #else
 #define VEC_DEF_IN_OBJ_OF_MG(p,tp)     (false)  // 2d grids have no vectors at all
 #endif
@@ -2961,7 +3241,8 @@ MULTIGRID               *GetNextMultigrid                       (const MULTIGRID
 MULTIGRID *CreateMultiGrid (char *MultigridName, STD_BVP *theBVP,
                             const char *format,
                             INT optimizedIE, INT insertMesh,
-                            std::shared_ptr<PPIF::PPIFContext> ppifContext = nullptr);
+                            std::shared_ptr<PPIF::PPIFContext> ppifContext = nullptr,
+                            bool distributedCoarseGrid = false);
 MULTIGRID *OpenMGFromDataFile(MULTIGRID *theMG, INT number, char *type,
                               char *DataFileName, NS_PREFIX MEM heapSize);
 INT         DisposeGrid             (GRID *theGrid);
@@ -2981,9 +3262,16 @@ INT             DeleteElement                   (MULTIGRID *theMG, ELEMENT *theE
 /** \todo !!! should be moved to rm.h [Thimo] */
 INT             EstimateHere                    (const ELEMENT *theElement);
 INT         MarkForRefinement       (ELEMENT *theElement, enum RefinementRule rule, INT data);
+INT         MarkElements            (MULTIGRID *theMG, INT n, ELEMENT **theElements, const enum RefinementRule *rules);
+INT         MarkElementsByIndicator (MULTIGRID *theMG, INT n, ELEMENT **theElements, const DOUBLE *indicator, DOUBLE refineThreshold, DOUBLE coarsenThreshold);
 INT             GetRefinementMark               (ELEMENT *theElement, INT *rule, void *data);
 INT             GetRefinementMarkType   (ELEMENT *theElement);
 INT             AdaptMultiGrid                  (MULTIGRID *theMG, INT flag, INT seq, INT mgtest);
+INT         SetRefineThreads        (MULTIGRID *theMG, INT nThreads);
+INT         SetChangeSetRecording   (MULTIGRID *theMG, bool record);
+INT         SetSonTable             (MULTIGRID *theMG, bool store);
+INT         SetBoundaryBatching     (MULTIGRID *theMG, bool batch);
+INT         SetSearchIndex          (MULTIGRID *theMG, bool index);
 INT         SetRefineInfo           (MULTIGRID *theMG);
 
 
@@ -3017,6 +3305,16 @@ EDGE            *FatherEdge                             (NODE **SideNodes, INT n
 #endif
 EDGE            *GetEdge                                (const NODE *from, const NODE *to);
 INT             GetSons                                 (const ELEMENT *theElement, ELEMENT *SonList[MAX_SONS]);
+SonRange        GetSonRange                             (const MULTIGRID *theMG, const ELEMENT *theElement);
+#ifdef ModelP
+SonRange        GetAllSonRange                  (const MULTIGRID *theMG, const ELEMENT *theElement);
+#endif
+void            SonsChanged                             (MULTIGRID *theMG, const ELEMENT *theFather);
+void            SonTableDisposeElement  (MULTIGRID *theMG, const ELEMENT *theElement);
+void            UpdateSonTable                  (MULTIGRID *theMG);
+ELEMENT         *FindLeafElement                (const MULTIGRID *theMG, const FieldVector<DOUBLE,DIM>& global, FieldVector<DOUBLE,DIM> *local);
+INT             FindLeafElements                (const MULTIGRID *theMG, INT n, const FieldVector<DOUBLE,DIM> *global, ELEMENT **theElements);
+INT             FindNearestLeafElements (const MULTIGRID *theMG, const FieldVector<DOUBLE,DIM>& global, INT k, ELEMENT **theElements);
 #ifdef ModelP
 INT             GetAllSons                              (const ELEMENT *theElement, ELEMENT *SonList[MAX_SONS]);
 #endif
@@ -3043,7 +3341,7 @@ INT         SetEdgeSubdomainFromElements        (GRID *theGrid);
 INT         SetSubdomainIDfromBndInfo           (MULTIGRID *theMG);
 INT         FixCoarseGrid                       (MULTIGRID *theMG);
 INT                     ClearMultiGridUsedFlags                         (MULTIGRID *theMG, INT FromLevel, INT ToLevel, INT mask);
-void            CalculateCenterOfMass                           (ELEMENT *theElement, DOUBLE_VECTOR center_of_mass);
+void            CalculateCenterOfMass                           (ELEMENT *theElement, DOUBLE_VECTOR& center_of_mass);
 INT             KeyForObject                                            (KEY_OBJECT *obj);
 
 /** \todo remove the following functions after the code will never need any debugging */
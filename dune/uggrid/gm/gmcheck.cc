@@ -41,6 +41,7 @@
 #include <cmath>
 #include <cassert>
 #include <errno.h>
+#include <vector>
 
 #include <dune/uggrid/low/debug.h>
 #include <dune/uggrid/low/fifo.h>
@@ -1433,6 +1434,91 @@ INT CheckSubdomains (MULTIGRID *theMG)
 }
 #endif
 
+/* volumes and degenerate sides of the elements and the local coordinates
+   of the vertices in their fathers, computed for all elements of a tag at once */
+static INT CheckElementGeometry (GRID *theGrid)
+{
+  ElementCornerBuffer buffers[TAGS];
+  std::vector<DOUBLE> volume;
+  INT errors = 0;
+
+  GatherGridCorners(theGrid,buffers);
+  for (const ElementCornerBuffer& buffer : buffers)
+  {
+    ElementVolumes(buffer,volume);
+    for (std::size_t k=0; k<buffer.size(); k++)
+      if (!(volume[k]>0.0))
+      {
+        errors++;
+        UserWriteF("ELEM=" EID_FMTX " has volume %g\n",
+                   EID_PRTX(buffer.elements[k]),volume[k]);
+      }
+  }
+
+#ifdef UG_DIM_3
+  {
+    const ElementCornerBuffer& buffer = buffers[TETRAHEDRON];
+    std::vector<DOUBLE> normals[MAX_SIDES_OF_ELEM][DIM];
+    std::vector<INT> error;
+    TetrahedraSideNormals(buffer,normals,error);
+    for (std::size_t k=0; k<buffer.size(); k++)
+      if (error[k])
+      {
+        errors++;
+        UserWriteF("ELEM=" EID_FMTX " has a degenerate side\n",
+                   EID_PRTX(buffer.elements[k]));
+      }
+  }
+#endif
+
+  /* the vertices with a master father, grouped by the tag of the father */
+  std::vector<VERTEX*> vertices[TAGS];
+  std::vector<ELEMENT*> fathers[TAGS];
+  for (VERTEX *theVertex=PFIRSTVERTEX(theGrid); theVertex!=NULL; theVertex=SUCCV(theVertex))
+  {
+    ELEMENT *theFather = VFATHER(theVertex);
+    if (theFather==NULL || !EMASTER(theFather))
+      continue;
+    vertices[TAG(theFather)].push_back(theVertex);
+    fathers[TAG(theFather)].push_back(theFather);
+  }
+
+  for (INT tag=0; tag<TAGS; tag++)
+  {
+    const std::size_t n = vertices[tag].size();
+    ElementCornerBuffer buffer;
+    std::vector<DOUBLE> global[DIM], local[DIM];
+    std::vector<INT> error;
+
+    GatherElementCorners(n,fathers[tag].data(),buffer);
+    for (INT d=0; d<DIM; d++)
+    {
+      global[d].resize(n);
+      for (std::size_t k=0; k<n; k++)
+        global[d][k] = CVECT(vertices[tag][k])[d];
+    }
+    ElementsGlobalToLocal(buffer,global,local,error);
+
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE_VECTOR localCoord;
+      DOUBLE diff;
+      for (INT d=0; d<DIM; d++)
+        localCoord[d] = local[d][k];
+      V_DIM_EUKLIDNORM_OF_DIFF(localCoord,LCVECT(vertices[tag][k]),diff);
+      if (error[k]==0 && diff<=MAX_PAR_DIST)
+        continue;
+
+      errors++;
+      UserWriteF("vertex=" VID_FMTX " VFATHER=" EID_FMTX
+                 " local coordinates don't match the global ones in the father\n",
+                 VID_PRTX(vertices[tag][k]),EID_PRTX(fathers[tag][k]));
+    }
+  }
+
+  return(errors);
+}
+
 static INT CheckGeometry (GRID *theGrid)
 {
   NODE *theNode;
@@ -1722,6 +1808,8 @@ static INT CheckGeometry (GRID *theGrid)
                (long)NT(theGrid));
   }
 
+  errors += CheckElementGeometry(theGrid);
+
   return(errors);
 }
 
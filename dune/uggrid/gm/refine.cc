@@ -68,6 +68,14 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 /* low module */
 #include <dune/uggrid/low/debug.h>
@@ -257,6 +265,9 @@ using namespace PPIF;
   }
 /*@}*/
 
+/** \brief state of the refinement of the multigrid of a grid */
+#define REFINE_STATE(grid)      (MYMG(grid)->refineState)
+
 #define REFINE_CONTEXT_LIST(d,context)                                       \
   IFDEBUG(gm,2)                                                            \
   {                                                                        \
@@ -309,9 +320,6 @@ typedef NODE *ELEMENTCONTEXT[MAX_CORNERS_OF_ELEM+MAX_NEW_CORNERS_DIM];
 /*                                                                          */
 /****************************************************************************/
 
-/* information used by the estimator and refine*/
-REFINEINFO NS_DIM_PREFIX refine_info;
-
 #ifdef ModelP
 /* control words for identiftication of new nodes and edges */
 INT NS_DIM_PREFIX ce_NEW_NIDENT;
@@ -324,48 +332,6 @@ INT NS_DIM_PREFIX ce_NEW_EDIDENT;
 /*																			*/
 /****************************************************************************/
 
-/** \brief type of refinement                   */
-static int rFlag=GM_REFINE_TRULY_LOCAL;
-
-/** \brief refine with hanging nodes?		*/
-static int hFlag=0;
-
-/** \brief use fifo? 0=no 1=yes				*/
-static int fifoFlag=0;
-
-/** \brief fifo loop counter                            */
-static int first;
-
-/** \brief first element in fifo work list	*/
-static ELEMENT *fifo_first=NULL;
-
-/** \brief last element in fifo	work list	*/
-static ELEMENT *fifo_last=NULL;
-
-/** \brief first element in fifo insertlist */
-static ELEMENT *fifo_insertfirst=NULL;
-
-/** \brief last element in fifo insertlist	*/
-static ELEMENT *fifo_insertlast=NULL;
-
-/** \brief first element to consider for next loop   */
-static ELEMENT *firstElement=NULL;
-
-/** \brief Counter for green refinements doesn't need to be updated */
-static INT No_Green_Update;
-
-/** \brief green refined element counter	*/
-static INT Green_Marks;
-
-/** \brief 0/1: do/do not parallel part		*/
-static INT refine_seq = 0;
-
-/** \brief counter for FIFO loops			*/
-static INT fifoloop = 0;
-
-/** \brief count of adapted elements        */
-static INT total_adapted = 0;
-
 #ifdef STAT_OUT
 /* timing variables */
 static int adapt_timer,closure_timer,gridadapt_timer,gridadapti_timer;
@@ -473,26 +439,51 @@ static INT DropMarks (MULTIGRID *theMG)
  */
 /****************************************************************************/
 
-static INT InitClosureFIFO (void)
+static INT InitClosureFIFO (GRID *theGrid)
 {
-  fifo_first=fifo_last=fifo_insertfirst=fifo_insertlast=NULL;
-  first = 1;
-  fifoloop = 0;
-  if (0) UserWriteF("Using FIFO: loop %d\n",fifoloop);
+  RefineState& theState = REFINE_STATE(theGrid);
+
+  theState.fifoInsertList.clear();
+  theState.fifoQueued.clear();
+  theState.fifoloop = 0;
+  if (0) UserWriteF("Using FIFO: loop %d\n",theState.fifoloop);
 
   return (GM_OK);
 }
 
 
+#ifdef UG_DIM_2
+/****************************************************************************/
+/** \brief Add an element to the closure FIFO
+
+   \param theMG - multigrid of the element
+   \param theElement - element to visit in the next fifo loop
+
+   An element is added only once per fifo loop.
+ */
+/****************************************************************************/
+
+static void AddToClosureFIFO (MULTIGRID *theMG, ELEMENT *theElement)
+{
+  PRINTDEBUG(gm,1,("   ADDING to FIFO: NBID=%d\n",ID(theElement)))
+
+  RefineState& theState = theMG->refineState;
+  if (theState.fifoQueued.insert(theElement).second)
+    theState.fifoInsertList.push_back(theElement);
+}
+#endif
+
+
 /****************************************************************************/
 /** \brief Function for realizing the (parallel) closure FIFO
 
-   \param  theGrid - pointer to grid structure
-   .  theElement
-   .  thePattern
-   .  NewPattern
+   \param theGrid - grid level of the element
+   \param theElement - element whose rule has been set
+   \param thePattern - pattern of the element before
+   \param NewPattern - pattern of the rule of the element
 
-   DESCRIPTION:
+   The edges refined by the new rule are marked and the elements sharing
+   them are added to the closure FIFO.
 
  */
 /****************************************************************************/
@@ -523,29 +514,7 @@ static INT UpdateFIFOLists (GRID *theGrid, ELEMENT *theElement, INT thePattern,
 
         if (NbElement==NULL) continue;
 
-        PRINTDEBUG(gm,1,("   ADDING to FIFO: NBID=%d\n",
-                         ID(NbElement)))
-
-        /* unlink element from element list */
-        if (PREDE(NbElement) != NULL)
-          SUCCE(PREDE(NbElement)) = SUCCE(NbElement);
-        if (SUCCE(NbElement) != NULL)
-          PREDE(SUCCE(NbElement)) = PREDE(NbElement);
-        if (FIRSTELEMENT(theGrid) == NbElement)
-          FIRSTELEMENT(theGrid) = SUCCE(NbElement);
-
-        SUCCE(NbElement) = PREDE(NbElement) = NULL;
-        /* insert into fifo */
-        if (fifo_insertfirst == NULL)
-        {
-          fifo_insertfirst = fifo_insertlast = NbElement;
-        }
-        else
-        {
-          SUCCE(fifo_insertlast) = NbElement;
-          PREDE(NbElement) = fifo_insertlast;
-          fifo_insertlast = NbElement;
-        }
+        AddToClosureFIFO(MYMG(theGrid),NbElement);
       }
 
       if (EDGE_IN_PAT(thePattern,j) &&
@@ -574,92 +543,41 @@ static INT UpdateFIFOLists (GRID *theGrid, ELEMENT *theElement, INT thePattern,
 /** \brief Function for realizing the (parallel) closure FIFO
 
    \param theGrid - pointer to grid structure
+   \param workList - elements to visit in the next fifo loop
 
- */
-/****************************************************************************/
-
-static INT UpdateClosureFIFO (GRID *theGrid)
-{
-  /* insert fifo work list into elementlist */
-  for (ELEMENT *theElement = fifo_last; theElement != nullptr;
-       theElement=PREDE(theElement))
-  {
-    SUCCE(theElement) = FIRSTELEMENT(theGrid);
-    PREDE(FIRSTELEMENT(theGrid)) = theElement;
-    FIRSTELEMENT(theGrid) = theElement;
-  }
-
-  PREDE(FIRSTELEMENT(theGrid)) = NULL;
-
-  if (fifo_insertfirst != NULL)
-  {
-    /* append fifo insert list to fifo work list */
-    firstElement = fifo_first = fifo_insertfirst;
-    fifo_last = fifo_insertlast;
-
-    IFDEBUG(gm,2)
-    UserWriteF(" FIFO Queue:");
-    for (ELEMENT *theElement = fifo_first; theElement != nullptr;
-         theElement=SUCCE(theElement))
-      UserWriteF(" %d\n", ID(theElement));
-    ENDDEBUG
-
-      fifo_insertfirst = fifo_insertlast = NULL;
-    first = 0;
-    fifoloop++;
-    UserWriteF(" loop %d",fifoloop);
-    return(1);
-  }
-
-  return(0);
-}
-
-
-/****************************************************************************/
-/*
-   ManageParallelFIFO - function for realizing the (parallel) closure FIFO
-
-   SYNOPSIS:
-   static INT ManageParallelFIFO (ELEMENT *firstElement);
-
-   PARAMETERS:
-   \param firstElement
-
-   DESCRIPTION:
+   The elements added to the FIFO in this loop become the work list of the
+   next loop. In the parallel case the loop continues as long as one
+   processor has elements to visit, since the closure information is
+   exchanged in each loop.
 
    \return <ul>
-   INT
+   .n   1 if there is a next fifo loop
+   .n   0 if the closure is done
  */
 /****************************************************************************/
 
-static INT ManageParallelFIFO (const PPIF::PPIFContext& context, const ELEMENT *firstElement)
+static INT UpdateClosureFIFO (GRID *theGrid, std::vector<ELEMENT*>& workList)
 {
-#if defined(FIFO) && defined(ModelP)
-  if (context.procs() == 1) return(0);
+  RefineState& theState = REFINE_STATE(theGrid);
+  INT nInsert = theState.fifoInsertList.size();
+        #ifdef ModelP
+  nInsert = UG_GlobalMaxINT(theGrid->ppifContext(), nInsert);
+        #endif
+  if (nInsert == 0) return(0);
 
-  do
-  {
-    /* exchange FIFO flag and PATTERN from slaves to master */
-    IF_FIF0AndPat_S2M(GLEVEL(grid));
+  workList.clear();
+  std::swap(workList,theState.fifoInsertList);
+  theState.fifoQueued.clear();
 
-    /* add all master elements of horizontal interface to FIFO */
-    for (ELEMENT *theElement = firstElement; theElement != nullptr;
-         theElement=SUCCE(theElement))
-    {
-      if (IS_HOR_MASTER(theElement) && FIFO(theElement))
-      {
-        AddToFIFIO(theElement);
-        SETFIFO(theElement,0);
-      }
-    }
+  IFDEBUG(gm,2)
+  UserWriteF(" FIFO Queue:");
+  for (ELEMENT *theElement : workList)
+    UserWriteF(" %d\n", ID(theElement));
+  ENDDEBUG
 
-    /* check condition for termination of pattern adaptation */
-    AllFIFOsEmpty = CheckGlobalFIFOStatus(fifo);
-  }
-  while (fifo==NULL && AllFIFOsEmpty==1);
-#else
-  return (0);
-#endif
+  theState.fifoloop++;
+  UserWriteF(" loop %d",theState.fifoloop);
+  return(1);
 }
 
 /****************************************************************************/
@@ -803,7 +721,7 @@ static int Gather_ElementClosureInfo (DDD::DDDContext&, DDD_OBJ obj, void *data,
  */
 /****************************************************************************/
 
-static int Scatter_ElementClosureInfo (DDD::DDDContext&, DDD_OBJ obj, void *data, DDD_PROC proc, DDD_PRIO prio)
+static int Scatter_ElementClosureInfo (DDD::DDDContext& context, DDD_OBJ obj, void *data, DDD_PROC proc, DDD_PRIO prio)
 {
   ELEMENT *theElement = (ELEMENT *)obj;
 
@@ -813,7 +731,21 @@ static int Scatter_ElementClosureInfo (DDD::DDDContext&, DDD_OBJ obj, void *data
   INT refinedata = ((INT *)data)[0];
 
         #ifdef UG_DIM_2
+  INT thePattern = 0;
+  GetEdgeInfo(theElement,&thePattern,PATTERN);
   SetEdgeInfo(theElement,refinedata,PATTERN,|);
+
+  /* elements at edges refined on another processor */
+  /* are visited again in the next fifo loop        */
+  MULTIGRID *theMG = ddd_ctrl(context).currMG;
+  if (theMG->refineState.fifoFlag)
+    for (INT j=0; j<EDGES_OF_ELEM(theElement); j++)
+      if (!EDGE_IN_PAT(thePattern,j) && EDGE_IN_PAT(refinedata,j))
+      {
+        AddToClosureFIFO(theMG,theElement);
+        if (NBELEM(theElement,j) != NULL)
+          AddToClosureFIFO(theMG,NBELEM(theElement,j));
+      }
         #endif
 
   /* mark and sidepattern have same control word positions */
@@ -1005,13 +937,109 @@ static INT ExchangeClosureInfo (GRID *theGrid)
 
 /****************************************************************************/
 /*
-   ComputePatterns -
+   ClosureChunks - number of chunks for the closure loops
 
    SYNOPSIS:
-   static INT ComputePatterns (GRID *theGrid);
+   static INT ClosureChunks (const GRID *theGrid, std::size_t nElements);
 
    PARAMETERS:
    .  theGrid - pointer to grid structure
+   .  nElements - number of elements visited by the loops
+
+   DESCRIPTION:
+   This function returns the number of chunks the element loops of the
+   closure are split into, see ForElementChunks. It is limited by the
+   number of refine threads of the multigrid and such that each chunk has
+   a reasonable number of elements. The fifo and the parallel UG (ModelP)
+   always use one chunk.
+
+   \return <ul>
+   INT
+   .n   number of chunks
+ */
+/****************************************************************************/
+
+static INT ClosureChunks (const GRID *theGrid, std::size_t nElements)
+{
+#ifdef ModelP
+  return(1);
+#else
+  /* a thread is not worth it for few elements */
+  constexpr std::size_t minChunkSize = 1024;
+
+  /* UpdateFIFOLists() changes the lists of the refine state */
+  if (REFINE_STATE(theGrid).fifoFlag) return(1);
+
+  const std::size_t nChunks = std::min<std::size_t>(MYMG(theGrid)->refineThreads,
+                                                    nElements/minChunkSize);
+  return(std::max<INT>(nChunks,1));
+#endif
+}
+
+/****************************************************************************/
+/*
+   ForElementChunks - run a loop over elements on several threads
+
+   SYNOPSIS:
+   template <class F>
+   static INT ForElementChunks (const std::vector<ELEMENT*>& theElements,
+                                INT nChunks, F&& f);
+
+   PARAMETERS:
+   .  theElements - elements to visit
+   .  nChunks - number of chunks, see ClosureChunks
+   .  f - loop body, called as f(chunk,first,last)
+
+   DESCRIPTION:
+   This function splits 'theElements' into 'nChunks' contiguous chunks and
+   calls 'f' for the index range [first,last) of each chunk, chunk 0 on the
+   calling thread and the others on separate threads. 'f' may write the
+   control words of the elements of its range and data owned by its chunk
+   only; updates of edges and neighbors have to be collected per chunk and
+   done after the loop.
+
+   \return <ul>
+   INT
+   .n   GM_OK - if all chunks returned GM_OK
+   .n   the first error of the chunks otherwise
+ */
+/****************************************************************************/
+
+template <class F>
+static INT ForElementChunks (const std::vector<ELEMENT*>& theElements, INT nChunks, F&& f)
+{
+  const std::size_t n = theElements.size();
+  std::vector<INT> error(nChunks,GM_OK);
+  std::vector<std::thread> threads;
+
+  auto loopChunk = [&](INT chunk)
+  {
+    error[chunk] = f(chunk,(n*chunk)/nChunks,(n*(chunk+1))/nChunks);
+  };
+  for (INT chunk=1; chunk<nChunks; chunk++)
+    threads.emplace_back(loopChunk,chunk);
+  loopChunk(0);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (INT chunk=0; chunk<nChunks; chunk++)
+    if (error[chunk]!=GM_OK)
+      return(error[chunk]);
+
+  return(GM_OK);
+}
+
+/****************************************************************************/
+/*
+   ComputePatterns -
+
+   SYNOPSIS:
+   static INT ComputePatterns (const std::vector<ELEMENT*>& theElements,
+                               INT nChunks);
+
+   PARAMETERS:
+   .  theElements - elements of the grid
+   .  nChunks - number of chunks, see ClosureChunks
 
    DESCRIPTION:
 
@@ -1020,8 +1048,11 @@ static INT ExchangeClosureInfo (GRID *theGrid)
  */
 /****************************************************************************/
 
-static INT ComputePatterns (const GRID *theGrid)
+static INT ComputePatterns (const std::vector<ELEMENT*>& theElements, INT nChunks)
 {
+  /* edges to refine, set after the loop since edges are shared */
+  std::vector<std::vector<EDGE*> > patternEdges(nChunks);
+
   /* ComputePatterns works only on master elements      */
   /* since ghost elements have no information from      */
   /* RestrictMarks() up to this time and this may       */
@@ -1030,70 +1061,94 @@ static INT ComputePatterns (const GRID *theGrid)
   /* reset EDGE/SIDEPATTERN in elements                 */
   /* set SIDEPATTERN in elements                        */
   /* set PATTERN on the edges                           */
-  for (ELEMENT *theElement = PFIRSTELEMENT(theGrid); theElement != nullptr;
-       theElement=SUCCE(theElement))
+  ForElementChunks(theElements,nChunks,[&](INT chunk, std::size_t first, std::size_t last) -> INT
   {
-                #ifdef ModelP
-    if (EGHOST(theElement))
+    for (std::size_t e=first; e<last; e++)
     {
+      ELEMENT *theElement = theElements[e];
+
+                #ifdef ModelP
+      if (EGHOST(theElement))
+      {
                         #ifdef UG_DIM_3
-      SETSIDEPATTERN(theElement,0);
+        SETSIDEPATTERN(theElement,0);
                         #endif
-      continue;
-    }
+        continue;
+      }
                 #endif
 
-    if (MARKCLASS(theElement)==RED_CLASS)
-    {
-      INT Mark = MARK(theElement);
-      SHORT *thePattern = MARK2PATTERN(theElement,Mark);
+      if (MARKCLASS(theElement)==RED_CLASS)
+      {
+        INT Mark = MARK(theElement);
+        SHORT *thePattern = MARK2PATTERN(theElement,Mark);
 
-      for (INT i = 0; i < EDGES_OF_ELEM(theElement); i++)
-        if (EDGE_IN_PATTERN(thePattern,i))
-        {
-          EDGE *theEdge = GetEdge(CORNER_OF_EDGE_PTR(theElement, i, 0),
-                                  CORNER_OF_EDGE_PTR(theElement, i, 1));
+        for (INT i = 0; i < EDGES_OF_ELEM(theElement); i++)
+          if (EDGE_IN_PATTERN(thePattern,i))
+          {
+            EDGE *theEdge = GetEdge(CORNER_OF_EDGE_PTR(theElement, i, 0),
+                                    CORNER_OF_EDGE_PTR(theElement, i, 1));
 
-          ASSERT(theEdge != NULL);
+            ASSERT(theEdge != NULL);
 
-          SETPATTERN(theEdge,1);
-        }
+            patternEdges[chunk].push_back(theEdge);
+          }
 
                         #ifdef UG_DIM_3
-      /* SIDEPATTERN must be reset here for master elements, */
-      /* because it overlaps with MARK (980217 s.l.)         */
-      SETSIDEPATTERN(theElement,0);
-      for (INT i = 0; i < SIDES_OF_ELEM(theElement); i++)
-      {
-#ifdef DUNE_UGGRID_TET_RULESET
-        if (CORNERS_OF_SIDE(theElement,i)==4)
+        /* SIDEPATTERN must be reset here for master elements, */
+        /* because it overlaps with MARK (980217 s.l.)         */
+        SETSIDEPATTERN(theElement,0);
+        for (INT i = 0; i < SIDES_OF_ELEM(theElement); i++)
         {
+#ifdef DUNE_UGGRID_TET_RULESET
+          if (CORNERS_OF_SIDE(theElement,i)==4)
+          {
 #endif
-        /* set SIDEPATTERN if side has node */
-        if(SIDE_IN_PATTERN(theElement,thePattern,i))
-          SETSIDEPATTERN(theElement,
-                         SIDEPATTERN(theElement) | 1<<i);
+          /* set SIDEPATTERN if side has node */
+          if(SIDE_IN_PATTERN(theElement,thePattern,i))
+            SETSIDEPATTERN(theElement,
+                           SIDEPATTERN(theElement) | 1<<i);
 #ifdef DUNE_UGGRID_TET_RULESET
-      }
+        }
 #endif
-      }
+        }
                         #endif
-    }
-    else
-    {
+      }
+      else
+      {
                         #ifdef UG_DIM_3
-      /* SIDEPATTERN must be reset here for master elements, */
-      /* because it overlaps with MARK (980217 s.l.)         */
-      SETSIDEPATTERN(theElement,0);
+        /* SIDEPATTERN must be reset here for master elements, */
+        /* because it overlaps with MARK (980217 s.l.)         */
+        SETSIDEPATTERN(theElement,0);
                         #endif
-      SETMARKCLASS(theElement,NO_CLASS);
+        SETMARKCLASS(theElement,NO_CLASS);
+      }
     }
-  }
+
+    return(GM_OK);
+  });
+
+  for (const std::vector<EDGE*>& edges : patternEdges)
+    for (EDGE *theEdge : edges)
+      SETPATTERN(theEdge,1);
 
   return(GM_OK);
 }
 
 #ifdef UG_DIM_3
+
+/** \brief Correction of a side pattern, see SetElementSidePatterns */
+struct SideCorrection
+{
+  /** \brief element whose SIDEPATTERN is corrected */
+  ELEMENT *theElement;
+
+  /** \brief the side */
+  INT side;
+
+  /** \brief toggle the bit of the side instead of setting it */
+  bool toggle;
+};
+
 #ifdef DUNE_UGGRID_TET_RULESET
 
 /****************************************************************************/
@@ -1101,13 +1156,15 @@ static INT ComputePatterns (const GRID *theGrid)
    CorrectTetrahedronSidePattern -
 
    SYNOPSIS:
-   static INT CorrectTetrahedronSidePattern (ELEMENT *theElement, INT i, ELEMENT *theNeighbor, INT j);
+   static INT CorrectTetrahedronSidePattern (ELEMENT *theElement, INT i, ELEMENT *theNeighbor, INT j,
+                                             std::vector<SideCorrection>& corrections);
 
    PARAMETERS:
    .  theElement
    .  i
    .  theNeighbor
    .  j
+   .  corrections - list the correction of the neighbor is appended to
 
    DESCRIPTION:
 
@@ -1116,10 +1173,11 @@ static INT ComputePatterns (const GRID *theGrid)
  */
 /****************************************************************************/
 
-static INT CorrectTetrahedronSidePattern (ELEMENT *theElement, INT i, ELEMENT *theNeighbor, INT j)
+static INT CorrectTetrahedronSidePattern (ELEMENT *theElement, INT i, ELEMENT *theNeighbor, INT j,
+                                          std::vector<SideCorrection>& corrections)
 {
   INT theEdgeNum,theEdgePattern=0;
-  INT NbEdgeNum,NbEdgePattern,NbSidePattern,NbSideMask;
+  INT NbEdgeNum,NbEdgePattern;
 
   if (TAG(theElement)==PYRAMID || TAG(theElement)==PRISM)
     return(GM_OK);
@@ -1173,24 +1231,16 @@ static INT CorrectTetrahedronSidePattern (ELEMENT *theElement, INT i, ELEMENT *t
           CORNER_OF_EDGE_PTR(theElement,theEdgeNum,1) ==
           CORNER_OF_EDGE_PTR(theNeighbor,NbEdgeNum,0)   ) )
     {
-      NbSidePattern = SIDEPATTERN(theNeighbor);
-      NbSideMask = (1<<j);
-
-      if ( NbSidePattern & NbSideMask )
-      {
-        NbSidePattern &= ~NbSideMask;
                                         #ifdef ModelP
-        /* in this case ExchangeSidePatterns() fails */
-        /* does it occur ? (980217 s.l.)             */
-        assert(0);
+      /* in this case ExchangeSidePatterns() fails */
+      /* does it occur ? (980217 s.l.)             */
+      assert(!(SIDEPATTERN(theNeighbor) & (1<<j)));
                                         #endif
-      }
-      else
-        NbSidePattern |= NbSideMask;
 
       PRINTDEBUG(gm,1,("CorrectTetrahedronSidePattern(): nb=" EID_FMTX
-                       " new nbsidepattern=%d\n",EID_PRTX(theNeighbor),NbSidePattern));
-      SETSIDEPATTERN(theNeighbor,NbSidePattern);
+                       " new nbsidepattern=%d\n",EID_PRTX(theNeighbor),
+                       SIDEPATTERN(theNeighbor)^(1<<j)));
+      corrections.push_back({theNeighbor,j,true});
     }
     break;
 
@@ -1213,8 +1263,7 @@ static INT CorrectTetrahedronSidePattern (ELEMENT *theElement, INT i, ELEMENT *t
     assert(trisectionedge != -1);
 
     if (theEdgeNum != trisectionedge)
-      SETSIDEPATTERN(theNeighbor,
-                     SIDEPATTERN(theNeighbor)|(1<<j));
+      corrections.push_back({theNeighbor,j,false});
 
     break;
   }
@@ -1233,21 +1282,26 @@ static INT CorrectTetrahedronSidePattern (ELEMENT *theElement, INT i, ELEMENT *t
    CorrectElementSidePattern -
 
    SYNOPSIS:
-   static INT CorrectElementSidePattern (ELEMENT *theElement, ELEMENT *theNeighbor, INT i);
+   static INT CorrectElementSidePattern (ELEMENT *theElement, ELEMENT *theNeighbor, INT i,
+                                         std::vector<SideCorrection>& corrections);
 
    PARAMETERS:
    .  theElement
    .  theNeighbor
    .  i
+   .  corrections - list the corrections are appended to
 
    DESCRIPTION:
+   The side patterns are not changed here, the corrections are appended to
+   'corrections' instead.
 
    \return <ul>
    INT
  */
 /****************************************************************************/
 
-static INT CorrectElementSidePattern (ELEMENT *theElement, ELEMENT *theNeighbor, INT i)
+static INT CorrectElementSidePattern (ELEMENT *theElement, ELEMENT *theNeighbor, INT i,
+                                      std::vector<SideCorrection>& corrections)
 {
   INT j;
 
@@ -1290,7 +1344,7 @@ static INT CorrectElementSidePattern (ELEMENT *theElement, ELEMENT *theNeighbor,
   case 3 :
                         #ifdef DUNE_UGGRID_TET_RULESET
     /* handle case with 2 edges of the side refined */
-    if (CorrectTetrahedronSidePattern(theElement,i,theNeighbor,j) != GM_OK)
+    if (CorrectTetrahedronSidePattern(theElement,i,theNeighbor,j,corrections) != GM_OK)
       RETURN(GM_ERROR);
                         #endif
     break;
@@ -1300,13 +1354,11 @@ static INT CorrectElementSidePattern (ELEMENT *theElement, ELEMENT *theNeighbor,
     /* sidenode, then both need a sidenode              */
     if (SIDE_IN_PAT(SIDEPATTERN(theElement),i))
     {
-      SETSIDEPATTERN(theNeighbor,
-                     SIDEPATTERN(theNeighbor) | (1<<j));
+      corrections.push_back({theNeighbor,j,false});
     }
     else if (SIDE_IN_PAT(SIDEPATTERN(theNeighbor),j))
     {
-      SETSIDEPATTERN(theElement,
-                     SIDEPATTERN(theElement) | (1<<i));
+      corrections.push_back({theElement,i,false});
     }
     break;
 
@@ -1323,74 +1375,99 @@ static INT CorrectElementSidePattern (ELEMENT *theElement, ELEMENT *theNeighbor,
    SetElementSidePatterns -
 
    SYNOPSIS:
-   static INT SetElementSidePatterns (GRID *theGrid, ELEMENT *firstElement);
+   static INT SetElementSidePatterns (const std::vector<ELEMENT*>& theElements,
+                                      INT nChunks);
 
    PARAMETERS:
-   .  theGrid - pointer to grid structure
-   .  firstElement
+   .  theElements - elements of this closure loop
+   .  nChunks - number of chunks, see ClosureChunks
 
    DESCRIPTION:
+   The corrections of the side patterns are collected while visiting the
+   elements and done afterwards. Each side bit is only corrected from its
+   own pair of neighboring elements, so the result does not depend on the
+   order of the elements and the elements can be visited on several threads.
 
    \return <ul>
    INT
  */
 /****************************************************************************/
 
-static INT SetElementSidePatterns (GRID *theGrid, ELEMENT *firstElement)
+static INT SetElementSidePatterns (const std::vector<ELEMENT*>& theElements, INT nChunks)
 {
-  INT i;
-  ELEMENT *theElement,*theNeighbor;
+  std::vector<std::vector<SideCorrection> > corrections(nChunks);
 
   /* set pattern (edge and side) on the elements */
-  for (theElement=firstElement; theElement!=NULL;
-       theElement=SUCCE(theElement))
+  if (ForElementChunks(theElements,nChunks,[&](INT chunk, std::size_t first, std::size_t last) -> INT
   {
-    /* make edgepattern consistent with pattern of edges */
-    SETUSED(theElement,1);
+    for (std::size_t e=first; e<last; e++)
+    {
+      ELEMENT *theElement = theElements[e];
 
                 #ifndef __ANISOTROPIC__
-    /** \todo change this for red refinement of pyramids */
-    if (DIM==3 && TAG(theElement)==PYRAMID) continue;
+      /** \todo change this for red refinement of pyramids */
+      if (DIM==3 && TAG(theElement)==PYRAMID) continue;
                 #endif
 
-    /* make sidepattern consistent with neighbors	*/
-    for (i=0; i<SIDES_OF_ELEM(theElement); i++)
-    {
-      theNeighbor = NBELEM(theElement,i);
-      if (theNeighbor == NULL) continue;
+      /* make sidepattern consistent with neighbors	*/
+      for (INT i=0; i<SIDES_OF_ELEM(theElement); i++)
+      {
+        ELEMENT *theNeighbor = NBELEM(theElement,i);
+        if (theNeighbor == NULL) continue;
 
-      /* only one of the neighboring elements does corrections */
-      /* determine element for side correction by (g)id        */
-      if (_EID_(theElement) < _EID_(theNeighbor)) continue;
+        /* only one of the neighboring elements does corrections */
+        /* determine element for side correction by (g)id        */
+        if (_EID_(theElement) < _EID_(theNeighbor)) continue;
 
-      /* determine element for side correction by used flag    */
-      /** \todo delete this:
-         if (USED(theNeighbor)) continue;
-       */
+        /* determine element for side correction by used flag    */
+        /** \todo delete this:
+           if (USED(theNeighbor)) continue;
+         */
 
-      /* edgepatterns from theElement and theNeighbor are in final state */
+        /* edgepatterns from theElement and theNeighbor are in final state */
 
-      if (CorrectElementSidePattern(theElement,theNeighbor,i) != GM_OK) RETURN(GM_ERROR);
+        if (CorrectElementSidePattern(theElement,theNeighbor,i,corrections[chunk]) != GM_OK) RETURN(GM_ERROR);
+      }
+    }
+
+    return(GM_OK);
+  }) != GM_OK) RETURN(GM_ERROR);
+
+  /* make edgepattern consistent with pattern of edges */
+  for (ELEMENT *theElement : theElements)
+    SETUSED(theElement,1);
+
+  for (const std::vector<SideCorrection>& chunkCorrections : corrections)
+    for (const SideCorrection& c : chunkCorrections)
+    {
+      if (c.toggle)
+        SETSIDEPATTERN(c.theElement,SIDEPATTERN(c.theElement) ^ (1<<c.side));
+      else
+        SETSIDEPATTERN(c.theElement,SIDEPATTERN(c.theElement) | (1<<c.side));
     }
-  }
 
   return(GM_OK);
 }
 #endif
 
 
-
 /****************************************************************************/
 /*
    SetElementRules -
 
    SYNOPSIS:
-   static INT SetElementRules (GRID *theGrid, ELEMENT *firstElement, INT *cnt);
+   static INT SetElementRules (GRID *theGrid,
+                               const std::vector<ELEMENT*>& theElements,
+                               const std::vector<INT>& fullRefRules,
+                               INT nChunks, INT *cnt);
 
    PARAMETERS:
    .  theGrid - pointer to grid structure
-   .  firstElement
-   .  cnt
+   .  theElements - elements of this closure loop
+   .  fullRefRules - full refrules of the red tetrahedra of 'theElements'
+                     computed by FullRefRules, or empty
+   .  nChunks - number of chunks, see ClosureChunks
+   .  cnt - number of elements with refinement
 
    DESCRIPTION:
 
@@ -1399,128 +1476,143 @@ static INT SetElementSidePatterns (GRID *theGrid, ELEMENT *firstElement)
  */
 /****************************************************************************/
 
-static INT SetElementRules (GRID *theGrid, ELEMENT *firstElement, INT *cnt)
+static INT SetElementRules (GRID *theGrid, const std::vector<ELEMENT*>& theElements,
+                            const std::vector<INT>& fullRefRules, INT nChunks, INT *cnt)
 {
-  INT Mark,NewPattern;
-  INT thePattern,theEdgePattern,theSidePattern=0;
-  ELEMENT *theElement;
+  std::vector<INT> counts(nChunks,0);
+  const RefineState& theState = REFINE_STATE(theGrid);
 
   [[maybe_unused]] const int me = theGrid->ppifContext().me();
 
   /* set refinement rules from edge- and sidepattern */
-  (*cnt) = 0;
-  for (theElement=firstElement; theElement!=NULL;
-       theElement=SUCCE(theElement))
+  /* a failing fifo update stops the loop, but is no error */
+  ForElementChunks(theElements,nChunks,[&](INT chunk, std::size_t first, std::size_t last) -> INT
   {
-    theEdgePattern = 0;
+    for (std::size_t e=first; e<last; e++)
+    {
+      ELEMENT *theElement = theElements[e];
+      INT Mark,NewPattern;
+      INT thePattern,theEdgePattern,theSidePattern=0;
 
-    /* compute element pattern */
-    GetEdgeInfo(theElement,&theEdgePattern,PATTERN);
+      theEdgePattern = 0;
+
+      /* compute element pattern */
+      GetEdgeInfo(theElement,&theEdgePattern,PATTERN);
 
                 #ifdef UG_DIM_2
-    thePattern = theEdgePattern;
-    PRINTDEBUG(gm,2,(PFMT "SetElementRules(): e=" EID_FMTX " edgepattern=%d\n",
-                     me,EID_PRTX(theElement),theEdgePattern));
+      thePattern = theEdgePattern;
+      PRINTDEBUG(gm,2,(PFMT "SetElementRules(): e=" EID_FMTX " edgepattern=%d\n",
+                       me,EID_PRTX(theElement),theEdgePattern));
                 #endif
                 #ifdef UG_DIM_3
-    theSidePattern = SIDEPATTERN(theElement);
-    thePattern = theSidePattern<<EDGES_OF_ELEM(theElement) | theEdgePattern;
-    PRINTDEBUG(gm,2,(PFMT "SetElementRules(): e=" EID_FMTX
-                     " edgepattern=%03x sidepattern=%02x\n",
-                     me,EID_PRTX(theElement),theEdgePattern,theSidePattern));
+      theSidePattern = SIDEPATTERN(theElement);
+      thePattern = theSidePattern<<EDGES_OF_ELEM(theElement) | theEdgePattern;
+      PRINTDEBUG(gm,2,(PFMT "SetElementRules(): e=" EID_FMTX
+                       " edgepattern=%03x sidepattern=%02x\n",
+                       me,EID_PRTX(theElement),theEdgePattern,theSidePattern));
                 #endif
 
-    /* get Mark from pattern */
-    Mark = PATTERN2MARK(theElement,thePattern);
+      /* get Mark from pattern */
+      Mark = PATTERN2MARK(theElement,thePattern);
 
-    /* treat Mark according to mode */
-    if (fifoFlag)
-    {
-      /* directed refinement */
-      if (Mark == -1 && MARKCLASS(theElement)==RED_CLASS)
+      /* treat Mark according to mode */
+      if (theState.fifoFlag)
+      {
+        /* directed refinement */
+        if (Mark == -1 && MARKCLASS(theElement)==RED_CLASS)
+        {
+          /* there is no rule for this pattern, switch to red */
+          Mark = RED;
+        }
+        else
+          ASSERT(Mark != -1);
+      }
+      else if (theState.hFlag==0 && MARKCLASS(theElement)!=RED_CLASS)
       {
-        /* there is no rule for this pattern, switch to red */
-        Mark = RED;
+        /* refinement with hanging nodes */
+        Mark = NO_REFINEMENT;
       }
       else
-        ASSERT(Mark != -1);
-    }
-    else if (hFlag==0 && MARKCLASS(theElement)!=RED_CLASS)
-    {
-      /* refinement with hanging nodes */
-      Mark = NO_REFINEMENT;
-    }
-    else
-    {
-      /* refinement with closure (default) */
-                        #ifdef __ANISOTROPIC__
-      if (MARKCLASS(theElement)==RED_CLASS && TAG(theElement)==PRISM)
       {
-        ASSERT(USED(theElement)==1);
-        if (Mark==-1)
+        /* refinement with closure (default) */
+                        #ifdef __ANISOTROPIC__
+        if (MARKCLASS(theElement)==RED_CLASS && TAG(theElement)==PRISM)
         {
-          ASSERT(TAG(theElement)==PRISM);
-          /* to implement the anisotropic case for other elements */
-          /* and anisotropic refinements the initial anisotropic  */
-          /* rule is needed here. (980316 s.l.)                   */
-          Mark = PRI_QUADSECT;
+          ASSERT(USED(theElement)==1);
+          if (Mark==-1)
+          {
+            ASSERT(TAG(theElement)==PRISM);
+            /* to implement the anisotropic case for other elements */
+            /* and anisotropic refinements the initial anisotropic  */
+            /* rule is needed here. (980316 s.l.)                   */
+            Mark = PRI_QUADSECT;
+          }
+          else
+            SETUSED(theElement,0);
         }
-        else
-          SETUSED(theElement,0);
-      }
                         #endif
-      ASSERT(Mark != -1);
+        ASSERT(Mark != -1);
 
-      /* switch green class to red class? */
-      if (MARKCLASS(theElement)!=RED_CLASS &&
-          SWITCHCLASS(CLASS_OF_RULE(MARK2RULEADR(theElement,Mark))))
-      {
-        IFDEBUG(gm,1)
-        UserWriteF("   Switching MARKCLASS=%d for MARK=%d of EID=%d "
-                   "to RED_CLASS\n",
-                   MARKCLASS(theElement),Mark,ID(theElement));
-        ENDDEBUG
-        SETMARKCLASS(theElement,RED_CLASS);
+        /* switch green class to red class? */
+        if (MARKCLASS(theElement)!=RED_CLASS &&
+            SWITCHCLASS(CLASS_OF_RULE(MARK2RULEADR(theElement,Mark))))
+        {
+          IFDEBUG(gm,1)
+          UserWriteF("   Switching MARKCLASS=%d for MARK=%d of EID=%d "
+                     "to RED_CLASS\n",
+                     MARKCLASS(theElement),Mark,ID(theElement));
+          ENDDEBUG
+          SETMARKCLASS(theElement,RED_CLASS);
+        }
       }
-    }
 
-    REFINE_ELEMENT_LIST(1,theElement,"");
+      REFINE_ELEMENT_LIST(1,theElement,"");
 
                 #ifdef UG_DIM_3
-    /* choose best tet_red rule according to (*theFullRefRule)() */
-    if (TAG(theElement)==TETRAHEDRON && MARKCLASS(theElement)==RED_CLASS)
-    {
+      /* choose best tet_red rule according to (*theFullRefRule)() */
+      if (TAG(theElement)==TETRAHEDRON && MARKCLASS(theElement)==RED_CLASS)
+      {
 #ifndef DUNE_UGGRID_TET_RULESET
-      if ((Mark==TET_RED || Mark==TET_RED_0_5 ||
-           Mark==TET_RED_1_3))
+        if ((Mark==TET_RED || Mark==TET_RED_0_5 ||
+             Mark==TET_RED_1_3))
 #endif
-      {
-        PRINTDEBUG(gm,5,("FullRefRule() call with mark=%d\n",Mark))
+        {
+          PRINTDEBUG(gm,5,("FullRefRule() call with mark=%d\n",Mark))
 
-        Mark = (*theFullRefRule)(theElement);
-        assert( Mark==FULL_REFRULE_0_5 ||
-                Mark==FULL_REFRULE_1_3 ||
-                Mark==FULL_REFRULE_2_4);
+          if (e<fullRefRules.size() && fullRefRules[e]>=0)
+            Mark = fullRefRules[e];
+          else
+            Mark = (*theFullRefRule)(theElement);
+          assert( Mark==FULL_REFRULE_0_5 ||
+                  Mark==FULL_REFRULE_1_3 ||
+                  Mark==FULL_REFRULE_2_4);
+        }
       }
-    }
                 #endif
 
-    /* get new pattern from mark */
-    NewPattern = MARK2PAT(theElement,Mark);
-    IFDEBUG(gm,2)
-    UserWriteF("   thePattern=%d EdgePattern=%d SidePattern=%d NewPattern=%d Mark=%d\n",
-               thePattern,theEdgePattern,theSidePattern,NewPattern,Mark);
-    ENDDEBUG
+      /* get new pattern from mark */
+      NewPattern = MARK2PAT(theElement,Mark);
+      IFDEBUG(gm,2)
+      UserWriteF("   thePattern=%d EdgePattern=%d SidePattern=%d NewPattern=%d Mark=%d\n",
+                 thePattern,theEdgePattern,theSidePattern,NewPattern,Mark);
+      ENDDEBUG
 
 
-    if (fifoFlag)
-    {
-      if (UpdateFIFOLists(theGrid,theElement,thePattern,NewPattern) != GM_OK) return(GM_OK);
+      if (theState.fifoFlag)
+      {
+        if (UpdateFIFOLists(theGrid,theElement,thePattern,NewPattern) != GM_OK) return(GM_ERROR);
+      }
+
+      if (Mark) counts[chunk]++;
+      SETMARK(theElement,Mark);
     }
 
-    if (Mark) (*cnt)++;
-    SETMARK(theElement,Mark);
-  }
+    return(GM_OK);
+  });
+
+  (*cnt) = 0;
+  for (INT chunkCount : counts)
+    (*cnt) += chunkCount;
 
   return(GM_OK);
 }
@@ -1671,10 +1763,14 @@ static INT ExchangeAddPatterns (GRID *theGrid)
    SetAddPatterns -
 
    SYNOPSIS:
-   static INT SetAddPatterns (GRID *theGrid);
+   static INT SetAddPatterns (GRID *theGrid,
+                              const std::vector<ELEMENT*>& theElements,
+                              INT nChunks);
 
    PARAMETERS:
    .  theGrid - pointer to grid structure
+   .  theElements - elements of the grid
+   .  nChunks - number of chunks, see ClosureChunks
 
    DESCRIPTION:
 
@@ -1683,34 +1779,43 @@ static INT ExchangeAddPatterns (GRID *theGrid)
  */
 /****************************************************************************/
 
-static INT SetAddPatterns (GRID *theGrid)
+static INT SetAddPatterns (GRID *theGrid, const std::vector<ELEMENT*>& theElements, INT nChunks)
 {
-  INT j;
-  ELEMENT *theElement;
-  EDGE    *theEdge;
+  /* edges of red elements, set after the loop since edges are shared */
+  std::vector<std::vector<EDGE*> > addPatternEdges(nChunks);
 
   /* set additional pattern on the edges */
-  for (theElement=PFIRSTELEMENT(theGrid); theElement!=NULL;
-       theElement=SUCCE(theElement))
+  ForElementChunks(theElements,nChunks,[&](INT chunk, std::size_t first, std::size_t last) -> INT
   {
-    if (MARKCLASS(theElement)!=RED_CLASS) continue;
+    for (std::size_t e=first; e<last; e++)
+    {
+      ELEMENT *theElement = theElements[e];
 
-    REFINE_ELEMENT_LIST(1,theElement,"SetAddPatterns(): addpattern=0");
+      if (MARKCLASS(theElement)!=RED_CLASS) continue;
 
-    for (j=0; j<EDGES_OF_ELEM(theElement); j++)
-    {
-      /* no green elements for this edge if there is no edge node */
-      if (!NODE_OF_RULE(theElement,MARK(theElement),j))
-        continue;
+      REFINE_ELEMENT_LIST(1,theElement,"SetAddPatterns(): addpattern=0");
 
-      theEdge=GetEdge(CORNER_OF_EDGE_PTR(theElement,j,0),
-                      CORNER_OF_EDGE_PTR(theElement,j,1));
-      ASSERT(theEdge != NULL);
+      for (INT j=0; j<EDGES_OF_ELEM(theElement); j++)
+      {
+        /* no green elements for this edge if there is no edge node */
+        if (!NODE_OF_RULE(theElement,MARK(theElement),j))
+          continue;
 
-      /* ADDPATTERN is now set to 0 for all edges of red elements */
-      SETADDPATTERN(theEdge,0);
+        EDGE *theEdge=GetEdge(CORNER_OF_EDGE_PTR(theElement,j,0),
+                              CORNER_OF_EDGE_PTR(theElement,j,1));
+        ASSERT(theEdge != NULL);
+
+        addPatternEdges[chunk].push_back(theEdge);
+      }
     }
-  }
+
+    return(GM_OK);
+  });
+
+  /* ADDPATTERN is now set to 0 for all edges of red elements */
+  for (const std::vector<EDGE*>& edges : addPatternEdges)
+    for (EDGE *theEdge : edges)
+      SETADDPATTERN(theEdge,0);
 
         #ifdef ModelP
   if (ExchangeAddPatterns(theGrid)) RETURN(GM_FATAL);
@@ -1725,176 +1830,210 @@ static INT SetAddPatterns (GRID *theGrid)
    BuildGreenClosure -
 
    SYNOPSIS:
-   static INT BuildGreenClosure (GRID *theGrid);
+   static INT BuildGreenClosure (const std::vector<ELEMENT*>& theElements,
+                                 INT nChunks);
 
    PARAMETERS:
-   .  theGrid - pointer to grid structure
+   .  theElements - elements of the grid
+   .  nChunks - number of chunks, see ClosureChunks
 
    DESCRIPTION:
+   The new flags of the green elements depend on the marks of their
+   neighbors. They are computed for all elements first and set afterwards.
 
    \return <ul>
    INT
  */
 /****************************************************************************/
 
-static INT BuildGreenClosure (const GRID *theGrid)
+static INT BuildGreenClosure (const std::vector<ELEMENT*>& theElements, INT nChunks)
 {
-  INT i;
-  ELEMENT *theElement;
-  EDGE    *theEdge;
-        #ifdef UG_DIM_3
-  INT j;
-        #endif
+  /** \brief New flags of a green element */
+  struct GreenFlags
+  {
+    ELEMENT *theElement;
+    INT mark;
+    INT markClass;
+    INT updateGreen;
+    INT used;
+  };
+  std::vector<std::vector<GreenFlags> > greenFlags(nChunks);
 
   /* build a green covering around the red elements */
-  for (theElement=PFIRSTELEMENT(theGrid); theElement!=NULL;
-       theElement=SUCCE(theElement))
+  ForElementChunks(theElements,nChunks,[&](INT chunk, std::size_t first, std::size_t last) -> INT
   {
+    for (std::size_t e=first; e<last; e++)
+    {
+      ELEMENT *theElement = theElements[e];
+
                 #ifdef __ANISOTROPIC__
-    if (MARKCLASS(theElement)==RED_CLASS &&
-        !(TAG(theElement)==PRISM && MARK(theElement)==PRI_QUADSECT)) continue;
+      if (MARKCLASS(theElement)==RED_CLASS &&
+          !(TAG(theElement)==PRISM && MARK(theElement)==PRI_QUADSECT)) continue;
 
-    ASSERT(MARKCLASS(theElement)!=RED_CLASS ||
-           (MARKCLASS(theElement)==RED_CLASS && TAG(theElement)==PRISM
-            && MARK(theElement)==PRI_QUADSECT));
+      ASSERT(MARKCLASS(theElement)!=RED_CLASS ||
+             (MARKCLASS(theElement)==RED_CLASS && TAG(theElement)==PRISM
+              && MARK(theElement)==PRI_QUADSECT));
                 #else
-    if (MARKCLASS(theElement)==RED_CLASS) continue;
+      if (MARKCLASS(theElement)==RED_CLASS) continue;
                 #endif
 
-    SETUPDATE_GREEN(theElement,0);
+      INT mark = MARK(theElement);
+      INT markClass = MARKCLASS(theElement);
+      INT updateGreen = 0;
+      INT used = USED(theElement);
 
-    /* if edge node exists element needs to be green */
-    for (i=0; i<EDGES_OF_ELEM(theElement); i++)
-    {
-      theEdge=GetEdge(CORNER_OF_EDGE_PTR(theElement,i,0),
-                      CORNER_OF_EDGE_PTR(theElement,i,1));
-      ASSERT(theEdge != NULL);
-
-      /* if edge is refined this will be a green element */
-      if (ADDPATTERN(theEdge) == 0)
+      /* if edge node exists element needs to be green */
+      for (INT i=0; i<EDGES_OF_ELEM(theElement); i++)
       {
-        /* for pyramids, prisms and hexhedra Patterns2Rules returns 0  */
-        /* for non red elements, because there is no complete rule set */
-        /* switch to mark COPY, because COPY rule refines no edges     */
+        EDGE *theEdge=GetEdge(CORNER_OF_EDGE_PTR(theElement,i,0),
+                              CORNER_OF_EDGE_PTR(theElement,i,1));
+        ASSERT(theEdge != NULL);
+
+        /* if edge is refined this will be a green element */
+        if (ADDPATTERN(theEdge) == 0)
+        {
+          /* for pyramids, prisms and hexhedra Patterns2Rules returns 0  */
+          /* for non red elements, because there is no complete rule set */
+          /* switch to mark COPY, because COPY rule refines no edges     */
 #ifdef DUNE_UGGRID_TET_RULESET
-        if (DIM==3 && TAG(theElement)!=TETRAHEDRON)
+          if (DIM==3 && TAG(theElement)!=TETRAHEDRON)
 #else
-        if (DIM==3)
+          if (DIM==3)
 #endif
-        {
-          /* set to no-empty rule, e.g. COPY rule */
+          {
+            /* set to no-empty rule, e.g. COPY rule */
                                         #ifdef __ANISOTROPIC__
-          if (MARKCLASS(theElement) != RED_CLASS)
+            if (markClass != RED_CLASS)
                                         #endif
-          SETMARK(theElement,COPY);
+            mark = COPY;
 
-          /* no existing edge node renew green refinement */
-          if (MIDNODE(theEdge)==NULL)
+            /* no existing edge node renew green refinement */
+            if (MIDNODE(theEdge)==NULL)
+            {
+              updateGreen = 1;
+            }
+          }
+          /* tetrahedra in 3D and 2D elements have a complete rule set */
+          else if (mark == NO_REFINEMENT)
           {
-            SETUPDATE_GREEN(theElement,1);
+            IFDEBUG(gm,2)
+            UserWriteF("   ERROR: green tetrahedron with no rule! "
+                       "EID=%d TAG=%d "
+                       "REFINECLASS=%d REFINE=%d MARKCLASS=%d  MARK=%d\n",
+                       ID(theElement),TAG(theElement),REFINECLASS(theElement),
+                       REFINE(theElement),markClass,mark);
+            ENDDEBUG
           }
-        }
-        /* tetrahedra in 3D and 2D elements have a complete rule set */
-        else if (MARK(theElement) == NO_REFINEMENT)
-        {
-          IFDEBUG(gm,2)
-          UserWriteF("   ERROR: green tetrahedron with no rule! "
-                     "EID=%d TAG=%d "
-                     "REFINECLASS=%d REFINE=%d MARKCLASS=%d  MARK=%d\n",
-                     ID(theElement),TAG(theElement),REFINECLASS(theElement),
-                     REFINE(theElement),MARKCLASS(theElement),
-                     MARK(theElement));
-          ENDDEBUG
-        }
 
                                 #ifdef __ANISOTROPIC__
-        if (MARKCLASS(theElement) != RED_CLASS)
+          if (markClass != RED_CLASS)
                                 #endif
-        SETMARKCLASS(theElement,GREEN_CLASS);
-      }
-      else
-      {
-        /* existing edge node is deleted                         */
-        /* renew green refinement if element will be a green one */
-        if (MIDNODE(theEdge)!=NULL)
-          SETUPDATE_GREEN(theElement,1);
+          markClass = GREEN_CLASS;
+        }
+        else
+        {
+          /* existing edge node is deleted                         */
+          /* renew green refinement if element will be a green one */
+          if (MIDNODE(theEdge)!=NULL)
+            updateGreen = 1;
+        }
       }
-    }
 
                 #ifdef UG_DIM_3
-    /* if side node exists element needs to be green */
-    for (i=0; i<SIDES_OF_ELEM(theElement); i++)
-    {
-      ELEMENT *theNeighbor;
+      /* if side node exists element needs to be green */
+      for (INT i=0; i<SIDES_OF_ELEM(theElement); i++)
+      {
+        INT j;
+        ELEMENT *theNeighbor;
 
-      theNeighbor = NBELEM(theElement,i);
+        theNeighbor = NBELEM(theElement,i);
 
-      if (theNeighbor==NULL) continue;
+        if (theNeighbor==NULL) continue;
 
-      for (j=0; j<SIDES_OF_ELEM(theNeighbor); j++)
-        if (NBELEM(theNeighbor,j) == theElement)
-          break;
+        for (j=0; j<SIDES_OF_ELEM(theNeighbor); j++)
+          if (NBELEM(theNeighbor,j) == theElement)
+            break;
 
                         #ifdef ModelP
-      if (j >= SIDES_OF_ELEM(theNeighbor))
-      {
-        ASSERT(EGHOST(theElement) && EGHOST(theNeighbor));
-        continue;
-      }
+        if (j >= SIDES_OF_ELEM(theNeighbor))
+        {
+          ASSERT(EGHOST(theElement) && EGHOST(theNeighbor));
+          continue;
+        }
                         #else
-      ASSERT(j<SIDES_OF_ELEM(theNeighbor));
+        ASSERT(j<SIDES_OF_ELEM(theNeighbor));
                         #endif
 
-      if (NODE_OF_RULE(theNeighbor,MARK(theNeighbor),
-                       EDGES_OF_ELEM(theNeighbor)+j))
-      {
+        /* the mark of a neighbor is the one before the loop, */
+        /* COPY instead of NO_REFINEMENT has no side nodes     */
+        if (NODE_OF_RULE(theNeighbor,MARK(theNeighbor),
+                         EDGES_OF_ELEM(theNeighbor)+j))
+        {
 #ifdef DUNE_UGGRID_TET_RULESET
-        if (TAG(theNeighbor)==TETRAHEDRON)
-          printf("ERROR: no side nodes for tetrahedra! side=%d\n",j);
+          if (TAG(theNeighbor)==TETRAHEDRON)
+            printf("ERROR: no side nodes for tetrahedra! side=%d\n",j);
 #endif
                                 #ifdef __ANISOTROPIC__
-        if (MARKCLASS(theElement) != RED_CLASS)
+          if (markClass != RED_CLASS)
                                 #endif
-        SETMARKCLASS(theElement,GREEN_CLASS);
-      }
+          markClass = GREEN_CLASS;
+        }
 
 
-      /* side node change? */
-      if ((!NODE_OF_RULE(theNeighbor,REFINE(theNeighbor),
-                         EDGES_OF_ELEM(theNeighbor)+j) &&
-           NODE_OF_RULE(theNeighbor,MARK(theNeighbor),
-                        EDGES_OF_ELEM(theNeighbor)+j)) ||
-          (NODE_OF_RULE(theNeighbor,REFINE(theNeighbor),
-                        EDGES_OF_ELEM(theNeighbor)+j) &&
-           !NODE_OF_RULE(theNeighbor,MARK(theNeighbor),
-                         EDGES_OF_ELEM(theNeighbor)+j)))
-      {
-        SETUPDATE_GREEN(theElement,1);
+        /* side node change? */
+        if ((!NODE_OF_RULE(theNeighbor,REFINE(theNeighbor),
+                           EDGES_OF_ELEM(theNeighbor)+j) &&
+             NODE_OF_RULE(theNeighbor,MARK(theNeighbor),
+                          EDGES_OF_ELEM(theNeighbor)+j)) ||
+            (NODE_OF_RULE(theNeighbor,REFINE(theNeighbor),
+                          EDGES_OF_ELEM(theNeighbor)+j) &&
+             !NODE_OF_RULE(theNeighbor,MARK(theNeighbor),
+                           EDGES_OF_ELEM(theNeighbor)+j)))
+        {
+          updateGreen = 1;
+        }
       }
-    }
                 #endif
 
 
 #ifndef ModelP
-    /* if element is green before refinement and will be green after */
-    /* refinement and nothing changes -> reset USED flag             */
-    /* in parallel case: one communication to determine the minimum  */
-    /* over all copies of an green element would be needed           */
-    if (REFINECLASS(theElement)==GREEN_CLASS &&
-        MARKCLASS(theElement)==GREEN_CLASS && UPDATE_GREEN(theElement)==0)
-    {
-      /* do not renew green refinement */
-      SETUSED(theElement,0);
-    }
+      /* if element is green before refinement and will be green after */
+      /* refinement and nothing changes -> reset USED flag             */
+      /* in parallel case: one communication to determine the minimum  */
+      /* over all copies of an green element would be needed           */
+      if (REFINECLASS(theElement)==GREEN_CLASS &&
+          markClass==GREEN_CLASS && updateGreen==0)
+      {
+        /* do not renew green refinement */
+        used = 0;
+      }
                 #ifdef __ANISOTROPIC__
-    if (MARKCLASS(theElement)==RED_CLASS && UPDATE_GREEN(theElement)==0)
-    {
-      ASSERT(TAG(theElement)==PRISM && MARK(theElement)==PRI_QUADSECT);
-      SETUSED(theElement,0);
-    }
+      if (markClass==RED_CLASS && updateGreen==0)
+      {
+        ASSERT(TAG(theElement)==PRISM && mark==PRI_QUADSECT);
+        used = 0;
+      }
                 #endif
 #endif
-  }
+
+      greenFlags[chunk].push_back({theElement,mark,markClass,updateGreen,used});
+    }
+
+    return(GM_OK);
+  });
+
+  ForElementChunks(theElements,nChunks,[&](INT chunk, std::size_t, std::size_t) -> INT
+  {
+    for (const GreenFlags& flags : greenFlags[chunk])
+    {
+      SETMARK(flags.theElement,flags.mark);
+      SETMARKCLASS(flags.theElement,flags.markClass);
+      SETUPDATE_GREEN(flags.theElement,flags.updateGreen);
+      SETUSED(flags.theElement,flags.used);
+    }
+
+    return(GM_OK);
+  });
 
   return(GM_OK);
 }
@@ -2094,17 +2233,36 @@ static INT CheckElementInfo (GRID *theGrid)
 static int GridClosure (GRID *theGrid)
 {
   INT cnt;
+  std::vector<ELEMENT*> theElements;
+  const RefineState& theState = REFINE_STATE(theGrid);
 
   /* initialize used control word entries */
   if (PrepareGridClosure(theGrid) != GM_OK) RETURN(GM_ERROR);
 
+  /* the loops over the elements are run in chunks on several threads */
+  for (ELEMENT *theElement=PFIRSTELEMENT(theGrid); theElement!=NULL;
+       theElement=SUCCE(theElement))
+    theElements.push_back(theElement);
+  const INT nChunks = ClosureChunks(theGrid,theElements.size());
+
   /* compute pattern on edges and elements */
-  if (ComputePatterns(theGrid) != GM_OK) RETURN(GM_ERROR);
+  if (ComputePatterns(theElements,nChunks) != GM_OK) RETURN(GM_ERROR);
+
+  /* the full refrules of the red tetrahedra are computed at once, */
+  /* the fifo loops compute them per element                       */
+  std::vector<INT> fullRefRules;
+        #ifdef UG_DIM_3
+  FullRefRules(theElements,fullRefRules);
+        #endif
+  const std::vector<INT> noFullRefRules;
 
-  firstElement = PFIRSTELEMENT(theGrid);
+  if (theState.fifoFlag)
+    if (InitClosureFIFO(theGrid) != GM_OK) return(GM_OK);
 
-  if (fifoFlag)
-    if (InitClosureFIFO() != GM_OK) return(GM_OK);
+  /* the first loop visits all elements, the next */
+  /* ones the elements of the fifo work list only */
+  std::vector<ELEMENT*> fifoWorkList;
+  const std::vector<ELEMENT*> *loopElements = &theElements;
 
   /* fifo loop */
   do
@@ -2112,14 +2270,14 @@ static int GridClosure (GRID *theGrid)
                 #ifdef UG_DIM_3
                 #if defined(ModelP) && defined(DUNE_UGGRID_TET_RULESET)
     /* edge pattern is needed consistently in CorrectTetrahedronSidePattern() */
-    if (!refine_seq)
+    if (!theState.refine_seq)
     {
       if (ExchangeEdgeClosureInfo(theGrid) != GM_OK) return(GM_ERROR);
     }
                 #endif
 
     /* set side patterns on the elements */
-    if (SetElementSidePatterns(theGrid,firstElement) != GM_OK) RETURN(GM_ERROR);
+    if (SetElementSidePatterns(*loopElements,nChunks) != GM_OK) RETURN(GM_ERROR);
                 #endif
 
                 #ifdef ModelP
@@ -2127,19 +2285,29 @@ static int GridClosure (GRID *theGrid)
                 #endif
 
     /* set rules on the elements */
-    if (SetElementRules(theGrid,firstElement,&cnt) != GM_OK) RETURN(GM_ERROR);
+    if (SetElementRules(theGrid,*loopElements,
+                        (loopElements==&theElements) ? fullRefRules : noFullRefRules,
+                        nChunks,&cnt) != GM_OK) RETURN(GM_ERROR);
 
+    loopElements = &fifoWorkList;
   }
   /* exit only if fifo not active or fifo queue   */
   /* empty or all processor have finished closure */
-  while (fifoFlag && UpdateClosureFIFO(theGrid) &&
-         ManageParallelFIFO(theGrid->ppifContext(), firstElement));
+  while (theState.fifoFlag && UpdateClosureFIFO(theGrid,fifoWorkList));
+
+  /* cnt only counts the elements of the last loop */
+  if (theState.fifoFlag && theState.fifoloop > 0)
+  {
+    cnt = 0;
+    for (ELEMENT *theElement : theElements)
+      if (MARK(theElement)) cnt++;
+  }
 
   /* set patterns on all edges of red elements */
-  if (SetAddPatterns(theGrid) != GM_OK) RETURN(GM_ERROR);
+  if (SetAddPatterns(theGrid,theElements,nChunks) != GM_OK) RETURN(GM_ERROR);
 
   /* build the closure around the red elements */
-  if (BuildGreenClosure(theGrid) != GM_OK) RETURN(GM_ERROR);
+  if (BuildGreenClosure(theElements,nChunks) != GM_OK) RETURN(GM_ERROR);
 
         #if defined(Debug) && defined(ModelP)
   if (CheckElementInfo(theGrid)) RETURN(GM_ERROR);
@@ -2334,6 +2502,284 @@ INT NS_DIM_PREFIX GetSons (const ELEMENT *theElement, ELEMENT *SonList[MAX_SONS]
   return(GM_OK);
 }
 
+/****************************************************************************/
+/*
+   CollectSons - store the sons of an element in theMG->sonTable
+
+   SYNOPSIS:
+   static void CollectSons (SonTable &table, const ELEMENT *theElement);
+
+   PARAMETERS:
+   .  table - son table of the multigrid
+   .  theElement - element whose sons changed
+
+   DESCRIPTION:
+   This function replaces the entry of theElement by the sons GetAllSons
+   returns, the sons returned by GetSons first. Elements without sons get
+   no entry.
+ */
+/****************************************************************************/
+
+static void CollectSons (SonTable &table, const ELEMENT *theElement)
+{
+  auto entry = table.entries.find(theElement);
+  if (entry!=table.entries.end())
+  {
+    table.unused += entry->second.allCount;
+    table.entries.erase(entry);
+  }
+
+  if (NSONS(theElement)==0)
+    return;
+
+  ELEMENT *SonList[MAX_SONS];
+  SonTable::Entry newEntry;
+  newEntry.first = table.sons.size();
+
+  GetSons(theElement,SonList);
+  for (INT i=0; i<MAX_SONS && SonList[i]!=NULL; i++)
+    table.sons.push_back(SonList[i]);
+  newEntry.count = table.sons.size()-newEntry.first;
+
+#ifdef ModelP
+  /* the ghost sons follow the master sons */
+  GetAllSons(theElement,SonList);
+  for (INT i=newEntry.count; i<MAX_SONS && SonList[i]!=NULL; i++)
+    table.sons.push_back(SonList[i]);
+#endif
+  newEntry.allCount = table.sons.size()-newEntry.first;
+
+  table.entries.emplace(theElement,newEntry);
+}
+
+/****************************************************************************/
+/** \brief Store the changed sons in the son table
+
+   \param theMG - multigrid
+
+   This function collects the sons of the elements recorded by SonsChanged
+   since the last update. The sons of other elements are not visited. If
+   more than half of the stored sons are no longer referenced, the table is
+   compacted.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX UpdateSonTable (MULTIGRID *theMG)
+{
+  if (!theMG->sonTable)
+    return;
+  SonTable &table = *theMG->sonTable;
+
+  for (const ELEMENT *theElement : table.changed)
+    CollectSons(table,theElement);
+  table.changed.clear();
+
+  if (2*table.unused > table.sons.size())
+  {
+    std::vector<ELEMENT*> sons;
+    sons.reserve(table.sons.size()-table.unused);
+    for (auto& [theElement,entry] : table.entries)
+    {
+      const INT first = sons.size();
+      sons.insert(sons.end(),table.sons.begin()+entry.first,
+                  table.sons.begin()+entry.first+entry.allCount);
+      entry.first = first;
+    }
+    table.sons.swap(sons);
+    table.unused = 0;
+  }
+
+  table.valid = true;
+}
+
+/****************************************************************************/
+/** \brief Record that the sons of an element changed
+
+   \param theMG - multigrid with son table
+   \param theFather - element which got or lost a son
+
+   The entry of theFather is not used until the next UpdateSonTable.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX SonsChanged (MULTIGRID *theMG, const ELEMENT *theFather)
+{
+  theMG->sonTable->changed.insert(theFather);
+}
+
+/****************************************************************************/
+/** \brief Remove a disposed element from the son table
+
+   \param theMG - multigrid with son table
+   \param theElement - element which is disposed
+
+   The sons of the element are no longer referenced, and its father
+   lost a son.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX SonTableDisposeElement (MULTIGRID *theMG, const ELEMENT *theElement)
+{
+  SonTable &table = *theMG->sonTable;
+
+  auto entry = table.entries.find(theElement);
+  if (entry!=table.entries.end())
+  {
+    table.unused += entry->second.allCount;
+    table.entries.erase(entry);
+  }
+  table.changed.erase(theElement);
+
+  if (EFATHER(theElement)!=NULL)
+    table.changed.insert(EFATHER(theElement));
+}
+
+/****************************************************************************/
+/*
+   StoredSons - entry of an element in the son table
+
+   SYNOPSIS:
+   static const SonTable::Entry *StoredSons (const MULTIGRID *theMG, const ELEMENT *theElement);
+
+   PARAMETERS:
+   .  theMG - multigrid of the element
+   .  theElement - element with sons
+
+   DESCRIPTION:
+   This function returns the entry of theElement if theMG stores the sons
+   and they did not change since the last update, nullptr otherwise.
+ */
+/****************************************************************************/
+
+static const SonTable::Entry *StoredSons (const MULTIGRID *theMG, const ELEMENT *theElement)
+{
+  const SonTable *table = theMG->sonTable.get();
+
+  if (table==nullptr || !table->valid)
+    return nullptr;
+  if (!table->changed.empty() && table->changed.count(theElement)>0)
+    return nullptr;
+
+  auto entry = table->entries.find(theElement);
+  if (entry==table->entries.end())
+    return nullptr;
+
+  return &entry->second;
+}
+
+/****************************************************************************/
+/** \brief Get the sons of an element as a range
+
+   \param theMG - multigrid of the element
+   \param theElement - element
+
+   This function returns the sons GetSons returns. If theMG stores the sons
+   (see SetSonTable) and they did not change since the last update, the range
+   points into the son table and is valid until the grid is changed.
+   Otherwise the sons are collected by GetSons into a buffer of the range.
+
+   \return the range of the sons
+ */
+/****************************************************************************/
+
+SonRange NS_DIM_PREFIX GetSonRange (const MULTIGRID *theMG, const ELEMENT *theElement)
+{
+  SonRange range;
+  if (NSONS(theElement)==0)
+    return range;
+
+  if (const SonTable::Entry *entry = StoredSons(theMG,theElement))
+  {
+    range.first = theMG->sonTable->sons.data()+entry->first;
+    range.count = entry->count;
+    return range;
+  }
+
+  GetSons(theElement,range.buffer.data());
+  while (range.count<MAX_SONS && range.buffer[range.count]!=NULL)
+    range.count++;
+
+  return range;
+}
+
+#ifdef ModelP
+/****************************************************************************/
+/** \brief Get the master and ghost sons of an element as a range
+
+   \param theMG - multigrid of the element
+   \param theElement - element
+
+   This function returns the sons GetAllSons returns, from the son table
+   like GetSonRange if possible.
+
+   \return the range of the sons
+ */
+/****************************************************************************/
+
+SonRange NS_DIM_PREFIX GetAllSonRange (const MULTIGRID *theMG, const ELEMENT *theElement)
+{
+  SonRange range;
+  if (NSONS(theElement)==0)
+    return range;
+
+  if (const SonTable::Entry *entry = StoredSons(theMG,theElement))
+  {
+    range.first = theMG->sonTable->sons.data()+entry->first;
+    range.count = entry->allCount;
+    return range;
+  }
+
+  GetAllSons(theElement,range.buffer.data());
+  while (range.count<MAX_SONS && range.buffer[range.count]!=NULL)
+    range.count++;
+
+  return range;
+}
+#endif
+
+/****************************************************************************/
+/** \brief Switch the storage of the sons of all elements
+
+   \param theMG - multigrid
+   \param store - true to store the sons
+
+   With a son table the sons of each element with sons are stored one after
+   the other in one array, and GetSonRange and GetAllSonRange return them
+   without following the element lists. Creating or disposing an element
+   and the transfer of an element record that the sons of its father
+   changed; AdaptMultiGrid and TransferGridFromLevel collect the sons of
+   these elements at their end. The table hence takes memory proportional
+   to the number of elements and is updated in time proportional to the
+   change. While AdaptMultiGrid runs, the table is not used.
+
+   \return <ul>
+   <li> GM_OK - ok
+   </ul>
+ */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX SetSonTable (MULTIGRID *theMG, bool store)
+{
+  if (!store)
+  {
+    theMG->sonTable.reset();
+    return(GM_OK);
+  }
+
+  if (!theMG->sonTable)
+  {
+    theMG->sonTable = std::make_unique<SonTable>();
+    for (INT level=0; level<TOPLEVEL(theMG); level++)
+      for (ELEMENT *theElement=PFIRSTELEMENT(GRID_ON_LEVEL(theMG,level)); theElement!=NULL;
+           theElement=SUCCE(theElement))
+        if (NSONS(theElement)>0)
+          SonsChanged(theMG,theElement);
+  }
+  UpdateSonTable(theMG);
+
+  return(GM_OK);
+}
+
 /****************************************************************************/
 /*																			*/
 /* Function:  RestrictElementMark							                */
@@ -2526,7 +2972,7 @@ static INT RestrictMarks (const GRID *theGrid)
   {
     if (GetSons(theElement,SonList)!=GM_OK) RETURN(GM_ERROR);
 
-    if (hFlag)
+    if (REFINE_STATE(theGrid).hFlag)
     {
       if (
         /* if element is not refined anyway,                   */
@@ -2602,7 +3048,7 @@ static INT RestrictMarks (const GRID *theGrid)
     if (flag) continue;
 
     /* preserve regular refinement marks */
-    if (hFlag==0 && SonList[0]==NULL) continue;
+    if (REFINE_STATE(theGrid).hFlag==0 && SonList[0]==NULL) continue;
 
     /* remove refinement */
     SETMARK(theElement,NO_REFINEMENT);
@@ -2659,7 +3105,7 @@ static int ComputeCopies (GRID *theGrid)
   }
 
   /* copy all option or neighborhood */
-  if (rFlag==GM_COPY_ALL)
+  if (REFINE_STATE(theGrid).rFlag==GM_COPY_ALL)
   {
         #ifdef ModelP
     flag = UG_GlobalMaxINT(theGrid->ppifContext(), flag);
@@ -3807,7 +4253,7 @@ INT NS_DIM_PREFIX Connect_Sons_of_ElementSide (GRID *theGrid, ELEMENT *theElemen
   if (MARKCLASS(theNeighbor)==NO_CLASS)
   {
 
-    if (hFlag) assert(MARKCLASS(theElement)==YELLOW_CLASS);
+    if (REFINE_STATE(theGrid).hFlag) assert(MARKCLASS(theElement)==YELLOW_CLASS);
 
     return(GM_OK);
   }
@@ -4025,11 +4471,24 @@ INT NS_DIM_PREFIX Connect_Sons_of_ElementSide (GRID *theGrid, ELEMENT *theElemen
                  ElemSortTable[i]->elem);
 #ifdef UG_DIM_3
       if (VEC_DEF_IN_OBJ_OF_GRID(theGrid,SIDEVEC))
+#ifdef ModelP
         if (DisposeDoubledSideVector(theGrid,ElemSortTable[i]->elem,
                                      ElemSortTable[i]->side,
                                      NbSortTable[i]->elem,
                                      NbSortTable[i]->side))
           RETURN(GM_FATAL);
+#else
+        /* keep the vector of the neighbor son: RefineElementsThreaded()  */
+        /* may have linked it into the list of the level, while theGrid   */
+        /* is the private grid of the thread refining this element. The   */
+        /* new vector of this element's son is disposed instead, which    */
+        /* makes no difference without copies on other processors.        */
+        if (DisposeDoubledSideVector(theGrid,NbSortTable[i]->elem,
+                                     NbSortTable[i]->side,
+                                     ElemSortTable[i]->elem,
+                                     ElemSortTable[i]->side))
+          RETURN(GM_FATAL);
+#endif
 #endif
     }
 
@@ -4117,49 +4576,44 @@ static INT RefineElementYellow (GRID *theGrid, ELEMENT *theElement, NODE **theCo
 }
 
 
+/** \brief Son of an element with new green refinement, see GreenSonLayout */
+struct greensondata
+{
+  /** \brief Element type */
+  short tag;
+  /** \brief Boundary element: yes (=1) or no (=0) */
+  short bdy;
+  std::array<NODE*, MAX_CORNERS_OF_ELEM> corners;
+  int nb[MAX_SIDES_OF_ELEM];
+  ELEMENT         *theSon;
+};
+typedef struct greensondata GREENSONDATA;
+
 /****************************************************************************/
-/** \brief Refine an element without context
+/** \brief Compute the sons of an element with new green refinement
 
-   \param theGrid - grid level of sons of theElement
    \param theElement - element to refine
    \param theContext - nodes needed for new elements
+   \param sons - tag, corners and neighbors of the sons
 
-   This function refines an element without context,
-   (i) corner and midnodes are already allocated,
-   (ii) edges between corner and midnodes are ok,
-   (iii) create interior nodes and edges,
-   (iv) create sons and set references to sons.
+   This function determines the sons of an element refined without rule
+   side by side from the nodes of the context. The corner missing in the
+   corner list of each son is the center node. The grid is not changed,
+   EstimateRefinement calls this function with a predicted context.
 
    \return <ul>
    INT
-   .n   0 - ok
-   .n   1 - fatal memory error
+   .n   GM_OK - ok
+   .n   GM_FATAL - side with neither 3 nor 4 corners
  */
 /****************************************************************************/
-static int RefineElementGreen (GRID *theGrid, ELEMENT *theElement, NODE **theContext)
+static INT GreenSonLayout (const ELEMENT *theElement, NODE **theContext,
+                           std::array<GREENSONDATA, MAX_GREEN_SONS>& sons)
 {
-  struct greensondata
-  {
-    /** \brief Element type */
-    short tag;
-    /** \brief Boundary element: yes (=1) or no (=0) */
-    short bdy;
-    std::array<NODE*, MAX_CORNERS_OF_ELEM> corners;
-    int nb[MAX_SIDES_OF_ELEM];
-    ELEMENT         *theSon;
-  };
-  typedef struct greensondata GREENSONDATA;
-
-  std::array<GREENSONDATA, MAX_GREEN_SONS> sons;
-
   int j, k, l;
   int node0;
   bool bdy;
 
-  IFDEBUG(gm,1)
-  UserWriteF("RefineElementGreen(): ELEMENT ID=%d\n",ID(theElement));
-  ENDDEBUG
-
   /* init son data array */
   for (int i = 0; i < MAX_GREEN_SONS; i++)
   {
@@ -4786,6 +5240,42 @@ static int RefineElementGreen (GRID *theGrid, ELEMENT *theElement, NODE **theCon
     }
   }
 
+  return(GM_OK);
+}
+
+
+/****************************************************************************/
+/** \brief Refine an element without context
+
+   \param theGrid - grid level of sons of theElement
+   \param theElement - element to refine
+   \param theContext - nodes needed for new elements
+
+   This function refines an element without context,
+   (i) corner and midnodes are already allocated,
+   (ii) edges between corner and midnodes are ok,
+   (iii) create interior nodes and edges,
+   (iv) create sons and set references to sons.
+
+   \return <ul>
+   INT
+   .n   0 - ok
+   .n   1 - fatal memory error
+ */
+/****************************************************************************/
+static int RefineElementGreen (GRID *theGrid, ELEMENT *theElement, NODE **theContext)
+{
+  std::array<GREENSONDATA, MAX_GREEN_SONS> sons;
+
+  int j, k, l;
+
+  IFDEBUG(gm,1)
+  UserWriteF("RefineElementGreen(): ELEMENT ID=%d\n",ID(theElement));
+  ENDDEBUG
+
+  if (GreenSonLayout(theElement,theContext,sons) != GM_OK)
+    RETURN(GM_FATAL);
+
   /* connect elements over edges */
   for (int i = 0; i < EDGES_OF_ELEM(theElement); i++)
   {
@@ -5369,6 +5859,276 @@ static INT RefineElement (GRID *UpGrid, ELEMENT *theElement,NODE** theNodeContex
 }
 
 
+#ifndef ModelP
+/****************************************************************************/
+/*
+   RefineElementRange - refine a range of elements
+
+   SYNOPSIS:
+   static INT RefineElementRange (GRID *UpGrid, ELEMENT *const *first,
+                                  ELEMENT *const *last);
+
+   PARAMETERS:
+   \param UpGrid - grid receiving the new objects
+   \param first, last - range of elements to refine
+
+   DESCRIPTION:
+   This function updates the context of each element of the range and
+   refines it. The flags of the elements are not changed.
+
+   \return <ul>
+   INT
+   .n   GM_OK - ok
+   .n   GM_FATAL - fatal memory error
+ */
+/****************************************************************************/
+
+static INT RefineElementRange (GRID *UpGrid, ELEMENT *const *first, ELEMENT *const *last)
+{
+  for (; first!=last; first++)
+  {
+    ELEMENTCONTEXT theContext;
+    if (UpdateContext(UpGrid,*first,theContext)!=0)
+      RETURN(GM_FATAL);
+
+    REFINE_CONTEXT_LIST(2,theContext);
+
+    if (RefineElement(UpGrid,*first,theContext))
+      RETURN(GM_FATAL);
+  }
+
+  return(GM_OK);
+}
+
+/****************************************************************************/
+/*
+   RefineElementsThreaded - refine elements of a grid level on several threads
+
+   SYNOPSIS:
+   static INT RefineElementsThreaded (GRID *UpGrid,
+                                      const std::vector<ELEMENT*>& theElements,
+                                      INT nThreads);
+
+   PARAMETERS:
+   \param UpGrid - next finer grid level
+   \param theElements - master elements to refine, all with REFINEMENT_CHANGES
+   \param nThreads - maximum number of threads
+
+   DESCRIPTION:
+   The elements are colored greedily such that elements of the same color
+   share no corner node. Hence they share no edge and no side either and all
+   nodes, edges, elements and side vectors created by the refinement of one
+   element (son, mid, side and center nodes) are touched by no other element
+   of the same color. The colors are refined one after the other, the elements
+   of one color are split into chunks which are refined by separate threads.
+   Each thread links its new objects into the lists of a private copy of
+   'UpGrid'; these lists and the edge and fine dof counts are added to
+   'UpGrid' in chunk order after the color is finished, so the sons of each
+   element stay contiguous.
+
+   The refine flags of an element are updated after its color is done.
+   Until then REFINEMENT_CHANGES holds and neighbors skip the connection
+   to its sons, exactly as in the sequential loop. Elements which cannot be
+   colored with 64 colors are refined by the calling thread.
+
+   Finally the sons are relinked and renumbered in the order of
+   'theElements'. The element lists and element ids are then those of the
+   sequential loop, which matters since the closure of the next refinement
+   step depends on both. Only the order and the ids of nodes, vertices,
+   edges and vectors differ. Boundary parametrizations have to be thread
+   safe.
+
+   \return <ul>
+   INT
+   .n   GM_OK - ok
+   .n   GM_FATAL - fatal memory error
+ */
+/****************************************************************************/
+
+static INT RefineElementsThreaded (GRID *UpGrid, const std::vector<ELEMENT*>& theElements, INT nThreads)
+{
+  MULTIGRID *theMG = MYMG(UpGrid);
+  INT elemId = theMG->elemIdCounter;
+
+  constexpr int maxColors = 64;
+  std::vector<std::vector<ELEMENT*> > colors(maxColors+1);
+  std::unordered_map<const NODE*,std::uint64_t> nodeColors;
+
+  for (ELEMENT *theElement : theElements)
+  {
+    std::uint64_t used = 0;
+    for (INT i=0; i<CORNERS_OF_ELEM(theElement); i++)
+      used |= nodeColors[CORNER(theElement,i)];
+
+    int color = 0;
+    while (color<maxColors && (used>>color) & 1) color++;
+    colors[color].push_back(theElement);
+    if (color==maxColors) continue;
+
+    for (INT i=0; i<CORNERS_OF_ELEM(theElement); i++)
+      nodeColors[CORNER(theElement,i)] |= std::uint64_t(1)<<color;
+  }
+
+  for (int color=0; color<=maxColors; color++)
+  {
+    const std::vector<ELEMENT*>& elements = colors[color];
+    const INT n = elements.size();
+    const INT nChunks = (color<maxColors) ? std::min(nThreads,n) : 1;
+
+    if (nChunks<=1)
+    {
+      if (RefineElementRange(UpGrid,elements.data(),elements.data()+n))
+        RETURN(GM_FATAL);
+    }
+    else
+    {
+      std::vector<GRID> chunkGrids(nChunks,*UpGrid);
+      std::vector<INT> error(nChunks,GM_OK);
+      std::vector<std::thread> threads;
+
+      for (GRID& chunkGrid : chunkGrids)
+      {
+        chunkGrid.status = 0;
+        chunkGrid.nEdge = 0;
+        chunkGrid.nFineDof = 0;
+        GRID_INIT_ELEMENT_LIST(&chunkGrid);
+        GRID_INIT_NODE_LIST(&chunkGrid);
+        GRID_INIT_VERTEX_LIST(&chunkGrid);
+        GRID_INIT_VECTOR_LIST(&chunkGrid);
+      }
+
+      auto refineChunk = [&](INT chunk)
+      {
+        ELEMENT *const *first = elements.data() + (n*chunk)/nChunks;
+        ELEMENT *const *last = elements.data() + (n*(chunk+1))/nChunks;
+        error[chunk] = RefineElementRange(&chunkGrids[chunk],first,last);
+      };
+      for (INT chunk=1; chunk<nChunks; chunk++)
+        threads.emplace_back(refineChunk,chunk);
+      refineChunk(0);
+      for (std::thread& thread : threads)
+        thread.join();
+
+      for (GRID& chunkGrid : chunkGrids)
+      {
+        GRID_APPEND_ELEMENT_LIST(UpGrid,&chunkGrid);
+        GRID_APPEND_NODE_LIST(UpGrid,&chunkGrid);
+        GRID_APPEND_VERTEX_LIST(UpGrid,&chunkGrid);
+        GRID_APPEND_VECTOR_LIST(UpGrid,&chunkGrid);
+        NE(UpGrid) += NE(&chunkGrid);
+        UpGrid->nFineDof += chunkGrid.nFineDof;
+        UpGrid->status |= chunkGrid.status;
+      }
+
+      for (INT chunk=0; chunk<nChunks; chunk++)
+        if (error[chunk]!=GM_OK)
+          RETURN(GM_FATAL);
+    }
+
+    /* refine and refineclass flag */
+    for (ELEMENT *theElement : elements)
+    {
+      SETREFINE(theElement,MARK(theElement));
+      SETREFINECLASS(theElement,MARKCLASS(theElement));
+      SETUSED(theElement,0);
+    }
+  }
+
+  /* the closure of the next step depends on the order and the ids of */
+  /* the elements, so link and number the sons as the sequential loop  */
+  for (ELEMENT *theElement : theElements)
+  {
+    ELEMENT *SonList[MAX_SONS];
+    if (GetAllSons(theElement,SonList)!=GM_OK)
+      RETURN(GM_FATAL);
+    for (INT i=0; i<MAX_SONS && SonList[i]!=NULL; i++)
+    {
+      GRID_UNLINK_ELEMENT(UpGrid,SonList[i]);
+      GRID_LINK_ELEMENT(UpGrid,SonList[i],PrioMaster);
+      ID(SonList[i]) = elemId++;
+    }
+  }
+  theMG->elemIdCounter = elemId;
+
+  return(GM_OK);
+}
+#endif
+
+#ifndef ModelP
+/****************************************************************************/
+/** \brief Record an element whose refinement changed
+
+   \param changeSet - changes of the current AdaptMultiGrid
+   \param theElement - element unrefined and possibly refined again
+   \param hadSons - the element had sons before
+
+   The corners, their vertices and the edges of the new sons which were
+   created by this AdaptMultiGrid are recorded as new nodes, vertices and
+   edges.
+ */
+/****************************************************************************/
+
+static void RecordChangedElement (ChangeSet& changeSet, ELEMENT *theElement, bool hadSons)
+{
+  ELEMENT *SonList[MAX_SONS];
+  if (GetAllSons(theElement,SonList)!=GM_OK)
+    return;
+
+  if (SonList[0] == NULL)
+  {
+    if (hadSons)
+      changeSet.coarsenedElements.push_back(theElement);
+    return;
+  }
+  changeSet.refinedElements.push_back(theElement);
+
+  for (INT i=0; i<MAX_SONS && SonList[i]!=NULL; i++)
+  {
+    ELEMENT *theSon = SonList[i];
+    for (INT j=0; j<CORNERS_OF_ELEM(theSon); j++)
+    {
+      NODE *theNode = CORNER(theSon,j);
+      if (ID(theNode) < changeSet.firstNodeId)
+        continue;
+      changeSet.newNodes.push_back(theNode);
+      if (ID(MYVERTEX(theNode)) >= changeSet.firstVertexId)
+        changeSet.newVertices.push_back(MYVERTEX(theNode));
+    }
+
+    for (INT j=0; j<EDGES_OF_ELEM(theSon); j++)
+    {
+      EDGE *theEdge = GetEdge(CORNER_OF_EDGE_PTR(theSon,j,0),CORNER_OF_EDGE_PTR(theSon,j,1));
+      ASSERT(theEdge != NULL);
+      if (theEdge->id >= changeSet.firstEdgeId)
+        changeSet.newEdges.push_back(theEdge);
+    }
+  }
+}
+
+/****************************************************************************/
+/** \brief Remove the duplicates of the new nodes, vertices and edges of a change set
+
+   \param changeSet - changes of the current AdaptMultiGrid
+ */
+/****************************************************************************/
+
+static void FinishChangeSet (ChangeSet& changeSet)
+{
+  std::sort(changeSet.newNodes.begin(),changeSet.newNodes.end(),
+            [](const NODE *a, const NODE *b) { return ID(a) < ID(b); });
+  changeSet.newNodes.erase(std::unique(changeSet.newNodes.begin(),changeSet.newNodes.end()),
+                           changeSet.newNodes.end());
+  std::sort(changeSet.newVertices.begin(),changeSet.newVertices.end(),
+            [](const VERTEX *a, const VERTEX *b) { return ID(a) < ID(b); });
+  changeSet.newVertices.erase(std::unique(changeSet.newVertices.begin(),changeSet.newVertices.end()),
+                              changeSet.newVertices.end());
+  std::sort(changeSet.newEdges.begin(),changeSet.newEdges.end(),
+            [](const EDGE *a, const EDGE *b) { return a->id < b->id; });
+  changeSet.newEdges.erase(std::unique(changeSet.newEdges.begin(),changeSet.newEdges.end()),
+                           changeSet.newEdges.end());
+}
+#endif
+
 /****************************************************************************/
 /*
    AdaptGrid - adapt one level of the multigrid
@@ -5407,6 +6167,15 @@ static int AdaptGrid (GRID *theGrid, INT *nadapted)
   if (UpGrid == nullptr)
     RETURN(GM_FATAL);
 
+  RefineState& theState = REFINE_STATE(theGrid);
+
+#ifndef ModelP
+  const INT nThreads = MYMG(theGrid)->refineThreads;
+  std::vector<ELEMENT*> elementsToRefine;
+  /* elements with changed refinement and whether they had sons */
+  std::vector<std::pair<ELEMENT*,bool> > changedElements;
+#endif
+
   REFINE_GRID_LIST(1,MYMG(theGrid),GLEVEL(theGrid),("AdaptGrid(%d):\n",GLEVEL(theGrid)),"");
 
         #ifdef IDENT_ONLY_NEW
@@ -5467,7 +6236,7 @@ static int AdaptGrid (GRID *theGrid, INT *nadapted)
       }
                         #endif
 
-      if (hFlag==0 && MARKCLASS(theElement)!=RED_CLASS)
+      if (theState.hFlag==0 && MARKCLASS(theElement)!=RED_CLASS)
       {
         /* remove copy marks */
         SETMARK(theElement,NO_REFINEMENT);
@@ -5477,6 +6246,13 @@ static int AdaptGrid (GRID *theGrid, INT *nadapted)
 
       REFINE_ELEMENT_LIST(1,theElement,"REFINING element: ");
 
+#ifndef ModelP
+      if (MYMG(theGrid)->indexMaintenance || MYMG(theGrid)->changeSet
+          || MYMG(theGrid)->searchIndex || MYMG(theGrid)->surfaceClassUpdate
+          || MYMG(theGrid)->sonTable)
+        changedElements.emplace_back(theElement,NSONS(theElement)>0);
+#endif
+
       if (UnrefineElement(UpGrid,theElement))
         RETURN(GM_FATAL);
 
@@ -5496,28 +6272,38 @@ static int AdaptGrid (GRID *theGrid, INT *nadapted)
         }
                         #endif
 
-      if (EMASTER(theElement))
+#ifndef ModelP
+      if (nThreads>1 && MARKED(theElement))
       {
-        ELEMENTCONTEXT theContext;
-        if (UpdateContext(UpGrid,theElement,theContext)!=0)
-          RETURN(GM_FATAL);
+        /* refined after this loop, see RefineElementsThreaded */
+        elementsToRefine.push_back(theElement);
+      }
+      else
+#endif
+      {
+        if (EMASTER(theElement))
+        {
+          ELEMENTCONTEXT theContext;
+          if (UpdateContext(UpGrid,theElement,theContext)!=0)
+            RETURN(GM_FATAL);
 
-        REFINE_CONTEXT_LIST(2,theContext);
+          REFINE_CONTEXT_LIST(2,theContext);
 
                                 #ifdef Debug
-        CheckElementContextConsistency(theElement,theContext);
+          CheckElementContextConsistency(theElement,theContext);
                                 #endif
 
-        /* is something to do ? */
-        if (MARKED(theElement))
-          if (RefineElement(UpGrid,theElement,theContext))
-            RETURN(GM_FATAL);
-      }
+          /* is something to do ? */
+          if (MARKED(theElement))
+            if (RefineElement(UpGrid,theElement,theContext))
+              RETURN(GM_FATAL);
+        }
 
-      /* refine and refineclass flag */
-      SETREFINE(theElement,MARK(theElement));
-      SETREFINECLASS(theElement,MARKCLASS(theElement));
-      SETUSED(theElement,0);
+        /* refine and refineclass flag */
+        SETREFINE(theElement,MARK(theElement));
+        SETREFINECLASS(theElement,MARKCLASS(theElement));
+        SETUSED(theElement,0);
+      }
 
                         #ifdef ModelP
       /* set update overlap flag */
@@ -5552,18 +6338,49 @@ static int AdaptGrid (GRID *theGrid, INT *nadapted)
                         #endif
       {
         /* count not updated green refinements */
-        No_Green_Update++;
+        theState.No_Green_Update++;
       }
     }
 
     /* count green marks */
-    if (MARKCLASS(theElement) == GREEN_CLASS) Green_Marks++;
+    if (MARKCLASS(theElement) == GREEN_CLASS) theState.Green_Marks++;
 
     /* reset coarse flag */
     SETCOARSEN(theElement,0);
   }
 
-  if (UG_GlobalMaxINT(theGrid->ppifContext(), modified))
+#ifndef ModelP
+  if (RefineElementsThreaded(UpGrid,elementsToRefine,nThreads)!=GM_OK)
+    RETURN(GM_FATAL);
+
+  /* number and record the new objects, see EnableIndexMaintenance, */
+  /* SetChangeSetRecording, SetSearchIndex,                           */
+  /* SetIncrementalSurfaceClasses and SetSonTable; CreateElement does */
+  /* not record the sons, since it may run on several threads         */
+  for (auto [theElement,hadSons] : changedElements)
+  {
+    if (MYMG(theGrid)->sonTable)
+      SonsChanged(MYMG(theGrid),theElement);
+    if (MYMG(theGrid)->indexMaintenance)
+      UpdateSonIndices(MYMG(theGrid),theElement);
+    if (MYMG(theGrid)->changeSet)
+      RecordChangedElement(*MYMG(theGrid)->changeSet,theElement,hadSons);
+    if (MYMG(theGrid)->searchIndex)
+      MYMG(theGrid)->searchIndex->changed.push_back(theElement);
+    if (MYMG(theGrid)->surfaceClassUpdate)
+      MYMG(theGrid)->surfaceClassUpdate->changed.push_back(theElement);
+  }
+#endif
+
+  /* move the new boundary vertices, see SetBoundaryBatching */
+  if (MYMG(theGrid)->boundaryBatch)
+    if (EvaluateBoundaryBatch(MYMG(theGrid)) != GM_OK)
+      RETURN(GM_FATAL);
+
+  /* sum over all processors, the parallel AdaptGrid() needs */
+  /* the sum and the status has to be reset on all of them    */
+  modified = UG_GlobalSumINT(theGrid->ppifContext(), modified);
+  if (modified)
   {
     /* reset (multi)grid status */
     SETGLOBALGSTATUS(UpGrid);
@@ -5638,7 +6455,7 @@ static int AdaptGrid (GRID *theGrid, INT toplevel, INT level, INT newlevel, INT
     }
 
     /* if no grid adaption has occurred adapt next level */
-    *nadapted = UG_GlobalSumINT(theGrid->ppifContext(), *nadapted);
+    /* AdaptLocalGrid() returns the sum over all processors */
     if (*nadapted == 0)
     {
       if (!IDENT_IN_STEPS)
@@ -5685,9 +6502,9 @@ static int AdaptGrid (GRID *theGrid, INT toplevel, INT level, INT newlevel, INT
 
       DDD_CONSCHECK(theGrid->dddContext());
 
-      DDD_XferBegin(theGrid->dddContext());
+      /* connecting the overlap starts its own transfer, without */
+      /* side vectors only for disposing useless ghosts          */
       if (ConnectGridOverlap(theGrid)) RETURN(GM_FATAL);
-      DDD_XferEnd(theGrid->dddContext());
 
       DDD_CONSCHECK(theGrid->dddContext());
 
@@ -5837,9 +6654,10 @@ static INT      PostProcessAdaptMultiGrid(MULTIGRID *theMG)
   REFINE_MULTIGRID_LIST(1,theMG,"END AdaptMultiGrid():\n","","");
 
   /*
-          if (hFlag)
+          if (theMG->refineState.hFlag)
                   UserWriteF(" Number of green refinements not updated: "
-                          "%d (%d green marks)\n",No_Green_Update,Green_Marks);
+                          "%d (%d green marks)\n",theMG->refineState.No_Green_Update,
+                          theMG->refineState.Green_Marks);
    */
 
   /* increment step count */
@@ -5851,7 +6669,7 @@ static INT      PostProcessAdaptMultiGrid(MULTIGRID *theMG)
    */
 
         #ifdef STAT_OUT
-  Print_Adapt_Timer(theMG, total_adapted);
+  Print_Adapt_Timer(theMG, theMG->refineState.total_adapted);
   Manage_Adapt_Timer(0);
         #endif
 
@@ -5877,6 +6695,7 @@ static INT      PostProcessAdaptMultiGrid(MULTIGRID *theMG)
 INT NS_DIM_PREFIX AdaptMultiGrid (MULTIGRID *theMG, INT flag, INT seq, INT mgtest)
 {
   INT nrefined,nadapted;
+  RefineState& theState = theMG->refineState;
 
   /* check necessary condition */
   if (!MG_COARSE_FIXED(theMG))
@@ -5884,27 +6703,47 @@ INT NS_DIM_PREFIX AdaptMultiGrid (MULTIGRID *theMG, INT flag, INT seq, INT mgtes
 
   if (PreProcessAdaptMultiGrid(theMG)) REP_ERR_RETURN(1);
 
+  if (theMG->changeSet)
+  {
+    *theMG->changeSet = ChangeSet();
+    theMG->changeSet->firstNodeId = theMG->nodeIdCounter;
+    theMG->changeSet->firstVertexId = theMG->vertIdCounter;
+    theMG->changeSet->firstEdgeId = theMG->edgeIdCounter;
+  }
+
+  /* only the changed element trees are updated if the index is valid now */
+  if (theMG->searchIndex)
+  {
+    theMG->searchIndex->changed.clear();
+    theMG->searchIndex->incremental = theMG->searchIndex->valid;
+  }
+
+  /* the same holds for the vector classes, see SetSurfaceClasses */
+  if (theMG->surfaceClassUpdate)
+  {
+    theMG->surfaceClassUpdate->changed.clear();
+    theMG->surfaceClassUpdate->incremental = theMG->surfaceClassUpdate->valid;
+  }
+
 #ifdef ModelP
   {
     /* check and restrict partitioning of elements */
     if (CheckPartitioning(theMG))
     {
-      /* Each call to RestrictPartitioning fixes the partitionings of children with
-       * respect to their fathers.  To fix also fix the partitionings of the grandchildren,
-       * the method has to be called again.  To be on the save side we call it once for
-       * every level.
-       * If I omit the loop (the way it was until 11.4.2014 I get assertion failures here
-       * when mixing load balancing and adaptive refinement.  I am not really sure whether
-       * the loop is the correct fix, or whether it just papers over the problem.
-       * Anyway, no crashes for now.
+      /* RestrictPartitioning propagates the restriction flags together with
+       * the partitions from level to level, such that a single call fixes the
+       * partitionings of all descendants, also across processes.
        */
-      for (int level = 0; level < TOPLEVEL(theMG); level++)
-        if (RestrictPartitioning(theMG)) RETURN(GM_FATAL);
+      if (RestrictPartitioning(theMG)) RETURN(GM_FATAL);
       if (CheckPartitioning(theMG)) assert(0);
     }
   }
 #endif
 
+  /* the sons change from here on, the son table is updated at the end */
+  if (theMG->sonTable)
+    theMG->sonTable->valid = false;
+
         #ifdef STAT_OUT
   Manage_Adapt_Timer(1);
         #endif
@@ -5931,17 +6770,17 @@ INT NS_DIM_PREFIX AdaptMultiGrid (MULTIGRID *theMG, INT flag, INT seq, INT mgtes
   }
 
   /* set flags for different modes */
-  rFlag=flag & 0x03;                    /* copy local or all */
-  hFlag=!((flag>>2)&0x1);       /* use hanging nodes */
-  fifoFlag=(flag>>3)&0x1;       /* use fifo              */
+  theState.rFlag=flag & 0x03;                    /* copy local or all */
+  theState.hFlag=!((flag>>2)&0x1);       /* use hanging nodes */
+  theState.fifoFlag=(flag>>3)&0x1;       /* use fifo              */
 
-  refine_seq = seq;
+  theState.refine_seq = seq;
 
-  No_Green_Update=0;
-  Green_Marks=0;
+  theState.No_Green_Update=0;
+  theState.Green_Marks=0;
 
   /* drop marks to regular elements */
-  if (hFlag)
+  if (theState.hFlag)
     if (DropMarks(theMG)) RETURN(GM_ERROR);
 
   /* prepare algebra (set internal flags correctly) */
@@ -5962,7 +6801,7 @@ INT NS_DIM_PREFIX AdaptMultiGrid (MULTIGRID *theMG, INT flag, INT seq, INT mgtes
   {
     GRID *theGrid = GRID_ON_LEVEL(theMG,level);
 
-    if (hFlag)
+    if (theState.hFlag)
     {
       PRINTDEBUG(gm,1,("Begin GridClosure(%d,down):\n",level))
 
@@ -6011,7 +6850,7 @@ INT NS_DIM_PREFIX AdaptMultiGrid (MULTIGRID *theMG, INT flag, INT seq, INT mgtes
       SETMODIFIED(theNode,0);
     }
 
-    if (hFlag)
+    if (theState.hFlag)
     {
       /* leave only regular marks */
       for (ELEMENT *theElement = PFIRSTELEMENT(theGrid); theElement != nullptr; theElement = SUCCE(theElement))
@@ -6041,7 +6880,7 @@ INT NS_DIM_PREFIX AdaptMultiGrid (MULTIGRID *theMG, INT flag, INT seq, INT mgtes
     nrefined += ComputeCopies(theGrid);
 
     /** \todo bug fix to force new level creation */
-    if (!hFlag)
+    if (!theState.hFlag)
     {
       /* set this variable>0 */
       nrefined = 1;
@@ -6050,7 +6889,8 @@ INT NS_DIM_PREFIX AdaptMultiGrid (MULTIGRID *theMG, INT flag, INT seq, INT mgtes
     /* create a new grid level, if at least one element is refined on finest level */
     if (nrefined>0 && level==toplevel) newlevel = 1;
 #ifdef ModelP
-    newlevel = UG_GlobalMaxINT(theMG->ppifContext(), newlevel);
+    if (level==toplevel)
+      newlevel = UG_GlobalMaxINT(theMG->ppifContext(), newlevel);
 #endif
     if (newlevel)
     {
@@ -6083,7 +6923,7 @@ INT NS_DIM_PREFIX AdaptMultiGrid (MULTIGRID *theMG, INT flag, INT seq, INT mgtes
     /* if no grid adaption has occurred adapt next level */
     if (nadapted == 0) continue;
 
-    total_adapted += nadapted;
+    theState.total_adapted += nadapted;
 
     if (level<toplevel || newlevel)
     {
@@ -6093,7 +6933,7 @@ INT NS_DIM_PREFIX AdaptMultiGrid (MULTIGRID *theMG, INT flag, INT seq, INT mgtes
       ClearNodeClasses(FinerGrid);
 
       for (ELEMENT *theElement = FIRSTELEMENT(FinerGrid); theElement != nullptr; theElement = SUCCE(theElement))
-        if (ECLASS(theElement)>=GREEN_CLASS || (rFlag==GM_COPY_ALL)) {
+        if (ECLASS(theElement)>=GREEN_CLASS || (theState.rFlag==GM_COPY_ALL)) {
           SeedNodeClasses(theElement);
         }
 
@@ -6118,7 +6958,795 @@ INT NS_DIM_PREFIX AdaptMultiGrid (MULTIGRID *theMG, INT flag, INT seq, INT mgtes
   DisposeTopLevel(theMG);
   if (TOPLEVEL(theMG) > 0) DisposeTopLevel(theMG);
 
+  if (theMG->indexMaintenance)
+    CompactIndices(theMG);
+
+#ifndef ModelP
+  if (theMG->changeSet)
+    FinishChangeSet(*theMG->changeSet);
+#endif
+
+  UpdateSonTable(theMG);
+
+  if (theMG->searchIndex)
+    RefreshSearchIndex(theMG);
+
   if (PostProcessAdaptMultiGrid(theMG)) REP_ERR_RETURN(1);
 
   return(GM_OK);
 }
+
+/****************************************************************************/
+/** \brief Set the number of threads used for the refinement
+
+   \param theMG - multigrid
+   \param nThreads - maximum number of threads refining the elements of a level
+
+   With more than one thread AdaptMultiGrid refines the marked elements
+   of each level color by color, the elements of one color on several
+   threads, see RefineElementsThreaded. The loops of the closure over the
+   elements of large levels are split into chunks run on several threads
+   as well, see ForElementChunks. The new grid is the same as with one
+   thread, but the order of the objects in the lists and their ids differ.
+   The boundary parametrization has to be thread safe. The parallel UG
+   (ModelP) always refines with one thread.
+
+   \return <ul>
+   <li> GM_OK - ok
+   <li> GM_ERROR - nThreads smaller than one
+   </ul>
+ */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX SetRefineThreads (MULTIGRID *theMG, INT nThreads)
+{
+  if (nThreads<1)
+    RETURN(GM_ERROR);
+
+  theMG->refineThreads = nThreads;
+
+  return(GM_OK);
+}
+
+/****************************************************************************/
+/** \brief Switch the recording of the changes by AdaptMultiGrid
+
+   \param theMG - multigrid
+   \param record - true to record the changes
+
+   While recording, each AdaptMultiGrid fills theMG->changeSet with the
+   elements it refined and coarsened, the nodes, vertices and edges it
+   created and the ids of all elements, nodes, vertices and edges it
+   disposed, see ChangeSet.
+   Prolongation, restriction and index updates then touch only the changed
+   objects instead of scanning the flags of the whole hierarchy. The side
+   vectors created by CreateAlgebra are not recorded. The parallel version
+   does not record changes, since AdaptMultiGrid also creates and disposes
+   ghost objects there.
+
+   \return <ul>
+   <li> GM_OK - ok
+   <li> GM_ERROR - recording requested in the parallel version
+   </ul>
+ */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX SetChangeSetRecording (MULTIGRID *theMG, bool record)
+{
+  if (!record)
+  {
+    theMG->changeSet.reset();
+    return(GM_OK);
+  }
+
+#ifdef ModelP
+  PrintErrorMessage('E',"SetChangeSetRecording","not available in the parallel version");
+  RETURN(GM_ERROR);
+#else
+  if (!theMG->changeSet)
+    theMG->changeSet = std::make_unique<ChangeSet>();
+
+  return(GM_OK);
+#endif
+}
+
+/** \brief Element of the next finer level created by the refinement, see EstimateRefinement */
+struct PredictedElement
+{
+  /** \brief Element type */
+  INT tag;
+
+  /** \brief Mark and mark class given by the closure */
+  INT mark;
+  INT markClass;
+
+  /** \brief Corners, existing nodes or stand-ins */
+  std::array<NODE*, MAX_CORNERS_OF_ELEM> corners;
+};
+
+/** \brief Objects of the next finer level after the refinement, see EstimateRefinement */
+struct PredictedLevel
+{
+  /** \brief Nodes not created yet, stand-ins for the nodes UpdateContext would create */
+  std::deque<NODE> newNodes;
+
+  /** \brief Stand-in by node type, side and father objects */
+  std::map<std::tuple<INT,INT,const void*,const void*>, NODE*> newNodeOf;
+
+  /** \brief New elements */
+  std::deque<PredictedElement> newElements;
+
+  /** \brief Corners of the elements of the finer level */
+  std::unordered_set<const NODE*> nodes;
+
+  /** \brief Edges of the elements of the finer level, as pair of their nodes */
+  std::set<std::pair<const NODE*,const NODE*> > edges;
+};
+
+static NODE *PredictNode (PredictedLevel& fine, INT nodeType, INT side,
+                          const void *father0, const void *father1=nullptr)
+{
+  NODE *&theNode = fine.newNodeOf[{nodeType,side,father0,father1}];
+  if (theNode == nullptr)
+  {
+    theNode = &fine.newNodes.emplace_back();
+    SETNTYPE(theNode,nodeType);
+    /* GreenSonLayout compares the ids of the nodes on a side */
+    ID(theNode) = fine.newNodes.size();
+  }
+  return theNode;
+}
+
+static NODE *PredictSonNode (PredictedLevel& fine, NODE *theNode)
+{
+  /* stand-ins have no son node */
+  if (SONNODE(theNode) != NULL)
+    return SONNODE(theNode);
+  return PredictNode(fine,CORNER_NODE,0,theNode);
+}
+
+static NODE *PredictMidNode (PredictedLevel& fine, NODE *Node0, NODE *Node1)
+{
+  const EDGE *theEdge = GetEdge(Node0,Node1);
+  if (theEdge != NULL && MIDNODE(theEdge) != NULL)
+    return MIDNODE(theEdge);
+  if (std::less<const NODE*>()(Node1,Node0))
+    std::swap(Node0,Node1);
+  return PredictNode(fine,MID_NODE,0,Node0,Node1);
+}
+
+static std::pair<const NODE*,const NODE*> PredictedEdge (const NODE *Node0, const NODE *Node1)
+{
+  return std::less<const NODE*>()(Node0,Node1) ? std::make_pair(Node0,Node1)
+         : std::make_pair(Node1,Node0);
+}
+
+static void PredictSon (PredictedLevel& fine, INT tag, NODE *const *corners)
+{
+  for (INT i=0; i<CORNERS_OF_TAG(tag); i++)
+    fine.nodes.insert(corners[i]);
+
+  for (INT i=0; i<EDGES_OF_TAG(tag); i++)
+  {
+    fine.edges.insert(PredictedEdge(corners[CORNER_OF_EDGE_TAG(tag,i,0)],
+                                    corners[CORNER_OF_EDGE_TAG(tag,i,1)]));
+  }
+}
+
+static void PredictNewSon (PredictedLevel& fine, REFINECOUNT& count, INT tag, NODE *const *corners)
+{
+  PredictedElement& theSon = fine.newElements.emplace_back();
+  theSon.tag = tag;
+  theSon.mark = NO_REFINEMENT;
+  theSon.markClass = NO_CLASS;
+  for (INT i=0; i<CORNERS_OF_TAG(tag); i++)
+    theSon.corners[i] = corners[i];
+
+  PredictSon(fine,tag,corners);
+  count.newElements[tag]++;
+}
+
+/****************************************************************************/
+/** \brief Predict the context of an element
+
+   \param theElement - element to refine
+   \param theContext - nodes needed for new elements
+   \param fine - objects of the next finer level
+
+   This function does what UpdateContext does, but it takes a stand-in
+   from fine for each node UpdateContext would create.
+ */
+/****************************************************************************/
+
+static void PredictContext (const ELEMENT *theElement, NODE **theContext, PredictedLevel& fine)
+{
+  for (INT i=0; i<MAX_CORNERS_OF_ELEM+MAX_NEW_CORNERS_DIM; i++)
+    theContext[i] = NULL;
+
+  const INT Mark = MARK(theElement);
+
+  for (INT i=0; i<CORNERS_OF_ELEM(theElement); i++)
+    theContext[i] = PredictSonNode(fine,CORNER(theElement,i));
+
+  NODE **MidNodes = theContext+CORNERS_OF_ELEM(theElement);
+  for (INT i=0; i<EDGES_OF_ELEM(theElement); i++)
+  {
+    const EDGE *theEdge = GetEdge(CORNER_OF_EDGE_PTR(theElement,i,0),
+                                  CORNER_OF_EDGE_PTR(theElement,i,1));
+    ASSERT(theEdge != NULL);
+
+    bool toBisect = false;
+    if (MARKED_NEW_GREEN(theElement))
+    {
+      if (ADDPATTERN(theEdge) == 0)
+        toBisect = true;
+    }
+                #ifndef __ANISOTROPIC__
+    else
+                #endif
+    if (NODE_OF_RULE(theElement,Mark,i))
+      toBisect = true;
+
+    if (toBisect)
+      MidNodes[i] = PredictMidNode(fine,CORNER_OF_EDGE_PTR(theElement,i,0),
+                                   CORNER_OF_EDGE_PTR(theElement,i,1));
+  }
+
+        #ifdef UG_DIM_3
+  NODE **SideNodes = theContext+CORNERS_OF_ELEM(theElement)+
+                     EDGES_OF_ELEM(theElement);
+  for (INT i=0; i<SIDES_OF_ELEM(theElement); i++)
+  {
+#ifdef DUNE_UGGRID_TET_RULESET
+    if (CORNERS_OF_SIDE(theElement,i) == 3) continue;
+#endif
+
+    const ELEMENT *theNeighbor = NBELEM(theElement,i);
+    INT nbSide = -1;
+    if (theNeighbor != NULL)
+      for (nbSide=0; nbSide<SIDES_OF_ELEM(theNeighbor); nbSide++)
+        if (NBELEM(theNeighbor,nbSide) == theElement) break;
+
+    bool toCreate = false;
+    if (MARKED_NEW_GREEN(theElement))
+    {
+      if (theNeighbor != NULL &&
+          MARKCLASS(theNeighbor)!=GREEN_CLASS &&
+          MARKCLASS(theNeighbor)!=YELLOW_CLASS &&
+          NODE_OF_RULE(theNeighbor,MARK(theNeighbor),
+                       EDGES_OF_ELEM(theNeighbor)+nbSide))
+        toCreate = true;
+    }
+                #ifndef __ANISOTROPIC__
+    else
+                #endif
+    if (NODE_OF_RULE(theElement,Mark,EDGES_OF_ELEM(theElement)+i))
+      toCreate = true;
+
+    if (!toCreate) continue;
+
+    if (theNeighbor != NULL)
+      SideNodes[i] = GetSideNode(theElement,i);
+    if (SideNodes[i] == NULL)
+    {
+      /* both elements of the side have to find the same stand-in */
+      if (theNeighbor != NULL && std::less<const ELEMENT*>()(theNeighbor,theElement))
+        SideNodes[i] = PredictNode(fine,SIDE_NODE,nbSide,theNeighbor);
+      else
+        SideNodes[i] = PredictNode(fine,SIDE_NODE,i,theElement);
+    }
+  }
+        #endif
+
+  if (MARKED_NEW_GREEN(theElement)
+      || NODE_OF_RULE(theElement,Mark,CENTER_NODE_INDEX(theElement)))
+    MidNodes[CENTER_NODE_INDEX(theElement)] =
+      PredictNode(fine,CENTER_NODE,0,theElement);
+}
+
+/****************************************************************************/
+/** \brief Predict the sons of an element
+
+   \param theElement - element to refine
+   \param fine - objects of the next finer level
+   \param count - objects created on the next finer level
+
+   This function enumerates the sons RefineElement would create, with the
+   nodes predicted by PredictContext.
+
+   \return <ul>
+   <li> GM_OK - ok
+   <li> GM_FATAL - no green sons for the element
+   </ul>
+ */
+/****************************************************************************/
+
+static INT PredictSons (const ELEMENT *theElement, PredictedLevel& fine, REFINECOUNT& count)
+{
+  NODE *theContext[MAX_CORNERS_OF_ELEM+MAX_NEW_CORNERS_DIM];
+  PredictContext(theElement,theContext,fine);
+
+  if (MARKCLASS(theElement) == YELLOW_CLASS)
+  {
+    PredictNewSon(fine,count,TAG(theElement),theContext);
+  }
+  else if (MARKED_NEW_GREEN(theElement))
+  {
+    std::array<GREENSONDATA, MAX_GREEN_SONS> sons;
+    if (GreenSonLayout(theElement,theContext,sons) != GM_OK)
+      RETURN(GM_FATAL);
+
+    for (const GREENSONDATA& son : sons)
+    {
+      if (son.tag < 0) continue;
+
+      NODE *SonNodes[MAX_CORNERS_OF_ELEM];
+      for (INT i=0; i<CORNERS_OF_TAG(son.tag); i++)
+        SonNodes[i] = (son.corners[i] != NULL) ? son.corners[i]
+                      : theContext[CORNERS_OF_ELEM(theElement)+CENTER_NODE_INDEX(theElement)];
+      PredictNewSon(fine,count,son.tag,SonNodes);
+    }
+  }
+  else
+  {
+    const REFRULE *rule = MARK2RULEADR(theElement,MARK(theElement));
+    for (INT s=0; s<NSONS_OF_RULE(rule); s++)
+    {
+      NODE *SonNodes[MAX_CORNERS_OF_ELEM];
+      for (INT i=0; i<CORNERS_OF_TAG(SON_TAG_OF_RULE(rule,s)); i++)
+        SonNodes[i] = theContext[SON_CORNER_OF_RULE(rule,s,i)];
+      PredictNewSon(fine,count,SON_TAG_OF_RULE(rule,s),SonNodes);
+    }
+  }
+
+  return(GM_OK);
+}
+
+/****************************************************************************/
+/** \brief Estimate the green closure of the new elements of a grid level
+
+   \param newElements - elements of the level created by the refinement
+
+   This function approximates for the new elements what GridClosure does
+   for the existing ones. An edge of a new element is refined if it already
+   exists and is refined by the closure of its neighbors, the edges of the
+   new elements themselves are not refined. Elements without complete rule
+   set are left unrefined, in 3D these are all but tetrahedra with the
+   DUNE_UGGRID_TET_RULESET. The result is exact in 2D only: the side
+   patterns of the tetrahedra are not matched with their neighbors, which
+   chooses the diagonals of the sides with two refined edges.
+ */
+/****************************************************************************/
+
+static void EstimateGreenClosure (std::deque<PredictedElement>& newElements)
+{
+  for (PredictedElement& theElement : newElements)
+  {
+    const INT tag = theElement.tag;
+#ifdef UG_DIM_3
+#ifdef DUNE_UGGRID_TET_RULESET
+    if (tag != TETRAHEDRON) continue;
+#else
+    continue;
+#endif
+#endif
+
+    INT thePattern = 0;
+    for (INT i=0; i<EDGES_OF_TAG(tag); i++)
+    {
+      const EDGE *theEdge = GetEdge(theElement.corners[CORNER_OF_EDGE_TAG(tag,i,0)],
+                                    theElement.corners[CORNER_OF_EDGE_TAG(tag,i,1)]);
+      if (theEdge != NULL && PATTERN(theEdge))
+        thePattern |= (1<<i);
+    }
+    if (thePattern == 0) continue;
+
+    const INT rule = TagPatterns2Rules(tag,GREEN_CLASS,thePattern);
+    ASSERT(rule >= 0);
+    theElement.mark = RefRules[tag][rule].mark;
+    theElement.markClass = SWITCHCLASS(CLASS_OF_RULE(&RefRules[tag][theElement.mark]))
+                           ? RED_CLASS : GREEN_CLASS;
+  }
+}
+
+/****************************************************************************/
+/** \brief Predict the sons of a new element
+
+   \param theElement - new element to refine
+   \param fine - objects of the next finer level
+   \param count - objects created on the next finer level
+
+   This function enumerates the sons of an element created by the same
+   refinement, see PredictSons. New elements have no side nodes.
+ */
+/****************************************************************************/
+
+static void PredictNewSons (const PredictedElement& theElement, PredictedLevel& fine, REFINECOUNT& count)
+{
+  const INT tag = theElement.tag;
+  NODE *theContext[MAX_CORNERS_OF_ELEM+MAX_NEW_CORNERS_DIM];
+  for (INT i=0; i<MAX_CORNERS_OF_ELEM+MAX_NEW_CORNERS_DIM; i++)
+    theContext[i] = NULL;
+
+  for (INT i=0; i<CORNERS_OF_TAG(tag); i++)
+    theContext[i] = PredictSonNode(fine,theElement.corners[i]);
+
+  if (theElement.markClass == YELLOW_CLASS)
+  {
+    PredictNewSon(fine,count,tag,theContext);
+    return;
+  }
+
+  const REFRULE *rule = &RefRules[tag][theElement.mark];
+  NODE **MidNodes = theContext+CORNERS_OF_TAG(tag);
+  for (INT i=0; i<EDGES_OF_TAG(tag); i++)
+    if (rule->sonandnode[i][0] != -1)
+      MidNodes[i] = PredictMidNode(fine,theElement.corners[CORNER_OF_EDGE_TAG(tag,i,0)],
+                                   theElement.corners[CORNER_OF_EDGE_TAG(tag,i,1)]);
+  if (rule->sonandnode[CENTER_NODE_INDEX_TAG(tag)][0] != -1)
+    MidNodes[CENTER_NODE_INDEX_TAG(tag)] = PredictNode(fine,CENTER_NODE,0,&theElement);
+
+  for (INT s=0; s<NSONS_OF_RULE(rule); s++)
+  {
+    NODE *SonNodes[MAX_CORNERS_OF_ELEM];
+    for (INT i=0; i<CORNERS_OF_TAG(SON_TAG_OF_RULE(rule,s)); i++)
+      SonNodes[i] = theContext[SON_CORNER_OF_RULE(rule,s,i)];
+    PredictNewSon(fine,count,SON_TAG_OF_RULE(rule,s),SonNodes);
+  }
+}
+
+#ifndef ModelP
+/****************************************************************************/
+/** \brief Predict the copy elements of a grid level
+
+   \param theGrid - grid level
+   \param removed - elements of the level disposed by the refinement
+   \param newElements - elements of the level created by the refinement
+
+   This function does what ComputeCopies does, for the grid level as
+   AdaptGrid leaves it: the removed elements are skipped and the new
+   elements, which are not in the grid yet, get copy marks as well.
+ */
+/****************************************************************************/
+
+static void PredictCopies (GRID *theGrid, const std::unordered_set<const ELEMENT*>& removed,
+                           std::deque<PredictedElement>& newElements)
+{
+  struct CopyCandidate
+  {
+    ELEMENT *theElement;
+    PredictedElement *newElement;
+    INT n;
+    const NODE *corners[MAX_CORNERS_OF_ELEM];
+  };
+
+  std::vector<CopyCandidate> candidates;
+  for (ELEMENT *theElement = FIRSTELEMENT(theGrid); theElement != nullptr; theElement = SUCCE(theElement))
+  {
+    if (removed.count(theElement)) continue;
+    CopyCandidate& c = candidates.emplace_back();
+    c.theElement = theElement;
+    c.newElement = nullptr;
+    c.n = CORNERS_OF_ELEM(theElement);
+    for (INT i=0; i<c.n; i++)
+      c.corners[i] = CORNER(theElement,i);
+  }
+  for (PredictedElement& theElement : newElements)
+  {
+    CopyCandidate& c = candidates.emplace_back();
+    c.theElement = nullptr;
+    c.newElement = &theElement;
+    c.n = CORNERS_OF_TAG(theElement.tag);
+    for (INT i=0; i<c.n; i++)
+      c.corners[i] = theElement.corners[i];
+  }
+
+  auto mark = [](const CopyCandidate& c) {
+    return c.theElement ? MARK(c.theElement) : c.newElement->mark;
+  };
+  auto markClass = [](const CopyCandidate& c) {
+    return c.theElement ? MARKCLASS(c.theElement) : c.newElement->markClass;
+  };
+
+  std::unordered_map<const NODE*,INT> nnclass;
+  auto maxClass = [&](const CopyCandidate& c) {
+    INT m = 0;
+    for (INT i=0; i<c.n; i++)
+    {
+      auto it = nnclass.find(c.corners[i]);
+      if (it != nnclass.end()) m = std::max(m,it->second);
+    }
+    return m;
+  };
+
+  /* seed dofs of regularly and irregularly refined elements to 3 */
+  bool seeded = false;
+  for (const CopyCandidate& c : candidates)
+    if (mark(c)!=NO_REFINEMENT &&
+        (markClass(c)==RED_CLASS || markClass(c)==GREEN_CLASS))
+    {
+      for (INT i=0; i<c.n; i++)
+        nnclass[c.corners[i]] = 3;
+      seeded = true;
+    }
+
+  /* copy all option or neighborhood */
+  if (REFINE_STATE(theGrid).rFlag==GM_COPY_ALL)
+  {
+    if (seeded)
+      for (const CopyCandidate& c : candidates)
+        for (INT i=0; i<c.n; i++)
+          nnclass[c.corners[i]] = 3;
+  }
+  else
+  {
+    for (INT cls = 3; cls >= 2; cls--)
+      for (const CopyCandidate& c : candidates)
+        if (maxClass(c) == cls)
+          for (INT i=0; i<c.n; i++)
+          {
+            INT& nodeClass = nnclass[c.corners[i]];
+            if (nodeClass < cls)
+              nodeClass = cls-1;
+          }
+  }
+
+  /* an element is copied if it has a dof of class 2 and higher */
+  for (const CopyCandidate& c : candidates)
+  {
+    if (mark(c)!=NO_REFINEMENT || maxClass(c)<MINVNCLASS) continue;
+    if (c.theElement)
+    {
+      SETMARK(c.theElement,COPY);
+      SETMARKCLASS(c.theElement,YELLOW_CLASS);
+    }
+    else
+    {
+      c.newElement->mark = COPY;
+      c.newElement->markClass = YELLOW_CLASS;
+    }
+  }
+}
+#endif
+
+/****************************************************************************/
+/** \brief Estimate the objects created and removed by AdaptMultiGrid
+
+   \param theMG - multigrid to refine
+   \param flag - flag for switching between different yellow closures, as for AdaptMultiGrid
+   \param count - count[l] is filled with the objects created and removed on level l
+
+   This function computes the closure of the current marks like
+   AdaptMultiGrid does, without creating or disposing any object.
+   For each level it counts the new and the removed elements per tag,
+   nodes per node type and edges. Afterwards the marks, all other
+   flags changed by the closure and the refine state of theMG are
+   restored. count has TOPLEVEL+2 entries, count[0] stays empty.
+
+   The counts are an estimate. They are exact for the refinement of the
+   elements which exist before the call. AdaptMultiGrid may refine new
+   elements in the same call as well, when the closure on their level
+   needs green or copy elements. These are estimated by
+   EstimateGreenClosure and PredictCopies, which is exact in 2D only. In
+   3D the side patterns of new tetrahedra are not matched with their
+   neighbors, so a side with two refined edges may be split along the
+   other diagonal than AdaptMultiGrid chooses. Then the counts of their
+   sons and of the new edges of the next finer level differ slightly,
+   and new pyramids, prisms and hexahedra are only copied. In the parallel
+   version only copies of the existing elements are estimated.
+   An object which is disposed and created again at the same place counts
+   as neither removed nor new. In the parallel version the counts are those
+   of the local process, objects on the interfaces are counted on each process.
+
+   \return <ul>
+   <li> GM_OK - ok
+   <li> GM_COARSE_NOT_FIXED - coarse grid not fixed
+   <li> GM_ERROR - error in the closure
+   </ul>
+ */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX EstimateRefinement (MULTIGRID *theMG, INT flag, std::vector<REFINECOUNT>& count)
+{
+  if (!MG_COARSE_FIXED(theMG))
+    return (GM_COARSE_NOT_FIXED);
+
+  const INT toplevel = TOPLEVEL(theMG);
+  RefineState& theState = theMG->refineState;
+  count.assign(toplevel+2, REFINECOUNT{});
+
+  /* save the flags the closure changes */
+  const RefineState savedState = theState;
+  std::vector<UINT> savedWords;
+  for (INT level = 0; level <= toplevel; level++)
+  {
+    GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+    for (ELEMENT *theElement = PFIRSTELEMENT(theGrid); theElement != nullptr; theElement = SUCCE(theElement))
+    {
+      savedWords.push_back(theElement->ge.control);
+      savedWords.push_back(theElement->ge.flag);
+    }
+    for (NODE *theNode = PFIRSTNODE(theGrid); theNode != nullptr; theNode = SUCCN(theNode))
+    {
+      savedWords.push_back(theNode->control);
+      for (LINK *theLink = START(theNode); theLink != nullptr; theLink = NEXT(theLink))
+        savedWords.push_back(LINK0(MYEDGE(theLink))->control);
+    }
+  }
+
+  auto restoreWords = [&]()
+  {
+    std::size_t n = 0;
+    for (INT level = 0; level <= toplevel; level++)
+    {
+      GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+      for (ELEMENT *theElement = PFIRSTELEMENT(theGrid); theElement != nullptr; theElement = SUCCE(theElement))
+      {
+        theElement->ge.control = savedWords[n++];
+        theElement->ge.flag = savedWords[n++];
+      }
+      for (NODE *theNode = PFIRSTNODE(theGrid); theNode != nullptr; theNode = SUCCN(theNode))
+      {
+        theNode->control = savedWords[n++];
+        for (LINK *theLink = START(theNode); theLink != nullptr; theLink = NEXT(theLink))
+          LINK0(MYEDGE(theLink))->control = savedWords[n++];
+      }
+    }
+    theState = savedState;
+  };
+
+  /* set flags for different modes */
+  theState.rFlag=flag & 0x03;
+  theState.hFlag=!((flag>>2)&0x1);
+  theState.fifoFlag=(flag>>3)&0x1;
+
+  /* compute modification of coarser levels from above */
+  for (INT level = toplevel; level > 0; level--)
+  {
+    GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+
+    if (theState.hFlag)
+    {
+      if (GridClosure(theGrid)<0)
+      {
+        restoreWords();
+        PrintErrorMessage('E',"EstimateRefinement","error in GridClosure");
+        RETURN(GM_ERROR);
+      }
+    }
+                #ifdef ModelP
+    else
+      ExchangeElementRefine(theGrid);
+                #endif
+
+    if (RestrictMarks(GRID_ON_LEVEL(theMG,level-1))!=GM_OK)
+    {
+      restoreWords();
+      RETURN(GM_ERROR);
+    }
+  }
+
+  /* elements disposed together with the sons of their father */
+  std::unordered_set<const ELEMENT*> removed;
+
+  /* elements created on the current level */
+  PredictedLevel current;
+
+  for (INT level = 0; level <= toplevel; level++)
+  {
+    GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+
+    for (ELEMENT *theElement = PFIRSTELEMENT(theGrid); theElement != nullptr; theElement = SUCCE(theElement))
+    {
+      if (removed.count(theElement))
+        SETMARK(theElement,NO_REFINEMENT);
+      else if (theState.hFlag &&
+               !((ECLASS(theElement)==RED_CLASS) && MARKCLASS(theElement)==RED_CLASS))
+        SETMARK(theElement,NO_REFINEMENT);
+    }
+
+    if (theState.hFlag)
+    {
+      if (GridClosure(theGrid)<0)
+      {
+        restoreWords();
+        PrintErrorMessage('E',"EstimateRefinement","error in 2. GridClosure");
+        RETURN(GM_ERROR);
+      }
+      EstimateGreenClosure(current.newElements);
+    }
+                #ifdef ModelP
+    else
+      ExchangeElementRefine(theGrid);
+                #endif
+
+        #ifdef ModelP
+    ComputeCopies(theGrid);
+        #else
+    PredictCopies(theGrid,removed,current.newElements);
+        #endif
+
+    /* enumerate the finer level as AdaptGrid would leave it */
+    PredictedLevel fine;
+    std::unordered_set<const ELEMENT*> removedSons;
+    REFINECOUNT& fineCount = count[level+1];
+
+    for (ELEMENT *theElement = PFIRSTELEMENT(theGrid); theElement != nullptr; theElement = SUCCE(theElement))
+    {
+      if (EVGHOST(theElement)) continue;
+
+      ELEMENT *SonList[MAX_SONS];
+      if (GetAllSons(theElement,SonList)!=GM_OK)
+      {
+        restoreWords();
+        RETURN(GM_ERROR);
+      }
+
+      if (removed.count(theElement) || REFINEMENT_CHANGES(theElement))
+      {
+        for (INT s=0; s<MAX_SONS && SonList[s]!=NULL; s++)
+        {
+          removedSons.insert(SonList[s]);
+          fineCount.removedElements[TAG(SonList[s])]++;
+        }
+
+        if (removed.count(theElement) || !MARKED(theElement) || !EMASTER(theElement))
+          continue;
+        if (theState.hFlag==0 && MARKCLASS(theElement)!=RED_CLASS)
+          continue;
+
+        if (PredictSons(theElement,fine,fineCount)!=GM_OK)
+        {
+          restoreWords();
+          RETURN(GM_ERROR);
+        }
+      }
+      else
+      {
+        for (INT s=0; s<MAX_SONS && SonList[s]!=NULL; s++)
+        {
+          NODE *SonNodes[MAX_CORNERS_OF_ELEM];
+          for (INT i=0; i<CORNERS_OF_ELEM(SonList[s]); i++)
+            SonNodes[i] = CORNER(SonList[s],i);
+          PredictSon(fine,TAG(SonList[s]),SonNodes);
+        }
+      }
+    }
+
+    /* new elements are refined by the closure only */
+    if (theState.hFlag)
+      for (const PredictedElement& theElement : current.newElements)
+        if (theElement.mark != NO_REFINEMENT)
+          PredictNewSons(theElement,fine,fineCount);
+
+    for (const NODE& theNode : fine.newNodes)
+      fineCount.newNodes[NTYPE(&theNode)]++;
+    for (const auto& theEdge : fine.edges)
+      if (GetEdge(theEdge.first,theEdge.second) == NULL)
+        fineCount.newEdges++;
+
+    if (level < toplevel)
+    {
+      GRID *FinerGrid = GRID_ON_LEVEL(theMG,level+1);
+      for (NODE *theNode = PFIRSTNODE(FinerGrid); theNode != nullptr; theNode = SUCCN(theNode))
+      {
+        if (!fine.nodes.count(theNode))
+          fineCount.removedNodes[NTYPE(theNode)]++;
+
+        for (LINK *theLink = START(theNode); theLink != nullptr; theLink = NEXT(theLink))
+        {
+          if (theLink != LINK0(MYEDGE(theLink))) continue;
+          if (!fine.edges.count(PredictedEdge(theNode,NBNODE(theLink))))
+            fineCount.removedEdges++;
+        }
+      }
+    }
+
+    removed = std::move(removedSons);
+    current = std::move(fine);
+  }
+
+  restoreWords();
+
+  return(GM_OK);
+}
@@ -36,6 +36,8 @@
 #ifndef __REFINE__
 #define __REFINE__
 
+#include <vector>
+
 #include <dune/uggrid/low/namespace.h>
 #include <dune/uggrid/low/ugtypes.h>
 #include "gm.h"
@@ -151,8 +153,7 @@ enum REFINE_CE {
 #endif
 
 /* macros for refineinfo */
-#define RINFO_MAX                                               100
-#define REFINEINFO(mg)                                  refine_info
+#define REFINEINFO(mg)                                  ((mg)->refineInfo)
 #define REFINESTEP(r)                                   (r).step
 #define SETREFINESTEP(r,s)                              (r).step = ((s)%RINFO_MAX)
 #define MARKCOUNT(r)                                    (r).markcount[(r).step]
@@ -224,14 +225,18 @@ enum REFINE_CE {
 /*                                                                                                                                                      */
 /****************************************************************************/
 
-typedef struct refineinfo
+typedef struct refineinfo REFINEINFO;
+
+/** \brief Objects created and removed on a grid level, see EstimateRefinement */
+typedef struct refinecount
 {
-  INT step;                                               /* count of calls to AdaptMultiGrid   */
-  float markcount[RINFO_MAX];             /* count of currently marked elements */
-  float predicted_new[RINFO_MAX][3];
-  /* count of elements, would be created */
-  float real[RINFO_MAX];                      /* count of elements before refinement */
-} REFINEINFO;
+  INT newElements[TAGS];                  /* new elements per tag               */
+  INT removedElements[TAGS];              /* removed elements per tag           */
+  INT newNodes[CENTER_NODE+1];            /* new nodes per node type            */
+  INT removedNodes[CENTER_NODE+1];        /* removed nodes per node type        */
+  INT newEdges;                           /* count of new edges                 */
+  INT removedEdges;                       /* count of removed edges             */
+} REFINECOUNT;
 
 typedef INT (*Get_Sons_of_ElementSideProcPtr)(ELEMENT *theElement, INT side, INT *Sons_of_Side,ELEMENT *SonList[MAX_SONS], INT *SonSides, INT NeedSons);
 
@@ -241,7 +246,6 @@ typedef INT (*Get_Sons_of_ElementSideProcPtr)(ELEMENT *theElement, INT side, INT
 /*                                                                          */
 /****************************************************************************/
 
-extern REFINEINFO refine_info;
 #ifdef ModelP
 extern INT ce_NEW_NIDENT;
 extern INT ce_NEW_EDIDENT;
@@ -264,6 +268,7 @@ INT Get_Sons_of_ElementSide(const ELEMENT *theElement,
                             INT useRefineClass=0);
 INT     Connect_Sons_of_ElementSide                     (GRID *theGrid, ELEMENT *theElement, INT side, INT Sons_of_Side, ELEMENT **Sons_of_Side_List, INT *SonSides, INT ioflag);
 INT             Refinement_Changes                                              (ELEMENT *theElement);
+INT     EstimateRefinement                      (MULTIGRID *theMG, INT flag, std::vector<REFINECOUNT>& count);
 
 END_UGDIM_NAMESPACE
 
@@ -35,6 +35,9 @@
 #include <cstdio>
 #include <cmath>
 #include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 /* low module */
 #include <dune/uggrid/low/architecture.h>
@@ -115,7 +118,8 @@ REFRULE * NS_DIM_PREFIX RefRules[TAGS] = {NULL,NULL,NULL,NULL,NULL,NULL,NULL,NUL
 SHORT const* NS_DIM_PREFIX Pattern2Rule[TAGS];
 
 #ifdef UG_DIM_3
-/* define the standard regular rules for tetrahedrons */
+/* define the standard regular rules for tetrahedrons; the choice is
+   process-wide and must not change while any multigrid is refined */
 FULLREFRULEPTR NS_DIM_PREFIX theFullRefRule;
 #endif
 
@@ -2049,6 +2053,203 @@ static INT MaxArea (ELEMENT *theElement)
   return (refrule);
 }
 
+/****************************************************************************/
+/*
+   FullRefRuleMetric - metric of a full refrule for many tetrahedra
+
+   SYNOPSIS:
+   static void FullRefRuleMetric (FULLREFRULEPTR rule, const ElementCornerBuffer& buffer,
+                                  INT i, std::vector<DOUBLE>& metric);
+
+   PARAMETERS:
+   .  rule - ShortestInteriorEdge, MaxPerpendicular, MaxRightAngle or MaxArea
+   .  buffer - corners of the tetrahedra
+   .  i - the interior edge connects the midpoints of edge i and its opposite edge
+   .  metric - filled with the quantity the rule compares for each tetrahedron
+
+   DESCRIPTION:
+   This function computes for all tetrahedra of 'buffer' the same quantity
+   as 'rule' computes for the choice 'i' of one tetrahedron, with the same
+   floating point operations.
+ */
+/****************************************************************************/
+
+static void FullRefRuleMetric (FULLREFRULEPTR rule, const ElementCornerBuffer& buffer,
+                               INT i, std::vector<DOUBLE>& metric)
+{
+  const INT j = OPPOSITE_EDGE_TAG(TETRAHEDRON,i);
+  const auto& xi0 = buffer.x[CORNER_OF_EDGE_TAG(TETRAHEDRON,i,0)];
+  const auto& xi1 = buffer.x[CORNER_OF_EDGE_TAG(TETRAHEDRON,i,1)];
+  const auto& xj0 = buffer.x[CORNER_OF_EDGE_TAG(TETRAHEDRON,j,0)];
+  const auto& xj1 = buffer.x[CORNER_OF_EDGE_TAG(TETRAHEDRON,j,1)];
+  const std::size_t n = metric.size();
+
+  if (rule==ShortestInteriorEdge)
+  {
+    /* distance of the edge midpoints */
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE d[3];
+      for (INT l=0; l<3; l++)
+        d[l] = (0.5*xi0[l][k] + 0.5*xi1[l][k]) - (0.5*xj0[l][k] + 0.5*xj1[l][k]);
+      metric[k] = sqrt(d[0]*d[0]+d[1]*d[1]+d[2]*d[2]);
+    }
+  }
+  else if (rule==MaxPerpendicular)
+  {
+    /* angle between the interior edge and the normal of both edges */
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE a[3],b[3],c[3],m[3];
+      for (INT l=0; l<3; l++)
+      {
+        a[l] = xi0[l][k] - xi1[l][k];
+        b[l] = xj0[l][k] - xj1[l][k];
+        m[l] = (0.5*xi0[l][k] + 0.5*xi1[l][k]) - (0.5*xj0[l][k] + 0.5*xj1[l][k]);
+      }
+      V3_VECTOR_PRODUCT(a,b,c)
+      DOUBLE norm;
+      V3_EUKLIDNORM(c,norm)
+      DOUBLE scale = (norm<SMALL_C) ? 1.0 : 1.0/norm;
+      V3_SCALE(scale,c)
+      V3_EUKLIDNORM(m,norm)
+      scale = (norm<SMALL_C) ? 1.0 : 1.0/norm;
+      V3_SCALE(scale,m)
+      DOUBLE sprd;
+      V3_SCALAR_PRODUCT(m,c,sprd)
+      metric[k] = std::abs(sprd);
+    }
+  }
+  else if (rule==MaxRightAngle)
+  {
+    /* angle between both edges */
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE a[3],b[3];
+      for (INT l=0; l<3; l++)
+      {
+        a[l] = xi0[l][k] - xi1[l][k];
+        b[l] = xj0[l][k] - xj1[l][k];
+      }
+      DOUBLE norm;
+      V3_EUKLIDNORM(a,norm)
+      DOUBLE scale = (norm<SMALL_C) ? 1.0 : 1.0/norm;
+      V3_SCALE(scale,a)
+      V3_EUKLIDNORM(b,norm)
+      scale = (norm<SMALL_C) ? 1.0 : 1.0/norm;
+      V3_SCALE(scale,b)
+      DOUBLE sprd;
+      V3_SCALAR_PRODUCT(a,b,sprd)
+      metric[k] = std::abs(sprd);
+    }
+  }
+  else
+  {
+    /* area spanned by both edges */
+    assert(rule==MaxArea);
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE a[3],b[3],c[3];
+      for (INT l=0; l<3; l++)
+      {
+        a[l] = xi0[l][k] - xi1[l][k];
+        b[l] = xj0[l][k] - xj1[l][k];
+      }
+      V3_VECTOR_PRODUCT(a,b,c)
+      V3_EUKLIDNORM(c,metric[k])
+    }
+  }
+}
+
+/****************************************************************************/
+/** \brief Compute the best full refrule of many tetrahedra at once
+
+   \param theElements - elements of a grid level
+   \param rules - filled with the result of theFullRefRule for the red tetrahedra
+
+   This function evaluates theFullRefRule for all tetrahedra of 'theElements'
+   with MARKCLASS RED_CLASS. The corner coordinates of these tetrahedra are
+   gathered into a buffer first and the quantities compared by the rules
+   ShortestInteriorEdge, MaxPerpendicular, MaxRightAngle and MaxArea are
+   computed in loops over this buffer. Other rules are called per element.
+   The result is the same as calling theFullRefRule for each tetrahedron.
+   'rules' is aligned with 'theElements' and is -1 for all other elements.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX FullRefRules (const std::vector<ELEMENT*>& theElements, std::vector<INT>& rules)
+{
+  rules.assign(theElements.size(),-1);
+
+  std::vector<std::size_t> tets;
+  for (std::size_t e=0; e<theElements.size(); e++)
+    if (TAG(theElements[e])==TETRAHEDRON && MARKCLASS(theElements[e])==RED_CLASS)
+      tets.push_back(e);
+
+  if (theFullRefRule!=ShortestInteriorEdge && theFullRefRule!=MaxPerpendicular
+      && theFullRefRule!=MaxRightAngle && theFullRefRule!=MaxArea)
+  {
+    for (std::size_t e : tets)
+      rules[e] = (*theFullRefRule)(theElements[e]);
+    return;
+  }
+
+  /* gather the corners */
+  const std::size_t n = tets.size();
+  std::vector<ELEMENT*> tetElements(n);
+  for (std::size_t k=0; k<n; k++)
+    tetElements[k] = theElements[tets[k]];
+  ElementCornerBuffer buffer;
+  GatherElementCorners(n,tetElements.data(),buffer);
+
+  std::vector<DOUBLE> metric[3];
+  for (INT i=0; i<3; i++)
+  {
+    metric[i].resize(n);
+    FullRefRuleMetric(theFullRefRule,buffer,i,metric[i]);
+  }
+
+  const INT fullRefRule[3] = {FULL_REFRULE_0_5,FULL_REFRULE_1_3,FULL_REFRULE_2_4};
+  for (std::size_t k=0; k<n; k++)
+  {
+    INT imin = -1;
+    if (theFullRefRule==ShortestInteriorEdge)
+    {
+      const DOUBLE Dist_0_5 = metric[0][k], Dist_1_3 = metric[1][k], Dist_2_4 = metric[2][k];
+      INT flags = (Dist_0_5 < Dist_1_3);
+      flags |= ((Dist_1_3 < Dist_2_4) <<1);
+      flags |= ((Dist_2_4 < Dist_0_5) <<2);
+      constexpr INT choice[7] = {0,0,1,0,2,2,1};
+      if (flags!=7)
+        imin = choice[flags];
+    }
+    else if (theFullRefRule==MaxRightAngle)
+    {
+      DOUBLE Min = MAX_C;
+      for (INT i=0; i<3; i++)
+        if (metric[i][k]<Min)
+        {
+          Min = metric[i][k];
+          imin = i;
+        }
+    }
+    else
+    {
+      DOUBLE Max = -MAX_C;
+      for (INT i=0; i<3; i++)
+        if (metric[i][k]>Max)
+        {
+          Max = metric[i][k];
+          imin = i;
+        }
+    }
+
+    /* degenerated element, let the rule handle it */
+    const std::size_t e = tets[k];
+    rules[e] = (imin<0) ? (*theFullRefRule)(theElements[e]) : fullRefRule[imin];
+  }
+}
+
 #endif /* UG_DIM_3 */
 
 
@@ -2421,6 +2622,235 @@ INT NS_DIM_PREFIX MarkForRefinement (ELEMENT *theElement, enum RefinementRule ru
   return(GM_OK);
 }
 
+/****************************************************************************/
+/*
+   StaticRedMarks - refinement marks of the rules COPY and RED per tag
+
+   SYNOPSIS:
+   static void StaticRedMarks (INT copyMark[TAGS], INT redMark[TAGS]);
+
+   PARAMETERS:
+   .  copyMark - filled with the mark of the rule COPY for each tag
+   .  redMark - filled with the mark of the rule RED for each tag, or -1
+                if it depends on the element (see MarkForRefinement)
+
+   DESCRIPTION:
+   This function hoists the tag switch of MarkForRefinement for the
+   rules used by MarkElements out of the element loop.
+ */
+/****************************************************************************/
+
+static void StaticRedMarks (INT copyMark[TAGS], INT redMark[TAGS])
+{
+  for (INT tag=0; tag<TAGS; tag++)
+    copyMark[tag] = redMark[tag] = -1;
+
+        #ifdef UG_DIM_2
+  copyMark[TRIANGLE] = T_COPY;
+  redMark[TRIANGLE] = T_RED;
+  copyMark[QUADRILATERAL] = Q_COPY;
+  redMark[QUADRILATERAL] = Q_RED;
+        #endif
+
+        #ifdef UG_DIM_3
+  /* the red rule of tetrahedra is chosen by theFullRefRule */
+  copyMark[TETRAHEDRON] = TET_COPY;
+  copyMark[PYRAMID] = PYR_COPY;
+  redMark[PYRAMID] = PYR_RED;
+  copyMark[PRISM] = PRI_COPY;
+                #ifndef __ANISOTROPIC__
+  redMark[PRISM] = PRI_RED;
+                #endif
+  copyMark[HEXAHEDRON] = HEXA_COPY;
+  redMark[HEXAHEDRON] = HEXA_RED;
+        #endif
+}
+
+/****************************************************************************/
+/** \brief Mark many elements for refinement in one pass
+
+   \param theMG - multigrid the elements belong to
+   \param n - number of elements
+   \param theElements - leaf elements to be marked
+   \param rules - refinement rule for each element, NO_REFINEMENT, COPY, RED or COARSE
+
+   This function has the effect of calling MarkForRefinement(theElements[i],rules[i],0)
+   for i=0,...,n-1, but looks up the marks of the rules per tag only once.
+   The loop runs on the refine threads of the multigrid (see SetRefineThreads).
+   Elements whose mark goes to an ancestor (sons of green elements) are
+   marked on the calling thread after the loop, in the given order.
+   Ghost elements are skipped. All rules and elements are checked before
+   the first element is marked, so no marks are changed on error.
+
+   \return <ul>
+   <li> GM_OK if ok </li>
+   <li> GM_ERROR if a rule is not supported or an element is not a leaf </li>
+   </ul>
+ */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX MarkElements (MULTIGRID *theMG, INT n, ELEMENT **theElements,
+                                const enum RefinementRule *rules)
+{
+  INT copyMark[TAGS], redMark[TAGS];
+  StaticRedMarks(copyMark,redMark);
+
+  /* a thread is not worth it for few elements */
+  constexpr INT minChunkSize = 4096;
+  const INT nChunks = std::max<INT>(std::min<INT>(theMG->refineThreads,
+                                                  n/minChunkSize),1);
+  std::vector<std::vector<INT> > deferred(nChunks);
+  std::vector<INT> error(nChunks,GM_OK);
+
+  auto forAllChunks = [nChunks](const auto& function)
+  {
+    std::vector<std::thread> threads;
+    for (INT chunk=1; chunk<nChunks; chunk++)
+      threads.emplace_back(function,chunk);
+    function(0);
+    for (std::thread& thread : threads)
+      thread.join();
+  };
+  auto begin = [n,nChunks](INT chunk) { return (INT)(((long)n*chunk)/nChunks); };
+
+  auto checkChunk = [&](INT chunk)
+  {
+    for (INT i=begin(chunk); i<begin(chunk+1); i++)
+    {
+      ELEMENT *theElement = theElements[i];
+      if (rules[i]!=NO_REFINEMENT && rules[i]!=COPY
+          && rules[i]!=RED && rules[i]!=COARSE)
+      {
+        error[chunk] = GM_ERROR;
+        return;
+      }
+
+      if (theElement==NULL) continue;
+                        #ifdef ModelP
+      if (EGHOST(theElement)) continue;
+                        #endif
+      if (IS_REFINED(theElement))
+      {
+        error[chunk] = GM_ERROR;
+        return;
+      }
+    }
+  };
+
+  auto markChunk = [&](INT chunk)
+  {
+    for (INT i=begin(chunk); i<begin(chunk+1); i++)
+    {
+      ELEMENT *theElement = theElements[i];
+      const enum RefinementRule rule = rules[i];
+
+      if (theElement==NULL) continue;
+                        #ifdef ModelP
+      if (EGHOST(theElement)) continue;
+                        #endif
+
+      SETCOARSEN(theElement,0);
+      switch (rule)
+      {
+      case COARSE :
+        SETMARK(theElement,NO_REFINEMENT);
+        SETMARKCLASS(theElement,0);
+        SETCOARSEN(theElement,1);
+        continue;
+      default :
+        break;
+      }
+
+      /* the mark of this element goes to its father */
+      if (ECLASS(theElement)!=RED_CLASS)
+      {
+        deferred[chunk].push_back(i);
+        continue;
+      }
+
+      switch (rule)
+      {
+      case NO_REFINEMENT :
+        SETMARK(theElement,NO_REFINEMENT);
+        SETMARKCLASS(theElement,0);
+        break;
+      case COPY :
+        SETMARK(theElement,copyMark[TAG(theElement)]);
+        SETMARKCLASS(theElement,RED_CLASS);
+        break;
+      default :
+        if (redMark[TAG(theElement)]<0)
+        {
+          /* only writes this element, too */
+          if (MarkForRefinement(theElement,rule,0)!=GM_OK)
+          {
+            error[chunk] = GM_ERROR;
+            return;
+          }
+          break;
+        }
+        SETMARK(theElement,redMark[TAG(theElement)]);
+        SETMARKCLASS(theElement,RED_CLASS);
+        break;
+      }
+    }
+  };
+
+  forAllChunks(checkChunk);
+  for (INT chunk=0; chunk<nChunks; chunk++)
+    if (error[chunk]!=GM_OK)
+      return(GM_ERROR);
+
+  forAllChunks(markChunk);
+  for (INT chunk=0; chunk<nChunks; chunk++)
+    if (error[chunk]!=GM_OK)
+      return(GM_ERROR);
+
+  /* several sons of a green element may share their father */
+  for (INT chunk=0; chunk<nChunks; chunk++)
+    for (INT i : deferred[chunk])
+      if (MarkForRefinement(theElements[i],rules[i],0)!=GM_OK)
+        return(GM_ERROR);
+
+  return(GM_OK);
+}
+
+/****************************************************************************/
+/** \brief Mark elements for refinement by comparing an error indicator to thresholds
+
+   \param theMG - multigrid the elements belong to
+   \param n - number of elements
+   \param theElements - leaf elements to be marked
+   \param indicator - error indicator for each element
+   \param refineThreshold - elements with indicator > refineThreshold are marked RED
+   \param coarsenThreshold - elements with indicator < coarsenThreshold are marked COARSE
+
+   All other elements are marked NO_REFINEMENT. The rules are computed in one
+   pass over the indicator and applied with MarkElements.
+
+   \return <ul>
+   <li> GM_OK if ok </li>
+   <li> GM_ERROR if coarsenThreshold > refineThreshold or marking failed </li>
+   </ul>
+ */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX MarkElementsByIndicator (MULTIGRID *theMG, INT n, ELEMENT **theElements,
+                                           const DOUBLE *indicator,
+                                           DOUBLE refineThreshold, DOUBLE coarsenThreshold)
+{
+  if (coarsenThreshold>refineThreshold)
+    return(GM_ERROR);
+
+  std::vector<enum RefinementRule> rules(n);
+  for (INT i=0; i<n; i++)
+    rules[i] = (indicator[i]>refineThreshold) ? RED
+               : (indicator[i]<coarsenThreshold) ? COARSE : NO_REFINEMENT;
+
+  return(MarkElements(theMG,n,theElements,rules.data()));
+}
+
+
 /****************************************************************************/
 /** \brief Return true when element can be tagged for refinement
 
@@ -2458,9 +2888,30 @@ INT NS_DIM_PREFIX EstimateHere (const ELEMENT *theElement)
 /****************************************************************************/
 
 INT NS_DIM_PREFIX Patterns2Rules(ELEMENT *theElement, INT pattern)
+{
+  return TagPatterns2Rules(TAG(theElement),MARKCLASS(theElement),pattern);
+}
+
+
+/****************************************************************************/
+/** \brief Return mark of rule for a specific pattern of an element type
+
+   \param tag - element type rule is searched for
+   \param markClass - mark class of the element
+   \param pattern: pattern a rule is searched for
+
+   This function returns mark of rule for a specific pattern, see Patterns2Rules.
+   The mark class matters only for element types without complete rule set.
+
+   \return Mark rule; values of the unnamed enums in the file rm.h
+   mark of rule
+ */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX TagPatterns2Rules(INT tag, INT markClass, INT pattern)
 {
         #ifdef UG_DIM_2
-  switch (TAG(theElement)) {
+  switch (tag) {
   case (TRIANGLE) :
     switch (pattern) {
     /** \todo 0 can mean T_COPY OR T_NOREF */
@@ -2527,7 +2978,7 @@ INT NS_DIM_PREFIX Patterns2Rules(ELEMENT *theElement, INT pattern)
   }
         #endif
         #ifdef UG_DIM_3
-  switch (TAG(theElement)) {
+  switch (tag) {
   case (TETRAHEDRON) :
 #ifdef DUNE_UGGRID_TET_RULESET
     /* convert pattern to old style */
@@ -2536,19 +2987,17 @@ INT NS_DIM_PREFIX Patterns2Rules(ELEMENT *theElement, INT pattern)
     IFDEBUG(gm,0)
     int tetrarule;
     if (pattern<0 || pattern>1023)
-      PRINTDEBUG(gm,0,("Pattern2Rule(): ERROR elem=" EID_FMTX
-                       " pattern=%d\n",EID_PRTX(theElement),pattern))
+      PRINTDEBUG(gm,0,("Pattern2Rule(): ERROR pattern=%d\n",pattern))
       assert(pattern>=0 && pattern<=1023);
-    tetrarule = Pattern2Rule[TAG(theElement)][pattern];
+    tetrarule = Pattern2Rule[tag][pattern];
     if (tetrarule<0 || tetrarule>MaxRules[TETRAHEDRON])
-      PRINTDEBUG(gm,0,("Pattern2Rule(): ERROR elem=" EID_FMTX
-                       " pattern=%d rule=%d\n",EID_PRTX(theElement),pattern,tetrarule))
+      PRINTDEBUG(gm,0,("Pattern2Rule(): ERROR pattern=%d rule=%d\n",pattern,tetrarule))
       assert(tetrarule>=0 && tetrarule<=MaxRules[TETRAHEDRON]);
     ENDDEBUG
 
-    return(Pattern2Rule[TAG(theElement)][pattern]);
+    return(Pattern2Rule[tag][pattern]);
 #else
-    if (MARKCLASS(theElement) != RED_CLASS) return(0);
+    if (markClass != RED_CLASS) return(0);
     switch (pattern) {
     /* copy rule */
     case (0) :
@@ -2565,7 +3014,7 @@ INT NS_DIM_PREFIX Patterns2Rules(ELEMENT *theElement, INT pattern)
 #endif
 
   case (PYRAMID) :
-    if (MARKCLASS(theElement) != RED_CLASS) return(0);
+    if (markClass != RED_CLASS) return(0);
     switch (pattern) {
     /* copy rule */
     case (0) :
@@ -2579,7 +3028,7 @@ INT NS_DIM_PREFIX Patterns2Rules(ELEMENT *theElement, INT pattern)
     break;
 
   case (PRISM) :
-    if (MARKCLASS(theElement) != RED_CLASS) return(0);
+    if (markClass != RED_CLASS) return(0);
     switch (pattern) {
     /* copy rule */
     case (0) :
@@ -2612,7 +3061,7 @@ INT NS_DIM_PREFIX Patterns2Rules(ELEMENT *theElement, INT pattern)
     break;
 
   case (HEXAHEDRON) :
-    if (MARKCLASS(theElement) != RED_CLASS) return(0);
+    if (markClass != RED_CLASS) return(0);
     switch (pattern) {
     /* copy rule */
     case (0) :
@@ -3223,7 +3672,9 @@ static INT InitRuleManager2D (void)
 /****************************************************************************/
 /** \brief InitRuleManager Initialize the 2- or 3D rule set
 
-   This function initialize the 2- or 3D rule set
+   This function initialize the 2- or 3D rule set. The rules and the
+   environment directory of the full refinement rules are shared by all
+   multigrids, so it must not run concurrently with other grid functions.
  */
 /****************************************************************************/
 
@@ -341,10 +341,12 @@ INT ShowRefRuleX        (INT tag, INT nb, PrintfProcPtr Printf);
 
 INT                     InitRuleManager                 (void);
 INT                     Patterns2Rules                  (ELEMENT *theElement,INT pattern);
+INT                     TagPatterns2Rules               (INT tag, INT markClass, INT pattern);
 ELEMENT         *ELEMENT_TO_MARK                (ELEMENT *theElement);
 
 #ifdef UG_DIM_3
 INT             GetRule_AnisotropicRed  (ELEMENT *theElement, INT *Rule);
+void            FullRefRules            (const std::vector<ELEMENT*>& theElements, std::vector<INT>& rules);
 #endif
 
 END_UGDIM_NAMESPACE
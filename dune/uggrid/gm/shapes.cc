@@ -34,6 +34,7 @@
 #include <cstddef>
 
 #include <algorithm>
+#include <vector>
 
 #include <dune/common/math.hh>
 #include <dune/uggrid/low/architecture.h>
@@ -137,6 +138,102 @@ INT NS_DIM_PREFIX UG_GlobalToLocal (INT n, const DOUBLE **Corners,
   return(1);
 }
 
+/****************************************************************************/
+/** \brief Transform global coordinates to local for many elements
+
+   \param buffer - corners of the elements, see GatherElementCorners
+   \param global - global[d][k] is coordinate d of the point in element k
+   \param local - filled with the local coordinates of the points
+   \param error - filled with the return value of UG_GlobalToLocal for each element
+
+   For simplices the transformation is affine and is computed in one loop
+   over the elements without branches, which the compiler can vectorize.
+   The local coordinates are the same as computed by UG_GlobalToLocal and
+   are 0 for degenerate elements. The Newton iteration for other elements
+   is done by UG_GlobalToLocal per element.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX ElementsGlobalToLocal (const ElementCornerBuffer &buffer, const std::vector<DOUBLE> global[DIM],
+                                          std::vector<DOUBLE> local[DIM], std::vector<INT> &error)
+{
+  const std::size_t n = buffer.size();
+  for (INT d=0; d<DIM; d++)
+    local[d].resize(n);
+  error.resize(n);
+  if (n==0) return;
+
+  const INT nCorners = CORNERS_OF_TAG(buffer.tag);
+  if (nCorners!=DIM+1)
+  {
+    for (std::size_t k=0; k<n; k++)
+    {
+      DOUBLE x[MAX_CORNERS_OF_ELEM][DIM];
+      const DOUBLE *Corners[MAX_CORNERS_OF_ELEM];
+      for (INT i=0; i<nCorners; i++)
+      {
+        for (INT d=0; d<DIM; d++)
+          x[i][d] = buffer.x[i][d][k];
+        Corners[i] = x[i];
+      }
+      FieldVector<DOUBLE,DIM> EvalPoint, LocalCoord(0.0);
+      for (INT d=0; d<DIM; d++)
+        EvalPoint[d] = global[d][k];
+      error[k] = UG_GlobalToLocal(nCorners,Corners,EvalPoint,LocalCoord);
+      for (INT d=0; d<DIM; d++)
+        local[d][k] = LocalCoord[d];
+    }
+    return;
+  }
+
+  /* the operations of TRANSFORMATION, M_DIM_INVERT and MT_TIMES_V_DIM */
+  for (std::size_t k=0; k<n; k++)
+  {
+    DOUBLE diff[DIM], M[DIM][DIM], IM[DIM][DIM];
+    for (INT d=0; d<DIM; d++)
+    {
+      diff[d] = global[d][k] - buffer.x[0][d][k];
+      for (INT i=0; i<DIM; i++)
+        M[i][d] = buffer.x[i+1][d][k] - buffer.x[0][d][k];
+    }
+
+                #ifdef UG_DIM_2
+    const DOUBLE det = M[0][0]*M[1][1]-M[1][0]*M[0][1];
+    const bool regular = !(std::abs(det)<SMALL_D*SMALL_D);
+    const DOUBLE invdet = regular ? 1.0/det : 0.0;
+    IM[0][0] =  M[1][1]*invdet;
+    IM[1][0] = -M[1][0]*invdet;
+    IM[0][1] = -M[0][1]*invdet;
+    IM[1][1] =  M[0][0]*invdet;
+    error[k] = regular ? 0 : 2;
+                #else
+    const DOUBLE det = M[0][0]*M[1][1]*M[2][2]
+                       + M[0][1]*M[1][2]*M[2][0]
+                       + M[0][2]*M[1][0]*M[2][1]
+                       - M[0][2]*M[1][1]*M[2][0]
+                       - M[0][0]*M[1][2]*M[2][1]
+                       - M[0][1]*M[1][0]*M[2][2];
+    const bool regular = !(std::abs(det)<SMALL_D*SMALL_D);
+    const DOUBLE invdet = regular ? 1.0/det : 0.0;
+    IM[0][0] = ( M[1][1]*M[2][2] - M[1][2]*M[2][1]) * invdet;
+    IM[0][1] = (-M[0][1]*M[2][2] + M[0][2]*M[2][1]) * invdet;
+    IM[0][2] = ( M[0][1]*M[1][2] - M[0][2]*M[1][1]) * invdet;
+    IM[1][0] = (-M[1][0]*M[2][2] + M[1][2]*M[2][0]) * invdet;
+    IM[1][1] = ( M[0][0]*M[2][2] - M[0][2]*M[2][0]) * invdet;
+    IM[1][2] = (-M[0][0]*M[1][2] + M[0][2]*M[1][0]) * invdet;
+    IM[2][0] = ( M[1][0]*M[2][1] - M[1][1]*M[2][0]) * invdet;
+    IM[2][1] = (-M[0][0]*M[2][1] + M[0][1]*M[2][0]) * invdet;
+    IM[2][2] = ( M[0][0]*M[1][1] - M[0][1]*M[1][0]) * invdet;
+    error[k] = regular ? 0 : 1;
+                #endif
+
+    DOUBLE xi[DIM];
+    MT_TIMES_V_DIM(IM,diff,xi);
+    for (INT d=0; d<DIM; d++)
+      local[d][k] = xi[d];
+  }
+}
+
 /****************************************************************************/
 /** \brief Calculate inner normals of tetrahedra
 
@@ -176,6 +273,66 @@ INT NS_DIM_PREFIX TetraSideNormals (ELEMENT *theElement, DOUBLE **theCorners, DO
   return (0);
 
 }
+
+/****************************************************************************/
+/** \brief Calculate inner normals of many tetrahedra
+
+   \param buffer - corners of tetrahedra, see GatherElementCorners
+   \param normals - normals[s][d][k] is filled with coordinate d of the inner
+                    normal of side s of tetrahedron k
+   \param error - filled with the return value of TetraSideNormals for each tetrahedron
+
+   This function computes the normals as TetraSideNormals, in one loop over
+   the tetrahedra. As TetraSideNormals it stops at the first degenerate side
+   and sets error 1; the normals of the following sides are 0 then.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX TetrahedraSideNormals (const ElementCornerBuffer &buffer,
+                                          std::vector<DOUBLE> normals[MAX_SIDES_OF_ELEM][DIM],
+                                          std::vector<INT> &error)
+{
+  const std::size_t n = buffer.size();
+  assert(n==0 || buffer.tag==TETRAHEDRON);
+  for (INT j=0; j<4; j++)
+    for (INT d=0; d<3; d++)
+      normals[SIDE_OPP_TO_CORNER_TAG(TETRAHEDRON,j)][d].assign(n,0.0);
+  error.assign(n,0);
+
+  for (std::size_t k=0; k<n; k++)
+  {
+    DOUBLE x[4][3];
+    for (INT i=0; i<4; i++)
+      for (INT d=0; d<3; d++)
+        x[i][d] = buffer.x[i][d][k];
+
+    for (INT j=0; j<4; j++)
+    {
+      DOUBLE a[3], b[3], normal[3], norm, h;
+
+      V3_SUBTRACT(x[(j+1)%4],x[(j+2)%4],a)
+      V3_SUBTRACT(x[(j+1)%4],x[(j+3)%4],b)
+      V3_VECTOR_PRODUCT(a,b,normal)
+      V3_EUKLIDNORM(normal,norm)
+      const DOUBLE scale = (norm<SMALL_C) ? 1.0 : 1.0/norm;
+      V3_SCALE(scale,normal)
+      V3_SUBTRACT(x[j],x[(j+1)%4],a)
+      V3_SCALAR_PRODUCT(normal,a,h)
+      const bool degenerate = (std::abs(h)<SMALL_C);
+      const DOUBLE sign = (!degenerate && h<0.0) ? -1.0 : 1.0;
+      V3_SCALE(sign,normal)
+
+      const INT side = SIDE_OPP_TO_CORNER_TAG(TETRAHEDRON,j);
+      for (INT d=0; d<3; d++)
+        normals[side][d][k] = normal[d];
+      if (degenerate)
+      {
+        error[k] = 1;
+        break;
+      }
+    }
+  }
+}
 #endif
 
 /****************************************************************************/
@@ -479,10 +479,12 @@ START_UGDIM_NAMESPACE
 /****************************************************************************/
 
 INT      UG_GlobalToLocal     (INT n, const DOUBLE **Corners, const FieldVector<DOUBLE,DIM>& EvalPoint, FieldVector<DOUBLE,DIM>& LocalCoord);
+void     ElementsGlobalToLocal (const ElementCornerBuffer &buffer, const std::vector<DOUBLE> global[DIM], std::vector<DOUBLE> local[DIM], std::vector<INT> &error);
 
 #ifdef UG_DIM_3
 DOUBLE  N                   (const INT i, const DOUBLE *LocalCoord);
 INT     TetraSideNormals    (ELEMENT *theElement, DOUBLE **theCorners, DOUBLE_VECTOR theNormals[MAX_SIDES_OF_ELEM]);
+void    TetrahedraSideNormals (const ElementCornerBuffer &buffer, std::vector<DOUBLE> normals[MAX_SIDES_OF_ELEM][DIM], std::vector<INT> &error);
 INT     TetMaxSideAngle     (ELEMENT *theElement, const DOUBLE **theCorners, DOUBLE *MaxAngle);
 INT     TetAngleAndLength   (ELEMENT *theElement, const DOUBLE **theCorners, DOUBLE *Angle, DOUBLE *Length);
 #endif
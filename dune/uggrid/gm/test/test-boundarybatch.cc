@@ -0,0 +1,97 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* the global and local coordinates of all vertices in the order of the grid lists */
+static std::vector<DOUBLE> Positions (const MULTIGRID *theMG)
+{
+  std::vector<DOUBLE> positions;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    for (VERTEX *theVertex=FIRSTVERTEX(GRID_ON_LEVEL(theMG,l));
+         theVertex!=nullptr; theVertex=SUCCV(theVertex))
+      for (INT d=0; d<DIM; d++)
+      {
+        positions.push_back(CVECT(theVertex)[d]);
+        if (l>0)
+          positions.push_back(LCVECT(theVertex)[d]);
+      }
+  return positions;
+}
+
+static INT BatchEvaluations (const std::vector<TestSegment>& segments)
+{
+  INT n = 0;
+  for (const TestSegment& segment : segments)
+    n += segment.batchEvaluations;
+  return n;
+}
+
+/* refine a grid with curved segments with and without boundary batching */
+static std::vector<std::vector<ElementTopology> > AdaptCurved (TestSuite& test, INT nThreads)
+{
+  std::vector<TestSegment> segments, batchSegments;
+  MULTIGRID *single = CreateUnitCubeGrid("single",&segments,false);
+  MULTIGRID *batch = CreateUnitCubeGrid("batch",&batchSegments,true);
+  test.require(single!=nullptr && batch!=nullptr, "require that the coarse grids are created");
+  test.require(SetRefineThreads(single,nThreads)==GM_OK && SetRefineThreads(batch,nThreads)==GM_OK,
+               "require that SetRefineThreads() succeeds");
+  test.require(SetBoundaryBatching(batch,true)==GM_OK, "require that SetBoundaryBatching() succeeds");
+  for (std::size_t s=0; s<segments.size(); s++)
+    segments[s].bulge = batchSegments[s].bulge = (s%2==0) ? 0.1 : -0.1;
+
+  for (INT step=0; step<6; step++)
+  {
+    for (MULTIGRID *theMG : {single,batch})
+    {
+      if (step<2)
+        for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+             theElement!=nullptr; theElement=SUCCE(theElement))
+          MarkForRefinement(theElement,RED,0);
+      else
+        MarkMovingFront(theMG,step-2);
+
+      test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+                 "AdaptMultiGrid() must succeed");
+    }
+
+    test.check(GridCounts(single)==GridCounts(batch) && GridTopology(single)==GridTopology(batch),
+               "the adapted grids must be equal");
+    test.check(Positions(single)==Positions(batch),
+               "the batched boundary evaluation must give the vertex positions of the per-node evaluation");
+  }
+
+  test.check(BatchEvaluations(segments)==0, "without batching the batch function must not be called");
+  test.check(BatchEvaluations(batchSegments)>0, "with batching the batch function must be called");
+
+  const auto topology = GridTopology(batch);
+  DisposeMultiGrid(batch);
+  DisposeMultiGrid(single);
+  return topology;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  CompareRefineThreads(test, AdaptCurved);
+
+  ExitUg();
+
+  return test.exit();
+}
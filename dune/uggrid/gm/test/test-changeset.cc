@@ -0,0 +1,164 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* the ids of all objects of a multigrid and the son ids of its elements */
+struct Snapshot
+{
+  std::set<INT> elements, nodes, vertices, edges;
+  std::map<INT,std::set<INT> > sons;
+};
+
+static Snapshot TakeSnapshot (const MULTIGRID *theMG)
+{
+  Snapshot snapshot;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+  {
+    const GRID *theGrid = GRID_ON_LEVEL(theMG,l);
+    for (ELEMENT *theElement=FIRSTELEMENT(theGrid); theElement!=nullptr; theElement=SUCCE(theElement))
+    {
+      snapshot.elements.insert(ID(theElement));
+      ELEMENT *SonList[MAX_SONS];
+      GetAllSons(theElement,SonList);
+      for (INT i=0; i<MAX_SONS && SonList[i]!=nullptr; i++)
+        snapshot.sons[ID(theElement)].insert(ID(SonList[i]));
+    }
+    for (NODE *theNode=FIRSTNODE(theGrid); theNode!=nullptr; theNode=SUCCN(theNode))
+    {
+      snapshot.nodes.insert(ID(theNode));
+      for (LINK *theLink=START(theNode); theLink!=nullptr; theLink=NEXT(theLink))
+        snapshot.edges.insert(MYEDGE(theLink)->id);
+    }
+    for (VERTEX *theVertex=FIRSTVERTEX(theGrid); theVertex!=nullptr; theVertex=SUCCV(theVertex))
+      snapshot.vertices.insert(ID(theVertex));
+  }
+  return snapshot;
+}
+
+static std::set<INT> Difference (const std::set<INT>& a, const std::set<INT>& b)
+{
+  std::set<INT> difference;
+  std::set_difference(a.begin(),a.end(),b.begin(),b.end(),
+                      std::inserter(difference,difference.end()));
+  return difference;
+}
+
+template <class Object, class Id>
+static std::set<INT> Ids (const std::vector<Object*>& objects, Id id)
+{
+  std::set<INT> ids;
+  for (Object *object : objects)
+    ids.insert(id(object));
+  return ids;
+}
+
+static std::set<INT> Ids (const std::vector<INT>& ids)
+{
+  return std::set<INT>(ids.begin(),ids.end());
+}
+
+/* compare the change set of the last AdaptMultiGrid with the difference of the grids */
+static void CheckChangeSet (TestSuite& test, const ChangeSet& changeSet,
+                            const Snapshot& before, const Snapshot& after)
+{
+  test.check(Ids(changeSet.newNodes,[](NODE *n) { return ID(n); })
+             ==Difference(after.nodes,before.nodes), "the change set must contain the new nodes");
+  test.check(Ids(changeSet.newVertices,[](VERTEX *v) { return ID(v); })
+             ==Difference(after.vertices,before.vertices), "the change set must contain the new vertices");
+  test.check(Ids(changeSet.newEdges,[](EDGE *e) { return e->id; })
+             ==Difference(after.edges,before.edges), "the change set must contain the new edges");
+
+  test.check(Ids(changeSet.deletedElements)==Difference(before.elements,after.elements),
+             "the change set must contain the disposed elements");
+  test.check(Ids(changeSet.deletedNodes)==Difference(before.nodes,after.nodes),
+             "the change set must contain the disposed nodes");
+  test.check(Ids(changeSet.deletedVertices)==Difference(before.vertices,after.vertices),
+             "the change set must contain the disposed vertices");
+  test.check(Ids(changeSet.deletedEdges)==Difference(before.edges,after.edges),
+             "the change set must contain the disposed edges");
+
+  /* elements whose sons changed, including new elements refined again */
+  std::set<INT> refined, coarsened;
+  for (INT id : after.elements)
+  {
+    const auto sonsBefore = before.sons.find(id);
+    const auto sonsAfter = after.sons.find(id);
+    if (sonsAfter!=after.sons.end())
+    {
+      if (sonsBefore==before.sons.end() || sonsBefore->second!=sonsAfter->second)
+        refined.insert(id);
+    }
+    else if (sonsBefore!=before.sons.end())
+      coarsened.insert(id);
+  }
+  test.check(Ids(changeSet.refinedElements,[](ELEMENT *e) { return ID(e); })==refined,
+             "the change set must contain the refined elements");
+  test.check(Ids(changeSet.coarsenedElements,[](ELEMENT *e) { return ID(e); })==coarsened,
+             "the change set must contain the coarsened elements");
+
+  /* the new elements are the sons of the refined elements */
+  std::set<INT> sons;
+  for (INT id : refined)
+    sons.insert(after.sons.at(id).begin(),after.sons.at(id).end());
+  test.check(sons==Difference(after.elements,before.elements),
+             "the new elements must be the sons of the refined elements");
+}
+
+static std::vector<std::vector<ElementTopology> > AdaptWithChangeSet (TestSuite& test, INT nThreads)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("changeset");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  test.require(SetRefineThreads(theMG,nThreads)==GM_OK, "require that SetRefineThreads() succeeds");
+  test.require(SetChangeSetRecording(theMG,true)==GM_OK, "require that SetChangeSetRecording() succeeds");
+
+  /* refine, then move the front, which refines and coarsens */
+  for (INT step=0; step<8; step++)
+  {
+    if (step<2)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+      MarkMovingFront(theMG,step-2);
+
+    const Snapshot before = TakeSnapshot(theMG);
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+    CheckChangeSet(test,*theMG->changeSet,before,TakeSnapshot(theMG));
+  }
+
+  const auto topology = GridTopology(theMG);
+  DisposeMultiGrid(theMG);
+  return topology;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  CompareRefineThreads(test, AdaptWithChangeSet);
+
+  ExitUg();
+
+  return test.exit();
+}
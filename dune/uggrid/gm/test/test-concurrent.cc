@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* the object counts and the sum of the vertex coordinates of all levels
+   after each adaptation step, or nothing if a step failed */
+static std::vector<DOUBLE> Adapt (const std::string& name, bool parametrized)
+{
+  std::vector<DOUBLE> result;
+  std::vector<TestSegment> segments;
+
+  MULTIGRID *theMG = CreateUnitCubeGrid(name.c_str(),parametrized ? &segments : nullptr);
+  if (theMG==nullptr)
+    return {};
+
+  for (INT step=0; step<6; step++)
+  {
+    if (step<2)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+      MarkMovingFront(theMG,step-2);
+
+    if (AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)!=GM_OK)
+      return {};
+
+    for (INT count : GridCounts(theMG))
+      result.push_back(count);
+    for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    {
+      DOUBLE sum = 0.0;
+      for (VERTEX *theVertex=FIRSTVERTEX(GRID_ON_LEVEL(theMG,l));
+           theVertex!=nullptr; theVertex=SUCCV(theVertex))
+        for (INT d=0; d<DIM; d++)
+          sum += CVECT(theVertex)[d];
+      result.push_back(sum);
+    }
+  }
+
+  DisposeMultiGrid(theMG);
+  return result;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  const std::vector<DOUBLE> linear = Adapt("linear", false);
+  const std::vector<DOUBLE> parametrized = Adapt("parametrized", true);
+  test.require(!linear.empty() && !parametrized.empty(), "require that the grids are adapted");
+
+  /* two grids of each kind at the same time */
+  constexpr INT nThreads = 4;
+  std::vector<std::vector<DOUBLE> > results(nThreads);
+  std::vector<std::thread> threads;
+  for (INT i=0; i<nThreads; i++)
+    threads.emplace_back([&results,i] {
+      results[i] = Adapt("concurrent"+std::to_string(i), i%2==1);
+    });
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (INT i=0; i<nThreads; i++)
+    test.check(results[i]==((i%2==1) ? parametrized : linear),
+               "adapting grids concurrently must give the grids adapted one after another");
+
+  ExitUg();
+
+  return test.exit();
+}
@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <set>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "../refine.h"
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* the elements per tag, the nodes per node type and the edges of the
+   first levels of a multigrid */
+static std::vector<std::vector<INT> > LevelCounts (const MULTIGRID *theMG, INT nLevels)
+{
+  std::vector<std::vector<INT> > counts(nLevels,std::vector<INT>(TAGS+CENTER_NODE+2,0));
+  for (INT l=0; l<=TOPLEVEL(theMG) && l<nLevels; l++)
+  {
+    const GRID *theGrid = GRID_ON_LEVEL(theMG,l);
+    for (ELEMENT *theElement=FIRSTELEMENT(theGrid); theElement!=nullptr; theElement=SUCCE(theElement))
+      counts[l][TAG(theElement)]++;
+    for (NODE *theNode=FIRSTNODE(theGrid); theNode!=nullptr; theNode=SUCCN(theNode))
+      counts[l][TAGS+NTYPE(theNode)]++;
+    counts[l][TAGS+CENTER_NODE+1] = NE(theGrid);
+  }
+  return counts;
+}
+
+/* the same counts changed by an estimate */
+static std::vector<INT> Estimated (const std::vector<INT>& counts, const REFINECOUNT& count)
+{
+  std::vector<INT> estimated = counts;
+  for (INT tag=0; tag<TAGS; tag++)
+    estimated[tag] += count.newElements[tag]-count.removedElements[tag];
+  for (INT type=0; type<=CENTER_NODE; type++)
+    estimated[TAGS+type] += count.newNodes[type]-count.removedNodes[type];
+  estimated[TAGS+CENTER_NODE+1] += count.newEdges-count.removedEdges;
+  return estimated;
+}
+
+static std::vector<INT> Marks (const MULTIGRID *theMG)
+{
+  std::vector<INT> marks;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+      marks.insert(marks.end(),{(INT)MARK(theElement),(INT)MARKCLASS(theElement),(INT)COARSEN(theElement)});
+  return marks;
+}
+
+/* compare the estimate of each adaptation step with the grid AdaptMultiGrid creates */
+static void EstimateAdaptation (TestSuite& test)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("estimate");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+
+  INT nChecked = 0;
+  for (INT step=0; step<8; step++)
+  {
+    if (step<2)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+      MarkMovingFront(theMG,step-2);
+
+    const std::vector<INT> marks = Marks(theMG);
+    std::vector<REFINECOUNT> count;
+    test.check(EstimateRefinement(theMG,GM_REFINE_TRULY_LOCAL,count)==GM_OK,
+               "EstimateRefinement() must succeed");
+    test.require(count.size()==(std::size_t)TOPLEVEL(theMG)+2, "there must be a count for each level and the next one");
+    test.check(Marks(theMG)==marks, "EstimateRefinement() must not change the marks");
+
+    std::set<INT> existing;
+    for (INT l=0; l<=TOPLEVEL(theMG); l++)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        existing.insert(ID(theElement));
+
+    const INT nLevels = count.size();
+    const std::vector<std::vector<INT> > before = LevelCounts(theMG,nLevels);
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+    const std::vector<std::vector<INT> > after = LevelCounts(theMG,nLevels);
+
+    for (INT l=1; l<nLevels; l++)
+    {
+      /* the estimate is exact for the sons of the existing elements, the
+         sons of elements created and refined in the same call are exact
+         only for the sequential version in 2D */
+      bool exact = true;
+#if defined UG_DIM_3 || defined ModelP
+      for (ELEMENT *theElement=(l-1<=TOPLEVEL(theMG)) ? FIRSTELEMENT(GRID_ON_LEVEL(theMG,l-1)) : nullptr;
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        if (NSONS(theElement)>0 && !existing.count(ID(theElement)))
+          exact = false;
+#endif
+      if (!exact) continue;
+
+      test.check(Estimated(before[l],count[l])==after[l],
+                 "EstimateRefinement() must count the elements, nodes and edges AdaptMultiGrid creates and removes");
+      nChecked++;
+    }
+  }
+  test.check(nChecked>=8, "the estimate of most levels must be checked");
+
+  DisposeMultiGrid(theMG);
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  EstimateAdaptation(test);
+
+  ExitUg();
+
+  return test.exit();
+}
@@ -0,0 +1,119 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+#include <dune/uggrid/low/ugenv.h>
+
+#include "../rm.h"
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* compare FullRefRules with theFullRefRule for each tetrahedron, for all
+   full refrules with a batched version */
+static void CompareFullRefRules (TestSuite& test, const std::vector<ELEMENT*>& theElements)
+{
+  const FULLREFRULEPTR defaultRule = theFullRefRule;
+  ENVDIR *theDir = ChangeEnvDir("/best full refrule");
+  test.require(theDir!=nullptr, "require the directory of the full refrules");
+
+  INT nRules = 0;
+  for (ENVITEM *item=ENVDIR_DOWN(theDir); item!=nullptr; item=NEXT_ENVITEM(item))
+  {
+    theFullRefRule = ((FULLREFRULE *)item)->theFullRefRule;
+    nRules++;
+
+    std::vector<INT> rules;
+    FullRefRules(theElements,rules);
+    test.require(rules.size()==theElements.size(), "FullRefRules() must return one rule per element");
+
+    std::set<INT> chosen;
+    for (std::size_t e=0; e<theElements.size(); e++)
+    {
+      ELEMENT *theElement = theElements[e];
+      const INT rule = (MARKCLASS(theElement)==RED_CLASS) ? (*theFullRefRule)(theElement) : -1;
+      test.check(rules[e]==rule, "FullRefRules() must choose the rule of theFullRefRule")
+        << ENVITEM_NAME(item) << ", element " << ID(theElement);
+      chosen.insert(rules[e]);
+    }
+    test.check(chosen.size()>2, "the distorted elements must not all get the same rule")
+      << ENVITEM_NAME(item);
+  }
+  test.check(nRules>=4, "the batched full refrules must be installed");
+
+  theFullRefRule = defaultRule;
+}
+
+/* the tetrahedra of level 2 of the unit cube with displaced vertices, some
+   of them flat or with coinciding corners */
+static void DistortedLevel (TestSuite& test)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("fullrefrules");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  for (INT step=0; step<2; step++)
+  {
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+      MarkForRefinement(theElement,RED,0);
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+  }
+
+  std::vector<ELEMENT*> theElements;
+  std::set<VERTEX*> vertices;
+  for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,2)); theElement!=nullptr; theElement=SUCCE(theElement))
+  {
+    theElements.push_back(theElement);
+    for (INT i=0; i<CORNERS_OF_ELEM(theElement); i++)
+      vertices.insert(MYVERTEX(CORNER(theElement,i)));
+  }
+
+  /* the rules only see the coordinates, the grid is not used afterwards */
+  for (VERTEX *theVertex : vertices)
+    for (INT j=0; j<DIM; j++)
+      CVECT(theVertex)[j] += 0.08*std::sin(1.7*ID(theVertex)+2.3*j);
+
+  /* all rules handle elements they cannot compare themselves: a flat
+     tetrahedron, one with coinciding corners and one collapsed to a point */
+  auto corner = [&](INT e, INT i) -> FieldVector<DOUBLE,DIM>& {
+    return CVECT(MYVERTEX(CORNER(theElements[e],i)));
+  };
+  corner(0,3) = corner(0,0);
+  corner(0,3).axpy(0.5,corner(0,1)-corner(0,0));
+  corner(0,3).axpy(0.5,corner(0,2)-corner(0,0));
+  corner(100,1) = corner(100,0);
+  for (INT i=1; i<CORNERS_OF_ELEM(theElements[200]); i++)
+    corner(200,i) = corner(200,0);
+
+  /* only the red tetrahedra get a rule */
+  for (std::size_t e=0; e<theElements.size(); e++)
+    SETMARKCLASS(theElements[e],(e%5==4) ? GREEN_CLASS : RED_CLASS);
+
+  CompareFullRefRules(test,theElements);
+
+  DisposeMultiGrid(theMG);
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  DistortedLevel(test);
+
+  ExitUg();
+
+  return test.exit();
+}
@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <cmath>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "../evm.h"
+#include "../shapes.h"
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+static const DOUBLE tolerance = 1e-12;
+
+/* compare the batched kernels with the functions for one element on all
+   elements of one tag */
+static void CheckKernels (TestSuite& test, const ElementCornerBuffer& buffer)
+{
+  const std::size_t n = buffer.size();
+
+  std::vector<DOUBLE> volume, center[DIM];
+  ElementVolumes(buffer,volume);
+  ElementCentersOfMass(buffer,center);
+  for (std::size_t k=0; k<n; k++)
+  {
+    test.check(volume[k]==ElementVolume(buffer.elements[k]),
+               "ElementVolumes() must give the volume of ElementVolume()");
+    DOUBLE_VECTOR centerOfMass;
+    CalculateCenterOfMass(buffer.elements[k],centerOfMass);
+    for (INT d=0; d<DIM; d++)
+      test.check(std::abs(center[d][k]-centerOfMass[d])<tolerance,
+                 "ElementCentersOfMass() must give the center of CalculateCenterOfMass()");
+  }
+
+  /* the local coordinates of the centers and of a point outside the element */
+  for (DOUBLE shift : {0.0,0.3})
+  {
+    std::vector<DOUBLE> global[DIM], local[DIM];
+    std::vector<INT> error;
+    for (INT d=0; d<DIM; d++)
+    {
+      global[d] = center[d];
+      for (DOUBLE& x : global[d])
+        x += shift*(d+1);
+    }
+    ElementsGlobalToLocal(buffer,global,local,error);
+    for (std::size_t k=0; k<n; k++)
+    {
+      const DOUBLE *Corners[MAX_CORNERS_OF_ELEM];
+      for (INT i=0; i<CORNERS_OF_ELEM(buffer.elements[k]); i++)
+        Corners[i] = CVECT(MYVERTEX(CORNER(buffer.elements[k],i))).data();
+      FieldVector<DOUBLE,DIM> EvalPoint, LocalCoord(0.0);
+      for (INT d=0; d<DIM; d++)
+        EvalPoint[d] = global[d][k];
+      test.check(error[k]==UG_GlobalToLocal(CORNERS_OF_ELEM(buffer.elements[k]),Corners,EvalPoint,LocalCoord),
+                 "ElementsGlobalToLocal() must return the error of UG_GlobalToLocal()");
+      for (INT d=0; d<DIM; d++)
+        test.check(std::abs(local[d][k]-LocalCoord[d])<tolerance,
+                   "ElementsGlobalToLocal() must give the local coordinates of UG_GlobalToLocal()");
+    }
+  }
+
+#ifdef UG_DIM_3
+  if (buffer.tag!=TETRAHEDRON) return;
+  std::vector<DOUBLE> normals[MAX_SIDES_OF_ELEM][DIM];
+  std::vector<INT> error;
+  TetrahedraSideNormals(buffer,normals,error);
+  for (std::size_t k=0; k<n; k++)
+  {
+    DOUBLE *Corners[MAX_CORNERS_OF_ELEM];
+    for (INT i=0; i<CORNERS_OF_TAG(TETRAHEDRON); i++)
+      Corners[i] = CVECT(MYVERTEX(CORNER(buffer.elements[k],i))).data();
+    DOUBLE_VECTOR Normals[MAX_SIDES_OF_ELEM];
+    test.check(error[k]==TetraSideNormals(buffer.elements[k],Corners,Normals),
+               "TetrahedraSideNormals() must return the error of TetraSideNormals()");
+    for (INT s=0; s<SIDES_OF_TAG(TETRAHEDRON); s++)
+      for (INT d=0; d<DIM; d++)
+        test.check(std::abs(normals[s][d][k]-Normals[s][d])<tolerance,
+                   "TetrahedraSideNormals() must give the normals of TetraSideNormals()");
+  }
+#endif
+}
+
+/* the kernels on the levels of a grid with curved boundary segments */
+static void AdaptCurved (TestSuite& test)
+{
+  std::vector<TestSegment> segments;
+  MULTIGRID *theMG = CreateUnitCubeGrid("geometry",&segments);
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  for (std::size_t s=0; s<segments.size(); s++)
+    segments[s].bulge = (s%2==0) ? 0.1 : -0.1;
+
+  for (INT step=0; step<5; step++)
+  {
+    if (step<2)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+      MarkMovingFront(theMG,step-2);
+
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+
+    for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    {
+      GRID *theGrid = GRID_ON_LEVEL(theMG,l);
+      ElementCornerBuffer buffers[TAGS];
+      GatherGridCorners(theGrid,buffers);
+      for (const ElementCornerBuffer& buffer : buffers)
+        CheckKernels(test,buffer);
+#ifdef ModelP
+      test.check(CheckGrid(theGrid,1,0,1,1)==GM_OK, "CheckGrid() must accept the grid");
+#else
+      test.check(CheckGrid(theGrid,1,0,1)==GM_OK, "CheckGrid() must accept the grid");
+#endif
+    }
+  }
+
+  DisposeMultiGrid(theMG);
+}
+
+#ifdef UG_DIM_3
+/* a tetrahedron with a flat side: the batched normals stop where
+   TetraSideNormals() stops */
+static void DegenerateTetrahedron (TestSuite& test)
+{
+  const DOUBLE x[4][3] = {{0.0,0.0,0.0},{1.0,0.0,0.0},{0.0,1.0,0.0},{1.0,1.0,0.0}};
+
+  ElementCornerBuffer buffer;
+  buffer.tag = TETRAHEDRON;
+  buffer.elements.push_back(nullptr);
+  for (INT i=0; i<4; i++)
+    for (INT d=0; d<3; d++)
+      buffer.x[i][d].push_back(x[i][d]);
+
+  std::vector<DOUBLE> normals[MAX_SIDES_OF_ELEM][DIM];
+  std::vector<INT> error;
+  TetrahedraSideNormals(buffer,normals,error);
+
+  DOUBLE *Corners[MAX_CORNERS_OF_ELEM];
+  DOUBLE_VECTOR Normals[MAX_SIDES_OF_ELEM];
+  for (INT i=0; i<4; i++)
+    Corners[i] = const_cast<DOUBLE*>(x[i]);
+  for (INT s=0; s<4; s++)
+    Normals[s] = 0.0;
+  test.check(TetraSideNormals(nullptr,Corners,Normals)==1, "TetraSideNormals() must fail on a flat tetrahedron");
+  test.check(error[0]==1, "TetrahedraSideNormals() must fail on a flat tetrahedron");
+  for (INT s=0; s<4; s++)
+    for (INT d=0; d<3; d++)
+      test.check(normals[s][d][0]==Normals[s][d],
+                 "TetrahedraSideNormals() must stop at the side where TetraSideNormals() stops");
+}
+#endif
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  AdaptCurved(test);
+#ifdef UG_DIM_3
+  DegenerateTetrahedron(test);
+#endif
+
+  ExitUg();
+
+  return test.exit();
+}
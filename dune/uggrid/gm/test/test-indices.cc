@@ -0,0 +1,118 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <set>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* the indices of a fresh enumeration of objects must be 0,...,n-1 and
+   the slots must hold each object at its index */
+template <class Object>
+static bool Dense (const IndexSlots& slots, const std::vector<std::pair<Object*,INT> >& objects)
+{
+  if (slots.objects.size()!=objects.size() || !slots.released.empty())
+    return false;
+  for (const auto& [object, index] : objects)
+    if (index<0 || index>=(INT)objects.size() || slots.objects[index]!=object)
+      return false;
+  return true;
+}
+
+static void CheckIndices (TestSuite& test, const MULTIGRID *theMG)
+{
+  const IndexMaintenance& indices = *theMG->indexMaintenance;
+  std::vector<std::vector<std::pair<ELEMENT*,INT> > > leafElements(TAGS);
+  std::vector<std::pair<VERTEX*,INT> > vertices;
+
+  test.check(indices.levels.size()>=(std::size_t)TOPLEVEL(theMG)+1, "there must be indices for each level");
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+  {
+    const GRID *theGrid = GRID_ON_LEVEL(theMG,l);
+    const IndexMaintenance::Level& level = indices.levels[l];
+
+    std::vector<std::vector<std::pair<ELEMENT*,INT> > > elements(TAGS);
+    for (ELEMENT *theElement=FIRSTELEMENT(theGrid); theElement!=nullptr; theElement=SUCCE(theElement))
+    {
+      elements[TAG(theElement)].emplace_back(theElement,theElement->ge.levelIndex);
+      if (NSONS(theElement)==0)
+        leafElements[TAG(theElement)].emplace_back(theElement,theElement->ge.leafIndex);
+    }
+    for (INT tag=0; tag<TAGS; tag++)
+      test.check(Dense(level.elements[tag],elements[tag]),
+                 "the level indices of the elements must be dense");
+
+    std::vector<std::pair<NODE*,INT> > nodes;
+    std::set<EDGE*> edgeSet;
+    std::vector<std::pair<EDGE*,INT> > edges;
+    for (NODE *theNode=FIRSTNODE(theGrid); theNode!=nullptr; theNode=SUCCN(theNode))
+    {
+      nodes.emplace_back(theNode,theNode->levelIndex);
+      for (LINK *theLink=START(theNode); theLink!=nullptr; theLink=NEXT(theLink))
+        if (edgeSet.insert(MYEDGE(theLink)).second)
+          edges.emplace_back(MYEDGE(theLink),MYEDGE(theLink)->levelIndex);
+    }
+    test.check(Dense(level.nodes,nodes), "the level indices of the nodes must be dense");
+    test.check(Dense(level.edges,edges), "the level indices of the edges must be dense");
+
+    for (VERTEX *theVertex=FIRSTVERTEX(theGrid); theVertex!=nullptr; theVertex=SUCCV(theVertex))
+      vertices.emplace_back(theVertex,theVertex->iv.leafIndex);
+  }
+
+  for (INT tag=0; tag<TAGS; tag++)
+    test.check(Dense(indices.leafElements[tag],leafElements[tag]),
+               "the leaf indices of the elements must be dense");
+  test.check(Dense(indices.leafVertices,vertices), "the leaf indices of the vertices must be dense");
+}
+
+static std::vector<std::vector<ElementTopology> > AdaptWithIndices (TestSuite& test, INT nThreads)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("indices");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  test.require(SetRefineThreads(theMG,nThreads)==GM_OK, "require that SetRefineThreads() succeeds");
+  test.require(EnableIndexMaintenance(theMG)==GM_OK, "require that EnableIndexMaintenance() succeeds");
+  CheckIndices(test,theMG);
+
+  /* refine, then move the front, which refines and coarsens */
+  for (INT step=0; step<8; step++)
+  {
+    if (step<2)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+      MarkMovingFront(theMG,step-2);
+
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+    CheckIndices(test,theMG);
+  }
+
+  const auto topology = GridTopology(theMG);
+  DisposeMultiGrid(theMG);
+  return topology;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  CompareRefineThreads(test, AdaptWithIndices);
+
+  ExitUg();
+
+  return test.exit();
+}
@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <utility>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "../refine.h"
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* the refinement marks of all elements in the order of the grid lists */
+static std::vector<INT> Marks (const MULTIGRID *theMG)
+{
+  std::vector<INT> marks;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+      marks.insert(marks.end(),{(INT)MARK(theElement),(INT)MARKCLASS(theElement),(INT)COARSEN(theElement)});
+  return marks;
+}
+
+static INT Adapt (MULTIGRID *theMG)
+{
+  return AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST);
+}
+
+/* mark one grid per element, the other one in bulk, and compare the marks */
+static std::vector<std::vector<ElementTopology> > MarkInBulk (TestSuite& test, INT nThreads)
+{
+  MULTIGRID *single = CreateUnitCubeGrid("single");
+  MULTIGRID *bulk = CreateUnitCubeGrid("bulk");
+  test.require(single!=nullptr && bulk!=nullptr, "require that the coarse grids are created");
+  test.require(SetRefineThreads(bulk,nThreads)==GM_OK, "require that SetRefineThreads() succeeds");
+
+  for (INT step=0; step<8; step++)
+  {
+    MarkMovingFront(single,step);
+
+    std::vector<std::pair<ELEMENT*,RefinementRule> > marked;
+    MarkMovingFront(bulk,step,&marked);
+    std::vector<ELEMENT*> theElements;
+    std::vector<RefinementRule> rules;
+    std::vector<DOUBLE> indicator;
+    for (const auto& [theElement, rule] : marked)
+    {
+      theElements.push_back(theElement);
+      rules.push_back(rule);
+      indicator.push_back((rule==RED) ? 1.0 : (rule==COARSE) ? -1.0 : 0.0);
+    }
+
+    if (step%2==0)
+      test.check(MarkElements(bulk,theElements.size(),theElements.data(),rules.data())==GM_OK,
+                 "MarkElements() must succeed");
+    else
+      test.check(MarkElementsByIndicator(bulk,theElements.size(),theElements.data(),
+                                         indicator.data(),0.5,-0.5)==GM_OK,
+                 "MarkElementsByIndicator() must succeed");
+    test.check(Marks(single)==Marks(bulk),
+               "bulk marking must set the marks MarkForRefinement() sets");
+
+    test.check(Adapt(single)==GM_OK && Adapt(bulk)==GM_OK, "AdaptMultiGrid() must succeed");
+    test.check(GridCounts(single)==GridCounts(bulk) && GridTopology(single)==GridTopology(bulk),
+               "the adapted grids must be equal");
+  }
+
+  /* an element that is not a leaf: nothing is marked */
+  for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(bulk,0));
+       theElement!=nullptr; theElement=SUCCE(theElement))
+    if (NSONS(theElement)==0)
+      MarkForRefinement(theElement,RED,0);
+  test.check(Adapt(bulk)==GM_OK, "AdaptMultiGrid() must succeed");
+
+  std::vector<ELEMENT*> theElements;
+  for (INT l=TOPLEVEL(bulk); l>=0; l--)
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(bulk,l));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+      theElements.push_back(theElement);
+  const std::vector<RefinementRule> rules(theElements.size(),RED);
+  const std::vector<INT> marks = Marks(bulk);
+  test.check(MarkElements(bulk,theElements.size(),theElements.data(),rules.data())==GM_ERROR,
+             "MarkElements() must fail for elements that are not leaves");
+  test.check(Marks(bulk)==marks, "MarkElements() must not mark any element on error");
+
+  const auto topology = GridTopology(bulk);
+  DisposeMultiGrid(bulk);
+  DisposeMultiGrid(single);
+  return topology;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  CompareRefineThreads(test, MarkInBulk);
+
+  ExitUg();
+
+  return test.exit();
+}
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <utility>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* number of edges counted from the links of the nodes */
+static INT CountEdges (const GRID *theGrid)
+{
+  INT n = 0;
+  for (NODE *theNode=FIRSTNODE(theGrid); theNode!=nullptr; theNode=SUCCN(theNode))
+    for (LINK *theLink=START(theNode); theLink!=nullptr; theLink=NEXT(theLink))
+      n++;
+  return n/2;
+}
+
+/* the object counts and the elements of all levels after each adaptation step */
+static std::vector<std::pair<std::vector<INT>,std::vector<std::vector<ElementTopology> > > >
+AdaptWithThreads (TestSuite& test, INT nThreads)
+{
+  std::vector<std::pair<std::vector<INT>,std::vector<std::vector<ElementTopology> > > > grids;
+
+  MULTIGRID *theMG = CreateUnitCubeGrid("threads");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  test.require(SetRefineThreads(theMG,nThreads)==GM_OK, "require that SetRefineThreads() succeeds");
+
+  for (INT step=0; step<6; step++)
+  {
+    if (step<2)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+      MarkMovingFront(theMG,step-2);
+
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+    grids.emplace_back(GridCounts(theMG),GridTopology(theMG));
+
+    for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    {
+      const GRID *theGrid = GRID_ON_LEVEL(theMG,l);
+      test.check(NE(theGrid)==CountEdges(theGrid), "NE must be the number of edges of the level");
+      test.check(NT(theGrid)>0, "no level must be empty");
+    }
+  }
+
+  DisposeMultiGrid(theMG);
+  return grids;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  CompareRefineThreads(test, AdaptWithThreads);
+
+  ExitUg();
+
+  return test.exit();
+}
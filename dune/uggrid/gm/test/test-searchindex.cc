@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "../shapes.h"
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+static std::vector<ELEMENT*> LeafElements (const MULTIGRID *theMG)
+{
+  std::vector<ELEMENT*> leaves;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+      if (NSONS(theElement)==0)
+        leaves.push_back(theElement);
+  return leaves;
+}
+
+/* whether the simplex theElement contains global */
+static bool Contains (ELEMENT *theElement, const FieldVector<DOUBLE,DIM>& global)
+{
+  DOUBLE *x[MAX_CORNERS_OF_ELEM];
+  INT n;
+  CORNER_COORDINATES(theElement,n,x);
+
+  FieldVector<DOUBLE,DIM> local;
+  if (UG_GlobalToLocal(n,(const DOUBLE **)x,global,local)!=0)
+    return false;
+
+  const DOUBLE eps = 1e-8;
+  DOUBLE sum = 0.0;
+  for (INT d=0; d<DIM; d++)
+  {
+    if (local[d]<-eps)
+      return false;
+    sum += local[d];
+  }
+  return sum<=1.0+eps;
+}
+
+static DOUBLE CenterDistance (ELEMENT *theElement, const FieldVector<DOUBLE,DIM>& global)
+{
+  FieldVector<DOUBLE,DIM> center(0.0);
+  for (INT i=0; i<CORNERS_OF_ELEM(theElement); i++)
+    center += CVECT(MYVERTEX(CORNER(theElement,i)));
+  center /= CORNERS_OF_ELEM(theElement);
+  return (center-global).two_norm();
+}
+
+/* compare the point location with a search over all leaf elements */
+static void CheckSearch (TestSuite& test, const MULTIGRID *theMG, std::mt19937& random)
+{
+  const std::vector<ELEMENT*> leaves = LeafElements(theMG);
+  std::uniform_real_distribution<DOUBLE> coordinate(0.0,1.0);
+
+  std::vector<FieldVector<DOUBLE,DIM> > points(5000);
+  for (auto& x : points)
+    for (INT d=0; d<DIM; d++)
+      x[d] = coordinate(random);
+  points[0] = 0.5;
+  points[1] = 1.5;
+
+  std::vector<ELEMENT*> found(points.size());
+  test.check(FindLeafElements(theMG,points.size(),points.data(),found.data())==GM_OK,
+             "FindLeafElements() must succeed");
+
+  for (std::size_t i=0; i<points.size(); i++)
+  {
+    const bool inside = std::any_of(leaves.begin(),leaves.end(),
+                                    [&](ELEMENT *e) { return Contains(e,points[i]); });
+    ELEMENT *theElement = FindLeafElement(theMG,points[i],nullptr);
+    test.check(found[i]==theElement, "FindLeafElements() must find the element FindLeafElement() finds");
+    if (inside)
+      test.check(theElement!=nullptr && NSONS(theElement)==0 && Contains(theElement,points[i]),
+                 "FindLeafElement() must find a leaf element containing the point");
+    else
+      test.check(theElement==nullptr, "FindLeafElement() must find nothing outside of the grid");
+  }
+
+  constexpr INT k = 7;
+  for (std::size_t i=0; i<20; i++)
+  {
+    std::vector<DOUBLE> distances;
+    for (ELEMENT *theElement : leaves)
+      distances.push_back(CenterDistance(theElement,points[i]));
+    std::sort(distances.begin(),distances.end());
+
+    ELEMENT *nearest[k];
+    const INT n = FindNearestLeafElements(theMG,points[i],k,nearest);
+    test.check(n==std::min<INT>(k,leaves.size()), "FindNearestLeafElements() must find k elements");
+    for (INT j=0; j<n; j++)
+      test.check(NSONS(nearest[j])==0
+                 && std::abs(CenterDistance(nearest[j],points[i])-distances[j])<1e-12,
+                 "FindNearestLeafElements() must find the nearest leaf elements in order");
+  }
+}
+
+static std::vector<std::vector<ElementTopology> > AdaptWithSearchIndex (TestSuite& test, INT nThreads)
+{
+  std::mt19937 random(nThreads);
+
+  MULTIGRID *theMG = CreateUnitCubeGrid("searchindex");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  test.require(SetRefineThreads(theMG,nThreads)==GM_OK, "require that SetRefineThreads() succeeds");
+  test.require(SetSearchIndex(theMG,true)==GM_OK, "require that SetSearchIndex() succeeds");
+  CheckSearch(test,theMG,random);
+
+  /* refine, then move the front, which refines and coarsens */
+  for (INT step=0; step<8; step++)
+  {
+    if (step<2)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+      MarkMovingFront(theMG,step-2);
+
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+    CheckSearch(test,theMG,random);
+  }
+
+  const auto topology = GridTopology(theMG);
+  DisposeMultiGrid(theMG);
+  return topology;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  CompareRefineThreads(test, AdaptWithSearchIndex);
+
+  ExitUg();
+
+  return test.exit();
+}
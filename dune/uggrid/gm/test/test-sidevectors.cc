@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* check that each element side has one vector, shared by the two elements
+   of an inner side, and return per level the ids of the vectors in list
+   order followed by the id and index of the vector of each element side */
+static std::vector<std::vector<INT> > CheckSideVectors (TestSuite& test, MULTIGRID *theMG)
+{
+  std::vector<std::vector<INT> > vectors(TOPLEVEL(theMG)+1);
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+  {
+    GRID *theGrid = GRID_ON_LEVEL(theMG,l);
+    test.check(CheckAlgebra(theGrid)==0, "CheckAlgebra() must accept the side vectors");
+
+    for (VECTOR *theVector=PFIRSTVECTOR(theGrid); theVector!=nullptr; theVector=SUCCVC(theVector))
+      vectors[l].push_back(theVector->id);
+
+#ifdef UG_DIM_3
+    INT nSides = 0, nInnerSides = 0;
+    for (ELEMENT *theElement=PFIRSTELEMENT(theGrid); theElement!=nullptr; theElement=SUCCE(theElement))
+      for (INT i=0; i<SIDES_OF_ELEM(theElement); i++)
+      {
+        VECTOR *theVector = SVECTOR(theElement,i);
+        test.require(theVector!=nullptr, "each element side must have a vector");
+        vectors[l].insert(vectors[l].end(),{theVector->id,(INT)VINDEX(theVector)});
+
+        ELEMENT *theNeighbor = NBELEM(theElement,i);
+        nSides++;
+        if (theNeighbor==nullptr)
+        {
+          test.check(VCOUNT(theVector)==1, "the vector of a boundary side must have VCOUNT 1");
+          continue;
+        }
+        nInnerSides++;
+        test.check(VCOUNT(theVector)==2, "the vector of an inner side must have VCOUNT 2");
+        bool shared = false;
+        for (INT j=0; j<SIDES_OF_ELEM(theNeighbor); j++)
+          if (NBELEM(theNeighbor,j)==theElement)
+            shared = (SVECTOR(theNeighbor,j)==theVector);
+        test.check(shared, "the two elements of an inner side must share its vector");
+      }
+    test.check(NVEC(theGrid)==nSides-nInnerSides/2, "each side of a level must have exactly one vector");
+#else
+    test.check(NVEC(theGrid)==0, "a 2D grid must not have vectors");
+#endif
+  }
+  return vectors;
+}
+
+/* check that no element side has a vector */
+static void CheckNoSideVectors (TestSuite& test, MULTIGRID *theMG)
+{
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+  {
+    GRID *theGrid = GRID_ON_LEVEL(theMG,l);
+    test.check(NVEC(theGrid)==0, "a grid without side vectors must not have vectors");
+    test.check(CheckGrid(theGrid,1,1,1)==GM_OK, "CheckGrid() must accept a grid without side vectors");
+#ifdef UG_DIM_3
+    for (ELEMENT *theElement=PFIRSTELEMENT(theGrid); theElement!=nullptr; theElement=SUCCE(theElement))
+      for (INT i=0; i<SIDES_OF_ELEM(theElement); i++)
+        test.check(SVECTOR(theElement,i)==nullptr, "SVECTOR must be NULL without side vectors");
+#endif
+  }
+}
+
+/* switch the side vectors off and on between adaptation steps */
+static void SwitchSideVectors (TestSuite& test)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("sidevectors");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+
+  for (INT step=0; step<8; step++)
+  {
+    if (step==2)
+    {
+      test.check(SetSideVectors(theMG,false)==GM_OK, "SetSideVectors() must dispose the side vectors");
+      CheckNoSideVectors(test,theMG);
+    }
+    if (step==5)
+    {
+      test.check(SetSideVectors(theMG,true)==GM_OK, "SetSideVectors() must create the side vectors");
+      CheckSideVectors(test,theMG);
+    }
+
+    if (step<2)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+      MarkMovingFront(theMG,step-2);
+
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+    if (step>=2 && step<5)
+      CheckNoSideVectors(test,theMG);
+    else
+      CheckSideVectors(test,theMG);
+  }
+
+  DisposeMultiGrid(theMG);
+}
+
+/* create the side vectors of a level too large for a single thread: the
+   elements are refined without side vectors, which are switched on at the end */
+static std::vector<std::vector<INT> > CreateWithThreads (TestSuite& test, INT nThreads)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("sidevectors");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  test.require(SetRefineThreads(theMG,nThreads)==GM_OK, "require that SetRefineThreads() succeeds");
+  test.require(SetSideVectors(theMG,false)==GM_OK, "require that SetSideVectors() succeeds");
+
+  /* level 4 of the cube has 24576 tetrahedra, more than 4 chunks of 4096 */
+  for (INT step=0; step<4; step++)
+  {
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+      MarkForRefinement(theElement,RED,0);
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+  }
+
+  test.check(SetSideVectors(theMG,true)==GM_OK, "SetSideVectors() must create the side vectors");
+  const auto vectors = CheckSideVectors(test,theMG);
+  DisposeMultiGrid(theMG);
+  return vectors;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  SwitchSideVectors(test);
+  CompareRefineThreads(test, CreateWithThreads);
+
+  ExitUg();
+
+  return test.exit();
+}
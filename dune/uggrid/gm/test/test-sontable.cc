@@ -0,0 +1,86 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* compare the son table with GetSons for all elements */
+static void CheckSons (TestSuite& test, const MULTIGRID *theMG)
+{
+  std::size_t nSons = 0;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+    {
+      ELEMENT *SonList[MAX_SONS];
+      GetSons(theElement,SonList);
+      std::vector<ELEMENT*> sons;
+      for (INT i=0; i<MAX_SONS && SonList[i]!=nullptr; i++)
+        sons.push_back(SonList[i]);
+
+      const SonRange range = GetSonRange(theMG,theElement);
+      test.check(std::vector<ELEMENT*>(range.begin(),range.end())==sons,
+                 "GetSonRange() must return the sons GetSons() returns");
+      nSons += sons.size();
+    }
+
+  const SonTable& table = *theMG->sonTable;
+  test.check(table.changed.empty(), "all changes must be collected after AdaptMultiGrid()");
+  test.check(table.sons.size()-table.unused==nSons, "the son table must store each son once");
+  test.check(table.sons.size()<=2*nSons+1, "the son table must be compacted");
+}
+
+static std::vector<std::vector<ElementTopology> > AdaptWithSonTable (TestSuite& test, INT nThreads)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("sontable");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  test.require(SetRefineThreads(theMG,nThreads)==GM_OK, "require that SetRefineThreads() succeeds");
+
+  for (INT step=0; step<8; step++)
+  {
+    /* start storing the sons of a refined grid */
+    if (step==1)
+      test.require(SetSonTable(theMG,true)==GM_OK, "require that SetSonTable() succeeds");
+
+    if (step<2)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+      MarkMovingFront(theMG,step-2);
+
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+    if (step>=1)
+      CheckSons(test,theMG);
+  }
+
+  const auto topology = GridTopology(theMG);
+  DisposeMultiGrid(theMG);
+  return topology;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  CompareRefineThreads(test, AdaptWithSonTable);
+
+  ExitUg();
+
+  return test.exit();
+}
@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+
+#include "testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* the classes of all vectors in the order of the grid lists, the fine
+   grid dof count of each level and the full refine level */
+static std::vector<INT> Classes (const MULTIGRID *theMG)
+{
+  std::vector<INT> classes;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+  {
+    const GRID *theGrid = GRID_ON_LEVEL(theMG,l);
+    for (VECTOR *v=FIRSTVECTOR(theGrid); v!=nullptr; v=SUCCVC(v))
+      classes.insert(classes.end(),{(INT)VCLASS(v),(INT)VNCLASS(v),(INT)FINE_GRID_DOF(v)});
+    classes.push_back(theGrid->nFineDof);
+  }
+  classes.push_back(FULLREFINELEVEL(theMG));
+  return classes;
+}
+
+/* compare the classes AdaptMultiGrid updates incrementally with the
+   classes computed on all levels */
+static std::vector<std::vector<ElementTopology> > AdaptWithSurfaceClasses (TestSuite& test, INT nThreads)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("surfaceclasses");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  test.require(SetRefineThreads(theMG,nThreads)==GM_OK, "require that SetRefineThreads() succeeds");
+  test.require(SetIncrementalSurfaceClasses(theMG,true)==GM_OK,
+               "require that SetIncrementalSurfaceClasses() succeeds");
+
+  /* refine four times, then refine one element of level 4 in each step
+     and coarsen the one of the previous step. The first one stays refined,
+     which keeps the grid of the top level */
+  ELEMENT *theFirst = nullptr;
+  for (INT step=0; step<10; step++)
+  {
+    if (step<4)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+    {
+      std::vector<ELEMENT*> theElements;
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,4));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        if (NSONS(theElement)==0)
+          theElements.push_back(theElement);
+      ELEMENT *theRefined = theElements[(7*step)%theElements.size()];
+      MarkForRefinement(theRefined,RED,0);
+      if (theFirst==nullptr)
+        theFirst = theRefined;
+      else
+        for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,5));
+             theElement!=nullptr; theElement=SUCCE(theElement))
+          if (EFATHER(theElement)!=theFirst && EFATHER(theElement)!=theRefined)
+            MarkForRefinement(theElement,COARSE,0);
+    }
+
+    test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+               "AdaptMultiGrid() must succeed");
+    const std::vector<INT> incremental = Classes(theMG);
+
+    test.require(SetIncrementalSurfaceClasses(theMG,false)==GM_OK,
+                 "require that SetIncrementalSurfaceClasses() succeeds");
+    test.check(SetSurfaceClasses(theMG)==GM_OK, "SetSurfaceClasses() must succeed");
+    test.check(Classes(theMG)==incremental,
+               "the incremental update must give the classes computed on all levels");
+    test.require(SetIncrementalSurfaceClasses(theMG,true)==GM_OK,
+                 "require that SetIncrementalSurfaceClasses() succeeds");
+  }
+
+  const auto topology = GridTopology(theMG);
+  DisposeMultiGrid(theMG);
+  return topology;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  CompareRefineThreads(test, AdaptWithSurfaceClasses);
+
+  ExitUg();
+
+  return test.exit();
+}
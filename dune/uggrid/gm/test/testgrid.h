@@ -0,0 +1,320 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+/** \file
+ * \brief Small coarse grids for the tests of the grid manager
+ *
+ * The coarse grid of the unit square (two triangles) or the unit cube
+ * (six tetrahedra of the Kuhn triangulation) is built the way the Dune
+ * grid factory builds it: the boundary vertices are the corners of the
+ * domain, the boundary faces are its segments.
+ */
+#ifndef DUNE_UGGRID_GM_TEST_TESTGRID_H
+#define DUNE_UGGRID_GM_TEST_TESTGRID_H
+
+#include <array>
+#include <tuple>
+#include <vector>
+
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/domain/std_domain.h>
+
+#include "../algebra.h"
+#include "../gm.h"
+#include "../ugm.h"
+#ifdef ModelP
+#include <dune/uggrid/parallel/ppif/ppifcontext.hh>
+#endif
+
+START_UGDIM_NAMESPACE
+
+/** \brief Boundary segment used by the parametrized test grids
+
+   The segment is the simplex spanned by the corners, displaced along its
+   normal by bulge times a bubble function that vanishes on its boundary.
+   The segments can be changed until the grid is refined.
+ */
+struct TestSegment
+{
+  std::array<FieldVector<DOUBLE,DIM>,DIM> corners;
+  DOUBLE bulge = 0.0;
+  /* number of points evaluated by TestSegmentGlobalBatch */
+  INT batchEvaluations = 0;
+};
+
+/* x = c0 + s (c1-c0) in 2D and x = c0 + (s-t) (c1-c0) + t (c2-c0) in 3D,
+   where UG places the corners of a triangle at (0,0), (1,0) and (1,1) */
+inline INT TestSegmentGlobal (void *data, DOUBLE *local, FieldVector<DOUBLE,DIM>& global)
+{
+  const TestSegment *segment = static_cast<TestSegment*>(data);
+  const auto& c = segment->corners;
+  DOUBLE lambda[DIM_OF_BND];
+  lambda[0] = local[0];
+#ifdef UG_DIM_3
+  lambda[0] -= local[1];
+  lambda[1] = local[1];
+#endif
+  global = c[0];
+  for (INT i=1; i<DIM; i++)
+    for (INT j=0; j<DIM; j++)
+      global[j] += lambda[i-1]*(c[i][j]-c[0][j]);
+
+  if (segment->bulge!=0.0)
+  {
+    FieldVector<DOUBLE,DIM> normal;
+#ifdef UG_DIM_2
+    normal = {c[0][1]-c[1][1], c[1][0]-c[0][0]};
+    const DOUBLE bubble = 4.0*lambda[0]*(1.0-lambda[0]);
+#else
+    FieldVector<DOUBLE,DIM> a = c[1]-c[0], b = c[2]-c[0];
+    normal = {a[1]*b[2]-a[2]*b[1], a[2]*b[0]-a[0]*b[2], a[0]*b[1]-a[1]*b[0]};
+    const DOUBLE bubble = 27.0*lambda[0]*lambda[1]*(1.0-lambda[0]-lambda[1]);
+#endif
+    normal /= normal.two_norm();
+    global.axpy(segment->bulge*bubble,normal);
+  }
+  return 0;
+}
+
+inline INT TestSegmentGlobalBatch (void *data, INT n, const DOUBLE *local, DOUBLE *global)
+{
+  static_cast<TestSegment*>(data)->batchEvaluations += n;
+  for (INT k=0; k<n; k++)
+  {
+    FieldVector<DOUBLE,DIM> x;
+    DOUBLE lambda[DIM_OF_BND];
+    for (INT i=0; i<DIM_OF_BND; i++)
+      lambda[i] = local[k*DIM_OF_BND+i];
+    TestSegmentGlobal(data,lambda,x);
+    for (INT j=0; j<DIM; j++)
+      global[k*DIM+j] = x[j];
+  }
+  return 0;
+}
+
+/** \brief Create the coarse grid of the unit square or cube
+
+   \param name - name of the multigrid
+   \param segments - if not null, the boundary is given by parametrized
+                     segments stored here instead of linear segments
+   \param batch - give the parametrized segments a batch function
+   \param distributedCoarseGrid - all processes insert all elements, which
+                                  have to be identified by
+                                  IdentifyDistributedCoarseGrid
+
+   The multigrid owns the boundary value problem and is disposed of with
+   DisposeMultiGrid. The segments have to outlive it. In the parallel
+   version only the master inserts the elements, the other processes get
+   an empty grid as from the Dune grid factory, unless distributedCoarseGrid
+   is set. The ids of the corners and elements are the same on all processes.
+ */
+inline MULTIGRID *CreateUnitCubeGrid (const char *name,
+                                      std::vector<TestSegment> *segments = nullptr,
+                                      bool batch = false,
+                                      bool distributedCoarseGrid = false)
+{
+  constexpr INT nCorners = 1<<DIM;
+  std::vector<std::array<INT,DIM> > faces;
+  std::vector<std::array<INT,DIM+1> > elements;
+
+#ifdef UG_DIM_2
+  /* vertex i has the coordinates of the bits of i */
+  faces = {{0,1},{1,3},{3,2},{2,0}};
+  elements = {{0,1,3},{0,3,2}};
+#else
+  for (INT a=0; a<DIM; a++)
+  {
+    const INT b = 1<<((a+1)%3), c = 1<<((a+2)%3);
+    faces.push_back({0,b,b+c});
+    faces.push_back({0,c,b+c});
+    faces.push_back({1<<a,(1<<a)+b,7});
+    faces.push_back({1<<a,(1<<a)+c,7});
+  }
+  const INT perms[6][3] = {{0,1,2},{0,2,1},{1,0,2},{1,2,0},{2,0,1},{2,1,0}};
+  for (const auto& p : perms)
+    elements.push_back({0,1<<p[0],(1<<p[0])+(1<<p[1]),7});
+#endif
+
+  auto corner = [](INT i) {
+    FieldVector<DOUBLE,DIM> x;
+    for (INT j=0; j<DIM; j++)
+      x[j] = (i>>j) & 1;
+    return x;
+  };
+
+  STD_BVP *theBVP = new STD_BVP;
+  theBVP->Domain = std::make_unique<domain>();
+  theBVP->Domain->numOfSegments = faces.size();
+  theBVP->Domain->numOfCorners = nCorners;
+  if (segments!=nullptr)
+    segments->resize(faces.size());
+  for (std::size_t s=0; s<faces.size(); s++)
+  {
+    std::array<FieldVector<DOUBLE,DIM>,CORNERS_OF_BND_SEG> x;
+    INT points[CORNERS_OF_BND_SEG];
+    for (INT i=0; i<CORNERS_OF_BND_SEG; i++)
+      points[i] = -1;
+    for (INT i=0; i<DIM; i++)
+    {
+      points[i] = faces[s][i];
+      x[i] = corner(faces[s][i]);
+    }
+    if (segments==nullptr)
+      theBVP->Domain->linearSegments.emplace_back(s,DIM,points,x);
+    else
+    {
+      for (INT i=0; i<DIM; i++)
+        (*segments)[s].corners[i] = x[i];
+      theBVP->Domain->boundarySegments.emplace_back(s,points,TestSegmentGlobal,&(*segments)[s],
+                                                    batch ? TestSegmentGlobalBatch : nullptr);
+    }
+  }
+
+  MULTIGRID *theMG = CreateMultiGrid(const_cast<char*>(name),theBVP,"",true,true,
+                                       nullptr,distributedCoarseGrid);
+  if (theMG==nullptr)
+    return nullptr;
+
+  GRID *theGrid = GRID_ON_LEVEL(theMG,0);
+  std::vector<NODE*> nodes(nCorners);
+  for (NODE *theNode=FIRSTNODE(theGrid); theNode!=nullptr; theNode=SUCCN(theNode))
+    nodes[ID(theNode)] = theNode;
+
+#ifdef ModelP
+  if (!theMG->ppifContext().isMaster() && !distributedCoarseGrid)
+    elements.clear();
+#endif
+  for (const auto& element : elements)
+  {
+    NODE *nodeList[DIM+1];
+    VERTEX *vertexList[DIM+1];
+    for (INT i=0; i<DIM+1; i++)
+    {
+      nodeList[i] = nodes[element[i]];
+      vertexList[i] = MYVERTEX(nodeList[i]);
+    }
+    if (!CheckOrientation(DIM+1,vertexList))
+      std::swap(nodeList[1],nodeList[2]);
+    if (InsertElement(theGrid,DIM+1,nodeList,nullptr,nullptr,nullptr)==nullptr)
+      return nullptr;
+  }
+
+  /* as the Dune grid factory: no subdomain information from the boundary */
+  if (CreateAlgebra(theMG)!=GM_OK)
+    return nullptr;
+  ReleaseTmpMem(MGHEAP(theMG),MG_MARK_KEY(theMG));
+  MG_MARK_KEY(theMG) = 0;
+
+  return theMG;
+}
+
+/** \brief Mark the leaf elements for one step of a moving refinement front
+
+   \param theMG - multigrid
+   \param step - number of the adaptation step
+   \param theElements - if not null, the marked elements and their rules
+                        are returned here instead of being marked
+
+   The leaf elements close to a point moving along the diagonal are marked
+   for red refinement up to level 4, the other leaf elements are marked for
+   coarsening. Successive steps hence refine and coarsen the grid locally.
+ */
+inline void MarkMovingFront (MULTIGRID *theMG, INT step,
+                             std::vector<std::pair<ELEMENT*,RefinementRule> > *theElements = nullptr)
+{
+  DOUBLE_VECTOR p;
+  p = 0.1+0.2*step;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+    {
+      if (!EstimateHere(theElement)) continue;
+
+      DOUBLE_VECTOR center;
+      CalculateCenterOfMass(theElement,center);
+      center -= p;
+      RefinementRule rule = NO_REFINEMENT;
+      if (center.two_norm()<0.35)
+      {
+        if (l<4) rule = RED;
+      }
+      else if (l>0)
+        rule = COARSE;
+      if (rule==NO_REFINEMENT) continue;
+
+      if (theElements!=nullptr)
+        theElements->emplace_back(theElement,rule);
+      else
+        MarkForRefinement(theElement,rule,0);
+    }
+}
+
+/** \brief Counts of the objects of all levels of a multigrid */
+inline std::vector<INT> GridCounts (const MULTIGRID *theMG)
+{
+  std::vector<INT> counts;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+  {
+    const GRID *theGrid = GRID_ON_LEVEL(theMG,l);
+    counts.insert(counts.end(),{NT(theGrid),NN(theGrid),NV(theGrid),NE(theGrid),NVEC(theGrid)});
+  }
+  return counts;
+}
+
+/** \brief ID, tag, father and corner coordinates of an element */
+struct ElementTopology
+{
+  INT id, tag, father;
+  std::vector<DOUBLE> corners;
+
+  bool operator== (const ElementTopology& other) const
+  {
+    return std::tie(id,tag,father,corners)==std::tie(other.id,other.tag,other.father,other.corners);
+  }
+};
+
+/** \brief The elements of each level of a multigrid in the order of the grid lists
+
+   Two multigrids with the same topology have the same elements with the
+   same IDs on each level, stored in the same order and refined from the
+   same fathers. The father of an element of level 0 is -1.
+ */
+inline std::vector<std::vector<ElementTopology> > GridTopology (const MULTIGRID *theMG)
+{
+  std::vector<std::vector<ElementTopology> > topology(TOPLEVEL(theMG)+1);
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+    {
+      ElementTopology& element = topology[l].emplace_back();
+      element.id = ID(theElement);
+      element.tag = TAG(theElement);
+      element.father = (EFATHER(theElement)!=nullptr) ? ID(EFATHER(theElement)) : -1;
+      for (INT i=0; i<CORNERS_OF_ELEM(theElement); i++)
+        for (INT j=0; j<DIM; j++)
+          element.corners.push_back(CVECT(MYVERTEX(CORNER(theElement,i)))[j]);
+    }
+  return topology;
+}
+
+/** \brief Run a test with the refinement on one and on four threads
+
+   \param test - test suite
+   \param run - function of the test suite and the number of refine threads,
+                which returns the result to compare, e.g. the GridTopology
+                of the adapted multigrid
+
+   The refinement of a level on several threads must give the grid of the
+   sequential refinement, hence both runs must return the same result.
+ */
+template <class Run>
+inline void CompareRefineThreads (Dune::TestSuite& test, Run run)
+{
+  const auto sequential = run(test,1);
+  const auto threaded = run(test,4);
+  test.check(sequential==threaded, "the refinement on 4 threads must give the grid of the sequential refinement");
+}
+
+END_UGDIM_NAMESPACE
+
+#endif
@@ -47,6 +47,9 @@
 
 #include <errno.h>
 #include <vector>
+#include <limits>
+#include <queue>
+#include <thread>
 
 #include <dune/uggrid/low/architecture.h>
 #include <dune/uggrid/low/heaps.h>
@@ -118,8 +121,19 @@ static char buffer[4*256];
 static INT theMGDirID;                          /* env var ID for the multigrids		*/
 static INT theMGRootDirID;                      /* env dir ID for the multigrids		*/
 
+/** \brief Guards the /Multigrids directory, multigrids may be created
+    and disposed on several threads */
+static std::mutex theMGDirMutex;
+
 static UINT UsedOBJT;           /* for the dynamic OBJECT management	*/
 
+#ifdef ModelP
+/** \brief Message buffers of the nodes and elements set on this thread,
+    see MessageBuffer. A load-balancing step sets, sends and frees them on
+    its thread, so multigrids balanced on different threads share nothing. */
+static thread_local std::unordered_map<const void*,MessageBuffer> theMessageBuffers;
+#endif
+
 /****************************************************************************/
 /*                                                                          */
 /* forward declarations of functions used before they are defined           */
@@ -345,6 +359,61 @@ static VERTEX *CreateInnerVertex (GRID *theGrid)
   return(pv);
 }
 
+#ifdef ModelP
+/****************************************************************************/
+/** \brief Message buffer of a node or an element
+
+ * @param  object - the node or element
+
+   @return the buffer, empty if none is set
+ */
+/****************************************************************************/
+
+const MessageBuffer& NS_DIM_PREFIX GetMessageBuffer (const void *object)
+{
+  static const MessageBuffer noBuffer;
+
+  auto it = theMessageBuffers.find(object);
+  return (it != theMessageBuffers.end()) ? it->second : noBuffer;
+}
+
+/****************************************************************************/
+/** \brief Set the message buffer of a node or an element
+
+ * @param  object - the node or element
+ * @param  data - the message allocated with std::malloc, or nullptr
+ * @param  size - size of the message
+
+   A previous buffer of the object is not freed, nullptr removes the object
+   from the table.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX SetMessageBuffer (const void *object, char* data, std::size_t size)
+{
+  if (data == nullptr)
+    theMessageBuffers.erase(object);
+  else
+    theMessageBuffers[object] = MessageBuffer{data, size};
+}
+
+/****************************************************************************/
+/** \brief Free the message buffer of a node or an element
+
+ * @param  object - the node or element
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX FreeMessageBuffer (const void *object)
+{
+  auto it = theMessageBuffers.find(object);
+  if (it == theMessageBuffers.end())
+    return;
+  std::free(it->second.data);
+  theMessageBuffers.erase(it);
+}
+#endif
+
 /****************************************************************************/
 /** \brief Return pointer to a new node structure
 
@@ -376,8 +445,6 @@ static NODE *CreateNode (GRID *theGrid, VERTEX *vertex,
         #ifdef ModelP
   DDD_AttrSet(PARHDR(pn),GRID_ATTR(theGrid));
   /* SETPRIO(pn,PrioMaster); */
-  pn->message_buffer_ = nullptr;
-  pn->message_buffer_size_ = 0;
         #endif
   ID(pn) = (theGrid->mg->nodeIdCounter)++;
   START(pn) = NULL;
@@ -504,24 +571,38 @@ NODE *NS_DIM_PREFIX CreateMidNode (GRID *theGrid, ELEMENT *theElement, VERTEX *t
         theVertex = CreateBoundaryVertex(theGrid);
         if (theVertex == NULL)
           return(NULL);
-        if (BNDP_Global(bndp,bnd_global))
-          return(NULL);
+        BoundaryBatch *batch = MYMG(theGrid)->boundaryBatch.get();
+        if (batch == NULL)
+          if (BNDP_Global(bndp,bnd_global))
+            return(NULL);
         if (BNDP_BndPDesc(bndp,&move))
           return(NULL);
         SETMOVE(theVertex,move);
         V_BNDP(theVertex) = bndp;
-        V_DIM_COPY(bnd_global,CVECT(theVertex));
         FieldVector<DOUBLE,DIM>& local = LCVECT(theVertex);
-        V_DIM_EUKLIDNORM_OF_DIFF(bnd_global,global,diff);
-        if (diff > MAX_PAR_DIST)
+        if (batch != NULL)
         {
-          SETMOVED(theVertex,1);
-          CORNER_COORDINATES(theElement,n,x);
-          UG_GlobalToLocal(n,(const DOUBLE **)x,bnd_global,local);
-        }
-        else
+          /* moved by EvaluateBoundaryBatch */
+          V_DIM_COPY(global,CVECT(theVertex));
           V_DIM_LINCOMB(0.5, LOCAL_COORD_OF_ELEM(theElement,co0),
                         0.5, LOCAL_COORD_OF_ELEM(theElement,co1),local);
+          std::lock_guard<std::mutex> lock(batch->mutex);
+          batch->vertices.push_back(theVertex);
+        }
+        else
+        {
+          V_DIM_COPY(bnd_global,CVECT(theVertex));
+          V_DIM_EUKLIDNORM_OF_DIFF(bnd_global,global,diff);
+          if (diff > MAX_PAR_DIST)
+          {
+            SETMOVED(theVertex,1);
+            CORNER_COORDINATES(theElement,n,x);
+            UG_GlobalToLocal(n,(const DOUBLE **)x,bnd_global,local);
+          }
+          else
+            V_DIM_LINCOMB(0.5, LOCAL_COORD_OF_ELEM(theElement,co0),
+                          0.5, LOCAL_COORD_OF_ELEM(theElement,co1),local);
+        }
         PRINTDEBUG(gm,1,("local = %f %f %f\n",local[0],local[1],local[2]));
       }
     }
@@ -695,16 +776,27 @@ NODE *NS_DIM_PREFIX CreateSideNode (GRID *theGrid, ELEMENT *theElement, VERTEX *
           if (BNDP_BndPDesc(bndp,&move))
             return(NULL);
           SETMOVE(theVertex,move);
-          if (BNDP_Global(bndp,bnd_global))
-            return(NULL);
           V_BNDP(theVertex) = bndp;
-          V_DIM_COPY(bnd_global,CVECT(theVertex));
-          V_DIM_EUKLIDNORM_OF_DIFF(bnd_global,global,diff);
-          if (diff > MAX_PAR_DIST) {
-            SETMOVED(theVertex,1);
-            CORNER_COORDINATES(theElement,k,x);
-            UG_GlobalToLocal(k,(const DOUBLE **)x,bnd_global,local);
-            PRINTDEBUG(gm,1,("local = %f %f %f\n",local[0],local[1],local[2]));
+          BoundaryBatch *batch = MYMG(theGrid)->boundaryBatch.get();
+          if (batch != NULL)
+          {
+            /* moved by EvaluateBoundaryBatch */
+            V_DIM_COPY(global,CVECT(theVertex));
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            batch->vertices.push_back(theVertex);
+          }
+          else
+          {
+            if (BNDP_Global(bndp,bnd_global))
+              return(NULL);
+            V_DIM_COPY(bnd_global,CVECT(theVertex));
+            V_DIM_EUKLIDNORM_OF_DIFF(bnd_global,global,diff);
+            if (diff > MAX_PAR_DIST) {
+              SETMOVED(theVertex,1);
+              CORNER_COORDINATES(theElement,k,x);
+              UG_GlobalToLocal(k,(const DOUBLE **)x,bnd_global,local);
+              PRINTDEBUG(gm,1,("local = %f %f %f\n",local[0],local[1],local[2]));
+            }
           }
         }
       }
@@ -1396,6 +1488,79 @@ NODE * NS_DIM_PREFIX GetCenterNode (const ELEMENT *theElement)
   return (NULL);
 }
 
+/****************************************************************************/
+/** \brief Find the vertices on the edges of an element
+ *
+ * @param   theElement - element
+ * @param   VertexOnEdge - filled with the vertex of the mid node of each edge, or NULL
+ *
+ * @return the number of moved vertices on the edges */
+/****************************************************************************/
+
+static INT MovedEdgeVertices (ELEMENT *theElement, VERTEX **VertexOnEdge)
+{
+  INT moved = 0;
+
+  for (INT j=0; j<EDGES_OF_ELEM(theElement); j++) {
+    EDGE *theEdge=GetEdge(CORNER(theElement,CORNER_OF_EDGE(theElement,j,0)),
+                          CORNER(theElement,CORNER_OF_EDGE(theElement,j,1)));
+    ASSERT(theEdge != NULL);
+    NODE *theNode = MIDNODE(theEdge);
+    if (theNode == NULL)
+      VertexOnEdge[j] = NULL;
+    else {
+      VertexOnEdge[j] = MYVERTEX(theNode);
+      moved += MOVED(VertexOnEdge[j]);
+    }
+  }
+
+  return(moved);
+}
+
+/****************************************************************************/
+/** \brief Set the position of a new center vertex
+ *
+ * @param   theElement - father element of the vertex
+ * @param   theVertex - center vertex
+ *
+   The vertex is placed in the center of the element and moved by the
+   moved vertices on the edges of boundary elements.
+ */
+/****************************************************************************/
+
+static void SetCenterVertexPosition (ELEMENT *theElement, VERTEX *theVertex)
+{
+  DOUBLE_VECTOR diff;
+  VERTEX *VertexOnEdge[MAX_EDGES_OF_ELEM];
+  DOUBLE *x[MAX_CORNERS_OF_ELEM];
+  INT n,j;
+
+  CORNER_COORDINATES(theElement,n,x);
+  const INT moved = (OBJT(theElement) == BEOBJ) ? MovedEdgeVertices(theElement,VertexOnEdge) : 0;
+
+  Dune::FieldVector<DOUBLE,DIM>& global = CVECT(theVertex);
+  Dune::FieldVector<DOUBLE,DIM>& local = LCVECT(theVertex);
+  V_DIM_CLEAR(local);
+  const DOUBLE fac = 1.0 / n;
+  for (j=0; j<n; j++)
+    V_DIM_LINCOMB(1.0,local,
+                  fac,LOCAL_COORD_OF_ELEM(theElement,j),local);
+  LOCAL_TO_GLOBAL(n,x,local,global);
+  if (moved) {
+    V_DIM_CLEAR(diff);
+    for (j=0; j<EDGES_OF_ELEM(theElement); j++)
+      if (VertexOnEdge[j] != NULL) {
+        V_DIM_COPY(CVECT(VertexOnEdge[j]),diff);
+        V_DIM_LINCOMB(1.0,diff,-0.5,CVECT(MYVERTEX(CORNER(theElement,CORNER_OF_EDGE(theElement,j,0)))),diff);
+        V_DIM_LINCOMB(1.0,diff,-0.5,CVECT(MYVERTEX(CORNER(theElement,CORNER_OF_EDGE(theElement,j,1)))),diff);
+        V_DIM_LINCOMB(0.5,diff,1.0,global,global);
+      }
+    UG_GlobalToLocal(n,(const DOUBLE **)x,global,local);
+    LOCAL_TO_GLOBAL(n,x,local,diff);
+    SETMOVED(theVertex,1);
+  }
+}
+
 /****************************************************************************/
 /** \brief Allocate a new node on a side of an element
  *
@@ -1410,38 +1575,25 @@ NODE * NS_DIM_PREFIX GetCenterNode (const ELEMENT *theElement)
 /* #define MOVE_MIDNODE */
 NODE * NS_DIM_PREFIX CreateCenterNode (GRID *theGrid, ELEMENT *theElement, VERTEX *theVertex)
 {
-  DOUBLE_VECTOR diff;
-  INT n,j,moved,vertex_null;
-  VERTEX *VertexOnEdge[MAX_EDGES_OF_ELEM];
+  INT vertex_null;
   NODE *theNode;
-  EDGE *theEdge;
-  DOUBLE fac;
-  DOUBLE *x[MAX_CORNERS_OF_ELEM];
         #ifdef MOVE_MIDNODE
         #ifndef ModelP
+  DOUBLE_VECTOR diff;
+  DOUBLE *x[MAX_CORNERS_OF_ELEM];
+  VERTEX *VertexOnEdge[MAX_EDGES_OF_ELEM];
   DOUBLE len_opp,len_bnd;
+  INT n,j,moved;
     #endif
     #endif
 
-  /* check if moved side nodes exist */
-  CORNER_COORDINATES(theElement,n,x);
-  moved = 0;
   vertex_null = (theVertex==NULL);
+        #ifdef MOVE_MIDNODE
+        #ifndef ModelP
+  /* check if moved side nodes exist */
   if (theVertex==NULL && OBJT(theElement) == BEOBJ) {
-    for (j=0; j<EDGES_OF_ELEM(theElement); j++) {
-      theEdge=GetEdge(CORNER(theElement,CORNER_OF_EDGE(theElement,j,0)),
-                      CORNER(theElement,CORNER_OF_EDGE(theElement,j,1)));
-      ASSERT(theEdge != NULL);
-      theNode = MIDNODE(theEdge);
-      if (theNode == NULL)
-        VertexOnEdge[j] = NULL;
-      else {
-        VertexOnEdge[j] = MYVERTEX(theNode);
-        moved += MOVED(VertexOnEdge[j]);
-      }
-    }
-                #ifdef MOVE_MIDNODE
-                #ifndef ModelP
+    moved = MovedEdgeVertices(theElement,VertexOnEdge);
+    CORNER_COORDINATES(theElement,n,x);
     if (moved == 1) {
       for (j=0; j<EDGES_OF_ELEM(theElement); j++)
         if (VertexOnEdge[j] != NULL)
@@ -1475,9 +1627,9 @@ NODE * NS_DIM_PREFIX CreateCenterNode (GRID *theGrid, ELEMENT *theElement, VERTE
         VFATHER(theVertex) = theElement;
       }
     }
-            #endif
-            #endif
   }
+        #endif
+        #endif
 
   if (vertex_null)
   {
@@ -1502,27 +1654,16 @@ NODE * NS_DIM_PREFIX CreateCenterNode (GRID *theGrid, ELEMENT *theElement, VERTE
 
   if (!vertex_null) return(theNode);
 
-  FieldVector<DOUBLE,DIM>& global = CVECT(theVertex);
-  FieldVector<DOUBLE,DIM>& local = LCVECT(theVertex);
-  V_DIM_CLEAR(local);
-  fac = 1.0 / n;
-  for (j=0; j<n; j++)
-    V_DIM_LINCOMB(1.0,local,
-                  fac,LOCAL_COORD_OF_ELEM(theElement,j),local);
-  LOCAL_TO_GLOBAL(n,x,local,global);
-  if (moved) {
-    V_DIM_CLEAR(diff);
-    for (j=0; j<EDGES_OF_ELEM(theElement); j++)
-      if (VertexOnEdge[j] != NULL) {
-        V_DIM_COPY(CVECT(VertexOnEdge[j]),diff);
-        V_DIM_LINCOMB(1.0,diff,-0.5,CVECT(MYVERTEX(CORNER(theElement,CORNER_OF_EDGE(theElement,j,0)))),diff);
-        V_DIM_LINCOMB(1.0,diff,-0.5,CVECT(MYVERTEX(CORNER(theElement,CORNER_OF_EDGE(theElement,j,1)))),diff);
-        V_DIM_LINCOMB(0.5,diff,1.0,global,global);
-      }
-    UG_GlobalToLocal(n,(const DOUBLE **)x,global,local);
-    LOCAL_TO_GLOBAL(n,x,local,diff);
-    SETMOVED(theVertex,1);
+  SetCenterVertexPosition(theElement,theVertex);
+
+  /* the vertices on the edges are moved by EvaluateBoundaryBatch */
+  BoundaryBatch *batch = MYMG(theGrid)->boundaryBatch.get();
+  if (batch != NULL && OBJT(theElement) == BEOBJ)
+  {
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    batch->centerVertices.push_back(theVertex);
   }
+
   return(theNode);
 }
 
@@ -2314,6 +2455,17 @@ ELEMENT * NS_DIM_PREFIX CreateElement (GRID *theGrid, INT tag, INT objtype, NODE
 
   SET_EFATHER(pe,Father);
 
+#ifdef ModelP
+  /* the sequential AdaptGrid() records the refined elements, since */
+  /* it may create the sons on several threads                      */
+  if (theGrid->mg->sonTable && Father != NULL)
+    SonsChanged(theGrid->mg,Father);
+#endif
+  if (theGrid->mg->searchIndex)
+    theGrid->mg->searchIndex->valid = false;
+  if (theGrid->mg->surfaceClassUpdate)
+    theGrid->mg->surfaceClassUpdate->valid = false;
+
   /* set corner nodes */
   for (i=0; i<CORNERS_OF_ELEM(pe); i++)
     SET_CORNER(pe,i,nodes[i]);
@@ -2345,7 +2497,7 @@ ELEMENT * NS_DIM_PREFIX CreateElement (GRID *theGrid, INT tag, INT objtype, NODE
   /* create side vectors if */
 #ifdef UG_DIM_3
     for (i=0; i<SIDES_OF_ELEM(pe); i++)
-      if (with_vector)
+      if (with_vector && VEC_DEF_IN_OBJ_OF_GRID(theGrid,SIDEVEC))
       {
         VECTOR *pv;
         if (CreateSideVector (theGrid,i,(GEOM_OBJECT *)pe,&pv))
@@ -2512,6 +2664,7 @@ GRID * NS_DIM_PREFIX CreateNewLevel (MULTIGRID *theMG)
   SETOBJT(theGrid,GROBJ);
   GLEVEL(theGrid) = l;
   NE(theGrid) = 0;
+  theGrid->nFineDof = 0;
   /* other counters are init in INIT fcts below */
 
   GSTATUS(theGrid,0);
@@ -2561,9 +2714,12 @@ MULTIGRID * NS_DIM_PREFIX MakeMGItem (const char *name, std::shared_ptr<PPIF::PP
 {
   MULTIGRID *theMG;
 
-  if (ChangeEnvDir("/Multigrids") == NULL) return (NULL);
   if (strlen(name)>=NAMESIZE || strlen(name)<=1) return (NULL);
-  theMG = (MULTIGRID *) MakeEnvItem(name,theMGDirID,sizeof(MULTIGRID));
+  {
+    std::lock_guard<std::mutex> lock(theMGDirMutex);
+    if (ChangeEnvDir("/Multigrids") == NULL) return (NULL);
+    theMG = (MULTIGRID *) MakeEnvItem(name,theMGDirID,sizeof(MULTIGRID));
+  }
   if (theMG == NULL) return(NULL);
 
   new(theMG) multigrid;
@@ -2691,6 +2847,7 @@ MULTIGRID * NS_DIM_PREFIX GetFirstMultigrid ()
   ENVDIR *theMGRootDir;
   MULTIGRID *theMG;
 
+  std::lock_guard<std::mutex> lock(theMGDirMutex);
   theMGRootDir = ChangeEnvDir("/Multigrids");
 
   assert (theMGRootDir!=NULL);
@@ -2713,7 +2870,9 @@ MULTIGRID * NS_DIM_PREFIX GetFirstMultigrid ()
  * @param   theMG - multigrid structure
 
    This function returns a pointer to the next multigrid in the /Multigrids
-   directory.
+   directory. Each call is guarded against multigrids created or disposed
+   on other threads, but a loop over all multigrids is not: theMG must not
+   be disposed meanwhile.
 
    @return <ul>
    <li>   pointer to MULTIGRID </li>
@@ -2725,7 +2884,10 @@ MULTIGRID * NS_DIM_PREFIX GetNextMultigrid (const MULTIGRID *theMG)
 {
   MULTIGRID *MG;
 
-  MG = (MULTIGRID *) NEXT_ENVITEM(theMG);
+  {
+    std::lock_guard<std::mutex> lock(theMGDirMutex);
+    MG = (MULTIGRID *) NEXT_ENVITEM(theMG);
+  }
 
   if (MG != NULL)
   {
@@ -2745,6 +2907,9 @@ MULTIGRID * NS_DIM_PREFIX GetNextMultigrid (const MULTIGRID *theMG)
  * @param   problem - name of problem description from environment
  * @param   format - name of format description from environment
  * @param   optimizedIE - allocate NodeElementList
+ * @param   distributedCoarseGrid - the coarse grid is inserted in parts on all processes
+                                    (see IdentifyDistributedCoarseGrid), hence the mesh
+                                    is inserted on all processes instead of the master only
 
    This function creates and initializes a new multigrid structure including
    allocation of heap, combining the domain and the boundary conditions
@@ -2758,7 +2923,8 @@ MULTIGRID * NS_DIM_PREFIX GetNextMultigrid (const MULTIGRID *theMG)
 
 MULTIGRID * NS_DIM_PREFIX CreateMultiGrid (char *MultigridName, STD_BVP *theBVP,
                                            const char *format, INT optimizedIE, INT insertMesh,
-                                           std::shared_ptr<PPIF::PPIFContext> ppifContext)
+                                           std::shared_ptr<PPIF::PPIFContext> ppifContext,
+                                           bool distributedCoarseGrid)
 {
   HEAP *theHeap;
   MULTIGRID *theMG;
@@ -2838,7 +3004,7 @@ MULTIGRID * NS_DIM_PREFIX CreateMultiGrid (char *MultigridName, STD_BVP *theBVP,
   if (insertMesh)
   {
                 #ifdef ModelP
-    if (theMG->ppifContext().isMaster())
+    if (theMG->ppifContext().isMaster() || distributedCoarseGrid)
     {
                 #endif
     if (InsertMesh(theMG,&mesh))
@@ -2862,6 +3028,48 @@ MULTIGRID * NS_DIM_PREFIX CreateMultiGrid (char *MultigridName, STD_BVP *theBVP,
   return(theMG);
 }
 
+/****************************************************************************/
+/** \brief Return the level indices of a grid level, see EnableIndexMaintenance
+
+ * @param   indices - maintained indices of a multigrid
+ * @param   level - grid level
+
+   @return level indices of the grid level */
+/****************************************************************************/
+
+static IndexMaintenance::Level &IndexLevel (IndexMaintenance &indices, INT level)
+{
+  if (indices.levels.size() <= (std::size_t)level)
+  {
+    indices.levels.resize(level+1);
+    for (IndexMaintenance::Level &theLevel : indices.levels)
+      theLevel.elements.resize(TAGS);
+  }
+  return indices.levels[level];
+}
+
+/* an object is numbered if its slot points back to it, new objects */
+/* are zero initialized by GetMemoryForObject                       */
+static bool HasIndex (const IndexSlots &slots, const void *object, int index)
+{
+  return index >= 0 && (std::size_t)index < slots.objects.size()
+         && slots.objects[index] == object;
+}
+
+static void AssignIndex (IndexSlots &slots, void *object, int &index)
+{
+  if (HasIndex(slots,object,index)) return;
+  index = slots.objects.size();
+  slots.objects.push_back(object);
+}
+
+static void ReleaseIndex (IndexSlots &slots, const void *object, int index)
+{
+  if (!HasIndex(slots,object,index)) return;
+  slots.objects[index] = nullptr;
+  slots.released.push_back(index);
+}
+
 /****************************************************************************/
 /** \brief Remove edge from the data structure
 
@@ -2932,6 +3140,12 @@ static INT DisposeEdge (GRID *theGrid, EDGE *theEdge)
   if (MIDNODE(theEdge) != NULL)
     SETNFATHER(MIDNODE(theEdge),NULL);
 
+  if (theGrid->mg->indexMaintenance)
+    ReleaseIndex(IndexLevel(*theGrid->mg->indexMaintenance,GLEVEL(theGrid)).edges,
+                 theEdge,theEdge->levelIndex);
+  if (theGrid->mg->changeSet)
+    theGrid->mg->changeSet->deletedEdges.push_back(theEdge->id);
+
   PutFreeObject(theGrid->mg,theEdge,sizeof(EDGE)-sizeof(VECTOR*),EDOBJ);
 
   /* check error condition */
@@ -3035,6 +3249,12 @@ INT NS_DIM_PREFIX DisposeNode (GRID *theGrid, NODE *theNode)
   else
     DECNOOFNODE(theVertex);
 
+  if (theGrid->mg->indexMaintenance)
+    ReleaseIndex(IndexLevel(*theGrid->mg->indexMaintenance,GLEVEL(theGrid)).nodes,
+                 theNode,theNode->levelIndex);
+  if (theGrid->mg->changeSet)
+    theGrid->mg->changeSet->deletedNodes.push_back(ID(theNode));
+
 #ifdef ModelP
   /* free message buffer */
   theNode->message_buffer_free();
@@ -3077,6 +3297,12 @@ static INT DisposeVertex (GRID *theGrid, VERTEX *theVertex)
   /* remove vertex from vertex list */
   GRID_UNLINK_VERTEX(theGrid,theVertex);
 
+  if (MYMG(theGrid)->indexMaintenance)
+    ReleaseIndex(MYMG(theGrid)->indexMaintenance->leafVertices,
+                 theVertex,theVertex->iv.leafIndex);
+  if (MYMG(theGrid)->changeSet)
+    MYMG(theGrid)->changeSet->deletedVertices.push_back(ID(theVertex));
+
   if( OBJT(theVertex) == BVOBJ )
   {
     BNDP_Dispose(MGHEAP(MYMG(theGrid)),V_BNDP(theVertex));
@@ -3121,6 +3347,23 @@ INT NS_DIM_PREFIX DisposeElement (GRID *theGrid, ELEMENT *theElement)
 
   GRID_UNLINK_ELEMENT(theGrid,theElement);
 
+  if (MYMG(theGrid)->indexMaintenance)
+  {
+    IndexMaintenance &indices = *MYMG(theGrid)->indexMaintenance;
+    ReleaseIndex(IndexLevel(indices,GLEVEL(theGrid)).elements[TAG(theElement)],
+                 theElement,theElement->ge.levelIndex);
+    ReleaseIndex(indices.leafElements[TAG(theElement)],
+                 theElement,theElement->ge.leafIndex);
+  }
+  if (MYMG(theGrid)->changeSet)
+    MYMG(theGrid)->changeSet->deletedElements.push_back(ID(theElement));
+  if (MYMG(theGrid)->sonTable)
+    SonTableDisposeElement(MYMG(theGrid),theElement);
+  if (MYMG(theGrid)->searchIndex)
+    MYMG(theGrid)->searchIndex->valid = false;
+  if (MYMG(theGrid)->surfaceClassUpdate)
+    MYMG(theGrid)->surfaceClassUpdate->valid = false;
+
         #ifdef __CENTERNODE__
   {
     theNode = CENTERNODE(theElement);
@@ -3541,6 +3784,10 @@ INT NS_DIM_PREFIX Collapse (MULTIGRID *theMG)
   DDD_IFRefreshAll(theGrid->dddContext());
         #endif
 
+  /* no element has sons any more */
+  if (theMG->sonTable)
+    theMG->sonTable = std::make_unique<SonTable>();
+
   if (MG_COARSE_FIXED(theMG))
     if (CreateAlgebra(theMG))
       REP_ERR_RETURN(1);
@@ -3671,6 +3918,14 @@ INT NS_DIM_PREFIX DisposeMultiGrid (MULTIGRID *theMG)
 {
   INT level;
 
+  /* nothing to maintain or record anymore */
+  theMG->indexMaintenance.reset();
+  theMG->changeSet.reset();
+  theMG->sonTable.reset();
+  theMG->boundaryBatch.reset();
+  theMG->searchIndex.reset();
+  theMG->surfaceClassUpdate.reset();
+
         #ifdef ModelP
   /* tell DDD that we will 'inconsistently' delete objects.
      this is a dangerous mode as it switches DDD warnings off. */
@@ -3710,12 +3965,846 @@ INT NS_DIM_PREFIX DisposeMultiGrid (MULTIGRID *theMG)
   theMG->~multigrid();
 
   /* delete mg */
+  std::lock_guard<std::mutex> lock(theMGDirMutex);
   if (ChangeEnvDir("/Multigrids")==NULL) RETURN (GM_ERROR);
   if (RemoveEnvDir ((ENVITEM *)theMG)) RETURN (GM_ERROR);
 
   return(GM_OK);
 }
 
+/****************************************************************************/
+/** \brief Let AdaptMultiGrid maintain the level and leaf indices
+
+ * @param   theMG - multigrid
+
+   Without maintenance the levelIndex and leafIndex fields are controlled
+   by DUNE, which renumbers the whole hierarchy after each adaptation.
+   This function numbers all objects once. Afterwards AdaptMultiGrid keeps
+   the indices unique and consecutive by itself:
+
+   - levelIndex of the nodes and edges of each level
+   - levelIndex of the elements of each level, per tag
+   - leafIndex of the elements without sons, per tag
+   - leafIndex of the vertices
+
+   Disposed objects release their index, new objects get one at the end,
+   and CompactIndices fills the released indices at the end of
+   AdaptMultiGrid by moving the objects with the largest indices. The moves
+   are kept in theMG->indexMaintenance, so user data can be compacted with
+   work proportional to the change. The leafIndex of edges and side vectors
+   and the isLeaf flag of the nodes are not maintained.
+
+   Objects inserted into the coarse grid later are not numbered, call this
+   function again then. The parallel version does not maintain the indices,
+   since load balancing creates and disposes objects in the DDD handlers.
+
+   @return <ul>
+   <li>   GM_OK if ok </li>
+   <li>   GM_ERROR in the parallel version </li>
+   </ul> */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX EnableIndexMaintenance (MULTIGRID *theMG)
+{
+#ifdef ModelP
+  PrintErrorMessage('E',"EnableIndexMaintenance","not available in the parallel version");
+  RETURN(GM_ERROR);
+#else
+  theMG->indexMaintenance = std::make_unique<IndexMaintenance>();
+  IndexMaintenance &indices = *theMG->indexMaintenance;
+  indices.leafElements.resize(TAGS);
+
+  for (INT level=0; level<=TOPLEVEL(theMG); level++)
+  {
+    GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+    IndexMaintenance::Level &theLevel = IndexLevel(indices,level);
+
+    for (ELEMENT *theElement = PFIRSTELEMENT(theGrid); theElement != NULL; theElement = SUCCE(theElement))
+    {
+      AssignIndex(theLevel.elements[TAG(theElement)],theElement,theElement->ge.levelIndex);
+      if (NSONS(theElement) == 0)
+        AssignIndex(indices.leafElements[TAG(theElement)],theElement,theElement->ge.leafIndex);
+    }
+
+    for (NODE *theNode = PFIRSTNODE(theGrid); theNode != NULL; theNode = SUCCN(theNode))
+    {
+      AssignIndex(theLevel.nodes,theNode,theNode->levelIndex);
+      for (LINK *theLink = START(theNode); theLink != NULL; theLink = NEXT(theLink))
+        AssignIndex(theLevel.edges,MYEDGE(theLink),MYEDGE(theLink)->levelIndex);
+    }
+
+    for (VERTEX *theVertex = PFIRSTVERTEX(theGrid); theVertex != NULL; theVertex = SUCCV(theVertex))
+      AssignIndex(indices.leafVertices,theVertex,theVertex->iv.leafIndex);
+  }
+
+  /* no moves for the initial numbering */
+  CompactIndices(theMG);
+
+  return(GM_OK);
+#endif
+}
+
+/****************************************************************************/
+/** \brief Number the sons of an element whose refinement changed
+
+ * @param   theMG - multigrid with index maintenance
+ * @param   theElement - element unrefined and possibly refined again
+
+   This function is called by AdaptMultiGrid after the refinement of an
+   element changed. The old sons have released their indices already when
+   they were disposed. The element gets or releases its leafIndex, the new
+   sons, their corners, vertices and edges get indices at the end.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX UpdateSonIndices (MULTIGRID *theMG, ELEMENT *theElement)
+{
+  IndexMaintenance &indices = *theMG->indexMaintenance;
+
+  ELEMENT *SonList[MAX_SONS];
+  if (GetAllSons(theElement,SonList) != GM_OK)
+    return;
+
+  if (SonList[0] == NULL)
+  {
+    AssignIndex(indices.leafElements[TAG(theElement)],theElement,theElement->ge.leafIndex);
+    return;
+  }
+  ReleaseIndex(indices.leafElements[TAG(theElement)],theElement,theElement->ge.leafIndex);
+
+  IndexMaintenance::Level &theLevel = IndexLevel(indices,LEVEL(theElement)+1);
+  for (INT i=0; i<MAX_SONS && SonList[i]!=NULL; i++)
+  {
+    ELEMENT *theSon = SonList[i];
+    AssignIndex(theLevel.elements[TAG(theSon)],theSon,theSon->ge.levelIndex);
+    if (NSONS(theSon) == 0)
+      AssignIndex(indices.leafElements[TAG(theSon)],theSon,theSon->ge.leafIndex);
+
+    for (INT j=0; j<CORNERS_OF_ELEM(theSon); j++)
+    {
+      NODE *theNode = CORNER(theSon,j);
+      AssignIndex(theLevel.nodes,theNode,theNode->levelIndex);
+      AssignIndex(indices.leafVertices,MYVERTEX(theNode),MYVERTEX(theNode)->iv.leafIndex);
+    }
+
+    for (INT j=0; j<EDGES_OF_ELEM(theSon); j++)
+    {
+      EDGE *theEdge = GetEdge(CORNER_OF_EDGE_PTR(theSon,j,0),CORNER_OF_EDGE_PTR(theSon,j,1));
+      ASSERT(theEdge != NULL);
+      AssignIndex(theLevel.edges,theEdge,theEdge->levelIndex);
+    }
+  }
+}
+
+/****************************************************************************/
+/** \brief Fill the released indices of one kind of objects
+
+ * @param   slots - indices of one kind of objects
+ * @param   indexOf - index field of an object
+
+   The released indices are filled in increasing order, each with the
+   object of the largest index. The moves are recorded in slots.moves.
+ */
+/****************************************************************************/
+
+template <class IndexOf>
+static void CompactIndexSlots (IndexSlots &slots, IndexOf indexOf)
+{
+  slots.moves.clear();
+  std::sort(slots.released.begin(),slots.released.end());
+
+  for (INT hole : slots.released)
+  {
+    while (!slots.objects.empty() && slots.objects.back() == nullptr)
+      slots.objects.pop_back();
+    if ((std::size_t)hole >= slots.objects.size())
+      break;
+
+    const INT last = slots.objects.size()-1;
+    slots.objects[hole] = slots.objects[last];
+    slots.objects.pop_back();
+    indexOf(slots.objects[hole]) = hole;
+    slots.moves.emplace_back(last,hole);
+  }
+  while (!slots.objects.empty() && slots.objects.back() == nullptr)
+    slots.objects.pop_back();
+
+  slots.released.clear();
+  slots.previousSize = slots.objects.size();
+}
+
+/****************************************************************************/
+/** \brief Make the maintained indices consecutive again
+
+ * @param   theMG - multigrid with index maintenance
+
+   This function is called at the end of AdaptMultiGrid, see
+   EnableIndexMaintenance. Its work is proportional to the number of
+   objects created and disposed since the previous call.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX CompactIndices (MULTIGRID *theMG)
+{
+  IndexMaintenance &indices = *theMG->indexMaintenance;
+
+  auto elementLevelIndex = [](void *object) -> int& { return ((ELEMENT *)object)->ge.levelIndex; };
+  auto elementLeafIndex = [](void *object) -> int& { return ((ELEMENT *)object)->ge.leafIndex; };
+
+  for (IndexMaintenance::Level &theLevel : indices.levels)
+  {
+    CompactIndexSlots(theLevel.nodes,[](void *object) -> int& { return ((NODE *)object)->levelIndex; });
+    CompactIndexSlots(theLevel.edges,[](void *object) -> int& { return ((EDGE *)object)->levelIndex; });
+    for (IndexSlots &slots : theLevel.elements)
+      CompactIndexSlots(slots,elementLevelIndex);
+  }
+
+  for (IndexSlots &slots : indices.leafElements)
+    CompactIndexSlots(slots,elementLeafIndex);
+  CompactIndexSlots(indices.leafVertices,[](void *object) -> int& { return ((VERTEX *)object)->iv.leafIndex; });
+}
+
+/****************************************************************************/
+/** \brief Set the positions of the boundary vertices of a refinement step
+
+ * @param   theMG - multigrid with boundary batching
+
+   This function is called by AdaptMultiGrid after the elements of a level
+   have been refined, see SetBoundaryBatching. It evaluates the boundary
+   parametrization for all new vertices on the boundary with one call of
+   BNDP_GlobalBatch, moves them onto the boundary and updates their local
+   coordinates. Afterwards the new center vertices of boundary elements are
+   placed again, since they depend on the moved vertices on their edges.
+   The result is the same as with the evaluation in CreateMidNode and
+   CreateSideNode.
+
+   @return <ul>
+   <li>   GM_OK if ok </li>
+   <li>   GM_ERROR if the boundary parametrization failed </li>
+   </ul> */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX EvaluateBoundaryBatch (MULTIGRID *theMG)
+{
+  BoundaryBatch &batch = *theMG->boundaryBatch;
+  const INT nVertices = batch.vertices.size();
+
+  std::vector<const BNDP*> bndps(nVertices);
+  std::vector<FieldVector<DOUBLE,DIM> > globals(nVertices);
+  for (INT i=0; i<nVertices; i++)
+    bndps[i] = V_BNDP(batch.vertices[i]);
+  if (BNDP_GlobalBatch(nVertices,bndps.data(),globals.data()))
+    RETURN(GM_ERROR);
+
+  for (INT i=0; i<nVertices; i++)
+  {
+    VERTEX *theVertex = batch.vertices[i];
+    DOUBLE *x[MAX_CORNERS_OF_ELEM];
+    DOUBLE diff;
+    INT n;
+
+    /* CVECT is still the linear position */
+    V_DIM_EUKLIDNORM_OF_DIFF(globals[i],CVECT(theVertex),diff);
+    V_DIM_COPY(globals[i],CVECT(theVertex));
+    if (diff > MAX_PAR_DIST)
+    {
+      SETMOVED(theVertex,1);
+      CORNER_COORDINATES(VFATHER(theVertex),n,x);
+      UG_GlobalToLocal(n,(const DOUBLE **)x,globals[i],LCVECT(theVertex));
+    }
+  }
+
+  for (VERTEX *theVertex : batch.centerVertices)
+    SetCenterVertexPosition(VFATHER(theVertex),theVertex);
+
+  batch.vertices.clear();
+  batch.centerVertices.clear();
+
+  return(GM_OK);
+}
+
+/****************************************************************************/
+/** \brief Switch the batched evaluation of the boundary parametrization
+
+ * @param   theMG - multigrid
+ * @param   batch - true to evaluate the boundary nodes of a refinement step at once
+
+   With batching, CreateMidNode and CreateSideNode place new boundary vertices
+   at the linear position first and AdaptMultiGrid evaluates the boundary
+   parametrization for all of them after the elements of a level have been
+   refined, see EvaluateBoundaryBatch. Boundary segments with a BndSegBatchFunc
+   are then evaluated with one call per segment.
+
+   @return <ul>
+   <li>   GM_OK </li>
+   </ul> */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX SetBoundaryBatching (MULTIGRID *theMG, bool batch)
+{
+  if (!batch)
+    theMG->boundaryBatch.reset();
+  else if (!theMG->boundaryBatch)
+    theMG->boundaryBatch = std::make_unique<BoundaryBatch>();
+
+  return(GM_OK);
+}
+
+/****************************************************************************/
+/*                                                                          */
+/* point location                                                           */
+/*                                                                          */
+/****************************************************************************/
+
+/** \brief Margin of the boxes relative to the size of the domain and
+    margin of the reference elements in the point location */
+#define SEARCH_TOLERANCE                1e-8
+
+static void CornerBox (ELEMENT *theElement, SearchIndex::Box &box)
+{
+  box.lower.fill(std::numeric_limits<DOUBLE>::max());
+  box.upper.fill(-std::numeric_limits<DOUBLE>::max());
+
+  for (INT i=0; i<CORNERS_OF_ELEM(theElement); i++)
+  {
+    const Dune::FieldVector<DOUBLE,DIM>& x = CVECT(MYVERTEX(CORNER(theElement,i)));
+    for (INT d=0; d<DIM; d++)
+    {
+      box.lower[d] = std::min(box.lower[d],x[d]);
+      box.upper[d] = std::max(box.upper[d],x[d]);
+    }
+  }
+}
+
+static void AddToBox (SearchIndex::Box &box, const SearchIndex::Box &other)
+{
+  for (INT d=0; d<DIM; d++)
+  {
+    box.lower[d] = std::min(box.lower[d],other.lower[d]);
+    box.upper[d] = std::max(box.upper[d],other.upper[d]);
+  }
+}
+
+static bool InBox (const SearchIndex::Box &box, const Dune::FieldVector<DOUBLE,DIM>& x, DOUBLE tolerance)
+{
+  for (INT d=0; d<DIM; d++)
+    if (x[d]<box.lower[d]-tolerance || x[d]>box.upper[d]+tolerance)
+      return false;
+
+  return true;
+}
+
+static DOUBLE BoxDistance2 (const SearchIndex::Box &box, const Dune::FieldVector<DOUBLE,DIM>& x)
+{
+  DOUBLE distance2 = 0.0;
+  for (INT d=0; d<DIM; d++)
+  {
+    const DOUBLE diff = std::max({box.lower[d]-x[d],x[d]-box.upper[d],0.0});
+    distance2 += diff*diff;
+  }
+
+  return distance2;
+}
+
+/* append the tree at first in from to entries, returns the entry of its root */
+static INT CopySearchTree (std::vector<SearchIndex::Entry> &entries,
+                          const std::vector<SearchIndex::Entry> &from, INT first)
+{
+  const INT root = entries.size();
+  const INT offset = root-first;
+
+  entries.insert(entries.end(),from.begin()+first,from.begin()+from[first].end);
+  for (INT i=root; i<(INT)entries.size(); i++)
+    entries[i].end += offset;
+
+  return root;
+}
+
+/* elements of the current AdaptMultiGrid whose sons changed, and their ancestors */
+struct SearchTreeChanges {
+  std::unordered_set<const ELEMENT*> changed;
+  std::unordered_set<const ELEMENT*> dirty;
+};
+
+/* append the tree of theElement in pre-order, old is its entry in index.entries
+   or -1; the boxes of unchanged subtrees are copied from there */
+static void AppendSearchTree (const SearchIndex &index, const SearchTreeChanges *changes,
+                              std::vector<SearchIndex::Entry> &entries, ELEMENT *theElement, INT old)
+{
+  if (old>=0 && changes->dirty.count(theElement)==0)
+  {
+    CopySearchTree(entries,index.entries,old);
+    return;
+  }
+
+  const INT entry = entries.size();
+  entries.push_back({SearchIndex::Box(),theElement,0});
+  CornerBox(theElement,entries[entry].box);
+
+  if (NSONS(theElement)>0)
+  {
+    /* the old sons are still the sons unless they changed */
+    ELEMENT *OldSonList[MAX_SONS];
+    INT oldSons[MAX_SONS];
+    INT nOld = 0;
+    if (old>=0 && changes->changed.count(theElement)==0)
+      for (INT son=old+1; son<index.entries[old].end; son=index.entries[son].end)
+      {
+        OldSonList[nOld] = index.entries[son].element;
+        oldSons[nOld++] = son;
+      }
+
+    ELEMENT *SonList[MAX_SONS];
+    GetSons(theElement,SonList);
+    for (INT i=0; i<MAX_SONS && SonList[i]!=NULL; i++)
+    {
+      INT oldSon = -1;
+      for (INT j=0; j<nOld; j++)
+        if (OldSonList[j]==SonList[i])
+          oldSon = oldSons[j];
+
+      const INT son = entries.size();
+      AppendSearchTree(index,changes,entries,SonList[i],oldSon);
+      AddToBox(entries[entry].box,entries[son].box);
+    }
+  }
+
+  entries[entry].end = entries.size();
+}
+
+/* hierarchy over the trees with the roots roots[first,last) in pre-order,
+   returns the index of its root */
+static INT BuildSearchNodes (SearchIndex &index, std::vector<INT> &roots, INT first, INT last)
+{
+  const INT node = index.nodes.size();
+  index.nodes.emplace_back();
+
+  if (last-first==1)
+  {
+    index.nodes[node].entry = roots[first];
+    index.nodes[node].box = index.entries[roots[first]].box;
+    return node;
+  }
+
+  /* split at the median of the box centers along the longest axis */
+  SearchIndex::Box centers;
+  centers.lower.fill(std::numeric_limits<DOUBLE>::max());
+  centers.upper.fill(-std::numeric_limits<DOUBLE>::max());
+  for (INT i=first; i<last; i++)
+  {
+    const SearchIndex::Box &box = index.entries[roots[i]].box;
+    for (INT d=0; d<DIM; d++)
+    {
+      centers.lower[d] = std::min(centers.lower[d],box.lower[d]+box.upper[d]);
+      centers.upper[d] = std::max(centers.upper[d],box.lower[d]+box.upper[d]);
+    }
+  }
+  INT axis = 0;
+  for (INT d=1; d<DIM; d++)
+    if (centers.upper[d]-centers.lower[d]>centers.upper[axis]-centers.lower[axis])
+      axis = d;
+
+  const INT middle = (first+last)/2;
+  std::nth_element(roots.begin()+first,roots.begin()+middle,roots.begin()+last,
+                   [&index,axis](INT a, INT b)
+  {
+    const SearchIndex::Box &boxA = index.entries[a].box;
+    const SearchIndex::Box &boxB = index.entries[b].box;
+    return boxA.lower[axis]+boxA.upper[axis] < boxB.lower[axis]+boxB.upper[axis];
+  });
+
+  const INT left = BuildSearchNodes(index,roots,first,middle);
+  const INT right = BuildSearchNodes(index,roots,middle,last);
+  index.nodes[node].left = left;
+  index.nodes[node].right = right;
+  index.nodes[node].box = index.nodes[left].box;
+  AddToBox(index.nodes[node].box,index.nodes[right].box);
+
+  return node;
+}
+
+/****************************************************************************/
+/** \brief Update the search index of a multigrid
+
+ * @param   theMG - multigrid with a search index
+
+   This function is called by SetSearchIndex and at the end of AdaptMultiGrid.
+   The element trees are stored one after the other in the order of the
+   leaves of the hierarchy over level 0. If the index was valid before
+   AdaptMultiGrid, the trees are stored again in this order: the boxes of
+   the elements whose sons changed and of their ancestors are computed
+   again, those of the other subtrees are copied, and the hierarchy is
+   refitted. Otherwise the boxes of all elements and the hierarchy are
+   built from scratch.
+ */
+/****************************************************************************/
+
+void NS_DIM_PREFIX RefreshSearchIndex (MULTIGRID *theMG)
+{
+  SearchIndex &index = *theMG->searchIndex;
+  std::vector<SearchIndex::Entry> entries;
+
+  if (index.incremental)
+  {
+    SearchTreeChanges changes;
+    for (ELEMENT *theElement : index.changed)
+    {
+      changes.changed.insert(theElement);
+      for (ELEMENT *e=theElement; e!=NULL && changes.dirty.insert(e).second; e=EFATHER(e)) ;
+    }
+
+    entries.reserve(index.entries.size());
+    for (SearchIndex::Node &theNode : index.nodes)
+      if (theNode.entry>=0)
+      {
+        const INT old = theNode.entry;
+        theNode.entry = entries.size();
+        AppendSearchTree(index,&changes,entries,index.entries[old].element,old);
+      }
+    index.entries.swap(entries);
+
+    /* the children of a node come after it */
+    for (INT node=index.nodes.size()-1; node>=0; node--)
+    {
+      SearchIndex::Node &theNode = index.nodes[node];
+      if (theNode.entry>=0)
+        theNode.box = index.entries[theNode.entry].box;
+      else
+      {
+        theNode.box = index.nodes[theNode.left].box;
+        AddToBox(theNode.box,index.nodes[theNode.right].box);
+      }
+    }
+  }
+  else
+  {
+    /* the trees in the order of level 0 first */
+    std::vector<INT> roots;
+    for (ELEMENT *theElement=PFIRSTELEMENT(GRID_ON_LEVEL(theMG,0)); theElement!=NULL;
+         theElement=SUCCE(theElement))
+    {
+      roots.push_back(entries.size());
+      AppendSearchTree(index,nullptr,entries,theElement,-1);
+    }
+    index.entries.swap(entries);
+
+    index.nodes.clear();
+    if (!roots.empty())
+    {
+      index.nodes.reserve(2*roots.size()-1);
+      BuildSearchNodes(index,roots,0,roots.size());
+    }
+
+    /* then in the order of the leaves */
+    entries.clear();
+    for (SearchIndex::Node &theNode : index.nodes)
+      if (theNode.entry>=0)
+        theNode.entry = CopySearchTree(entries,index.entries,theNode.entry);
+    index.entries.swap(entries);
+  }
+
+  index.tolerance = 0.0;
+  if (!index.nodes.empty())
+    for (INT d=0; d<DIM; d++)
+      index.tolerance = std::max(index.tolerance,
+                                 index.nodes[0].box.upper[d]-index.nodes[0].box.lower[d]);
+  index.tolerance *= SEARCH_TOLERANCE;
+
+  index.changed.clear();
+  index.valid = true;
+}
+
+/* local coordinates of global if it is in the leaf element theElement */
+static bool LocalInLeafElement (ELEMENT *theElement, const Dune::FieldVector<DOUBLE,DIM>& global,
+                                Dune::FieldVector<DOUBLE,DIM>& local)
+{
+  DOUBLE *x[MAX_CORNERS_OF_ELEM];
+  INT n;
+
+  CORNER_COORDINATES(theElement,n,x);
+  if (UG_GlobalToLocal(n,(const DOUBLE **)x,global,local)!=0)
+    return false;
+
+  const DOUBLE eps = SEARCH_TOLERANCE;
+  for (INT d=0; d<DIM; d++)
+    if (local[d]<-eps)
+      return false;
+
+  switch (TAG(theElement))
+  {
+#ifdef UG_DIM_2
+  case TRIANGLE :
+    return local[0]+local[1]<=1.0+eps;
+  case QUADRILATERAL :
+    return local[0]<=1.0+eps && local[1]<=1.0+eps;
+#else
+  case TETRAHEDRON :
+    return local[0]+local[1]+local[2]<=1.0+eps;
+  case PYRAMID :
+    return local[0]+local[2]<=1.0+eps && local[1]+local[2]<=1.0+eps;
+  case PRISM :
+    return local[0]+local[1]<=1.0+eps && local[2]<=1.0+eps;
+  case HEXAHEDRON :
+    return local[0]<=1.0+eps && local[1]<=1.0+eps && local[2]<=1.0+eps;
+#endif
+  default :
+    return false;
+  }
+}
+
+static ELEMENT *LocateInEntry (const SearchIndex &index, INT entry,
+                               const Dune::FieldVector<DOUBLE,DIM>& global, Dune::FieldVector<DOUBLE,DIM>& local)
+{
+  const SearchIndex::Entry &theEntry = index.entries[entry];
+
+  if (!InBox(theEntry.box,global,index.tolerance))
+    return nullptr;
+
+  if (NSONS(theEntry.element)==0)
+    return LocalInLeafElement(theEntry.element,global,local) ? theEntry.element : nullptr;
+
+  for (INT son=entry+1; son<theEntry.end; son=index.entries[son].end)
+    if (ELEMENT *theLeaf = LocateInEntry(index,son,global,local))
+      return theLeaf;
+
+  return nullptr;
+}
+
+static ELEMENT *LocateInNode (const SearchIndex &index, INT node,
+                              const Dune::FieldVector<DOUBLE,DIM>& global, Dune::FieldVector<DOUBLE,DIM>& local)
+{
+  const SearchIndex::Node &theNode = index.nodes[node];
+
+  if (!InBox(theNode.box,global,index.tolerance))
+    return nullptr;
+  if (theNode.entry>=0)
+    return LocateInEntry(index,theNode.entry,global,local);
+
+  if (ELEMENT *theLeaf = LocateInNode(index,theNode.left,global,local))
+    return theLeaf;
+  return LocateInNode(index,theNode.right,global,local);
+}
+
+static const SearchIndex *ValidSearchIndex (const MULTIGRID *theMG, const char *caller)
+{
+  const SearchIndex *index = theMG->searchIndex.get();
+
+  if (index==nullptr || !index->valid.load(std::memory_order_relaxed))
+  {
+    PrintErrorMessage('E',caller,"no valid search index, see SetSearchIndex");
+    return nullptr;
+  }
+
+  return index;
+}
+
+/****************************************************************************/
+/** \brief Find the leaf element containing a point
+
+ * @param   theMG - multigrid with a valid search index
+ * @param   global - global coordinates of the point
+ * @param   local - local coordinates of the point in the element if not nullptr
+
+   The search descends the bounding volume hierarchy over level 0 and the
+   boxes of the element trees to the leaf elements whose boxes contain the
+   point, see SetSearchIndex. A point on the boundary between elements is
+   found in one of them.
+
+   @return <ul>
+   <li>   the leaf element containing global </li>
+   <li>   nullptr if global is outside of the grid or there is no valid search index </li>
+   </ul> */
+/****************************************************************************/
+
+ELEMENT * NS_DIM_PREFIX FindLeafElement (const MULTIGRID *theMG, const FieldVector<DOUBLE,DIM>& global,
+                                         FieldVector<DOUBLE,DIM> *local)
+{
+  const SearchIndex *index = ValidSearchIndex(theMG,"FindLeafElement");
+  if (index==nullptr || index->nodes.empty())
+    return nullptr;
+
+  FieldVector<DOUBLE,DIM> xi;
+  ELEMENT *theElement = LocateInNode(*index,0,global,xi);
+  if (theElement!=nullptr && local!=nullptr)
+    *local = xi;
+
+  return theElement;
+}
+
+/****************************************************************************/
+/** \brief Find the leaf elements containing many points
+
+ * @param   theMG - multigrid with a valid search index
+ * @param   n - number of points
+ * @param   global - global coordinates of the points
+ * @param   theElements - leaf element containing each point, nullptr if outside
+
+   The points are located as with FindLeafElement, in chunks on the refine
+   threads of the multigrid (see SetRefineThreads).
+
+   @return <ul>
+   <li>   GM_OK if ok </li>
+   <li>   GM_ERROR if there is no valid search index </li>
+   </ul> */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX FindLeafElements (const MULTIGRID *theMG, INT n, const FieldVector<DOUBLE,DIM> *global,
+                                    ELEMENT **theElements)
+{
+  const SearchIndex *index = ValidSearchIndex(theMG,"FindLeafElements");
+  if (index==nullptr)
+    return(GM_ERROR);
+
+  if (index->nodes.empty())
+  {
+    std::fill(theElements,theElements+n,nullptr);
+    return(GM_OK);
+  }
+
+  /* a thread is not worth it for few points */
+  constexpr INT minChunkSize = 4096;
+  const INT nChunks = std::max<INT>(std::min<INT>(theMG->refineThreads,
+                                                  n/minChunkSize),1);
+
+  auto findChunk = [&](INT chunk)
+  {
+    FieldVector<DOUBLE,DIM> local;
+    for (INT i=(INT)(((long)n*chunk)/nChunks); i<(INT)(((long)n*(chunk+1))/nChunks); i++)
+      theElements[i] = LocateInNode(*index,0,global[i],local);
+  };
+
+  std::vector<std::thread> threads;
+  for (INT chunk=1; chunk<nChunks; chunk++)
+    threads.emplace_back(findChunk,chunk);
+  findChunk(0);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  return(GM_OK);
+}
+
+/****************************************************************************/
+/** \brief Find the leaf elements nearest to a point
+
+ * @param   theMG - multigrid with a valid search index
+ * @param   global - global coordinates of the point
+ * @param   k - number of elements wanted
+ * @param   theElements - the elements, nearest first
+
+   The distance of an element is the distance of its center of mass to the
+   point. The search visits the nodes of the hierarchy and the element trees
+   in the order of the distance of their boxes, which is a lower bound for
+   the distances of the leaf elements below them.
+
+   @return <ul>
+   <li>   number of elements found, less than k only if the grid has less leaf elements </li>
+   <li>   -1 if there is no valid search index </li>
+   </ul> */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX FindNearestLeafElements (const MULTIGRID *theMG, const FieldVector<DOUBLE,DIM>& global,
+                                           INT k, ELEMENT **theElements)
+{
+  const SearchIndex *index = ValidSearchIndex(theMG,"FindNearestLeafElements");
+  if (index==nullptr)
+    return(-1);
+
+  /* node of the hierarchy, entry of an element tree or leaf element */
+  struct Candidate {
+    DOUBLE distance2;
+    INT node;
+    INT entry;
+    bool leaf;
+
+    bool operator> (const Candidate &other) const { return distance2 > other.distance2; }
+  };
+  std::priority_queue<Candidate,std::vector<Candidate>,std::greater<Candidate> > candidates;
+
+  if (!index->nodes.empty())
+    candidates.push({BoxDistance2(index->nodes[0].box,global),0,-1,false});
+
+  INT count = 0;
+  while (count<k && !candidates.empty())
+  {
+    const Candidate candidate = candidates.top();
+    candidates.pop();
+
+    if (candidate.leaf)
+      theElements[count++] = index->entries[candidate.entry].element;
+    else if (candidate.entry<0)
+    {
+      const SearchIndex::Node &theNode = index->nodes[candidate.node];
+      if (theNode.entry>=0)
+        candidates.push({BoxDistance2(theNode.box,global),-1,theNode.entry,false});
+      else
+        for (INT child : {theNode.left,theNode.right})
+          candidates.push({BoxDistance2(index->nodes[child].box,global),child,-1,false});
+    }
+    else
+    {
+      const SearchIndex::Entry &theEntry = index->entries[candidate.entry];
+      if (NSONS(theEntry.element)==0)
+      {
+        FieldVector<DOUBLE,DIM> center(0.0);
+        for (INT i=0; i<CORNERS_OF_ELEM(theEntry.element); i++)
+          center += CVECT(MYVERTEX(CORNER(theEntry.element,i)));
+        center /= CORNERS_OF_ELEM(theEntry.element);
+        candidates.push({(center-global).two_norm2(),-1,candidate.entry,true});
+      }
+      else
+        for (INT son=candidate.entry+1; son<theEntry.end; son=index->entries[son].end)
+          candidates.push({BoxDistance2(index->entries[son].box,global),-1,son,false});
+    }
+  }
+
+  return(count);
+}
+
+/****************************************************************************/
+/** \brief Switch the search index for point location
+
+ * @param   theMG - multigrid
+ * @param   index - true to build and keep the search index
+
+   The search index stores a bounding box for each element and its
+   descendants and a bounding volume hierarchy over the elements of level 0.
+   The boxes are stored in one array, each element tree in pre-order, so
+   the search does not follow the element lists. FindLeafElement,
+   FindLeafElements and FindNearestLeafElements use it to locate points in
+   O(log n) steps for grids of bounded depth. AdaptMultiGrid updates the
+   index at its end, computing only the boxes of the changed subtrees.
+   Other changes of the grid make the index invalid; call SetSearchIndex
+   again after them and after moving vertices. The parallel version does
+   not keep the index, since load balancing also creates and disposes
+   elements.
+
+   @return <ul>
+   <li>   GM_OK if ok </li>
+   <li>   GM_ERROR if the index is requested in the parallel version </li>
+   </ul> */
+/****************************************************************************/
+
+INT NS_DIM_PREFIX SetSearchIndex (MULTIGRID *theMG, bool index)
+{
+  if (!index)
+  {
+    theMG->searchIndex.reset();
+    return(GM_OK);
+  }
+
+#ifdef ModelP
+  PrintErrorMessage('E',"SetSearchIndex","not available in the parallel version");
+  RETURN(GM_ERROR);
+#else
+  if (!theMG->searchIndex)
+    theMG->searchIndex = std::make_unique<SearchIndex>();
+  theMG->searchIndex->incremental = false;
+  RefreshSearchIndex(theMG);
+
+  return(GM_OK);
+#endif
+}
+
 /****************************************************************************/
 /** \brief Determine neighbor and side of neighbor that goes back to element
  *
@@ -4651,7 +5740,7 @@ INT NS_DIM_PREFIX InnerBoundary (ELEMENT *t, INT side)
  */
 /****************************************************************************/
 
-void NS_DIM_PREFIX CalculateCenterOfMass(ELEMENT *theElement, DOUBLE_VECTOR center_of_mass)
+void NS_DIM_PREFIX CalculateCenterOfMass(ELEMENT *theElement, DOUBLE_VECTOR& center_of_mass)
 {
   INT i, nr_corners;
 
@@ -5005,13 +6094,13 @@ INT NS_DIM_PREFIX MultiGridStatus (const MULTIGRID *theMG, INT gridflag, INT gre
     UserWriteF(" EST %2d  ELEMS=%9.0f MARKCOUNT=%9.0f PRED_NEW0=%9.0f PRED_NEW1=%9.0f\n",
                REFINESTEP(REFINEINFO(theMG)),REAL(REFINEINFO(theMG)),MARKCOUNT(REFINEINFO(theMG)),
                PREDNEW0(REFINEINFO(theMG)),PREDNEW1(REFINEINFO(theMG)));
-    UserWriteF(" EST TRACE step=%d\n",refine_info.step);
-    for (i=0; i<refine_info.step; i++)
+    UserWriteF(" EST TRACE step=%d\n",REFINEINFO(theMG).step);
+    for (i=0; i<REFINEINFO(theMG).step; i++)
       UserWriteF(" EST  %2d  ELEMS=%9.0f MARKS=%9.0f REAL=%9.0f PRED0=%9.0f PRED1=%9.0f\n",
-                 i,refine_info.real[i],refine_info.markcount[i],
-                 ((i<refine_info.step) ? refine_info.real[i+1]-refine_info.real[i] : 0),
-                 refine_info.predicted_new[i][0],
-                 refine_info.predicted_new[i][1]);
+                 i,REFINEINFO(theMG).real[i],REFINEINFO(theMG).markcount[i],
+                 ((i<REFINEINFO(theMG).step) ? REFINEINFO(theMG).real[i+1]-REFINEINFO(theMG).real[i] : 0),
+                 REFINEINFO(theMG).predicted_new[i][0],
+                 REFINEINFO(theMG).predicted_new[i][1]);
   }
 
   /* compute and list green rule info */
@@ -6754,6 +7843,7 @@ INT NS_DIM_PREFIX InitUGManager ()
   INT i;
 
   /* install the /Multigrids directory */
+  std::lock_guard<std::mutex> lock(theMGDirMutex);
   if (ChangeEnvDir("/")==NULL)
   {
     PrintErrorMessage('F',"InitUGManager","could not changedir to root");
@@ -109,6 +109,17 @@ INT              DisposeElement                 (GRID *theGrid, ELEMENT *theElem
 INT              DisposeTopLevel                (MULTIGRID *theMG);
 INT              DisposeNode                    (GRID *theGrid, NODE *theNode);
 
+/* level and leaf indices */
+INT              EnableIndexMaintenance         (MULTIGRID *theMG);
+void             UpdateSonIndices               (MULTIGRID *theMG, ELEMENT *theElement);
+void             CompactIndices                 (MULTIGRID *theMG);
+
+/* boundary vertices of a refinement step */
+INT              EvaluateBoundaryBatch          (MULTIGRID *theMG);
+
+/* point location */
+void             RefreshSearchIndex             (MULTIGRID *theMG);
+
 /* miscellaneous */
 INT              FindNeighborElement    (const ELEMENT *theElement, INT Side, ELEMENT **theNeighbor, INT *NeighborSide);
 INT             CheckOrientation                (INT n, VERTEX **vertices);
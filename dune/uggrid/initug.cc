@@ -96,7 +96,9 @@ USING_UG_NAMESPACES
  * @param argcp - pointer to argument counter
  * @param argvp - pointer to argument vector
  *
- *   This function initializes.
+ *   This function initializes. It sets up process-wide tables and
+ *   environment directories and must return before multigrids are
+ *   created on several threads.
  *
  * @return <ul>
  *   <li> 0 if ok </li>
@@ -0,0 +1,342 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+/****************************************************************************/
+/* File:	  distrib.c														*/
+/* Purpose:   couple a coarse grid that has been inserted in parts on all	*/
+/*            processes (each with a one element overlap) by DDD			*/
+/*            identification, without collecting it on one process			*/
+/****************************************************************************/
+
+#ifdef ModelP
+
+#include <config.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <unordered_set>
+#include <vector>
+
+#include <mpi.h>
+
+#include <dune/uggrid/parallel/ppif/ppifcontext.hh>
+
+#include "parallel.h"
+#include <dune/uggrid/low/namespace.h>
+#include <dune/uggrid/ugdevices.h>
+#include <dune/uggrid/gm/ugm.h>
+
+USING_UG_NAMESPACES
+using namespace PPIF;
+
+START_UGDIM_NAMESPACE
+
+/* kinds of objects which are identified */
+enum IdentKeyType {KEY_NODE, KEY_EDGE, KEY_ELEMENT, KEY_SIDE};
+
+/* an identification key is the object kind followed by up to four global ids */
+static constexpr int KEY_SIZE = 5;
+using IdentKey = std::array<int, KEY_SIZE>;
+
+static IdentKey MakeKey (IdentKeyType type, int n, const int *gids)
+{
+  IdentKey key;
+  key.fill(-1);
+  key[0] = type;
+  std::copy(gids, gids+n, key.begin()+1);
+  std::sort(key.begin()+1, key.begin()+1+n);
+  return key;
+}
+
+/**
+ * Process collecting all copies of a key ("rendezvous" process)
+ */
+static int HomeOfKey (const IdentKey& key, int procs)
+{
+  std::uint32_t h = 2166136261u;
+  for (int k : key)
+    h = (h ^ static_cast<std::uint32_t>(k)) * 16777619u;
+  return h % procs;
+}
+
+/****************************************************************************/
+/*
+   SharingProcs - find all other processes holding the same keys
+
+   PARAMETERS:
+   .  ppifContext
+   .  keys - identification keys of the local objects
+   .  procsOfKey - returns for each key the other processes having it
+
+   DESCRIPTION:
+   Each key is sent to its home process, which collects the processes
+   for all its keys and sends the lists back. Thus no process needs to
+   know more than its own keys and a share of all keys.
+
+   RETURN VALUE:
+   void
+ */
+/****************************************************************************/
+
+static void SharingProcs (const PPIF::PPIFContext& ppifContext, const std::vector<IdentKey>& keys,
+                          std::vector<std::vector<int> >& procsOfKey)
+{
+  const int procs = ppifContext.procs();
+  const MPI_Comm comm = ppifContext.comm();
+
+  /* send keys to their home process */
+  std::vector<std::vector<int> > keysTo(procs);
+  std::vector<std::vector<int> > keyIndex(procs);
+  for (std::size_t k = 0; k < keys.size(); ++k)
+  {
+    const int home = HomeOfKey(keys[k], procs);
+    keysTo[home].insert(keysTo[home].end(), keys[k].begin(), keys[k].end());
+    keyIndex[home].push_back(k);
+  }
+
+  auto exchange = [&](const std::vector<std::vector<int> >& sendTo,
+                      std::vector<int>& recvBuf, std::vector<int>& recvDispls)
+  {
+    std::vector<int> sendCounts(procs), sendDispls(procs+1, 0), recvCounts(procs);
+    for (int p = 0; p < procs; ++p)
+      sendCounts[p] = sendTo[p].size();
+    std::partial_sum(sendCounts.begin(), sendCounts.end(), sendDispls.begin()+1);
+    std::vector<int> sendBuf;
+    sendBuf.reserve(sendDispls[procs]);
+    for (const auto& s : sendTo)
+      sendBuf.insert(sendBuf.end(), s.begin(), s.end());
+
+    MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, comm);
+    recvDispls.assign(procs+1, 0);
+    std::partial_sum(recvCounts.begin(), recvCounts.end(), recvDispls.begin()+1);
+    recvBuf.resize(recvDispls[procs]);
+    MPI_Alltoallv(sendBuf.data(), sendCounts.data(), sendDispls.data(), MPI_INT,
+                  recvBuf.data(), recvCounts.data(), recvDispls.data(), MPI_INT, comm);
+  };
+
+  std::vector<int> recvKeys, recvKeyDispls;
+  exchange(keysTo, recvKeys, recvKeyDispls);
+
+  /* on the home process: processes of each key */
+  std::map<IdentKey, std::vector<int> > holders;
+  for (int p = 0; p < procs; ++p)
+    for (int pos = recvKeyDispls[p]; pos < recvKeyDispls[p+1]; pos += KEY_SIZE)
+    {
+      IdentKey key;
+      std::copy(recvKeys.begin()+pos, recvKeys.begin()+pos+KEY_SIZE, key.begin());
+      holders[key].push_back(p);
+    }
+
+  /* answer: for each key the number of other holders, followed by them */
+  std::vector<std::vector<int> > answerTo(procs);
+  for (int p = 0; p < procs; ++p)
+    for (int pos = recvKeyDispls[p]; pos < recvKeyDispls[p+1]; pos += KEY_SIZE)
+    {
+      IdentKey key;
+      std::copy(recvKeys.begin()+pos, recvKeys.begin()+pos+KEY_SIZE, key.begin());
+      const auto& h = holders[key];
+      answerTo[p].push_back(h.size()-1);
+      for (int q : h)
+        if (q != p)
+          answerTo[p].push_back(q);
+    }
+
+  std::vector<int> answers, answerDispls;
+  exchange(answerTo, answers, answerDispls);
+
+  procsOfKey.assign(keys.size(), std::vector<int>());
+  for (int home = 0; home < procs; ++home)
+  {
+    int pos = answerDispls[home];
+    for (int k : keyIndex[home])
+    {
+      const int n = answers[pos++];
+      procsOfKey[k].assign(answers.begin()+pos, answers.begin()+pos+n);
+      pos += n;
+    }
+  }
+}
+
+/****************************************************************************/
+/*
+   IdentifyDistributedCoarseGrid - couple the parts of a distributed coarse grid
+
+   SYNOPSIS:
+   INT IdentifyDistributedCoarseGrid (MULTIGRID *theMG, const INT *vertexGid,
+                                      const INT *elementGid, const INT *elementOwner);
+
+   PARAMETERS:
+   .  theMG - multigrid created with distributedCoarseGrid=true
+   .  vertexGid - global id of each level 0 node, indexed by ID(node)
+   .  elementGid - global id of each level 0 element, indexed by ID(element)
+   .  elementOwner - process owning each level 0 element, indexed by ID(element)
+
+   DESCRIPTION:
+   This function is the parallel alternative to inserting the coarse grid on
+   the master and distributing it by TransferGridFromLevel. Every process
+   inserts the elements it owns together with all their neighbors (one
+   element overlap) into level 0 and calls FixCoarseGrid. The function then
+
+   - removes the nodes not needed by any local element (e.g. the boundary
+     nodes of the domain inserted on all processes),
+   - identifies the copies of nodes, vertices, edges, side vectors and
+     elements on different processes by their global ids, and
+   - makes the elements not owned by this process horizontal ghosts and
+     sets all priorities consistently.
+
+   The processes sharing an object are found by sending its global ids
+   to a home process determined by hashing, so no process ever has more
+   than its part of the grid. The function is collective.
+
+   RETURN VALUE:
+   INT
+   .n   GM_OK - ok
+   .n   GM_ERROR - error
+ */
+/****************************************************************************/
+
+INT IdentifyDistributedCoarseGrid (MULTIGRID *theMG, const INT *vertexGid,
+                                   const INT *elementGid, const INT *elementOwner)
+{
+  auto& context = theMG->dddContext();
+  const PPIF::PPIFContext& ppifContext = theMG->ppifContext();
+  const int me = context.me();
+
+  if (TOPLEVEL(theMG) != 0)
+  {
+    PrintErrorMessage('E',"IdentifyDistributedCoarseGrid","multigrid has been refined already");
+    REP_ERR_RETURN(GM_ERROR);
+  }
+  GRID *theGrid = GRID_ON_LEVEL(theMG,0);
+
+  /* remove nodes which are not corner of a local element */
+  for (NODE *theNode=PFIRSTNODE(theGrid); theNode!=NULL; theNode=SUCCN(theNode))
+    SETUSED(theNode,0);
+  for (ELEMENT *theElement=PFIRSTELEMENT(theGrid); theElement!=NULL; theElement=SUCCE(theElement))
+    for (INT i=0; i<CORNERS_OF_ELEM(theElement); i++)
+      SETUSED(CORNER(theElement,i),1);
+  for (NODE *theNode=PFIRSTNODE(theGrid), *next; theNode!=NULL; theNode=next)
+  {
+    next = SUCCN(theNode);
+    if (!USED(theNode))
+      if (DisposeNode(theGrid,theNode))
+        REP_ERR_RETURN(GM_ERROR);
+  }
+
+  /* identification keys of all local objects */
+  std::vector<NODE *> nodes;
+  std::vector<EDGE *> edges;
+  std::vector<ELEMENT *> elements;
+  std::vector<VECTOR *> sideVectors;
+  std::vector<IdentKey> keys;
+
+  for (NODE *theNode=PFIRSTNODE(theGrid); theNode!=NULL; theNode=SUCCN(theNode))
+  {
+    nodes.push_back(theNode);
+    keys.push_back(MakeKey(KEY_NODE, 1, &vertexGid[ID(theNode)]));
+  }
+
+  std::unordered_set<EDGE *> edgeSeen;
+  for (ELEMENT *theElement=PFIRSTELEMENT(theGrid); theElement!=NULL; theElement=SUCCE(theElement))
+    for (INT i=0; i<EDGES_OF_ELEM(theElement); i++)
+    {
+      NODE *n0 = CORNER(theElement,CORNER_OF_EDGE(theElement,i,0));
+      NODE *n1 = CORNER(theElement,CORNER_OF_EDGE(theElement,i,1));
+      EDGE *theEdge = GetEdge(n0,n1);
+      ASSERT(theEdge!=NULL);
+      if (!edgeSeen.insert(theEdge).second)
+        continue;
+      const int gids[2] = {vertexGid[ID(n0)], vertexGid[ID(n1)]};
+      edges.push_back(theEdge);
+      keys.push_back(MakeKey(KEY_EDGE, 2, gids));
+    }
+
+  for (ELEMENT *theElement=PFIRSTELEMENT(theGrid); theElement!=NULL; theElement=SUCCE(theElement))
+  {
+    elements.push_back(theElement);
+    keys.push_back(MakeKey(KEY_ELEMENT, 1, &elementGid[ID(theElement)]));
+  }
+
+#ifdef UG_DIM_3
+  std::unordered_set<VECTOR *> vectorSeen;
+  for (ELEMENT *theElement=PFIRSTELEMENT(theGrid); theElement!=NULL; theElement=SUCCE(theElement))
+    for (INT side=0; side<SIDES_OF_ELEM(theElement); side++)
+    {
+      VECTOR *theVector = SVECTOR(theElement,side);
+      if (theVector==NULL || !vectorSeen.insert(theVector).second)
+        continue;
+      int gids[MAX_CORNERS_OF_SIDE];
+      const INT n = CORNERS_OF_SIDE(theElement,side);
+      for (INT k=0; k<n; k++)
+        gids[k] = vertexGid[ID(CORNER(theElement,CORNER_OF_SIDE(theElement,side,k)))];
+      sideVectors.push_back(theVector);
+      keys.push_back(MakeKey(KEY_SIDE, n, gids));
+    }
+#endif
+
+  std::vector<std::vector<int> > procsOfKey;
+  SharingProcs(ppifContext, keys, procsOfKey);
+
+  /* identify the copies */
+  DDD_IdentifyBegin(context);
+  std::size_t k = 0;
+  for (NODE *theNode : nodes)
+  {
+    for (int proc : procsOfKey[k])
+    {
+      DDD_IdentifyNumber(context, PARHDR(theNode), proc, vertexGid[ID(theNode)]);
+      DDD_IdentifyObject(context, PARHDRV(MYVERTEX(theNode)), proc, PARHDR(theNode));
+    }
+    k++;
+  }
+  for (EDGE *theEdge : edges)
+  {
+    for (int proc : procsOfKey[k])
+    {
+      DDD_IdentifyObject(context, PARHDR(theEdge), proc, PARHDR(NBNODE(LINK0(theEdge))));
+      DDD_IdentifyObject(context, PARHDR(theEdge), proc, PARHDR(NBNODE(LINK1(theEdge))));
+    }
+    k++;
+  }
+  for (ELEMENT *theElement : elements)
+  {
+    for (int proc : procsOfKey[k])
+      DDD_IdentifyNumber(context, PARHDRE(theElement), proc, elementGid[ID(theElement)]);
+    k++;
+  }
+  for (VECTOR *theVector : sideVectors)
+  {
+    ELEMENT *theElement = (ELEMENT *)VOBJECT(theVector);
+    const INT side = VECTORSIDE(theVector);
+    for (int proc : procsOfKey[k])
+      for (INT c=0; c<CORNERS_OF_SIDE(theElement,side); c++)
+        DDD_IdentifyObject(context, PARHDR(theVector), proc,
+                           PARHDR(CORNER(theElement,CORNER_OF_SIDE(theElement,side,c))));
+    k++;
+  }
+  DDD_IdentifyEnd(context);
+
+  /* elements of other processes become horizontal ghosts */
+  ddd_HandlerInit(context, HSET_XFER);
+  DDD_XferBegin(context);
+  for (ELEMENT *theElement : elements)
+  {
+    PARTITION(theElement) = elementOwner[ID(theElement)];
+    if (PARTITION(theElement) != me)
+      SETEPRIO(context, theElement, PrioHGhost);
+  }
+  DDD_XferEnd(context);
+
+  ConstructConsistentMultiGrid(theMG);
+  RESETMGSTATUS(theMG);
+
+  return GM_OK;
+}
+
+END_UGDIM_NAMESPACE
+
+#endif  /* ModelP */
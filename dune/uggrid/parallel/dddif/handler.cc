@@ -916,11 +916,7 @@ static void ElementXferCopy (DDD::DDDContext& context, DDD_OBJ obj, DDD_PROC pro
       VECTOR *vec = EDVECTOR(edge);
 
       if (vec != NULL) {
-#ifdef UG_DIM_2
-        int Size = sizeof(VECTOR)-sizeof(DOUBLE);
-#else
         int Size = sizeof(VECTOR);
-#endif
         PRINTDEBUG(dddif,3,(PFMT " ElementXferCopy():  e=" EID_FMTX
                             " EDGEVEC=" VINDEX_FMTX " size=%d\n",
                             me,EID_PRTX(pe),VINDEX_PRTX(vec),Size))
@@ -937,7 +933,7 @@ static void ElementXferCopy (DDD::DDDContext& context, DDD_OBJ obj, DDD_PROC pro
     VECTOR *vec = EVECTOR(pe);
 
     if (vec != NULL) {
-      INT Size = sizeof(VECTOR)-sizeof(DOUBLE);
+      INT Size = sizeof(VECTOR);
 
       PRINTDEBUG(dddif,2,(PFMT " ElementXferCopy(): e=" EID_FMTX
                           " ELEMVEC=" VINDEX_FMTX " size=%d\n",
@@ -1259,6 +1255,14 @@ static void ElementObjMkCons (DDD::DDDContext& context, DDD_OBJ obj, int newness
 
   DEBUGNSONS(pe,theFather,"ElementObjMkCons begin:");
 
+  /* the sons of pe and of its father may be relinked below */
+  if (MYMG(theGrid)->sonTable)
+  {
+    SonsChanged(MYMG(theGrid),pe);
+    if (theFather != NULL)
+      SonsChanged(MYMG(theGrid),theFather);
+  }
+
   /* correct nb relationships between ghostelements */
   if (EGHOST(pe))
   {
@@ -1438,6 +1442,10 @@ static void ElementPriorityUpdate (DDD::DDDContext& context, DDD_OBJ obj, DDD_PR
 
   if (pe == NULL) return;
 
+  /* the sons of the father are relinked below */
+  if (theFather != NULL && MYMG(theGrid)->sonTable)
+    SonsChanged(MYMG(theGrid),theFather);
+
   /*  if called with prio old=ghost and new=ghost,
           then you have to unlink and link again to avoid
           decoupling of son and father.
@@ -395,11 +395,6 @@ static void ddd_DefineTypes(DDD::DDDContext& context)
                  EL_LDATA,  ELDEF(VECTOR,succ),
                  EL_GDATA,  ELDEF(VECTOR,index),
                  EL_GDATA,  ELDEF(VECTOR,leafIndex),
-
-                 /* TODO: value wird noch ausgelassen. Feld variabler Laenge? */
-                 /* bei Entscheidung 'value': kein weiteres Feld
-                         bei ent. 'userdata *': EL_GDATA-feld        */
-                 EL_GDATA,  ELDEF(VECTOR,value),
                  EL_END,    sizeof(VECTOR)
                  );
 
@@ -32,8 +32,11 @@
 /****************************************************************************/
 
 #include <config.h>
+#include <algorithm>
 #include <cstdio>
 
+#include <dune/common/fvector.hh>
+
 #include "parallel.h"
 #include <dune/uggrid/gm/evm.h>
 #include <dune/uggrid/gm/ugm.h>
@@ -81,6 +84,89 @@ START_UGDIM_NAMESPACE
 /****************************************************************************/
 
 
+/****************************************************************************/
+/*
+   CenterOfMass - center of the corners of an element
+
+   PARAMETERS:
+   .  e - the element
+
+   DESCRIPTION:
+   The point the geometric load balancers sort or bisect the elements by.
+
+   RETURN VALUE:
+   Dune::FieldVector<DOUBLE,DIM>
+ */
+/****************************************************************************/
+
+Dune::FieldVector<DOUBLE, DIM> CenterOfMass (ELEMENT *e)
+{
+  Dune::FieldVector<DOUBLE, DIM> center(0.0);
+
+  const auto corners = CORNERS_OF_ELEM(e);
+  for(int i=0; i<corners; i++)
+    center +=  CVECT(MYVERTEX(CORNER(e,i)));
+
+  center /= corners;
+  return center;
+}
+
+
+/****************************************************************************/
+/*
+   InheritPartition - assign the partition of an element to its descendants
+
+   PARAMETERS:
+   .  theMG - multigrid of the element
+   .  e - the element
+
+   DESCRIPTION:
+   The load balancers partition one level and move the refinement tree
+   below each element together with it.
+
+   RETURN VALUE:
+   void
+ */
+/****************************************************************************/
+
+void InheritPartition (const MULTIGRID *theMG, ELEMENT *e)
+{
+  for (ELEMENT *son : GetAllSonRange(theMG,e))
+  {
+    PARTITION(son) = PARTITION(e);
+    InheritPartition(theMG,son);
+  }
+}
+
+
+/****************************************************************************/
+/*
+   LeafElementWeight - number of local leaf elements below an element
+
+   PARAMETERS:
+   .  theMG - multigrid of the element
+   .  e - the element
+
+   DESCRIPTION:
+   Counts the leaf elements in the (local part of the) refinement tree
+   of e, including e itself if it is a leaf. This is the load an element
+   carries into a new partition together with all its descendants.
+
+   RETURN VALUE:
+   INT
+ */
+/****************************************************************************/
+
+INT LeafElementWeight (const MULTIGRID *theMG, const ELEMENT *e)
+{
+  INT weight = 0;
+  for (const ELEMENT *son : GetSonRange(theMG,e))
+    weight += LeafElementWeight(theMG,son);
+
+  return std::max(weight, 1);
+}
+
+
 /****************************************************************************/
 /*
     TransferGridComplete-
@@ -409,6 +495,47 @@ void lbs (const char *argv, MULTIGRID *theMG)
     CreateDD(theMG,fromlevel,hor_boxes,vert_boxes);
     break;
 
+  /* balance a (possibly distributed) GRID along a space filling curve */
+  case (7) :
+  case (9) :
+    if (fromlevel>=0 && fromlevel<=TOPLEVEL(theMG))
+    {
+      BalanceGridSFC(theMG,fromlevel,(mode==7) ? SFC_HILBERT : SFC_MORTON);
+    }
+    else
+    {
+      UserWriteF(PFMT "lbs(): gridlevel=%d not "
+                 "existent!\n",me,fromlevel);
+    }
+    break;
+
+  /* balance a (possibly distributed) GRID by partitioning its dual graph */
+  case (10) :
+  case (11) :
+    if (fromlevel>=0 && fromlevel<=TOPLEVEL(theMG))
+    {
+      BalanceGridGraph(theMG,fromlevel,mode==11);
+    }
+    else
+    {
+      UserWriteF(PFMT "lbs(): gridlevel=%d not "
+                 "existent!\n",me,fromlevel);
+    }
+    break;
+
+  /* rebalance a distributed GRID by moving few subtrees to neighbors */
+  case (12) :
+    if (fromlevel>=0 && fromlevel<=TOPLEVEL(theMG))
+    {
+      BalanceGridDiffusive(theMG,fromlevel);
+    }
+    else
+    {
+      UserWriteF(PFMT "lbs(): gridlevel=%d not "
+                 "existent!\n",me,fromlevel);
+    }
+    break;
+
   case (8) :
   {
     SimpleSubdomainDistribution(theMG,procs,fromlevel,tolevel);
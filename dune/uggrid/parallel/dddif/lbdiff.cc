@@ -0,0 +1,380 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+/****************************************************************************/
+/* File:	  lbdiff.c														*/
+/* Purpose:   diffusive repartitioning of an already distributed grid:		*/
+/*            computes a balancing flow on the processor graph and moves	*/
+/*            few subtrees at the partition boundaries						*/
+/****************************************************************************/
+
+#ifdef ModelP
+
+#include <config.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <mpi.h>
+
+#include <dune/uggrid/parallel/ppif/ppifcontext.hh>
+
+#include "parallel.h"
+#include <dune/uggrid/low/namespace.h>
+#include <dune/uggrid/ugdevices.h>
+#include <dune/uggrid/gm/ugm.h>
+
+USING_UG_NAMESPACES
+using namespace PPIF;
+
+START_UGDIM_NAMESPACE
+
+/** \brief Maximal number of conjugate gradient iterations for the diffusion solve */
+static constexpr int DIFFUSION_MAX_ITER = 1000;
+
+/** \brief Relative residual reduction of the diffusion solve */
+static constexpr DOUBLE DIFFUSION_REDUCTION = 1e-10;
+
+/**
+ * Master process of the element across side j, or -1 if there is none
+ */
+static int NeighborPartition (const DDD::DDDContext& context, ELEMENT *e, int j)
+{
+  ELEMENT *nb = NBELEM(e,j);
+  if (nb == NULL)
+    return -1;
+  if (EMASTER(nb))
+    return PARTITION(nb);
+
+  const DDD_PROC p = EPROCPRIO(context, nb, PrioMaster);
+  return (p < static_cast<DDD_PROC>(context.procs())) ? static_cast<int>(p) : -1;
+}
+
+/****************************************************************************/
+/*
+   DiffusionFlow - balancing flow on the processor graph
+
+   PARAMETERS:
+   .  adj - adjacency lists of the (symmetric, connected) processor graph
+   .  load - load of each process
+
+   DESCRIPTION:
+   Solves the graph Laplacian system L x = load - average by the conjugate
+   gradient method. The flow x_p - x_q on the edge (p,q) balances the load
+   and is the flow of minimal 2-norm (Hu and Blake, Parallel Computing 25,
+   1999), i.e. it migrates as little load as possible. All processes
+   compute the same flow from the same input.
+
+   RETURN VALUE:
+   std::vector<DOUBLE> - the potential x of each process
+ */
+/****************************************************************************/
+
+static std::vector<DOUBLE> DiffusionFlow (const std::vector<std::vector<int> >& adj,
+                                          const std::vector<DOUBLE>& load)
+{
+  const int n = load.size();
+  const DOUBLE average = std::accumulate(load.begin(), load.end(), 0.0) / n;
+
+  auto laplace = [&](const std::vector<DOUBLE>& x, std::vector<DOUBLE>& y)
+  {
+    for (int p = 0; p < n; ++p)
+    {
+      y[p] = adj[p].size()*x[p];
+      for (int q : adj[p])
+        y[p] -= x[q];
+    }
+  };
+  auto dot = [&](const std::vector<DOUBLE>& a, const std::vector<DOUBLE>& b)
+  {
+    return std::inner_product(a.begin(), a.end(), b.begin(), 0.0);
+  };
+
+  std::vector<DOUBLE> x(n, 0.0), r(n), d(n), q(n);
+  for (int p = 0; p < n; ++p)
+    r[p] = load[p] - average;
+  d = r;
+  DOUBLE rr = dot(r,r);
+  const DOUBLE rr0 = rr;
+
+  for (int it = 0; it < DIFFUSION_MAX_ITER && rr > DIFFUSION_REDUCTION*DIFFUSION_REDUCTION*rr0; ++it)
+  {
+    laplace(d, q);
+    const DOUBLE dq = dot(d,q);
+    if (dq <= 0.0)
+      break;
+    const DOUBLE alpha = rr/dq;
+    for (int p = 0; p < n; ++p)
+    {
+      x[p] += alpha*d[p];
+      r[p] -= alpha*q[p];
+    }
+    const DOUBLE rrNew = dot(r,r);
+    for (int p = 0; p < n; ++p)
+      d[p] = r[p] + rrNew/rr*d[p];
+    rr = rrNew;
+  }
+
+  return x;
+}
+
+/****************************************************************************/
+/*
+   SelectElementsToMove - choose elements to send to a neighbor process
+
+   PARAMETERS:
+   .  context - the DDD context
+   .  elems - master elements of the level
+   .  weight - leaf element weight of each element
+   .  index - position of each element in elems
+   .  dest - the receiving process
+   .  amount - the load to send
+
+   DESCRIPTION:
+   Grows a region of elements that are to be sent to dest, starting from
+   the elements at the boundary to dest (or from an arbitrary element if
+   the two partitions do not touch). Elements with many sides towards dest
+   are taken first to keep the new partition boundary short; among those,
+   heavier subtrees are preferred so that few subtrees are moved. An element
+   is only taken if it brings the moved load closer to amount.
+
+   RETURN VALUE:
+   DOUBLE - the load assigned to dest
+ */
+/****************************************************************************/
+
+static DOUBLE SelectElementsToMove (const DDD::DDDContext& context,
+                                    const std::vector<ELEMENT *>& elems,
+                                    const std::vector<INT>& weight,
+                                    const std::unordered_map<const ELEMENT *, int>& index,
+                                    int dest, DOUBLE amount)
+{
+  const int me = context.me();
+  const int n = elems.size();
+
+  /* gain of moving k: sides towards dest minus sides towards elements staying on me */
+  std::vector<int> gain(n, 0);
+  std::vector<bool> queued(n, false);
+  std::set<std::tuple<int, INT, int> > queue;      /* (-gain, -weight, k) */
+
+  auto sideGain = [&](int k)
+  {
+    int g = 0;
+    for (int j=0; j<SIDES_OF_ELEM(elems[k]); j++)
+    {
+      const int p = NeighborPartition(context, elems[k], j);
+      if (p == dest)
+        g++;
+      else if (p == me)
+        g--;
+    }
+    return g;
+  };
+
+  for (int k = 0; k < n; ++k)
+    if (PARTITION(elems[k]) == me)
+      for (int j=0; j<SIDES_OF_ELEM(elems[k]); j++)
+        if (NeighborPartition(context, elems[k], j) == dest)
+        {
+          gain[k] = sideGain(k);
+          queue.insert({-gain[k], -weight[k], k});
+          queued[k] = true;
+          break;
+        }
+
+  DOUBLE moved = 0.0;
+  int seed = 0;
+  while (moved < amount)
+  {
+    if (queue.empty())
+    {
+      /* partitions do not touch (anymore): start a new region */
+      while (seed < n && PARTITION(elems[seed]) != me)
+        seed++;
+      if (seed == n)
+        break;
+      gain[seed] = sideGain(seed);
+      queue.insert({-gain[seed], -weight[seed], seed});
+      queued[seed] = true;
+    }
+
+    /* first element in queue order that does not overshoot */
+    auto it = queue.begin();
+    while (it != queue.end() && std::abs(amount - moved - weight[std::get<2>(*it)]) >= amount - moved)
+      ++it;
+    if (it == queue.end())
+      break;
+
+    const int k = std::get<2>(*it);
+    queue.erase(it);
+    PARTITION(elems[k]) = dest;
+    moved += weight[k];
+
+    /* update the neighbors that stay on me */
+    for (int j=0; j<SIDES_OF_ELEM(elems[k]); j++)
+    {
+      const ELEMENT *nb = NBELEM(elems[k],j);
+      if (nb == NULL || !EMASTER(nb) || PARTITION(nb) != me)
+        continue;
+      const auto nbIndex = index.find(nb);
+      if (nbIndex == index.end())
+        continue;
+      const int l = nbIndex->second;
+      if (queued[l])
+        queue.erase({-gain[l], -weight[l], l});
+      gain[l] = sideGain(l);
+      queue.insert({-gain[l], -weight[l], l});
+      queued[l] = true;
+    }
+  }
+
+  return moved;
+}
+
+/****************************************************************************/
+/*
+   BalanceGridDiffusive -
+
+   PARAMETERS:
+   .  theMG
+   .  level
+
+   DESCRIPTION:
+   Repartition an already distributed grid hierarchy by moving as few
+   subtrees as possible. The master elements of the given level are weighted
+   by their number of leaf elements. A balancing flow on the graph of
+   neighboring processes is computed by diffusion, and each process then
+   assigns elements at its partition boundaries to the neighbors its
+   flow goes to. Elements that do not move keep their current partition.
+
+   Processes that do not share a partition boundary with any other (e.g.
+   processes without elements after the initial load) are attached to the
+   most loaded process so that they receive load as well.
+
+   The new partition is stored in PARTITION and is to be realized by
+   TransferGridFromLevel.
+
+   RETURN VALUE:
+   void
+ */
+/****************************************************************************/
+
+void BalanceGridDiffusive (MULTIGRID *theMG, int level)
+{
+  const DDD::DDDContext& context = theMG->dddContext();
+  const PPIF::PPIFContext& ppifContext = theMG->ppifContext();
+  const int me = ppifContext.me();
+  const int procs = ppifContext.procs();
+  const MPI_Comm comm = ppifContext.comm();
+
+  /* elements not moved stay where they are */
+  for (int l = 0; l <= TOPLEVEL(theMG); l++)
+    for (auto e=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l)); e!=NULL; e=SUCCE(e))
+      PARTITION(e) = me;
+
+  const GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+  if (UG_GlobalSumINT(ppifContext, NT(theGrid)) == 0)
+  {
+    if (ppifContext.isMaster())
+      UserWriteF("WARNING in BalanceGridDiffusive: no elements in grid\n");
+    return;
+  }
+
+  std::vector<ELEMENT *> elems;
+  std::vector<INT> weight;
+  std::unordered_map<const ELEMENT *, int> index;
+  DOUBLE localLoad = 0.0;
+  std::vector<int> neighbors;
+  for (auto e=FIRSTELEMENT(theGrid); e!=NULL; e=SUCCE(e))
+  {
+    index.emplace(e, elems.size());
+    elems.push_back(e);
+    weight.push_back(LeafElementWeight(theMG,e));
+    localLoad += weight.back();
+    for (int j=0; j<SIDES_OF_ELEM(e); j++)
+    {
+      const int p = NeighborPartition(context, e, j);
+      if (p >= 0 && p != me)
+        neighbors.push_back(p);
+    }
+  }
+  std::sort(neighbors.begin(), neighbors.end());
+  neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+  /* loads and processor graph on all processes */
+  std::vector<DOUBLE> load(procs);
+  MPI_Allgather(&localLoad, 1, MPI_DOUBLE, load.data(), 1, MPI_DOUBLE, comm);
+
+  int nNeighbors = neighbors.size();
+  std::vector<int> sizes(procs), displs(procs+1, 0);
+  MPI_Allgather(&nNeighbors, 1, MPI_INT, sizes.data(), 1, MPI_INT, comm);
+  std::partial_sum(sizes.begin(), sizes.end(), displs.begin()+1);
+  std::vector<int> allNeighbors(displs[procs]);
+  MPI_Allgatherv(neighbors.data(), nNeighbors, MPI_INT,
+                 allNeighbors.data(), sizes.data(), displs.data(), MPI_INT, comm);
+
+  std::vector<std::vector<int> > adj(procs);
+  for (int p = 0; p < procs; ++p)
+    for (int k = displs[p]; k < displs[p+1]; ++k)
+    {
+      adj[p].push_back(allNeighbors[k]);
+      adj[allNeighbors[k]].push_back(p);
+    }
+
+  /* connect the components of the processor graph to the most loaded process */
+  const int heaviest = std::distance(load.begin(), std::max_element(load.begin(), load.end()));
+  std::vector<bool> reached(procs, false);
+  for (int p = heaviest, n = 0; n < procs; p = (p+1) % procs, n++)
+  {
+    if (reached[p])
+      continue;
+    if (p != heaviest)
+    {
+      adj[heaviest].push_back(p);
+      adj[p].push_back(heaviest);
+    }
+    std::vector<int> stack(1, p);
+    reached[p] = true;
+    while (!stack.empty())
+    {
+      const int q = stack.back();
+      stack.pop_back();
+      for (int r : adj[q])
+        if (!reached[r])
+        {
+          reached[r] = true;
+          stack.push_back(r);
+        }
+    }
+  }
+  for (auto& a : adj)
+  {
+    std::sort(a.begin(), a.end());
+    a.erase(std::unique(a.begin(), a.end()), a.end());
+  }
+
+  /* move load along the outgoing flows of this process */
+  const std::vector<DOUBLE> x = DiffusionFlow(adj, load);
+  for (int q : adj[me])
+  {
+    const DOUBLE flow = x[me] - x[q];
+    if (flow > 0.5)
+    {
+      [[maybe_unused]] const DOUBLE sent = SelectElementsToMove(context, elems, weight, index, q, flow);
+      PRINTDEBUG(dddif,1,(PFMT "BalanceGridDiffusive(): flow %g to %d, sent %g\n", me, flow, q, sent));
+    }
+  }
+
+  for (auto e : elems)
+    InheritPartition(theMG,e);
+}
+
+END_UGDIM_NAMESPACE
+
+#endif  /* ModelP */
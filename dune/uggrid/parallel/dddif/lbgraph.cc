@@ -0,0 +1,1035 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+/****************************************************************************/
+/* File:	  lbgraph.c														*/
+/* Purpose:   multilevel partitioning of the element dual graph of one		*/
+/*            grid level (heavy edge matching, greedy graph growing and		*/
+/*            Fiduccia-Mattheyses refinement)								*/
+/****************************************************************************/
+
+#ifdef ModelP
+
+#include <config.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <mpi.h>
+
+#include <dune/uggrid/parallel/ppif/ppifcontext.hh>
+
+#include "parallel.h"
+#include <dune/uggrid/low/namespace.h>
+#include <dune/uggrid/ugdevices.h>
+#include <dune/uggrid/gm/ugm.h>
+
+USING_UG_NAMESPACES
+using namespace PPIF;
+
+START_UGDIM_NAMESPACE
+
+/** \brief Stop coarsening when a graph has at most this many vertices */
+static constexpr int COARSEST_GRAPH_SIZE = 64;
+
+/** \brief Number of greedy graph growing trials on the coarsest graph */
+static constexpr int GROWING_TRIALS = 8;
+
+/** \brief Number of FM passes on each level of the multilevel hierarchy */
+static constexpr int FM_PASSES = 4;
+
+/** \brief Allowed relative deviation of a part from its target weight */
+static constexpr DOUBLE PARTITION_IMBALANCE = 0.03;
+
+// only used in this source file
+/**
+ * Weighted undirected graph in compressed sparse row format
+ */
+struct DUAL_GRAPH {
+  std::vector<int> xadj;      /* adjacency of v is adjncy[xadj[v]..xadj[v+1]) */
+  std::vector<int> adjncy;
+  std::vector<int> adjwgt;    /* number of element sides shared */
+  std::vector<int> vwgt;      /* number of leaf elements */
+
+  int nvtxs () const
+  { return vwgt.size(); }
+
+  long totalWeight () const
+  { return std::accumulate(vwgt.begin(), vwgt.end(), 0L); }
+};
+
+static long EdgeCut (const DUAL_GRAPH& g, const std::vector<int>& part)
+{
+  long cut = 0;
+  for (int v = 0; v < g.nvtxs(); ++v)
+    for (int j = g.xadj[v]; j < g.xadj[v+1]; ++j)
+      if (part[v] != part[g.adjncy[j]])
+        cut += g.adjwgt[j];
+  return cut/2;
+}
+
+/****************************************************************************/
+/*
+   CoarsenGraph - contract a heavy edge matching
+
+   PARAMETERS:
+   .  g - fine graph
+   .  rng - random number generator for the visiting order
+   .  cmap - returns the coarse vertex of each fine vertex
+
+   DESCRIPTION:
+   Visits the vertices in random order and matches each unmatched vertex
+   with the unmatched neighbor connected by the heaviest edge. Matched
+   pairs are contracted into one coarse vertex, parallel edges are merged.
+
+   RETURN VALUE:
+   DUAL_GRAPH - the coarse graph
+ */
+/****************************************************************************/
+
+static DUAL_GRAPH CoarsenGraph (const DUAL_GRAPH& g, std::mt19937& rng, std::vector<int>& cmap)
+{
+  const int n = g.nvtxs();
+  std::vector<int> perm(n);
+  std::iota(perm.begin(), perm.end(), 0);
+  std::shuffle(perm.begin(), perm.end(), rng);
+
+  std::vector<int> match(n, -1);
+  cmap.assign(n, -1);
+  int ncoarse = 0;
+  for (int v : perm)
+  {
+    if (match[v] != -1)
+      continue;
+
+    int best = v;
+    int bestWeight = -1;
+    for (int j = g.xadj[v]; j < g.xadj[v+1]; ++j)
+    {
+      const int u = g.adjncy[j];
+      if (match[u] == -1 && u != v && g.adjwgt[j] > bestWeight)
+      {
+        best = u;
+        bestWeight = g.adjwgt[j];
+      }
+    }
+    match[v] = best;
+    match[best] = v;
+    cmap[v] = cmap[best] = ncoarse++;
+  }
+
+  DUAL_GRAPH coarse;
+  coarse.vwgt.assign(ncoarse, 0);
+  coarse.xadj.assign(ncoarse+1, 0);
+  coarse.adjncy.reserve(g.adjncy.size());
+  coarse.adjwgt.reserve(g.adjncy.size());
+
+  /* marker[c] is the position of coarse neighbor c in the adjacency of the current coarse vertex */
+  std::vector<int> marker(ncoarse, -1);
+  std::vector<int> members;
+  members.reserve(2);
+  std::vector<int> coarseToFine(ncoarse, -1);
+  for (int v : perm)
+    if (coarseToFine[cmap[v]] == -1)
+      coarseToFine[cmap[v]] = v;
+
+  for (int c = 0; c < ncoarse; ++c)
+  {
+    const int v = coarseToFine[c];
+    members.clear();
+    members.push_back(v);
+    if (match[v] != v)
+      members.push_back(match[v]);
+
+    const int begin = coarse.adjncy.size();
+    for (int w : members)
+    {
+      coarse.vwgt[c] += g.vwgt[w];
+      for (int j = g.xadj[w]; j < g.xadj[w+1]; ++j)
+      {
+        const int cu = cmap[g.adjncy[j]];
+        if (cu == c)
+          continue;
+        if (marker[cu] >= begin)
+          coarse.adjwgt[marker[cu]] += g.adjwgt[j];
+        else
+        {
+          marker[cu] = coarse.adjncy.size();
+          coarse.adjncy.push_back(cu);
+          coarse.adjwgt.push_back(g.adjwgt[j]);
+        }
+      }
+    }
+    coarse.xadj[c+1] = coarse.adjncy.size();
+  }
+
+  return coarse;
+}
+
+/****************************************************************************/
+/*
+   RefineBisectionFM - Fiduccia-Mattheyses refinement of a bisection
+
+   PARAMETERS:
+   .  g - the graph
+   .  part - bisection (0/1 per vertex), improved in place
+   .  maxWeight - maximal allowed weight of part 0 and part 1
+   .  passes - maximal number of passes
+
+   DESCRIPTION:
+   In each pass all vertices are moved at most once, always choosing the
+   move with the highest gain that keeps the receiving side below its
+   maximal weight. A side exceeding its maximal weight is emptied first.
+   After each pass the partition is rolled back to the best state seen.
+
+   RETURN VALUE:
+   void
+ */
+/****************************************************************************/
+
+static void RefineBisectionFM (const DUAL_GRAPH& g, std::vector<int>& part,
+                               const std::array<long, 2>& maxWeight, int passes)
+{
+  const int n = g.nvtxs();
+  std::vector<int> gain(n);
+  std::vector<bool> locked(n);
+  std::vector<int> moves;
+
+  for (int pass = 0; pass < passes; ++pass)
+  {
+    std::array<long, 2> weight = {{0, 0}};
+    for (int v = 0; v < n; ++v)
+      weight[part[v]] += g.vwgt[v];
+
+    /* gain of moving v to the other side: external minus internal edge weight */
+    std::array<std::set<std::pair<int, int> >, 2> queue;
+    for (int v = 0; v < n; ++v)
+    {
+      gain[v] = 0;
+      for (int j = g.xadj[v]; j < g.xadj[v+1]; ++j)
+        gain[v] += (part[g.adjncy[j]] != part[v]) ? g.adjwgt[j] : -g.adjwgt[j];
+      queue[part[v]].insert({-gain[v], v});
+    }
+    std::fill(locked.begin(), locked.end(), false);
+    moves.clear();
+
+    auto overweight = [&](const std::array<long, 2>& w)
+    {
+      return std::max(w[0]-maxWeight[0], 0L) + std::max(w[1]-maxWeight[1], 0L);
+    };
+
+    long cut = EdgeCut(g, part);
+    long bestCut = cut;
+    long bestOverweight = overweight(weight);
+    std::size_t bestMoves = 0;
+    const std::size_t maxUselessMoves = 50 + n/100;
+
+    while (moves.size() < static_cast<std::size_t>(n) && moves.size() - bestMoves < maxUselessMoves)
+    {
+      /* choose the side to move from */
+      int from = -1;
+      for (int s = 0; s < 2; ++s)
+        if (weight[s] > maxWeight[s] && !queue[s].empty())
+          from = s;
+      if (from == -1)
+      {
+        int bestGain = std::numeric_limits<int>::min();
+        for (int s = 0; s < 2; ++s)
+        {
+          if (queue[s].empty())
+            continue;
+          const int v = queue[s].begin()->second;
+          if (weight[1-s] + g.vwgt[v] <= maxWeight[1-s] && gain[v] > bestGain)
+          {
+            bestGain = gain[v];
+            from = s;
+          }
+        }
+      }
+      if (from == -1)
+        break;
+
+      const int v = queue[from].begin()->second;
+      queue[from].erase(queue[from].begin());
+      locked[v] = true;
+      part[v] = 1-from;
+      weight[from] -= g.vwgt[v];
+      weight[1-from] += g.vwgt[v];
+      cut -= gain[v];
+      moves.push_back(v);
+
+      for (int j = g.xadj[v]; j < g.xadj[v+1]; ++j)
+      {
+        const int u = g.adjncy[j];
+        if (locked[u])
+          continue;
+        queue[part[u]].erase({-gain[u], u});
+        gain[u] += (part[u] == part[v]) ? -2*g.adjwgt[j] : 2*g.adjwgt[j];
+        queue[part[u]].insert({-gain[u], u});
+      }
+
+      const long ow = overweight(weight);
+      if (ow < bestOverweight || (ow == bestOverweight && cut < bestCut))
+      {
+        bestCut = cut;
+        bestOverweight = ow;
+        bestMoves = moves.size();
+      }
+    }
+
+    /* roll back to the best partition of this pass */
+    for (std::size_t k = moves.size(); k > bestMoves; --k)
+      part[moves[k-1]] = 1-part[moves[k-1]];
+
+    if (bestMoves == 0)
+      break;
+  }
+}
+
+/****************************************************************************/
+/*
+   GrowBisection - greedy graph growing bisection
+
+   PARAMETERS:
+   .  g - the graph
+   .  targetWeight0 - desired weight of part 0
+   .  maxWeight - maximal allowed weights of the two parts
+   .  rng - random number generator for the seed vertices
+
+   DESCRIPTION:
+   Grows part 0 from random seed vertices, always adding the frontier
+   vertex with the highest gain, until it has reached its target weight.
+   The best of several refined trials is returned.
+
+   RETURN VALUE:
+   std::vector<int> - bisection (0/1 per vertex)
+ */
+/****************************************************************************/
+
+static std::vector<int> GrowBisection (const DUAL_GRAPH& g, long targetWeight0,
+                                       const std::array<long, 2>& maxWeight, std::mt19937& rng)
+{
+  const int n = g.nvtxs();
+  std::vector<int> best;
+  long bestCut = std::numeric_limits<long>::max();
+  std::uniform_int_distribution<int> seed(0, n-1);
+
+  for (int trial = 0; trial < GROWING_TRIALS; ++trial)
+  {
+    std::vector<int> part(n, 1);
+    std::vector<int> gain(n, 0);
+    std::set<std::pair<int, int> > frontier;
+    long weight0 = 0;
+
+    while (weight0 < targetWeight0)
+    {
+      int v;
+      if (frontier.empty())
+      {
+        /* start a new region (first trial or disconnected graph) */
+        v = seed(rng);
+        for (int k = 0; k < n && part[v] == 0; ++k)
+          v = (v+1) % n;
+        if (part[v] == 0)
+          break;
+      }
+      else
+      {
+        v = frontier.begin()->second;
+        frontier.erase(frontier.begin());
+      }
+
+      part[v] = 0;
+      weight0 += g.vwgt[v];
+      for (int j = g.xadj[v]; j < g.xadj[v+1]; ++j)
+      {
+        const int u = g.adjncy[j];
+        if (part[u] == 0)
+          continue;
+        frontier.erase({-gain[u], u});
+        gain[u] += g.adjwgt[j];
+        frontier.insert({-gain[u], u});
+      }
+    }
+
+    RefineBisectionFM(g, part, maxWeight, FM_PASSES);
+    const long cut = EdgeCut(g, part);
+    if (cut < bestCut)
+    {
+      bestCut = cut;
+      best = std::move(part);
+    }
+  }
+
+  return best;
+}
+
+/****************************************************************************/
+/*
+   MultilevelBisection - bisect a graph into parts of given weight ratio
+
+   PARAMETERS:
+   .  g - the graph
+   .  ratio - desired fraction of the total weight in part 0
+   .  imbalance - allowed relative deviation of the parts from their desired weights
+   .  rng - random number generator
+
+   DESCRIPTION:
+   Coarsens the graph by heavy edge matching, bisects the coarsest graph by
+   greedy graph growing and projects the bisection back, refining it by
+   FM on every level.
+
+   RETURN VALUE:
+   std::vector<int> - bisection (0/1 per vertex)
+ */
+/****************************************************************************/
+
+static std::vector<int> MultilevelBisection (const DUAL_GRAPH& g, DOUBLE ratio, DOUBLE imbalance,
+                                             std::mt19937& rng)
+{
+  const long total = g.totalWeight();
+  const long target0 = static_cast<long>(ratio*total + 0.5);
+  const long maxVertexWeight = *std::max_element(g.vwgt.begin(), g.vwgt.end());
+  const long tolerance = std::max(static_cast<long>(imbalance*std::min(target0, total-target0)), maxVertexWeight);
+  const std::array<long, 2> maxWeight = {{target0 + tolerance, total - target0 + tolerance}};
+
+  /* coarsening phase */
+  std::vector<DUAL_GRAPH> graphs;
+  std::vector<std::vector<int> > cmaps;
+  const DUAL_GRAPH *current = &g;
+  while (current->nvtxs() > COARSEST_GRAPH_SIZE)
+  {
+    std::vector<int> cmap;
+    DUAL_GRAPH coarse = CoarsenGraph(*current, rng, cmap);
+    if (coarse.nvtxs() > 0.95*current->nvtxs())
+      break;
+    cmaps.push_back(std::move(cmap));
+    graphs.push_back(std::move(coarse));
+    current = &graphs.back();
+  }
+
+  /* initial partitioning phase */
+  std::vector<int> part = GrowBisection(*current, target0, maxWeight, rng);
+
+  /* uncoarsening phase */
+  for (int l = graphs.size()-1; l >= 0; --l)
+  {
+    const DUAL_GRAPH& fine = (l == 0) ? g : graphs[l-1];
+    std::vector<int> finePart(fine.nvtxs());
+    for (int v = 0; v < fine.nvtxs(); ++v)
+      finePart[v] = part[cmaps[l][v]];
+    part = std::move(finePart);
+    RefineBisectionFM(fine, part, maxWeight, FM_PASSES);
+  }
+
+  return part;
+}
+
+/**
+ * Extract the subgraph induced by all vertices v with part[v]==side
+ */
+static DUAL_GRAPH InducedSubgraph (const DUAL_GRAPH& g, const std::vector<int>& part, int side,
+                                   std::vector<int>& subToFine)
+{
+  std::vector<int> fineToSub(g.nvtxs(), -1);
+  subToFine.clear();
+  for (int v = 0; v < g.nvtxs(); ++v)
+    if (part[v] == side)
+    {
+      fineToSub[v] = subToFine.size();
+      subToFine.push_back(v);
+    }
+
+  DUAL_GRAPH sub;
+  sub.xadj.push_back(0);
+  for (int v : subToFine)
+  {
+    sub.vwgt.push_back(g.vwgt[v]);
+    for (int j = g.xadj[v]; j < g.xadj[v+1]; ++j)
+      if (fineToSub[g.adjncy[j]] != -1)
+      {
+        sub.adjncy.push_back(fineToSub[g.adjncy[j]]);
+        sub.adjwgt.push_back(g.adjwgt[j]);
+      }
+    sub.xadj.push_back(sub.adjncy.size());
+  }
+
+  return sub;
+}
+
+/**
+ * Partition a graph into nparts parts by recursive multilevel bisection
+ */
+static void RecursiveBisection (const DUAL_GRAPH& g, const std::vector<int>& vertexIds,
+                                int firstPart, int nparts, std::mt19937& rng,
+                                std::vector<int>& result)
+{
+  if (nparts <= 1 || g.nvtxs() == 0)
+  {
+    for (int id : vertexIds)
+      result[id] = firstPart;
+    return;
+  }
+
+  /* split the allowed imbalance between the remaining bisection levels */
+  int depth = 0;
+  while ((1 << depth) < nparts)
+    ++depth;
+
+  const int nparts0 = nparts/2;
+  const std::vector<int> part = MultilevelBisection(g, static_cast<DOUBLE>(nparts0)/nparts,
+                                                    PARTITION_IMBALANCE/depth, rng);
+
+  for (int side = 0; side < 2; ++side)
+  {
+    std::vector<int> subToFine;
+    const DUAL_GRAPH sub = InducedSubgraph(g, part, side, subToFine);
+    std::vector<int> subIds(subToFine.size());
+    for (std::size_t k = 0; k < subToFine.size(); ++k)
+      subIds[k] = vertexIds[subToFine[k]];
+    RecursiveBisection(sub, subIds,
+                       (side == 0) ? firstPart : firstPart+nparts0,
+                       (side == 0) ? nparts0 : nparts-nparts0,
+                       rng, result);
+  }
+}
+
+/**
+ * Part of the dual graph of a grid level on this process
+ */
+struct LOCAL_GRAPH {
+  /* graphs[0] has a vertex per master element, graphs[l+1] is coarsened from graphs[l] */
+  std::vector<DUAL_GRAPH> graphs;
+  std::vector<std::vector<int> > cmaps;
+  /* vertexOfElement[l][k] is the vertex of element k in graphs[l] */
+  std::vector<std::vector<int> > vertexOfElement;
+  /* sides shared with elements of other processes: element and gid of the neighbor */
+  std::vector<std::pair<int, std::uint64_t> > remote;
+  /* boundary[p] lists the elements with a neighbor on process p, with their gids */
+  std::vector<std::vector<std::pair<int, std::uint64_t> > > boundary;
+};
+
+/****************************************************************************/
+/*
+   ExchangeBoundaryValues - send a value of each boundary element to the neighbor processes
+
+   PARAMETERS:
+   .  comm - communicator of the multigrid
+   .  local - local graph with the boundary elements
+   .  value - value of an element
+   .  received - returns the value of each remote neighbor element by its gid
+
+   DESCRIPTION:
+   Only the processes sharing element sides exchange data, the size of the
+   messages is that of the partition boundaries.
+
+   RETURN VALUE:
+   void
+ */
+/****************************************************************************/
+
+template<class Value>
+static void ExchangeBoundaryValues (MPI_Comm comm, const LOCAL_GRAPH& local, const Value& value,
+                                    std::unordered_map<std::uint64_t, int>& received)
+{
+  const int procs = local.boundary.size();
+  std::vector<int> sendCounts(procs), recvCounts(procs);
+  std::vector<int> sendDispls(procs+1, 0), recvDispls(procs+1, 0);
+
+  std::vector<std::uint64_t> sendBuf;
+  for (int p = 0; p < procs; ++p)
+  {
+    for (const auto& [k, gid] : local.boundary[p])
+    {
+      sendBuf.push_back(gid);
+      sendBuf.push_back(value(k));
+    }
+    sendCounts[p] = 2*local.boundary[p].size();
+  }
+
+  MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, comm);
+  std::partial_sum(sendCounts.begin(), sendCounts.end(), sendDispls.begin()+1);
+  std::partial_sum(recvCounts.begin(), recvCounts.end(), recvDispls.begin()+1);
+  std::vector<std::uint64_t> recvBuf(recvDispls[procs]);
+  MPI_Alltoallv(sendBuf.data(), sendCounts.data(), sendDispls.data(), MPI_UINT64_T,
+                recvBuf.data(), recvCounts.data(), recvDispls.data(), MPI_UINT64_T, comm);
+
+  received.clear();
+  for (std::size_t k = 0; k < recvBuf.size(); k += 2)
+    received[recvBuf[k]] = static_cast<int>(recvBuf[k+1]);
+}
+
+/****************************************************************************/
+/*
+   RefineKWayGreedy - greedy refinement of a distributed partition
+
+   PARAMETERS:
+   .  comm - communicator of the multigrid
+   .  local - local graph
+   .  level - level of the local graph to refine
+   .  nparts - number of parts
+   .  maxWeight - maximal weight of a part
+   .  part - part of each vertex of graphs[level], improved in place
+   .  passes - maximal number of passes
+
+   DESCRIPTION:
+   In each pass every process moves its vertices to the adjacent part they
+   share the most edges with, if this reduces the edge cut. The parts of the
+   elements of other processes are those at the start of the pass. A process
+   may add at most the nparts-th fraction of the remaining capacity of a part
+   to it, so no part exceeds its maximal weight.
+
+   RETURN VALUE:
+   void
+ */
+/****************************************************************************/
+
+static void RefineKWayGreedy (MPI_Comm comm, const LOCAL_GRAPH& local, int level, int nparts,
+                              long maxWeight, std::vector<int>& part, int passes)
+{
+  const DUAL_GRAPH& g = local.graphs[level];
+  const std::vector<int>& vertexOf = local.vertexOfElement[level];
+  const int n = g.nvtxs();
+
+  /* remote neighbors of each vertex */
+  std::vector<int> remoteXadj(n+1, 0);
+  for (const auto& [k, gid] : local.remote)
+    remoteXadj[vertexOf[k]+1]++;
+  std::partial_sum(remoteXadj.begin(), remoteXadj.end(), remoteXadj.begin());
+  std::vector<std::uint64_t> remoteGid(local.remote.size());
+  std::vector<int> fill(remoteXadj.begin(), remoteXadj.end()-1);
+  for (const auto& [k, gid] : local.remote)
+    remoteGid[fill[vertexOf[k]]++] = gid;
+
+  std::vector<long> conn(nparts, 0);
+  std::vector<int> touched;
+  std::unordered_map<std::uint64_t, int> remotePart;
+
+  for (int pass = 0; pass < passes; ++pass)
+  {
+    ExchangeBoundaryValues(comm, local, [&](int k) { return part[vertexOf[k]]; }, remotePart);
+
+    std::vector<long> weight(nparts, 0);
+    for (int v = 0; v < n; ++v)
+      weight[part[v]] += g.vwgt[v];
+    MPI_Allreduce(MPI_IN_PLACE, weight.data(), nparts, MPI_LONG, MPI_SUM, comm);
+
+    std::vector<long> budget(nparts);
+    for (int q = 0; q < nparts; ++q)
+      budget[q] = std::max(0L, maxWeight - weight[q]) / nparts;
+
+    long moved = 0;
+    for (int v = 0; v < n; ++v)
+    {
+      auto connect = [&](int q, long w)
+      {
+        if (conn[q] == 0)
+          touched.push_back(q);
+        conn[q] += w;
+      };
+      for (int j = g.xadj[v]; j < g.xadj[v+1]; ++j)
+        connect(part[g.adjncy[j]], g.adjwgt[j]);
+      for (int j = remoteXadj[v]; j < remoteXadj[v+1]; ++j)
+      {
+        auto nb = remotePart.find(remoteGid[j]);
+        if (nb != remotePart.end())
+          connect(nb->second, 1);
+      }
+
+      const int from = part[v];
+      int best = from;
+      long bestGain = 0;
+      for (int q : touched)
+        if (q != from && conn[q] - conn[from] > bestGain && budget[q] >= g.vwgt[v])
+        {
+          best = q;
+          bestGain = conn[q] - conn[from];
+        }
+      if (best != from)
+      {
+        part[v] = best;
+        budget[best] -= g.vwgt[v];
+        moved++;
+      }
+
+      for (int q : touched)
+        conn[q] = 0;
+      touched.clear();
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &moved, 1, MPI_LONG, MPI_SUM, comm);
+    if (moved == 0)
+      break;
+  }
+}
+
+/****************************************************************************/
+/*
+   PartitionGathered - partition the dual graph on the master
+
+   PARAMETERS:
+   .  theMG
+   .  theGrid - grid level to partition
+
+   DESCRIPTION:
+   The processes send their part of the graph to the master, which
+   partitions it by recursive multilevel bisection and sends each process
+   the parts of its elements. Only the master holds the whole graph.
+
+   RETURN VALUE:
+   void
+ */
+/****************************************************************************/
+
+static void PartitionGathered (MULTIGRID *theMG, const GRID *theGrid)
+{
+  const PPIF::PPIFContext& ppifContext = theMG->ppifContext();
+  const int procs = ppifContext.procs();
+  const int master = ppifContext.master();
+  const MPI_Comm comm = ppifContext.comm();
+
+  /* local part of the graph: gid, weight, number of neighbors, neighbor gids */
+  std::vector<std::uint64_t> local;
+  int nLocal = 0;
+  for (auto e=FIRSTELEMENT(theGrid); e!=NULL; e=SUCCE(e))
+  {
+    local.push_back(EGID(e));
+    local.push_back(LeafElementWeight(theMG,e));
+    const std::size_t nbPos = local.size();
+    local.push_back(0);
+    for (int j=0; j<SIDES_OF_ELEM(e); j++)
+      if (NBELEM(e,j) != NULL)
+      {
+        local.push_back(EGID(NBELEM(e,j)));
+        local[nbPos]++;
+      }
+    nLocal++;
+  }
+
+  /* collect the graph on the master */
+  int localSize = local.size();
+  std::vector<int> sizes(procs), displs(procs+1, 0);
+  std::vector<int> counts(procs), firstVertexOfProc(procs+1, 0);
+  MPI_Gather(&localSize, 1, MPI_INT, sizes.data(), 1, MPI_INT, master, comm);
+  MPI_Gather(&nLocal, 1, MPI_INT, counts.data(), 1, MPI_INT, master, comm);
+  std::partial_sum(sizes.begin(), sizes.end(), displs.begin()+1);
+  std::partial_sum(counts.begin(), counts.end(), firstVertexOfProc.begin()+1);
+  std::vector<std::uint64_t> global(ppifContext.isMaster() ? displs[procs] : 0);
+  MPI_Gatherv(local.data(), localSize, MPI_UINT64_T,
+              global.data(), sizes.data(), displs.data(), MPI_UINT64_T, master, comm);
+
+  std::vector<int> part;
+  if (ppifContext.isMaster())
+  {
+    std::unordered_map<std::uint64_t, int> vertexOfGid;
+    for (int pos = 0; pos < displs[procs]; pos += 3+global[pos+2])
+      vertexOfGid.emplace(global[pos], vertexOfGid.size());
+
+    DUAL_GRAPH g;
+    g.xadj.push_back(0);
+    for (int pos = 0; pos < displs[procs]; pos += 3+global[pos+2])
+    {
+      g.vwgt.push_back(global[pos+1]);
+      for (std::uint64_t k = 0; k < global[pos+2]; ++k)
+      {
+        auto nb = vertexOfGid.find(global[pos+3+k]);
+        if (nb == vertexOfGid.end())
+          continue;
+        g.adjncy.push_back(nb->second);
+        g.adjwgt.push_back(1);
+      }
+      g.xadj.push_back(g.adjncy.size());
+    }
+
+    part.assign(g.nvtxs(), 0);
+    std::mt19937 rng(5489u);
+    std::vector<int> ids(g.nvtxs());
+    std::iota(ids.begin(), ids.end(), 0);
+    RecursiveBisection(g, ids, 0, procs, rng, part);
+
+IFDEBUG(dddif,1)
+    UserWriteF("BalanceGridGraph(): edge cut %ld\n", EdgeCut(g, part));
+ENDDEBUG
+  }
+
+  std::vector<int> localPart(nLocal);
+  MPI_Scatterv(part.data(), counts.data(), firstVertexOfProc.data(), MPI_INT,
+               localPart.data(), nLocal, MPI_INT, master, comm);
+
+  int k = 0;
+  for (auto e=FIRSTELEMENT(theGrid); e!=NULL; e=SUCCE(e))
+    PARTITION(e) = localPart[k++];
+}
+
+/****************************************************************************/
+/*
+   PartitionDistributed - partition the dual graph without collecting it
+
+   PARAMETERS:
+   .  theMG
+   .  theGrid - grid level to partition
+
+   DESCRIPTION:
+   Each process coarsens its part of the graph by heavy edge matching, the
+   edges to elements of other processes are not contracted. All processes
+   coarsen equally often. The coarsest graphs of all processes are
+   collected by every process, which partitions them with its own random
+   seed; the partition with the smallest edge cut is taken. It is then
+   projected back level by level and refined by RefineKWayGreedy. Besides
+   the coarsest graph only the parts of the boundary elements are
+   communicated.
+
+   RETURN VALUE:
+   void
+ */
+/****************************************************************************/
+
+static void PartitionDistributed (MULTIGRID *theMG, const GRID *theGrid)
+{
+  const DDD::DDDContext& context = theMG->dddContext();
+  const PPIF::PPIFContext& ppifContext = theMG->ppifContext();
+  const int me = ppifContext.me();
+  const int procs = ppifContext.procs();
+  const MPI_Comm comm = ppifContext.comm();
+
+  std::vector<ELEMENT *> elems;
+  std::unordered_map<const ELEMENT *, int> index;
+  for (auto e=FIRSTELEMENT(theGrid); e!=NULL; e=SUCCE(e))
+  {
+    index.emplace(e, elems.size());
+    elems.push_back(e);
+  }
+  const int n = elems.size();
+
+  /* local graph, sides to other processes are remote edges */
+  LOCAL_GRAPH local;
+  local.boundary.resize(procs);
+  DUAL_GRAPH g;
+  g.xadj.push_back(0);
+  for (int k = 0; k < n; ++k)
+  {
+    ELEMENT *e = elems[k];
+    g.vwgt.push_back(LeafElementWeight(theMG,e));
+    for (int j=0; j<SIDES_OF_ELEM(e); j++)
+    {
+      ELEMENT *nb = NBELEM(e,j);
+      if (nb == NULL)
+        continue;
+
+      auto nbIndex = index.find(nb);
+      if (nbIndex != index.end())
+      {
+        g.adjncy.push_back(nbIndex->second);
+        g.adjwgt.push_back(1);
+        continue;
+      }
+
+      const DDD_PROC p = EPROCPRIO(context, nb, PrioMaster);
+      if (p >= static_cast<DDD_PROC>(procs) || static_cast<int>(p) == me)
+        continue;
+      local.remote.emplace_back(k, EGID(nb));
+      std::vector<std::pair<int, std::uint64_t> >& boundary = local.boundary[p];
+      if (boundary.empty() || boundary.back().first != k)
+        boundary.emplace_back(k, EGID(e));
+    }
+    g.xadj.push_back(g.adjncy.size());
+  }
+
+  std::vector<int> identity(n);
+  std::iota(identity.begin(), identity.end(), 0);
+  local.graphs.push_back(std::move(g));
+  local.vertexOfElement.push_back(identity);
+
+  /* coarsening phase, on each process */
+  std::mt19937 rng(5489u + me);
+  int levels = 0;
+  while (local.graphs.back().nvtxs() > COARSEST_GRAPH_SIZE)
+  {
+    std::vector<int> cmap;
+    DUAL_GRAPH coarse = CoarsenGraph(local.graphs.back(), rng, cmap);
+    if (coarse.nvtxs() > 0.95*local.graphs.back().nvtxs())
+      break;
+    std::vector<int> vertexOf(n);
+    for (int k = 0; k < n; ++k)
+      vertexOf[k] = cmap[local.vertexOfElement.back()[k]];
+    local.graphs.push_back(std::move(coarse));
+    local.cmaps.push_back(std::move(cmap));
+    local.vertexOfElement.push_back(std::move(vertexOf));
+    levels++;
+  }
+
+  /* the refinement communicates, so all processes need the same levels */
+  levels = UG_GlobalMaxINT(ppifContext, levels);
+  while (static_cast<int>(local.graphs.size()) <= levels)
+  {
+    std::vector<int> cmap(local.graphs.back().nvtxs());
+    std::iota(cmap.begin(), cmap.end(), 0);
+    local.graphs.push_back(local.graphs.back());
+    local.cmaps.push_back(std::move(cmap));
+    local.vertexOfElement.push_back(local.vertexOfElement.back());
+  }
+
+  /* coarsest graph of all processes, remote edges become edges between them */
+  const DUAL_GRAPH& coarsest = local.graphs.back();
+  int nCoarse = coarsest.nvtxs();
+  int offset = 0;
+  MPI_Exscan(&nCoarse, &offset, 1, MPI_INT, MPI_SUM, comm);
+  if (me == 0)
+    offset = 0;
+
+  std::unordered_map<std::uint64_t, int> remoteCoarse;
+  ExchangeBoundaryValues(comm, local,
+                         [&](int k) { return offset + local.vertexOfElement[levels][k]; },
+                         remoteCoarse);
+
+  std::vector<std::unordered_map<int, int> > remoteEdges(nCoarse);
+  for (const auto& [k, gid] : local.remote)
+  {
+    auto nb = remoteCoarse.find(gid);
+    if (nb != remoteCoarse.end())
+      remoteEdges[local.vertexOfElement[levels][k]][nb->second]++;
+  }
+
+  /* weight, number of neighbors, (neighbor, edge weight) for each coarse vertex */
+  std::vector<std::uint64_t> buffer;
+  for (int u = 0; u < nCoarse; ++u)
+  {
+    buffer.push_back(coarsest.vwgt[u]);
+    buffer.push_back(coarsest.xadj[u+1] - coarsest.xadj[u] + remoteEdges[u].size());
+    for (int j = coarsest.xadj[u]; j < coarsest.xadj[u+1]; ++j)
+    {
+      buffer.push_back(offset + coarsest.adjncy[j]);
+      buffer.push_back(coarsest.adjwgt[j]);
+    }
+    for (const auto& [nb, w] : remoteEdges[u])
+    {
+      buffer.push_back(nb);
+      buffer.push_back(w);
+    }
+  }
+
+  int localSize = buffer.size();
+  std::vector<int> sizes(procs), displs(procs+1, 0);
+  MPI_Allgather(&localSize, 1, MPI_INT, sizes.data(), 1, MPI_INT, comm);
+  std::partial_sum(sizes.begin(), sizes.end(), displs.begin()+1);
+  std::vector<std::uint64_t> global(displs[procs]);
+  MPI_Allgatherv(buffer.data(), localSize, MPI_UINT64_T,
+                 global.data(), sizes.data(), displs.data(), MPI_UINT64_T, comm);
+
+  DUAL_GRAPH G;
+  G.xadj.push_back(0);
+  for (int pos = 0; pos < displs[procs]; pos += 2+2*global[pos+1])
+  {
+    G.vwgt.push_back(global[pos]);
+    for (std::uint64_t k = 0; k < global[pos+1]; ++k)
+    {
+      G.adjncy.push_back(global[pos+2+2*k]);
+      G.adjwgt.push_back(global[pos+3+2*k]);
+    }
+    G.xadj.push_back(G.adjncy.size());
+  }
+
+  /* initial partition on all processes, the best one is taken */
+  std::vector<int> coarsePart(G.nvtxs(), 0);
+  std::vector<int> ids(G.nvtxs());
+  std::iota(ids.begin(), ids.end(), 0);
+  RecursiveBisection(G, ids, 0, procs, rng, coarsePart);
+
+  struct { long cut; int rank; } mine = {EdgeCut(G, coarsePart), me}, best;
+  MPI_Allreduce(&mine, &best, 1, MPI_LONG_INT, MPI_MINLOC, comm);
+  MPI_Bcast(coarsePart.data(), coarsePart.size(), MPI_INT, best.rank, comm);
+
+  /* uncoarsening phase, on each process */
+  const long total = G.totalWeight();
+  const long maxVertexWeight = G.nvtxs() > 0 ? *std::max_element(G.vwgt.begin(), G.vwgt.end()) : 0;
+  const long maxWeight = static_cast<long>((1.0 + PARTITION_IMBALANCE)*total/procs) + maxVertexWeight;
+
+  std::vector<int> part(coarsePart.begin()+offset, coarsePart.begin()+offset+nCoarse);
+  for (int l = levels; l >= 0; --l)
+  {
+    if (l < levels)
+    {
+      std::vector<int> finePart(local.graphs[l].nvtxs());
+      for (int v = 0; v < local.graphs[l].nvtxs(); ++v)
+        finePart[v] = part[local.cmaps[l][v]];
+      part = std::move(finePart);
+    }
+    RefineKWayGreedy(comm, local, l, procs, maxWeight, part, FM_PASSES);
+  }
+
+  for (int k = 0; k < n; ++k)
+    PARTITION(elems[k]) = part[k];
+
+IFDEBUG(dddif,1)
+  std::unordered_map<std::uint64_t, int> remotePart;
+  ExchangeBoundaryValues(comm, local, [&](int k) { return part[k]; }, remotePart);
+  long cut = 0;
+  for (const auto& [k, gid] : local.remote)
+    if (remotePart.count(gid) && remotePart[gid] != part[k])
+      cut++;
+  cut = 2*EdgeCut(local.graphs[0], part) + cut;
+  MPI_Allreduce(MPI_IN_PLACE, &cut, 1, MPI_LONG, MPI_SUM, comm);
+  if (ppifContext.isMaster())
+    UserWriteF("BalanceGridGraph(): edge cut %ld\n", cut/2);
+ENDDEBUG
+}
+
+/****************************************************************************/
+/*
+   BalanceGridGraph -
+
+   PARAMETERS:
+   .  theMG
+   .  level
+   .  parallel - partition the graph without collecting it on one process
+
+   DESCRIPTION:
+   Load balance one level of a multigrid hierarchy by partitioning the dual
+   graph of its elements (vertices are the master elements weighted by their
+   number of leaf elements, edges are NBELEM relations) into procs() parts
+   of equal weight with small edge cut.
+
+   Without the parallel option the graph is collected and partitioned by the
+   master, see PartitionGathered. With the parallel option the processes
+   coarsen their parts of the graph and only the coarsest graph is collected,
+   see PartitionDistributed; this scales to large grids at the price of a
+   somewhat larger edge cut.
+
+   RETURN VALUE:
+   void
+ */
+/****************************************************************************/
+
+void BalanceGridGraph (MULTIGRID *theMG, int level, bool parallel)
+{
+  const GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+  const PPIF::PPIFContext& ppifContext = theMG->ppifContext();
+
+  if (UG_GlobalSumINT(ppifContext, NT(theGrid)) == 0)
+  {
+    if (ppifContext.isMaster())
+      UserWriteF("WARNING in BalanceGridGraph: no elements in grid\n");
+    return;
+  }
+
+  if (parallel)
+    PartitionDistributed(theMG,theGrid);
+  else
+    PartitionGathered(theMG,theGrid);
+
+  for (auto e=FIRSTELEMENT(theGrid); e!=NULL; e=SUCCE(e))
+    InheritPartition(theMG,e);
+}
+
+END_UGDIM_NAMESPACE
+
+#endif  /* ModelP */
@@ -156,53 +156,6 @@ static void RecursiveCoordinateBisection (const PPIF::PPIFContext& ppifContext,
   RecursiveCoordinateBisection(ppifContext, middle, end, procPartitions[1], nextBisectionAxis);
 }
 
-/**
- * Compute an element's center of mass
- */
-static Dune::FieldVector<DOUBLE, DIM> CenterOfMass (ELEMENT *e)
-{
-  Dune::FieldVector<DOUBLE, DIM> center(0.0);
-
-  const auto corners = CORNERS_OF_ELEM(e);
-  for(int i=0; i<corners; i++)
-    center +=  CVECT(MYVERTEX(CORNER(e,i)));
-
-  center /= corners;
-  return center;
-}
-
-/****************************************************************************/
-/*
-   InheritPartition -
-
-   SYNOPSIS:
-   static void InheritPartition (ELEMENT *e);
-
-   PARAMETERS:
-   .  e
-
-   DESCRIPTION:
-
-   RETURN VALUE:
-   void
- */
-/****************************************************************************/
-
-static void InheritPartition (ELEMENT *e)
-{
-  ELEMENT *SonList[MAX_SONS];
-
-  if (GetAllSons(e,SonList)==0)
-  {
-    for(int i=0; i<MAX_SONS && SonList[i]!=NULL; i++)
-    {
-      PARTITION(SonList[i]) = PARTITION(e);
-      InheritPartition(SonList[i]);
-    }
-  }
-}
-
-
 /****************************************************************************/
 /*
    BalanceGridRCB -
@@ -222,7 +175,7 @@ static void InheritPartition (ELEMENT *e)
 
 void BalanceGridRCB (MULTIGRID *theMG, int level)
 {
-  const GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+  GRID *theGrid = GRID_ON_LEVEL(theMG,level);
   DDD::DDDContext& context = theMG->dddContext();
   const PPIF::PPIFContext& ppifContext = theMG->ppifContext();
 
@@ -238,13 +191,23 @@ void BalanceGridRCB (MULTIGRID *theMG, int level)
       return;
     }
 
-    std::vector<LB_INFO> lbinfo(NT(theGrid));
-    int i = 0;
-    for (auto e=FIRSTELEMENT(theGrid); e!=NULL; e=SUCCE(e))
+    /* the centers of mass of all elements of one tag at once */
+    ElementCornerBuffer buffers[TAGS];
+    GatherGridCorners(theGrid,buffers);
+
+    std::vector<LB_INFO> lbinfo;
+    lbinfo.reserve(NT(theGrid));
+    for (const ElementCornerBuffer& buffer : buffers)
     {
-      lbinfo[i].elem = e;
-      lbinfo[i].center = CenterOfMass(e);
-      ++i;
+      std::vector<DOUBLE> center[DIM];
+      ElementCentersOfMass(buffer,center);
+      for (std::size_t k=0; k<buffer.size(); k++)
+      {
+        LB_INFO& info = lbinfo.emplace_back();
+        info.elem = buffer.elements[k];
+        for (int d=0; d<DIM; d++)
+          info.center[d] = center[d][k];
+      }
     }
 
     RecursiveCoordinateBisection(ppifContext, lbinfo.begin(), lbinfo.end(), {0, 0, ppifContext.dimX(), ppifContext.dimY()});
@@ -255,7 +218,7 @@ IFDEBUG(dddif,1)
 ENDDEBUG
 
     for (auto e=FIRSTELEMENT(theGrid); e!=NULL; e=SUCCE(e))
-      InheritPartition (e);
+      InheritPartition (theMG,e);
 
   }
 }
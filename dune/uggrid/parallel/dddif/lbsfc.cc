@@ -0,0 +1,263 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+/****************************************************************************/
+/* File:	  lbsfc.c														*/
+/* Purpose:   load balancing along a space filling curve (Hilbert or		*/
+/*            Morton order) of the elements of one grid level				*/
+/****************************************************************************/
+
+#ifdef ModelP
+
+#include <config.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <dune/uggrid/parallel/ppif/ppifcontext.hh>
+
+#include "parallel.h"
+#include <dune/uggrid/low/namespace.h>
+#include <dune/uggrid/ugdevices.h>
+#include <dune/uggrid/gm/evm.h>
+#include <dune/uggrid/gm/ugm.h>
+
+USING_UG_NAMESPACES
+using namespace PPIF;
+
+START_UGDIM_NAMESPACE
+
+/** \brief Number of bits per coordinate direction used for the curve keys */
+static constexpr int SFC_BITS = 63/DIM;
+
+using SFCKey = std::uint64_t;
+
+// only used in this source file
+struct SFC_INFO {
+  SFCKey key;
+  DOUBLE weight;
+  ELEMENT *elem;
+};
+
+/**
+ * Interleave the bits of the (transposed) coordinates, most significant bit first.
+ */
+static SFCKey InterleaveBits (const std::array<std::uint32_t, DIM>& x)
+{
+  SFCKey key = 0;
+  for (int b = SFC_BITS-1; b >= 0; --b)
+    for (int i = 0; i < DIM; ++i)
+      key = (key << 1) | ((x[i] >> b) & 1u);
+  return key;
+}
+
+static SFCKey MortonKey (const std::array<std::uint32_t, DIM>& x)
+{
+  return InterleaveBits(x);
+}
+
+/**
+ * Compute the index of a point on the Hilbert curve.
+ *
+ * The coordinates are transformed into the "transposed" Hilbert index
+ * following J. Skilling, Programming the Hilbert curve,
+ * AIP Conf. Proc. 707 (2004), which is then interleaved into the key.
+ */
+static SFCKey HilbertKey (std::array<std::uint32_t, DIM> x)
+{
+  const std::uint32_t M = 1u << (SFC_BITS-1);
+
+  /* inverse undo excess work */
+  for (std::uint32_t Q = M; Q > 1; Q >>= 1)
+  {
+    const std::uint32_t P = Q-1;
+    for (int i = 0; i < DIM; ++i)
+    {
+      if (x[i] & Q)
+        x[0] ^= P;
+      else
+      {
+        const std::uint32_t t = (x[0] ^ x[i]) & P;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+
+  /* Gray encode */
+  for (int i = 1; i < DIM; ++i)
+    x[i] ^= x[i-1];
+  std::uint32_t t = 0;
+  for (std::uint32_t Q = M; Q > 1; Q >>= 1)
+    if (x[DIM-1] & Q)
+      t ^= Q-1;
+  for (int i = 0; i < DIM; ++i)
+    x[i] ^= t;
+
+  return InterleaveBits(x);
+}
+
+
+/****************************************************************************/
+/*
+   SpaceFillingCurveKey -
+
+   PARAMETERS:
+   .  x - integer coordinates of a point, each less than 2^(63/DIM)
+   .  curve - SFC_HILBERT or SFC_MORTON
+
+   DESCRIPTION:
+   Position of the point on the curve BalanceGridSFC orders the elements
+   by. Both curves start at the origin, hence the points of the cube
+   [0,2^k)^DIM get the keys 0,...,2^(k*DIM)-1.
+
+   RETURN VALUE:
+   std::uint64_t
+ */
+/****************************************************************************/
+
+std::uint64_t SpaceFillingCurveKey (const std::array<std::uint32_t, DIM>& x, SpaceFillingCurve curve)
+{
+  return (curve == SFC_MORTON) ? MortonKey(x) : HilbertKey(x);
+}
+
+
+/****************************************************************************/
+/*
+   BalanceGridSFC -
+
+   PARAMETERS:
+   .  theMG
+   .  level
+   .  curve - SFC_HILBERT or SFC_MORTON
+
+   DESCRIPTION:
+   Load balance one level of a multigrid hierarchy by ordering the
+   master elements of that level along a space filling curve and cutting
+   the curve into procs() chunks of equal leaf element weight.
+
+   In contrast to BalanceGridRCB the grid may already be distributed:
+   the curve keys are computed locally and the cut positions on the curve
+   are determined by a bitwise bisection using one global sum per key bit.
+   Since the key of an element does not depend on the weights, small
+   weight changes only shift the cut positions slightly, and only few
+   elements change their partition.
+
+   RETURN VALUE:
+   void
+ */
+/****************************************************************************/
+
+void BalanceGridSFC (MULTIGRID *theMG, int level, SpaceFillingCurve curve)
+{
+  const GRID *theGrid = GRID_ON_LEVEL(theMG,level);
+  const PPIF::PPIFContext& ppifContext = theMG->ppifContext();
+  const int procs = ppifContext.procs();
+
+  if (UG_GlobalSumINT(ppifContext, NT(theGrid)) == 0)
+  {
+    if (ppifContext.isMaster())
+      UserWriteF("WARNING in BalanceGridSFC: no elements in grid\n");
+    return;
+  }
+
+  /* bounding box of all element centers */
+  std::vector<SFC_INFO> sfcinfo;
+  sfcinfo.reserve(NT(theGrid));
+  std::vector<Dune::FieldVector<DOUBLE, DIM> > centers;
+  centers.reserve(NT(theGrid));
+  DOUBLE bbmin[DIM], bbmax[DIM];
+  for (int i = 0; i < DIM; ++i)
+  {
+    bbmin[i] = std::numeric_limits<DOUBLE>::max();
+    bbmax[i] = std::numeric_limits<DOUBLE>::lowest();
+  }
+
+  for (auto e=FIRSTELEMENT(theGrid); e!=NULL; e=SUCCE(e))
+  {
+    const auto center = CenterOfMass(e);
+    for (int i = 0; i < DIM; ++i)
+    {
+      bbmin[i] = std::min(bbmin[i], center[i]);
+      bbmax[i] = std::max(bbmax[i], center[i]);
+    }
+    centers.push_back(center);
+    sfcinfo.push_back({0, static_cast<DOUBLE>(LeafElementWeight(theMG,e)), e});
+  }
+  UG_GlobalMinNDOUBLE(ppifContext, DIM, bbmin);
+  UG_GlobalMaxNDOUBLE(ppifContext, DIM, bbmax);
+
+  /* curve keys */
+  const DOUBLE maxCoord = static_cast<DOUBLE>((1u << SFC_BITS) - 1);
+  for (std::size_t k = 0; k < sfcinfo.size(); ++k)
+  {
+    std::array<std::uint32_t, DIM> x;
+    for (int i = 0; i < DIM; ++i)
+    {
+      const DOUBLE extent = bbmax[i] - bbmin[i];
+      const DOUBLE s = (extent > 0.0) ? (centers[k][i] - bbmin[i]) / extent : 0.0;
+      x[i] = static_cast<std::uint32_t>(std::clamp(s, 0.0, 1.0) * maxCoord);
+    }
+    sfcinfo[k].key = SpaceFillingCurveKey(x, curve);
+  }
+
+  std::sort(sfcinfo.begin(), sfcinfo.end(),
+            [](const auto& a, const auto& b) { return a.key < b.key; });
+
+  /* prefixWeight[k] is the local weight of all elements with key < sfcinfo[k].key */
+  std::vector<DOUBLE> prefixWeight(sfcinfo.size()+1, 0.0);
+  for (std::size_t k = 0; k < sfcinfo.size(); ++k)
+    prefixWeight[k+1] = prefixWeight[k] + sfcinfo[k].weight;
+
+  const DOUBLE totalWeight = UG_GlobalSumDOUBLE(ppifContext, prefixWeight.back());
+
+  /* local weight of all elements with a key smaller than a given key */
+  auto weightBelow = [&](SFCKey key)
+  {
+    auto it = std::lower_bound(sfcinfo.begin(), sfcinfo.end(), key,
+                               [](const auto& a, SFCKey k) { return a.key < k; });
+    return prefixWeight[std::distance(sfcinfo.begin(), it)];
+  };
+
+  /* cut[p-1] is the largest key such that the global weight below it
+     does not exceed p/procs of the total weight; all cuts are bisected
+     simultaneously, bit by bit, starting with the most significant bit */
+  const int nCuts = procs-1;
+  std::vector<SFCKey> cut(nCuts, 0);
+  std::vector<DOUBLE> below(nCuts);
+  for (int b = DIM*SFC_BITS-1; b >= 0 && nCuts > 0; --b)
+  {
+    const SFCKey bit = SFCKey(1) << b;
+    for (int p = 0; p < nCuts; ++p)
+      below[p] = weightBelow(cut[p] | bit);
+    UG_GlobalSumNDOUBLE(ppifContext, nCuts, below.data());
+    for (int p = 0; p < nCuts; ++p)
+      if (below[p] <= totalWeight*(p+1)/procs)
+        cut[p] |= bit;
+  }
+
+  /* assign partitions: elements between two cuts go to the same process */
+  int part = 0;
+  for (auto& info : sfcinfo)
+  {
+    while (part < nCuts && info.key >= cut[part])
+      ++part;
+    PARTITION(info.elem) = part;
+  }
+
+IFDEBUG(dddif,1)
+  for (auto e=FIRSTELEMENT(theGrid); e!=NULL; e=SUCCE(e))
+    UserWriteF("elem %08x has dest=%d\n", DDD_InfoGlobalId(PARHDRE(e)), PARTITION(e));
+ENDDEBUG
+
+  for (auto e=FIRSTELEMENT(theGrid); e!=NULL; e=SUCCE(e))
+    InheritPartition (theMG,e);
+}
+
+END_UGDIM_NAMESPACE
+
+#endif  /* ModelP */
@@ -35,6 +35,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 
 /* low module */
 #include <dune/uggrid/low/debug.h>
@@ -324,6 +325,13 @@ static INT DropUsedFlags (GRID *theGrid)
    .  theGrid
 
    DESCRIPTION:
+   Connects the sons of the horizontal ghosts with the sons of their
+   neighbors and disposes yellow ghosts which turn out to be useless.
+   Both need a transfer, which is started here. In 3D connecting the sons
+   disposes doubled side vectors, so the transfer encloses the whole
+   connection. Without side vectors connecting only changes local pointers,
+   and the transfer for the useless ghosts is skipped if no processor has
+   such ghosts.
 
    RETURN VALUE:
    INT
@@ -338,6 +346,15 @@ INT ConnectGridOverlap (GRID *theGrid)
   ELEMENT *theNeighbor;
   ELEMENT *theSon;
   ELEMENT *Sons_of_Side_List[MAX_SONS];
+  std::vector<ELEMENT*> uselessGhosts;
+
+  /* disposing doubled side vectors needs a transfer */
+  bool xfer = false;
+#ifdef UG_DIM_3
+  xfer = VEC_DEF_IN_OBJ_OF_GRID(theGrid,SIDEVEC);
+#endif
+  if (xfer)
+    DDD_XferBegin(theGrid->dddContext());
 
   for (theElement=PFIRSTELEMENT(theGrid); theElement!=NULL; theElement=SUCCE(theElement))
   {
@@ -396,8 +413,8 @@ INT ConnectGridOverlap (GRID *theGrid)
     /* master element as neighbor                              */
     /* TODO: move this functionality to ComputeCopies          */
     /* then disposing of theSon can be done in AdaptGrid       */
-    /* and the extra Xfer env around ConnectGridOverlap()      */
-    /* can be deleted (s.l. 971029)                            */
+    /* and the extra Xfer env below can be deleted             */
+    /* (s.l. 971029)                                           */
 
     /* 2. ghost-ghost neighborship specific code:              */
     /* reset in 3D all unsymmetric neighbor relationships      */
@@ -443,7 +460,7 @@ INT ConnectGridOverlap (GRID *theGrid)
             UserWriteF("ConnectGridOverlap(): disposing useless yellow ghost  e=" EID_FMTX
                        "f=" EID_FMTX "this ghost is useless!\n",
                        EID_PRTX(theSon),EID_PRTX(theElement));
-            DisposeElement(UPGRID(theGrid),theSon);
+            uselessGhosts.push_back(theSon);
           }
           else
           {
@@ -459,6 +476,19 @@ INT ConnectGridOverlap (GRID *theGrid)
     }
   }
 
+  /* disposing needs a transfer, start it only if needed */
+  if (!xfer && UG_GlobalMaxINT(theGrid->ppifContext(), !uselessGhosts.empty()))
+  {
+    xfer = true;
+    DDD_XferBegin(theGrid->dddContext());
+  }
+  if (xfer)
+  {
+    for (ELEMENT *theGhost : uselessGhosts)
+      DisposeElement(UPGRID(theGrid),theGhost);
+    DDD_XferEnd(theGrid->dddContext());
+  }
+
   return(GM_OK);
 }
 
@@ -602,6 +632,8 @@ INT ConnectVerticalOverlap (MULTIGRID *theMG)
                                   EID_PRTX(theFather),
                                   EID_PRTX(el)));
               SET_EFATHER(theElement,el);
+              if (theMG->sonTable)
+                SonsChanged(theMG,el);
               if (NSONS(el) == 0)
               {
                 SET_SON(el,where,theElement);
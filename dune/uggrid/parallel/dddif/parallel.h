@@ -33,6 +33,8 @@
 #ifndef __PARALLEL_H__
 #define __PARALLEL_H__
 
+#include <array>
+#include <cstdint>
 #include <memory>
 
 #ifdef ModelP
@@ -266,6 +268,27 @@ struct DDD_CTRL
          EdgeSymmVHIF;
 };
 
+/* quality of the current partitioning, see PartitionStatistics */
+struct PARTITION_STATISTICS
+{
+  INT minLoad;                  /* min/max number of leaf master elements per process */
+  INT maxLoad;
+  DOUBLE avgLoad;
+  DOUBLE imbalance;             /* maxLoad/avgLoad */
+
+  INT edgeCut;                  /* leaf element sides at partition boundaries */
+  INT maxEdgeCut;               /* max of these sides of a single partition   */
+
+  INT maxNeighborProcs;         /* processes sharing objects with a process */
+  DOUBLE avgNeighborProcs;
+
+  INT ghostElements;            /* total and max number of ghost elements */
+  INT maxGhostElements;
+
+  DOUBLE migrationBytes;        /* estimated total and max volume sent by the */
+  DOUBLE maxMigrationBytes;     /* next TransferGridFromLevel                 */
+};
+
 #endif
 
 /****************************************************************************/
@@ -304,6 +327,9 @@ void    ddd_pstat                       (DDD::DDDContext& context, char *);
 
 /* from lb.c */
 void lbs (const char *argv, MULTIGRID *theMG);
+Dune::FieldVector<DOUBLE, DIM> CenterOfMass (ELEMENT *e);
+void InheritPartition (const MULTIGRID *theMG, ELEMENT *e);
+INT  LeafElementWeight (const MULTIGRID *theMG, const ELEMENT *e);
 
 /* from handler.c */
 void            ddd_HandlerInit                 (DDD::DDDContext& context, INT);
@@ -313,6 +339,21 @@ void            ObjectPriorityUpdate    (DDD::DDDContext& context, DDD_OBJ obj,
 /* from lbrcb.c */
 void BalanceGridRCB (MULTIGRID *, int);
 
+/* from lbsfc.c */
+enum SpaceFillingCurve {SFC_HILBERT, SFC_MORTON};
+std::uint64_t SpaceFillingCurveKey (const std::array<std::uint32_t, DIM>& x, SpaceFillingCurve curve);
+void BalanceGridSFC (MULTIGRID *, int, SpaceFillingCurve curve = SFC_HILBERT);
+
+/* from lbgraph.c */
+void BalanceGridGraph (MULTIGRID *, int, bool parallel = false);
+
+/* from lbdiff.c */
+void BalanceGridDiffusive (MULTIGRID *, int);
+
+/* from distrib.c */
+INT             IdentifyDistributedCoarseGrid (MULTIGRID *theMG, const INT *vertexGid,
+                                               const INT *elementGid, const INT *elementOwner);
+
 /* from gridcons.c */
 void    ConstructConsistentGrid                 (GRID *theGrid);
 void    ConstructConsistentMultiGrid    (MULTIGRID *theMG);
@@ -328,6 +369,8 @@ void    SetGhostObjectPriorities    (GRID *theGrid);
 /* from trans.c */
 int             TransferGrid                            (MULTIGRID *theMG);
 int             TransferGridFromLevel           (MULTIGRID *theMG, INT level);
+int             TransferGridFromLevelChunked    (MULTIGRID *theMG, INT level, std::size_t maxBytes);
+std::size_t     ElementTransferSize             (ELEMENT *theElement);
 
 /* from identify.c */
 void    IdentifyInit                                    (MULTIGRID *theMG);
@@ -348,6 +391,7 @@ INT             SetGridBorderPriorities         (GRID *theGrid);
 
 /* from partition.c */
 INT             CheckPartitioning                       (MULTIGRID *theMG);
+PARTITION_STATISTICS PartitionStatistics        (MULTIGRID *theMG, bool print = false);
 INT             RestrictPartitioning            (MULTIGRID *theMG);
 
 /* from pgmcheck.c */
@@ -36,6 +36,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <set>
 
 /* low module */
 #include <dune/uggrid/low/debug.h>
@@ -193,6 +194,118 @@ INT NS_DIM_PREFIX CheckPartitioning (MULTIGRID *theMG)
   return(_restrict_);
 }
 
+/****************************************************************************/
+/*
+   PartitionStatistics - compute quality measures of the current partitioning
+
+   SYNOPSIS:
+   PARTITION_STATISTICS PartitionStatistics (MULTIGRID *theMG, bool print);
+
+   PARAMETERS:
+   .  theMG
+   .  print - write the statistics on the master process
+
+   DESCRIPTION:
+   This function computes the load imbalance (number of leaf master elements),
+   the edge cut (number of leaf element sides at partition boundaries, in
+   total and for the partition with most of them), the number of neighbor
+   processes and the number of ghost elements. If new
+   destinations have been stored in PARTITION (e.g. by a load balancer),
+   the data volume TransferGridFromLevel will send is estimated from the size
+   of the master elements to be moved and their corners.
+   The function is collective; it needs three global reductions.
+
+   RETURN VALUE:
+   PARTITION_STATISTICS
+ */
+/****************************************************************************/
+
+PARTITION_STATISTICS NS_DIM_PREFIX PartitionStatistics (MULTIGRID *theMG, bool print)
+{
+  auto& context = theMG->dddContext();
+  const auto& ppifContext = theMG->ppifContext();
+  const int me = context.me();
+
+  INT load = 0, cut = 0, partitionCut = 0, ghosts = 0;
+  DOUBLE bytes = 0.0;
+  std::set<DDD_PROC> neighbors;
+
+  for (INT i=0; i<=TOPLEVEL(theMG); i++)
+  {
+    const GRID *theGrid = GRID_ON_LEVEL(theMG,i);
+    for (ELEMENT *theElement=PFIRSTELEMENT(theGrid); theElement!=NULL;
+         theElement=SUCCE(theElement))
+    {
+      for (auto&& [proc, prio] : DDD_InfoProcListRange(context, PARHDRE(theElement), false))
+        neighbors.insert(proc);
+
+      if (!EMASTER(theElement))
+      {
+        ghosts++;
+        continue;
+      }
+
+      if (PARTITION(theElement) != me)
+        bytes += ElementTransferSize(theElement);
+
+      if (!LEAFELEM(theElement))
+        continue;
+
+      load++;
+      for (INT j=0; j<SIDES_OF_ELEM(theElement); j++)
+      {
+        ELEMENT *theNeighbor = NBELEM(theElement,j);
+        if (theNeighbor==NULL || EMASTER(theNeighbor))
+          continue;
+
+        partitionCut++;
+        /* a side between two leaf elements is seen by both processes,
+           count it on the smaller one only */
+        if (!LEAFELEM(theNeighbor) || static_cast<DDD_PROC>(me) < EPROCPRIO(context,theNeighbor,PrioMaster))
+          cut++;
+      }
+    }
+  }
+  neighbors.erase(me);
+
+  DOUBLE sum[5] = {(DOUBLE)load, (DOUBLE)cut, (DOUBLE)neighbors.size(), (DOUBLE)ghosts, bytes};
+  DOUBLE max[5] = {(DOUBLE)load, (DOUBLE)partitionCut, (DOUBLE)neighbors.size(), (DOUBLE)ghosts, bytes};
+  UG_GlobalSumNDOUBLE(ppifContext, 5, sum);
+  UG_GlobalMaxNDOUBLE(ppifContext, 5, max);
+  const DOUBLE min = UG_GlobalMinDOUBLE(ppifContext, load);
+
+  const int procs = context.procs();
+  PARTITION_STATISTICS stat;
+  stat.minLoad = (INT)min;
+  stat.maxLoad = (INT)max[0];
+  stat.avgLoad = sum[0]/procs;
+  stat.imbalance = (stat.avgLoad > 0.0) ? stat.maxLoad/stat.avgLoad : 1.0;
+  stat.edgeCut = (INT)sum[1];
+  stat.maxEdgeCut = (INT)max[1];
+  stat.maxNeighborProcs = (INT)max[2];
+  stat.avgNeighborProcs = sum[2]/procs;
+  stat.ghostElements = (INT)sum[3];
+  stat.maxGhostElements = (INT)max[3];
+  stat.migrationBytes = sum[4];
+  stat.maxMigrationBytes = max[4];
+
+  if (print && context.isMaster())
+  {
+    UserWriteF("PartitionStatistics(): load min=%d max=%d avg=%.1f imbalance=%.3f\n",
+               stat.minLoad, stat.maxLoad, stat.avgLoad, stat.imbalance);
+    UserWriteF("                       edge cut total=%d max=%d\n",
+               stat.edgeCut, stat.maxEdgeCut);
+    UserWriteF("                       neighbor procs max=%d avg=%.1f\n",
+               stat.maxNeighborProcs, stat.avgNeighborProcs);
+    UserWriteF("                       ghost elements total=%d max=%d\n",
+               stat.ghostElements, stat.maxGhostElements);
+    UserWriteF("                       migration bytes total=%.0f max=%.0f\n",
+               stat.migrationBytes, stat.maxMigrationBytes);
+  }
+
+  return stat;
+}
+
 /****************************************************************************/
 /*
    Gather_ElementRestriction -
@@ -288,6 +401,7 @@ static int Gather_RestrictedPartition (DDD::DDDContext&, DDD_OBJ obj, void *data
     PRINTDEBUG(gm,4,(PFMT "Gather_RestrictedPartition(): e=" EID_FMTX "\n",
                      me,EID_PRTX(theElement)))
       ((int *)data)[0] = PARTITION(theElement);
+    ((int *)data)[1] = USED(theElement);
   }
 
   return(GM_OK);
@@ -314,21 +428,31 @@ static int Gather_RestrictedPartition (DDD::DDDContext&, DDD_OBJ obj, void *data
  */
 /****************************************************************************/
 
-static int Scatter_RestrictedPartition (DDD::DDDContext&, DDD_OBJ obj, void *data, DDD_PROC proc, DDD_PRIO prio)
+static int Scatter_RestrictedPartition (DDD::DDDContext& context, DDD_OBJ obj, void *data, DDD_PROC proc, DDD_PRIO prio)
 {
   ELEMENT *theElement = (ELEMENT *)obj;
-  ELEMENT *SonList[MAX_SONS];
 
-  if (USED(theElement) && EMASTERPRIO(prio))
+  if (!EMASTERPRIO(prio)) return(GM_OK);
+
+  /* the restriction flag of the master copy may stem from a descendant */
+  /* on a third process, hence the copies take it over                  */
+  if (((int *)data)[1])
+    SETUSED(theElement,1);
+
+  if (USED(theElement))
   {
     PRINTDEBUG(gm,4,(PFMT "Scatter_ElementRestriction(): restricting sons of e=" EID_FMTX "\n",
                      me,EID_PRTX(theElement)))
 
     int partition = ((int *)data)[0];
-    /* send master sons to master element partition */
-    if (GetSons(theElement,SonList)) RETURN(GM_ERROR);
-    for (int i = 0; SonList[i] != NULL; i++)
-      PARTITION(SonList[i]) = partition;
+    PARTITION(theElement) = partition;
+    /* send master sons to master element partition and mark them */
+    /* such that the restriction reaches the next level           */
+    for (ELEMENT *son : GetSonRange(ddd_ctrl(context).currMG,theElement))
+    {
+      PARTITION(son) = partition;
+      SETUSED(son,1);
+    }
   }
 
   return(GM_OK);
@@ -345,6 +469,11 @@ static int Scatter_RestrictedPartition (DDD::DDDContext&, DDD_OBJ obj, void *dat
    .  theMG
 
    DESCRIPTION:
+   This function moves the master copies of all descendants of elements
+   which cannot be refined or coarsened locally to the partition of their
+   father. The restriction flags are collected bottom-up, then partitions
+   and flags are pushed top-down through all levels in a single pass with
+   one interface exchange per level, followed by one TransferGrid.
 
    RETURN VALUE:
    INT
@@ -356,10 +485,9 @@ INT NS_DIM_PREFIX RestrictPartitioning (MULTIGRID *theMG)
   auto& context = theMG->dddContext();
   const auto& dddctrl = ddd_ctrl(context);
 
-  INT i,j;
+  INT i;
   ELEMENT *theElement;
   ELEMENT *theFather;
-  ELEMENT *SonList[MAX_SONS];
   GRID    *theGrid;
 
   /* reset used flags */
@@ -422,7 +550,7 @@ INT NS_DIM_PREFIX RestrictPartitioning (MULTIGRID *theMG)
 
     /* transfer (new) partitions of elements to non master copies */
     DDD_IFAOnewayX(context,
-                   dddctrl.ElementVHIF,GRID_ATTR(theGrid),IF_FORWARD,sizeof(INT),
+                   dddctrl.ElementVHIF,GRID_ATTR(theGrid),IF_FORWARD,2*sizeof(int),
                    Gather_RestrictedPartition, Scatter_RestrictedPartition);
 
     for (theElement=PFIRSTELEMENT(theGrid); theElement!=NULL;
@@ -431,12 +559,11 @@ INT NS_DIM_PREFIX RestrictPartitioning (MULTIGRID *theMG)
       if (!USED(theElement)) continue;
 
       /* push partition to the sons */
-      GetAllSons(theElement,SonList);
-      for (j=0; SonList[j]!=NULL; j++)
+      for (ELEMENT *son : GetAllSonRange(theMG,theElement))
       {
-        SETUSED(SonList[j],1);
-        if (EMASTER(SonList[j]))
-          PARTITION(SonList[j]) = PARTITION(theElement);
+        SETUSED(son,1);
+        if (EMASTER(son))
+          PARTITION(son) = PARTITION(theElement);
       }
     }
   }
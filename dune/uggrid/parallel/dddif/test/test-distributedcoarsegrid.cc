@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+#include <dune/uggrid/parallel/dddif/parallel.h>
+#include <dune/uggrid/parallel/ppif/ppifcontext.hh>
+
+#include "../../../gm/test/testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* the number of master elements of a level on all processes */
+static INT GlobalMasterElements (MULTIGRID *theMG, INT level)
+{
+  INT n = 0;
+  for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,level));
+       theElement!=nullptr; theElement=SUCCE(theElement))
+    n++;
+  return UG_GlobalSumINT(theMG->ppifContext(),n);
+}
+
+/* each process inserts the whole coarse grid and owns every procs-th element,
+   the identified grid is consistent and can be refined; the whole grid is the
+   local part plus overlap only on one or two processes */
+static void IdentifyCoarseGrid (TestSuite& test)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("distributedcoarsegrid",nullptr,false,true);
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  const INT procs = theMG->ppifContext().procs();
+
+  GRID *theGrid = GRID_ON_LEVEL(theMG,0);
+  std::vector<INT> vertexGid(NN(theGrid)), elementGid(NT(theGrid)), elementOwner(NT(theGrid));
+  for (NODE *theNode=FIRSTNODE(theGrid); theNode!=nullptr; theNode=SUCCN(theNode))
+    vertexGid[ID(theNode)] = ID(theNode);
+  for (ELEMENT *theElement=FIRSTELEMENT(theGrid); theElement!=nullptr; theElement=SUCCE(theElement))
+  {
+    elementGid[ID(theElement)] = ID(theElement);
+    elementOwner[ID(theElement)] = ID(theElement)%procs;
+  }
+  const INT nElements = elementGid.size();
+
+  test.check(IdentifyDistributedCoarseGrid(theMG,vertexGid.data(),elementGid.data(),elementOwner.data())==GM_OK,
+             "IdentifyDistributedCoarseGrid() must succeed");
+  test.check(CheckGrid(theGrid,1,0,1,1)==GM_OK, "CheckGrid() must accept the identified coarse grid");
+  test.check(GlobalMasterElements(theMG,0)==nElements, "each element must have exactly one master");
+  for (ELEMENT *theElement=FIRSTELEMENT(theGrid); theElement!=nullptr; theElement=SUCCE(theElement))
+    test.check(elementOwner[ID(theElement)]==theMG->ppifContext().me(),
+               "the master elements must be on their owner");
+
+  for (ELEMENT *theElement=FIRSTELEMENT(theGrid); theElement!=nullptr; theElement=SUCCE(theElement))
+    MarkForRefinement(theElement,RED,0);
+  test.check(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+             "AdaptMultiGrid() must refine the identified coarse grid");
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    test.check(CheckGrid(GRID_ON_LEVEL(theMG,l),1,0,1,1)==GM_OK, "CheckGrid() must accept the refined grid");
+  test.check(GlobalMasterElements(theMG,1)==(1<<DIM)*nElements, "the red refinement must create all sons");
+
+  /* the coarse grid cannot be identified once it is refined */
+  test.check(IdentifyDistributedCoarseGrid(theMG,vertexGid.data(),elementGid.data(),elementOwner.data())==GM_ERROR,
+             "IdentifyDistributedCoarseGrid() must reject a refined multigrid");
+
+  DisposeMultiGrid(theMG);
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  IdentifyCoarseGrid(test);
+
+  ExitUg();
+
+  return test.exit();
+}
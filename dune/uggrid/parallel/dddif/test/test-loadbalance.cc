@@ -0,0 +1,221 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+#include <dune/uggrid/parallel/dddif/parallel.h>
+#include <dune/uggrid/parallel/ppif/ppifcontext.hh>
+
+#include "../../../gm/rm.h"
+#include "../../../gm/test/testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+/* the unit cube after two red refinement steps and two steps of a moving front */
+static MULTIGRID *CreateAdaptedGrid (TestSuite& test)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("loadbalance");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+
+  for (INT step=0; step<4; step++)
+  {
+    if (step<2)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        MarkForRefinement(theElement,RED,0);
+    else
+      MarkMovingFront(theMG,step-2);
+    test.require(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+                 "require that AdaptMultiGrid() succeeds");
+  }
+  return theMG;
+}
+
+/* a single process keeps all objects of a consistent grid */
+static void CheckTransferred (TestSuite& test, MULTIGRID *theMG, const std::vector<INT>& counts,
+                              const std::string& name)
+{
+  test.check(GridCounts(theMG)==counts, "a single process must keep all objects") << name;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    test.check(CheckGrid(GRID_ON_LEVEL(theMG,l),1,0,1,1)==GM_OK, "CheckGrid() must accept the balanced grid")
+      << name << ", level " << l;
+
+  const PARTITION_STATISTICS stat = PartitionStatistics(theMG);
+  test.check(stat.imbalance==1.0 && stat.edgeCut==0, "a single process must be balanced without edge cut") << name;
+}
+
+/* the statistics of the partitioning of a single process */
+static void CheckStatistics (TestSuite& test)
+{
+  MULTIGRID *theMG = CreateAdaptedGrid(test);
+
+  INT leaves = 0;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+      if (LEAFELEM(theElement))
+        leaves++;
+
+  PARTITION_STATISTICS stat = PartitionStatistics(theMG,true);
+  test.check(stat.minLoad==leaves && stat.maxLoad==leaves && stat.avgLoad==leaves,
+             "the load of a single process must be its number of leaf elements");
+  test.check(stat.imbalance==1.0, "a single process must be balanced");
+  test.check(stat.edgeCut==0 && stat.maxEdgeCut==0, "a single process must not have an edge cut");
+  test.check(stat.maxNeighborProcs==0 && stat.avgNeighborProcs==0.0, "a single process must not have neighbors");
+  test.check(stat.ghostElements==0 && stat.maxGhostElements==0, "a single process must not have ghost elements");
+  test.check(stat.migrationBytes==0.0 && stat.maxMigrationBytes==0.0, "elements staying must not be sent");
+
+  /* new destinations of the leaf elements, only estimated, not sent */
+  DOUBLE bytes = 0.0;
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+      if (LEAFELEM(theElement))
+      {
+        PARTITION(theElement) = theMG->ppifContext().procs();
+        bytes += ElementTransferSize(theElement);
+      }
+  stat = PartitionStatistics(theMG);
+  test.check(bytes>0.0 && stat.migrationBytes==bytes && stat.maxMigrationBytes==bytes,
+             "the migration volume must be the transfer size of the elements to be moved");
+  test.check(stat.imbalance==1.0 && stat.edgeCut==0, "new destinations must not change the current partitioning");
+
+  DisposeMultiGrid(theMG);
+}
+
+/* the keys of a structured grid of 2^k points per direction: both curves
+   visit each point once, the Hilbert curve steps to a neighboring point,
+   the Morton key grows with each coordinate */
+static void CheckCurveKeys (TestSuite& test)
+{
+  constexpr INT k = 3;
+  constexpr std::uint32_t n = 1u << k;
+  constexpr std::uint64_t nPoints = std::uint64_t(1) << (k*DIM);
+
+  for (SpaceFillingCurve curve : {SFC_HILBERT, SFC_MORTON})
+  {
+    const char *name = (curve==SFC_HILBERT) ? "Hilbert" : "Morton";
+    std::vector<std::array<std::uint32_t,DIM> > points(nPoints);
+    std::vector<bool> visited(nPoints,false);
+    bool bijective = true, monotone = true;
+    for (std::uint64_t i=0; i<nPoints; i++)
+    {
+      std::array<std::uint32_t,DIM> x;
+      for (INT d=0; d<DIM; d++)
+        x[d] = (i >> (k*d)) & (n-1);
+      const std::uint64_t key = SpaceFillingCurveKey(x,curve);
+      if (key>=nPoints || visited[key])
+      {
+        bijective = false;
+        continue;
+      }
+      visited[key] = true;
+      points[key] = x;
+
+      for (INT d=0; d<DIM; d++)
+        if (x[d]>0)
+        {
+          std::array<std::uint32_t,DIM> y = x;
+          y[d]--;
+          if (SpaceFillingCurveKey(y,curve)>=key)
+            monotone = false;
+        }
+    }
+    test.require(bijective, "the curve must number the points of the cube at its origin consecutively") << name;
+
+    if (curve==SFC_MORTON)
+    {
+      test.check(monotone, "the Morton key must grow with each coordinate");
+      continue;
+    }
+    bool steps = true;
+    for (std::uint64_t key=1; key<nPoints; key++)
+    {
+      INT distance = 0;
+      for (INT d=0; d<DIM; d++)
+        distance += std::abs((INT)points[key][d]-(INT)points[key-1][d]);
+      if (distance!=1)
+        steps = false;
+    }
+    test.check(steps, "the Hilbert curve must step to a neighboring point");
+  }
+}
+
+/* balance the grid from level 0 and 1 with a load balancer, which has to
+   assign each element of these levels to a process, then with the same
+   strategy of lbs */
+template <class Balance>
+static void CheckStrategy (TestSuite& test, INT strategy, Balance balance)
+{
+  for (INT level=0; level<2; level++)
+  {
+    const std::string name = "lbs " + std::to_string(strategy) + " " + std::to_string(level);
+    MULTIGRID *theMG = CreateAdaptedGrid(test);
+    const std::vector<INT> counts = GridCounts(theMG);
+    const INT procs = theMG->ppifContext().procs();
+
+    for (INT l=level; l<=TOPLEVEL(theMG); l++)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        PARTITION(theElement) = -1;
+    balance(theMG,level);
+
+    bool assigned = true;
+    for (INT l=level; l<=TOPLEVEL(theMG); l++)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        if (PARTITION(theElement)<0 || PARTITION(theElement)>=procs)
+          assigned = false;
+    test.check(assigned, "the load balancer must assign each element to a process") << name;
+
+    if (assigned)
+    {
+      test.check(TransferGridFromLevel(theMG,level)==0, "TransferGridFromLevel() must succeed") << name;
+      CheckTransferred(test,theMG,counts,name);
+    }
+
+    lbs(name.substr(4).c_str(),theMG);
+    CheckTransferred(test,theMG,counts,name);
+
+    DisposeMultiGrid(theMG);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  CheckStatistics(test);
+  CheckCurveKeys(test);
+  CheckStrategy(test, 7, [](MULTIGRID *theMG, INT level) { BalanceGridSFC(theMG,level,SFC_HILBERT); });
+  CheckStrategy(test, 9, [](MULTIGRID *theMG, INT level) { BalanceGridSFC(theMG,level,SFC_MORTON); });
+  CheckStrategy(test, 10, [](MULTIGRID *theMG, INT level) { BalanceGridGraph(theMG,level); });
+  CheckStrategy(test, 11, [](MULTIGRID *theMG, INT level) { BalanceGridGraph(theMG,level,true); });
+  CheckStrategy(test, 12, [&](MULTIGRID *theMG, INT level) {
+    BalanceGridDiffusive(theMG,level);
+    /* a balanced process has no reason to move elements */
+    for (INT l=0; l<=TOPLEVEL(theMG); l++)
+      for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+           theElement!=nullptr; theElement=SUCCE(theElement))
+        test.check(PARTITION(theElement)==theMG->ppifContext().me(),
+                   "BalanceGridDiffusive() must keep the elements of a balanced grid");
+  });
+
+  ExitUg();
+
+  return test.exit();
+}
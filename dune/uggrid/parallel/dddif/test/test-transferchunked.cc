@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: Copyright © DUNE Project contributors, see file LICENSE.md in module root
+// SPDX-License-Identifier: LGPL-2.1-or-later
+#include "config.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/test/testsuite.hh>
+
+#include <dune/uggrid/initug.h>
+#include <dune/uggrid/parallel/dddif/parallel.h>
+#include <dune/uggrid/parallel/ppif/ppifcontext.hh>
+
+#include "../../../gm/test/testgrid.h"
+
+using namespace Dune;
+USING_UGDIM_NAMESPACE
+USING_UG_NAMESPACE
+
+using MasterElements = std::vector<std::vector<std::array<DOUBLE,DIM> > >;
+
+/* the sorted centers of the master elements of each level on this process */
+static MasterElements GetMasterElements (MULTIGRID *theMG)
+{
+  MasterElements masters(TOPLEVEL(theMG)+1);
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+  {
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,l));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+    {
+      const FieldVector<DOUBLE,DIM> center = CenterOfMass(theElement);
+      std::array<DOUBLE,DIM> x;
+      std::copy(center.begin(),center.end(),x.begin());
+      masters[l].push_back(x);
+    }
+    std::sort(masters[l].begin(),masters[l].end());
+  }
+  return masters;
+}
+
+/* distribute the unit cube from level 0, then move the subtrees of level 0
+   to slices along the x axis, in one transfer if maxBytes is 0 and in chunks
+   of maxBytes otherwise */
+static MasterElements Redistribute (TestSuite& test, std::size_t maxBytes)
+{
+  MULTIGRID *theMG = CreateUnitCubeGrid("transferchunked");
+  test.require(theMG!=nullptr, "require that the coarse grid is created");
+  const INT procs = theMG->ppifContext().procs();
+
+  for (INT step=0; step<2; step++)
+  {
+    for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,TOPLEVEL(theMG)));
+         theElement!=nullptr; theElement=SUCCE(theElement))
+      MarkForRefinement(theElement,RED,0);
+    test.require(AdaptMultiGrid(theMG,GM_REFINE_TRULY_LOCAL,GM_REFINE_PARALLEL,GM_REFINE_NOHEAPTEST)==GM_OK,
+                 "require that AdaptMultiGrid() succeeds");
+  }
+  BalanceGridRCB(theMG,0);
+  test.require(TransferGridFromLevel(theMG,0)==0, "require that the grid is distributed");
+
+  for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,0));
+       theElement!=nullptr; theElement=SUCCE(theElement))
+  {
+    PARTITION(theElement) = std::min<INT>(CenterOfMass(theElement)[0]*procs,procs-1);
+    InheritPartition(theMG,theElement);
+  }
+
+  if (maxBytes==0)
+    test.check(TransferGridFromLevel(theMG,0)==0, "TransferGridFromLevel() must succeed");
+  else
+    test.check(TransferGridFromLevelChunked(theMG,0,maxBytes)==0, "TransferGridFromLevelChunked() must succeed");
+  for (INT l=0; l<=TOPLEVEL(theMG); l++)
+    test.check(CheckGrid(GRID_ON_LEVEL(theMG,l),1,0,1,1)==GM_OK, "CheckGrid() must accept the redistributed grid");
+
+  /* a level above 0 is rejected before anything is moved */
+  const MasterElements masters = GetMasterElements(theMG);
+  for (ELEMENT *theElement=FIRSTELEMENT(GRID_ON_LEVEL(theMG,1));
+       theElement!=nullptr; theElement=SUCCE(theElement))
+  {
+    PARTITION(theElement) = (PARTITION(theElement)+1)%procs;
+    InheritPartition(theMG,theElement);
+  }
+  test.check(TransferGridFromLevelChunked(theMG,1,maxBytes)==1, "TransferGridFromLevelChunked() must reject level 1");
+  test.check(GetMasterElements(theMG)==masters, "a rejected transfer must not move elements");
+
+  DisposeMultiGrid(theMG);
+  return masters;
+}
+
+int main(int argc, char** argv)
+{
+  MPIHelper::instance(argc, argv);
+  InitUg(&argc, &argv);
+
+  TestSuite test;
+
+  const MasterElements direct = Redistribute(test,0);
+  for (std::size_t maxBytes : {1,4096})
+    test.check(Redistribute(test,maxBytes)==direct,
+               "TransferGridFromLevelChunked() must give the distribution of TransferGridFromLevel()");
+
+  ExitUg();
+
+  return test.exit();
+}
@@ -35,6 +35,9 @@
 
 #include <config.h>
 #include <cassert>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
 
 #include <dune/uggrid/parallel/ppif/ppifcontext.hh>
 
@@ -287,8 +290,6 @@ static int Gather_GhostCmd (DDD::DDDContext&, DDD_OBJ obj, void *data, DDD_PROC
 static int Scatter_GhostCmd (DDD::DDDContext& context, DDD_OBJ obj, void *data, DDD_PROC proc, DDD_PRIO prio)
 {
   ELEMENT *theElement = (ELEMENT *)obj;
-  ELEMENT *SonList[MAX_SONS];
-  INT i;
 
   const auto& me = context.me();
 
@@ -304,16 +305,8 @@ static int Scatter_GhostCmd (DDD::DDDContext& context, DDD_OBJ obj, void *data,
     break;
 
   case GC_Delete :
-    if (NSONS(theElement) > 0)
-    {
-      if (GetAllSons(theElement,SonList) != 0) return(1);
-      i = 0;
-      while (i<MAX_SONS && SonList[i] != NULL)
-      {
-        if (PARTITION(SonList[i]) == me) return(0);
-        i++;
-      }
-    }
+    for (ELEMENT *son : GetAllSonRange(ddd_ctrl(context).currMG,theElement))
+      if (PARTITION(son) == me) return(0);
     XFEREDELETE(context, theElement);
     break;
 
@@ -411,7 +404,6 @@ static int Scatter_VHGhostCmd (DDD::DDDContext& context, DDD_OBJ obj, void *data
   const auto& me = context.me();
 
   ELEMENT *theElement = (ELEMENT *)obj;
-  ELEMENT *SonList[MAX_SONS];
 
   /* if element is needed after transfer here */
   if ((*(int *)data) == GC_Keep) return(0);
@@ -420,13 +412,8 @@ static int Scatter_VHGhostCmd (DDD::DDDContext& context, DDD_OBJ obj, void *data
   if (PARTITION(theElement) == me) return(0);
 
   /* if a son resides as master keep element as vghost */
-  if (GetAllSons(theElement,SonList) != GM_OK) return(0);
-  INT i = 0;
-  while (i<MAX_SONS && SonList[i] != NULL)
-  {
-    if (PARTITION(SonList[i]) == me) return(0);
-    i++;
-  }
+  for (ELEMENT *son : GetAllSonRange(ddd_ctrl(context).currMG,theElement))
+    if (PARTITION(son) == me) return(0);
   /* element is not needed on me any more */
   if ((*(int *)data) == GC_Delete)
   {
@@ -488,8 +475,7 @@ static int ComputeGhostCmds (MULTIGRID *theMG)
 static int XferGridWithOverlap (GRID *theGrid)
 {
   ELEMENT *theElement, *theFather, *theNeighbor;
-  ELEMENT *SonList[MAX_SONS];
-  INT i,j,overlap_elem,part;
+  INT j,overlap_elem,part;
   INT migrated = 0;
 
   DDD::DDDContext& context = theGrid->dddContext();
@@ -550,20 +536,12 @@ static int XferGridWithOverlap (GRID *theGrid)
     /* consider elements on master-proc */
     if (PARTITION(theElement)!=me)
     {
-      if (NSONS(theElement) > 0)
-      {
-        if (GetAllSons(theElement,SonList) != 0) assert(0);
-        i = 0;
-        while (i<MAX_SONS && SonList[i] != NULL)
+      for (ELEMENT *son : GetAllSonRange(MYMG(theGrid),theElement))
+        if (PARTITION(son) == me)
         {
-          if (PARTITION(SonList[i]) == me)
-          {
-            overlap_elem += 2;
-            break;
-          }
-          i++;
+          overlap_elem += 2;
+          break;
         }
-      }
 
       PRINTDEBUG(dddif,1,("%d: XferGridWithOverlap(): elem=" EID_FMTX " p=%d new prio=%d\n",
                           me,EGID(theElement),PARTITION(theElement),overlap_elem));
@@ -732,6 +710,9 @@ int NS_DIM_PREFIX TransferGridFromLevel (MULTIGRID *theMG, INT level)
     DDD_ConsCheck(theMG->dddContext());
         #endif
 
+  /* collect the sons of the elements changed by the transfer */
+  UpdateSonTable(theMG);
+
   return 0;
 }
 
@@ -758,6 +739,144 @@ int NS_DIM_PREFIX TransferGrid (MULTIGRID *theMG)
   return TransferGridFromLevel(theMG,0);
 }
 
+
+/****************************************************************************/
+/*
+   ElementTransferSize -
+
+   SYNOPSIS:
+   std::size_t ElementTransferSize (ELEMENT *theElement);
+
+   PARAMETERS:
+   .  theElement
+
+   DESCRIPTION:
+   Estimate of the data sent when theElement migrates: the element itself
+   and the nodes and vertices of its corners (which may be shared with
+   other migrating elements).
+
+   RETURN VALUE:
+   std::size_t
+ */
+/****************************************************************************/
+
+std::size_t NS_DIM_PREFIX ElementTransferSize (ELEMENT *theElement)
+{
+  return ((OBJT(theElement)==BEOBJ) ? BND_SIZE_TAG(TAG(theElement)) :
+          INNER_SIZE_TAG(TAG(theElement)))
+         + CORNERS_OF_ELEM(theElement)*(sizeof(NODE)+sizeof(VERTEX));
+}
+
+
+/****************************************************************************/
+/*
+   SetSubtreePartition -
+
+   SYNOPSIS:
+   static std::size_t SetSubtreePartition (const MULTIGRID *theMG, ELEMENT *e, DDD_PROC dest);
+
+   PARAMETERS:
+   .  theMG
+   .  e
+   .  dest
+
+   DESCRIPTION:
+   Sets the destination of e and all its descendants.
+
+   RETURN VALUE:
+   std::size_t - estimated transfer size of the subtree
+ */
+/****************************************************************************/
+
+static std::size_t SetSubtreePartition (const MULTIGRID *theMG, ELEMENT *e, DDD_PROC dest)
+{
+  std::size_t size = ElementTransferSize(e);
+
+  PARTITION(e) = dest;
+  for (ELEMENT *son : GetAllSonRange(theMG,e))
+    size += SetSubtreePartition(theMG,son,dest);
+
+  return size;
+}
+
+
+/****************************************************************************/
+/*
+   TransferGridFromLevelChunked -
+
+   SYNOPSIS:
+   int TransferGridFromLevelChunked (MULTIGRID *theMG, INT level, std::size_t maxBytes);
+
+   PARAMETERS:
+   .  theMG
+   .  level
+   .  maxBytes - approximate upper bound for the data a process sends per round
+
+   DESCRIPTION:
+   Realizes the new distribution given by the PARTITION entries like
+   TransferGridFromLevel, but in several rounds, to bound the memory needed
+   for the DDD transfer buffers. The subtrees of the master elements on the
+   given level move as a whole (the destination of a root is taken for its
+   subtree); each round a process sends subtrees up to an estimated volume
+   of maxBytes (but at least one), all other elements stay until a later round.
+   Only level 0 is supported: the elements of coarser levels would move
+   apart from their sons in many rounds, which the 3D side vectors do not
+   survive.
+   The destinations are stored by global id since elements may be recreated
+   during a transfer. The function returns when no process has pending
+   subtrees anymore; with a sufficiently large budget it is equivalent to
+   one call of TransferGridFromLevel.
+
+   RETURN VALUE:
+   int - 0 if ok, 1 if level is not 0 or a transfer failed
+ */
+/****************************************************************************/
+
+int NS_DIM_PREFIX TransferGridFromLevelChunked (MULTIGRID *theMG, INT level, std::size_t maxBytes)
+{
+  const auto& ppifContext = theMG->ppifContext();
+  const int me = ppifContext.me();
+
+  if (level != 0)
+  {
+    PrintErrorMessage('E',"TransferGridFromLevelChunked","only the subtrees of level 0 can be moved in chunks");
+    return 1;
+  }
+
+  /* pending destinations of the subtree roots */
+  std::unordered_map<DDD_GID, DDD_PROC> pending;
+  for (ELEMENT *e=FIRSTELEMENT(GRID_ON_LEVEL(theMG,level)); e!=NULL; e=SUCCE(e))
+    if (PARTITION(e) != me)
+      pending.emplace(EGID(e), PARTITION(e));
+
+  INT rounds = 0;
+  while (UG_GlobalMaxINT(ppifContext, pending.empty() ? 0 : 1))
+  {
+    /* select the subtrees sent in this round, all others stay */
+    std::size_t bytes = 0;
+    for (ELEMENT *e=FIRSTELEMENT(GRID_ON_LEVEL(theMG,level)); e!=NULL; e=SUCCE(e))
+    {
+      auto it = pending.find(EGID(e));
+      if (it != pending.end() && (bytes == 0 || bytes < maxBytes))
+      {
+        bytes += SetSubtreePartition(theMG, e, it->second);
+        pending.erase(it);
+      }
+      else
+        SetSubtreePartition(theMG, e, me);
+    }
+
+    PRINTDEBUG(dddif,1,(PFMT "TransferGridFromLevelChunked(): round %d sends %lu bytes, %lu subtrees pending\n",
+                        me,rounds,(unsigned long)bytes,(unsigned long)pending.size()));
+
+    if (TransferGridFromLevel(theMG,level))
+      return 1;
+    rounds++;
+  }
+
+  return 0;
+}
+
 /****************************************************************************/
 
 #endif  /* ModelP */